@@ -23,8 +23,27 @@ typedef enum beacon_BytecodeOpcode_e
     BeaconBytecodeMakeArray,
     BeaconBytecodeMakeClosureInstance,
     BeaconBytecodeExtendArguments,
+    BeaconBytecodeInlinedPrimitive,
 } beacon_BytecodeOpcode_t;
 
+/**
+ * The operations of the InlinedPrimitive instruction, whose first operand is the operation number as a literal.
+ * They are emitted by the compiler only where the classes of their operands are known, so they do not send any message.
+ */
+typedef enum beacon_BytecodeInlinedPrimitive_e
+{
+    // object class == literalClass
+    BeaconBytecodeInlinedPrimitiveClassIdentityEquals = 0,
+    // The size of an Array or an ArrayList.
+    BeaconBytecodeInlinedPrimitiveSequenceSize,
+    // The element of an Array or an ArrayList at a one-based index, which is checked against its storage like basicAt:.
+    BeaconBytecodeInlinedPrimitiveSequenceAt,
+    // Stores into an Array at a one-based index, which is checked against its size.
+    BeaconBytecodeInlinedPrimitiveArrayAtPut,
+    BeaconBytecodeInlinedPrimitiveSmallIntegerAdd,
+    BeaconBytecodeInlinedPrimitiveSmallIntegerLessOrEquals,
+} beacon_BytecodeInlinedPrimitive_t;
+
 typedef enum beacon_BytecodeArgumentType_e
 {
     BytecodeArgumentTypeLiteral = 0,
@@ -38,6 +57,11 @@ typedef enum beacon_BytecodeArgumentType_e
 
 #define BEACON_MAX_SUPPORTED_BYTECODE_ARGUMENTS 32
 
+// The bytecode values have 13 bits for the one-based literal index.
+#define BEACON_BYTECODE_MAX_LITERAL_COUNT 8191
+#define BEACON_BYTECODE_LITERAL_INDEX_THRESHOLD 16
+#define BEACON_LITERAL_FRAME_SET_INITIAL_CAPACITY 1024
+
 typedef uint16_t beacon_BytecodeValue_t;
 
 static inline beacon_BytecodeOpcode_t beacon_getBytecodeOpcode(uint8_t bytecode)
@@ -70,6 +94,14 @@ static inline int16_t beacon_BytecodeValue_encode(uint16_t index, beacon_Bytecod
     return (index << 3) | type;
 }
 
+/**
+ * Increments one of the SmallInteger execution counters of a bytecode code.
+ */
+static inline void beacon_BytecodeCode_incrementCounter(beacon_oop_t *counter)
+{
+    *counter += (beacon_oop_t)1 << ImmediateObjectTag_BitCount;
+}
+
 beacon_BytecodeCodeBuilder_t *beacon_BytecodeCodeBuilder_new(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *parentBuilder);
 
 /**
@@ -80,6 +112,16 @@ beacon_BytecodeCode_t *beacon_BytecodeCodeBuilder_finish(beacon_context_t *conte
 // Add a literal value.
 beacon_BytecodeValue_t beacon_BytecodeCodeBuilder_addLiteral(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder, beacon_oop_t literal);
 
+/**
+ * Gets the literal frame with the given contents. Methods with identical literals share a single frame, since the frames are never modified.
+ */
+beacon_Array_t *beacon_internLiteralFrame(beacon_context_t *context, size_t literalCount, beacon_oop_t *literals);
+
+/**
+ * Removes the literal frames that were cleared by the garbage collector from the weak literal frame set.
+ */
+void beacon_LiteralFrameSet_removeCollectedFrames(beacon_context_t *context);
+
 // Super receiver class.
 beacon_BytecodeValue_t beacon_BytecodeCodeBuilder_superReceiverClass(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder, beacon_oop_t literalBehavior);
 
@@ -167,6 +209,32 @@ void beacon_BytecodeCodeBuilder_makeArray(beacon_context_t *context, beacon_Byte
  */
 void beacon_BytecodeCodeBuilder_makeClosureInstance(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *methodBuilder, beacon_BytecodeValue_t resultTemporary, beacon_BytecodeValue_t closure, size_t captureCount, beacon_BytecodeValue_t *captures);
 
+/**
+ * Applies an inlined primitive operation to the given operands, and stores its result.
+ */
+void beacon_BytecodeCodeBuilder_inlinedPrimitive(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *methodBuilder, beacon_BytecodeValue_t resultTemporary, beacon_BytecodeInlinedPrimitive_t primitive, size_t operandCount, beacon_BytecodeValue_t *operands);
+
+/**
+ * Detects trivial methods (return self, return a literal, instance variable getter and setter)
+ * which can be executed by the send path without activating a frame.
+ */
+void beacon_CompiledCode_detectQuickMethod(beacon_context_t *context, beacon_CompiledCode_t *method);
+
+/**
+ * Executes a quick method without activating a frame. Returns false if the receiver is not suitable for it.
+ */
+bool beacon_CompiledCode_runQuickMethod(beacon_context_t *context, beacon_CompiledCode_t *method, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments, beacon_oop_t *outResult);
+
+/**
+ * Makes a closure instance for a MakeClosureInstance instruction. The previous closure held by the result temporary is reused when it has the same receiver and captured the same values.
+ */
+beacon_oop_t beacon_BytecodeInterpreter_makeClosureInstance(beacon_context_t *context, beacon_oop_t previousClosure, beacon_oop_t receiver, beacon_CompiledBlock_t *code, size_t captureCount, beacon_oop_t *captures);
+
+/**
+ * Runs an InlinedPrimitive instruction. This is shared by the interpreter and the JIT.
+ */
+beacon_oop_t beacon_BytecodeInterpreter_inlinedPrimitive(beacon_context_t *context, intptr_t primitive, size_t operandCount, beacon_oop_t *operands);
+
 /**
  * Bytecode interpretation.
  */
@@ -0,0 +1,62 @@
+#ifndef BEACON_LANG_BYTECODE_CACHE_H
+#define BEACON_LANG_BYTECODE_CACHE_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+
+// Increment this when the bytecode or the layout of the cache files changes.
+#define BEACON_BYTECODE_CACHE_FORMAT_VERSION 5
+
+typedef struct beacon_BytecodeCacheWriter_s beacon_BytecodeCacheWriter_t;
+typedef struct beacon_BytecodeCacheReader_s beacon_BytecodeCacheReader_t;
+
+/**
+ * Starts recording the doits of a source file. Returns NULL when the file cannot be cached.
+ */
+beacon_BytecodeCacheWriter_t *beacon_BytecodeCacheWriter_begin(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t localVariableCount, size_t statementCount);
+
+/**
+ * Records a method that is installed while compiling the current doit.
+ */
+void beacon_BytecodeCacheWriter_recordMethodInstallation(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_Behavior_t *behavior, beacon_CompiledMethod_t *method);
+
+/**
+ * Records a compiled doit. This must be called before running the doit, so that the globals are recorded with the values that were seen by the compiler.
+ */
+void beacon_BytecodeCacheWriter_recordDoIt(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_CompiledMethod_t *doItMethod);
+
+/**
+ * Writes the cache file when every doit was recorded, and releases the writer.
+ */
+void beacon_BytecodeCacheWriter_end(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer);
+
+/**
+ * Opens the cache file of a source file. Returns NULL when there is no valid cache entry for the current source text.
+ */
+beacon_BytecodeCacheReader_t *beacon_BytecodeCacheReader_open(beacon_context_t *context, beacon_SourceCode_t *sourceCode);
+
+size_t beacon_BytecodeCacheReader_getLocalVariableCount(beacon_BytecodeCacheReader_t *reader);
+size_t beacon_BytecodeCacheReader_getStatementCount(beacon_BytecodeCacheReader_t *reader);
+
+/**
+ * Loads the next doit, after installing the methods that were defined while compiling it.
+ * Returns NULL if the doit refers to a global that is not defined, in which case the rest of the file has to be compiled from the source.
+ */
+beacon_CompiledMethod_t *beacon_BytecodeCacheReader_nextDoIt(beacon_context_t *context, beacon_BytecodeCacheReader_t *reader);
+
+void beacon_BytecodeCacheReader_close(beacon_BytecodeCacheReader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_BYTECODE_CACHE_H
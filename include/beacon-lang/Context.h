@@ -5,12 +5,24 @@
 
 #include "ObjectModel.h"
 #include "Memory.h"
+#include <stdio.h>
+#include <threads.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define BEACON_VM_VERSION "0.1"
+
+// The interned symbol set capacity must be a power of two.
+#define BEACON_INTERNED_SYMBOL_SET_INITIAL_CAPACITY 2048
+#define BEACON_INTERNED_SYMBOL_SET_MIGRATION_STEP 16
+
+// The window table grows up to the highest window identifier.
+#define BEACON_WINDOW_TABLE_INITIAL_CAPACITY 8
+
 typedef struct beacon_context_s beacon_context_t;
+typedef struct beacon_BytecodeCacheWriter_s beacon_BytecodeCacheWriter_t;
 
 struct beacon_context_s
 {
@@ -103,6 +115,7 @@ struct beacon_context_s
         beacon_Behavior_t *assertionFailureClass;
         beacon_Behavior_t *messageNotUnderstoodClass;
         beacon_Behavior_t *nonBooleanReceiverClass;
+        beacon_Behavior_t *stackOverflowClass;
         beacon_Behavior_t *unhandledExceptionClass;
         beacon_Behavior_t *unhandledErrorClass;
         
@@ -112,6 +125,14 @@ struct beacon_context_s
         beacon_Behavior_t *abstractBinaryFileStreamClass;
         beacon_Behavior_t *stdioClass;
         beacon_Behavior_t *stdioStreamClass;
+        beacon_Behavior_t *timeClass;
+        beacon_Behavior_t *processClass;
+        beacon_Behavior_t *semaphoreClass;
+        beacon_Behavior_t *processorClass;
+        beacon_Behavior_t *timerClass;
+        beacon_Behavior_t *channelClass;
+        beacon_Behavior_t *workerClass;
+        beacon_Behavior_t *futureClass;
 
         beacon_Behavior_t *pointClass;
         beacon_Behavior_t *colorClass;
@@ -161,6 +182,7 @@ struct beacon_context_s
     struct ContextGCRoots
     {
         beacon_InternedSymbolSet_t *internedSymbolSet;
+        beacon_HashedCollection_t *literalFrameSet;
         beacon_MethodDictionary_t *systemDictionary;
         beacon_oop_t nilValue;
         beacon_oop_t trueValue;
@@ -196,11 +218,97 @@ struct beacon_context_s
         beacon_oop_t plusSelector;
         beacon_oop_t lessOrEqualsSelector;
 
-        beacon_MethodDictionary_t *windowHandleMap;
+        beacon_oop_t doSelector;
+        beacon_oop_t collectSelector;
+        beacon_oop_t selectSelector;
+        beacon_oop_t injectIntoSelector;
+
+        beacon_oop_t newSelector;
+        beacon_oop_t newWithSizeSelector;
+        beacon_oop_t addSelector;
+        beacon_oop_t asArraySelector;
+
+        beacon_oop_t renderSelector;
+        beacon_oop_t onExposeSelector;
+        beacon_oop_t onMouseButtonDownSelector;
+        beacon_oop_t onMouseButtonUpSelector;
+        beacon_oop_t onMouseMotionSelector;
+        beacon_oop_t onMouseWheelSelector;
+        beacon_oop_t onKeyPressedSelector;
+        beacon_oop_t onKeyReleasedSelector;
+        beacon_oop_t onTextInputSelector;
+        beacon_oop_t onSizeChangedSelector;
+        beacon_oop_t onCloseRequestSelector;
+
+        // The open windows, at the index of the window system identifier of their handle.
+        struct beacon_Array_s *windowTable;
+
+        // The event objects that are reused for the windows that do not keep their events. Created on their first use.
+        beacon_oop_t reusableExposeEvent;
+        beacon_oop_t reusableMouseButtonEvent;
+        beacon_oop_t reusableMouseMotionEvent;
+        beacon_oop_t reusableMouseWheelEvent;
+        beacon_oop_t reusableKeyboardEvent;
+        beacon_oop_t reusableTextInputEvent;
+
         struct beacon_AGPU_s *agpuCommon;
     } roots;
 
+    struct ContextOptions
+    {
+        // Inline do:, collect:, select: and inject:into: with literal blocks on Array and ArrayList receivers.
+        bool inlineCollectionIterationSelectors;
+
+        // Evaluate the top-level script statements by walking the parse tree instead of compiling them into bytecode.
+        bool evaluateScriptsWithAST;
+
+        // Number of invocations before a method is compiled into machine code. Zero disables the JIT.
+        size_t jitCompilationThreshold;
+
+        // Describe the machine code of the JIT compiled methods in /tmp/perf-<pid>.map, for perf.
+        bool writePerfMap;
+
+        // Directory where the compiled doits of the source files are cached. NULL disables the bytecode cache.
+        const char *bytecodeCacheDirectory;
+
+        // Number of threads used for scanning and parsing the files of SourceCode class>>fileInAll:. Zero uses one thread per processor.
+        size_t sourceParsingThreadCount;
+
+        // Install the methods of the loaded files as stubs that keep their source range, and compile them on their first invocation.
+        bool lazyMethodCompilation;
+
+        // Number of nested stack frame records above which a new activation signals StackOverflow.
+        size_t maxStackDepth;
+    } options;
+
+    // Records the methods that are installed while compiling the doits of the file that is being loaded.
+    beacon_BytecodeCacheWriter_t *bytecodeCacheWriter;
+
+    // The green threads. NULL until the first process is created.
+    struct beacon_ProcessScheduler_s *processScheduler;
+
+    // The timeouts of the delays and of the Timer objects. NULL until the first timer is scheduled.
+    struct beacon_TimerWheel_s *timerWheel;
+
+    // The channels that are referenced by this context, and the workers that it has started. NULL until the first channel is used.
+    struct beacon_WorkerRegistry_s *workerRegistry;
+
+    // The primitives that are running on the thread pool. NULL until the first one is started.
+    struct beacon_AsyncTasks_s *asyncTasks;
+
+    // The machine code of the JIT compiled methods. NULL until the first method is compiled.
+    struct beacon_JitCodeRegistry_s *jitCodeRegistry;
+
+    // Safepoints left until the next preemption check. Zero while there is a single process.
+    size_t preemptionCheckCountdown;
+
+    // Incremented whenever a method lookup result may have changed. Used for invalidating the inline caches.
+    uintptr_t methodLookupEpoch;
+
     beacon_MemoryHeap_t *heap;
+
+    // Guards the interned symbol set while the source files are parsed in parallel.
+    mtx_t internedSymbolSetMutex;
     
     void *userContextExtension;
 };
@@ -220,6 +328,11 @@ beacon_Symbol_t *beacon_internStringWithSize(beacon_context_t *context, size_t s
 beacon_Symbol_t *beacon_internCString(beacon_context_t *context, const char *string);
 beacon_Symbol_t *beacon_internString(beacon_context_t *context, beacon_String_t *string);
 
+/**
+ * Removes the symbols that were cleared by the garbage collector from the weak interned symbol set.
+ */
+void beacon_InternedSymbolSet_removeCollectedSymbols(beacon_context_t *context);
+
 beacon_Behavior_t *beacon_getClass(beacon_context_t *context, beacon_oop_t receiver);
 
 beacon_oop_t beacon_performWithArgumentsInSuperclass(beacon_context_t *context, beacon_oop_t receiver, beacon_oop_t selector, size_t argumentCount, beacon_oop_t *arguments, beacon_oop_t superclass);
@@ -229,12 +342,18 @@ beacon_oop_t beacon_performWith(beacon_context_t *context, beacon_oop_t receiver
 beacon_oop_t beacon_performWithWith(beacon_context_t *context, beacon_oop_t receiver, beacon_oop_t selector, beacon_oop_t firstArgument, beacon_oop_t secondArgument);
 
 beacon_oop_t beacon_runMethodWithArguments(beacon_context_t *context, beacon_CompiledCode_t *method, beacon_oop_t receiver, beacon_oop_t selector, size_t argumentCount, beacon_oop_t *arguments);
+beacon_oop_t beacon_runBlockClosureWithArguments(beacon_context_t *context, beacon_CompiledCode_t *blockClosureCode, beacon_oop_t receiver, beacon_oop_t captures, size_t argumentCount, beacon_oop_t *arguments);
 
 void beacon_addPrimitiveToClass(beacon_context_t *context, beacon_Behavior_t *behavior, const char *selector, size_t argumentCount, beacon_NativeCodeFunction_t primitive);
 
 beacon_oop_t beacon_boxExternalAddress(beacon_context_t *context, void *pointer);
 void *beacon_unboxExternalAddress(beacon_context_t *context, beacon_oop_t box);
 
+/**
+ * Prints the execution counters of the topCount hottest methods of the globally registered classes.
+ */
+void beacon_context_printHotMethods(beacon_context_t *context, FILE *output, size_t topCount);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,17 +9,34 @@
 extern "C" {
 #endif
 
+#if defined(_MSC_VER)
+#define BEACON_NORETURN __declspec(noreturn)
+#else
+#define BEACON_NORETURN __attribute__((noreturn))
+#endif
+
 typedef struct beacon_context_s beacon_context_t;
 typedef struct beacon_ScannerToken_s beacon_ScannerToken_t;
 
-void beacon_exception_signal(beacon_context_t *context, beacon_Exception_t *exception);
-
-void beacon_exception_error(beacon_context_t *context, const char *errorMessage);
-void beacon_exception_assertionFailure(beacon_context_t *context, const char *errorMessage);
-
-void beacon_exception_scannerError(beacon_context_t *context, beacon_ScannerToken_t *token);
-void beacon_exception_subclassResponsibility(beacon_context_t *context, beacon_oop_t receiver, beacon_oop_t selector);
-void beacon_exception_subclassResponsibility(beacon_context_t *context, beacon_oop_t receiver, beacon_oop_t selector);
+/**
+ * Signals the exception to the innermost on:do: handler that handles it. Returns the resumption value when the handler resumes it.
+ */
+beacon_oop_t beacon_exception_signal(beacon_context_t *context, beacon_Exception_t *exception);
+
+/**
+ * The errors raised by the VM never return to their caller. Resuming them returns the resumption value from the on:do: of their handler instead.
+ */
+BEACON_NORETURN void beacon_exception_error(beacon_context_t *context, const char *errorMessage);
+BEACON_NORETURN void beacon_exception_assertionFailure(beacon_context_t *context, const char *errorMessage);
+
+BEACON_NORETURN void beacon_exception_scannerError(beacon_context_t *context, beacon_ScannerToken_t *token);
+BEACON_NORETURN void beacon_exception_subclassResponsibility(beacon_context_t *context, beacon_oop_t receiver, beacon_oop_t selector);
+
+/**
+ * Called by an activation that exceeds the maximum stack depth or the native stack limit. Signals StackOverflow when the limit is crossed.
+ * Its handler, and the ensure blocks that it unwinds, may go deeper within a reserved depth and native stack size, beyond which the process is aborted.
+ */
+void beacon_exception_stackOverflow(beacon_context_t *context, size_t stackDepth, uintptr_t nativeStackAddress);
 
 #define BeaconAssertStringify_(s) #s
 #define BeaconAssertStringify(s) BeaconAssertStringify_(s)
@@ -0,0 +1,75 @@
+#ifndef BEACON_LANG_JIT_H
+#define BEACON_LANG_JIT_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+
+#define BEACON_JIT_DEFAULT_COMPILATION_THRESHOLD 100
+
+/**
+ * The interpreter state that is accessed by the machine code of a compiled method.
+ */
+typedef struct beacon_JitFrame_s
+{
+    beacon_context_t *context;
+    beacon_oop_t receiver;
+    beacon_oop_t *arguments;
+    beacon_oop_t *temporaries;
+    beacon_oop_t *captures;
+    beacon_oop_t *receiverSlots;
+    beacon_oop_t *decodedArguments;
+} beacon_JitFrame_t;
+
+typedef beacon_oop_t (*beacon_JitEntryPoint_t)(beacon_JitFrame_t *frame);
+
+/**
+ * Monomorphic inline cache used by a single send site.
+ */
+typedef struct beacon_JitInlineCache_s
+{
+    beacon_Behavior_t *behavior;
+    beacon_oop_t selector;
+    beacon_CompiledCode_t *method;
+    uintptr_t methodLookupEpoch;
+} beacon_JitInlineCache_t;
+
+typedef struct beacon_JitCompiledCode_s
+{
+    beacon_JitEntryPoint_t entryPoint;
+    size_t codeSize;
+    size_t requiredReceiverSlotCount;
+    size_t requiredCaptureCount;
+    size_t inlineCacheCount;
+    beacon_JitInlineCache_t *inlineCaches;
+} beacon_JitCompiledCode_t;
+
+/**
+ * Gets the machine code of the method if it is available.
+ * The method is compiled once its invocation counter reaches the compilation threshold.
+ * Returns NULL when the method has to be executed by the interpreter.
+ */
+beacon_JitCompiledCode_t *beacon_jit_getCompiledCodeFor(beacon_context_t *context, beacon_CompiledCode_t *method);
+
+/**
+ * Frees the machine code of the methods whose bytecode was not marked by the garbage collector. Called before the sweep.
+ */
+void beacon_jit_releaseCollectedCode(beacon_context_t *context);
+
+/**
+ * Frees the machine code of every method that was compiled by the context.
+ */
+void beacon_jit_destroy(beacon_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_JIT_H
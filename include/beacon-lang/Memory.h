@@ -5,6 +5,7 @@
 
 #include "ObjectModel.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <setjmp.h>
 
 #ifdef __cplusplus
@@ -13,6 +14,11 @@ extern "C" {
 
 typedef struct beacon_context_s beacon_context_t;
 
+#define BEACON_DEFAULT_MAX_STACK_DEPTH 10000
+#define BEACON_STACK_OVERFLOW_RESERVED_DEPTH 1000
+#define BEACON_NATIVE_STACK_GUARD_SIZE (64u << 10)
+#define BEACON_NATIVE_STACK_OVERFLOW_RESERVED_SIZE (512u << 10)
+
 typedef struct beacon_MemoryAllocationHeader_s beacon_MemoryAllocationHeader_t;
 
 typedef struct beacon_MemoryAllocationHeader_s
@@ -44,13 +50,22 @@ typedef enum beacon_StackFrameRecordKind_e
     StackFramePrimitiveRoots,
     StackFrameEnsure,
     StackFrameOnDo,
+    StackFrameExceptionHandler,
 } beacon_StackFrameRecordKind_t;
 
+typedef enum beacon_StackFrameOnDoJump_e
+{
+    StackFrameOnDoJumpNone = 0,
+    StackFrameOnDoJumpReturn,
+    StackFrameOnDoJumpRetry,
+} beacon_StackFrameOnDoJump_t;
+
 typedef struct beacon_StackFrameRecord_s
 {
     struct beacon_StackFrameRecord_s *previousRecord;
     struct beacon_context_s *context;
     beacon_StackFrameRecordKind_t kind;
+    size_t depth;
     union
     {
         struct
@@ -91,6 +106,7 @@ typedef struct beacon_StackFrameRecord_s
             beacon_oop_t ensureReceiver;
             beacon_oop_t ensureBlock;
             beacon_oop_t resultValue;
+            bool ensureBlockActivated;
         } ensure;
         
         struct
@@ -102,6 +118,15 @@ typedef struct beacon_StackFrameRecord_s
             beacon_oop_t exception;
             jmp_buf handlerJumpBuffer;
         } onDo;
+
+        struct
+        {
+            beacon_oop_t exception;
+            struct beacon_StackFrameRecord_s *handlerRecord;
+            beacon_oop_t resumptionValue;
+            bool isResumable;
+            jmp_buf resumptionJumpBuffer;
+        } exceptionHandler;
     };
 } beacon_StackFrameRecord_t;
 
@@ -109,6 +134,40 @@ beacon_StackFrameRecord_t *beacon_getTopStackFrameRecord();
 void beacon_pushStackFrameRecord(beacon_StackFrameRecord_t *record);
 void beacon_popStackFrameRecord(beacon_StackFrameRecord_t *record);
 
+/**
+ * Drops every record above the given one. This is used before unwinding the stack with a longjmp.
+ * The pending ensure blocks of the dropped records are run first, from the innermost one.
+ */
+void beacon_unwindStackFrameRecordsUntil(beacon_StackFrameRecord_t *record);
+
+/**
+ * Returns the lowest address that the native stack of the current thread may reach before an activation signals StackOverflow.
+ * This leaves BEACON_NATIVE_STACK_OVERFLOW_RESERVED_SIZE bytes for the handler, above a BEACON_NATIVE_STACK_GUARD_SIZE guard.
+ * Returns zero when the bounds of the native stack are not known.
+ */
+uintptr_t beacon_getNativeStackLimit(void);
+
+/**
+ * The depth of the stack where StackOverflow was signaled, while its handler runs on top of the overflowing stack. Zero otherwise.
+ * Unwinding below this depth resets it.
+ */
+size_t beacon_getStackOverflowHandlingDepth(void);
+void beacon_setStackOverflowHandlingDepth(size_t depth);
+
+/**
+ * The thread local state of a stack of frame records. The processes save it and restore it when they switch their native stacks.
+ */
+typedef struct beacon_StackState_s
+{
+    beacon_StackFrameRecord_t *topStackFrameRecord;
+    uintptr_t nativeStackLimit;
+    bool nativeStackLimitIsComputed;
+    size_t stackOverflowHandlingDepth;
+} beacon_StackState_t;
+
+void beacon_saveStackState(beacon_StackState_t *state);
+void beacon_restoreStackState(const beacon_StackState_t *state);
+
 beacon_MemoryHeap_t *beacon_createMemoryHeap(beacon_context_t *context);
 void beacon_destroyMemoryHeap(beacon_MemoryHeap_t *heap);
 
@@ -116,6 +175,32 @@ void beacon_memoryHeapDisableGC(beacon_MemoryHeap_t *heap);
 void beacon_memoryHeapEnableGC(beacon_MemoryHeap_t *heap);
 void beacon_memoryHeapSafepoint(beacon_context_t *context);
 
+/**
+ * Marks an object as reachable during the mark phase of the garbage collector.
+ */
+void beacon_heap_pushReachableObject(beacon_MemoryHeap_t *heap, beacon_oop_t object);
+
+/**
+ * Marks the objects that are referenced by a chain of stack frame records.
+ */
+void beacon_garbageCollect_markStackFrameRecords(beacon_context_t *context, beacon_StackFrameRecord_t *topRecord);
+
+/**
+ * Creates an arena for allocating objects from a worker thread, without synchronizing with the heap.
+ * The arena is never garbage collected, and its objects become part of the heap when it is merged.
+ */
+beacon_MemoryHeap_t *beacon_createMemoryArena(beacon_MemoryHeap_t *heap);
+
+/**
+ * Redirects the allocations performed by the current thread into the arena. NULL restores the normal allocations.
+ */
+void beacon_setThreadLocalMemoryArena(beacon_MemoryHeap_t *arena);
+
+/**
+ * Moves the objects of the arena into the heap, and destroys the arena. The heap must not be collected between the creation of the arena and this call.
+ */
+void beacon_mergeMemoryArenaIntoHeap(beacon_MemoryHeap_t *heap, beacon_MemoryHeap_t *arena);
+
 void *beacon_allocateObject(beacon_MemoryHeap_t *heap, size_t size, beacon_ObjectKind_t kind);
 void *beacon_allocateObjectWithBehavior(beacon_MemoryHeap_t *heap, beacon_Behavior_t *behavior, size_t size, beacon_ObjectKind_t kind);
 
@@ -184,6 +184,15 @@ typedef struct beacon_NativeCode_s
     beacon_NativeCodeFunction_t nativeFunction;
 } beacon_NativeCode_t;
 
+typedef enum beacon_QuickMethodKind_e
+{
+    BeaconQuickMethodNone = 0,
+    BeaconQuickMethodReturnSelf,
+    BeaconQuickMethodReturnLiteral,
+    BeaconQuickMethodReturnInstanceVariable,
+    BeaconQuickMethodSetInstanceVariable,
+} beacon_QuickMethodKind_t;
+
 typedef struct beacon_CompiledCode_s
 {
     beacon_Object_t super;
@@ -191,12 +200,15 @@ typedef struct beacon_CompiledCode_s
     beacon_NativeCode_t *nativeImplementation;
     struct beacon_BytecodeCode_s *bytecodeImplementation;
     struct beacon_SourcePosition_s *sourcePosition;
+    beacon_oop_t quickMethodKind;
+    beacon_oop_t quickMethodValue;
 } beacon_CompiledCode_t;
 
 typedef struct beacon_CompiledMethod_s
 {
     beacon_CompiledCode_t super;
     beacon_Symbol_t *name;
+    struct beacon_AbstractCompilationEnvironment_s *lazyCompilationEnvironment;
 } beacon_CompiledMethod_t;
 
 typedef struct beacon_CompiledBlock_s
@@ -210,6 +222,7 @@ typedef struct beacon_BlockClosure_s
     beacon_Object_t super;
     beacon_CompiledBlock_t *code;
     beacon_oop_t captures;
+    beacon_oop_t receiver;
 } beacon_BlockClosure_t;
 
 typedef struct beacon_Message_s
@@ -222,6 +235,10 @@ typedef struct beacon_Message_s
 typedef struct beacon_InternedSymbolSet_s
 {
     beacon_HashedCollection_t super;
+
+    // Storage that was replaced by a growth, and whose symbols are still being moved into the current array.
+    struct beacon_Array_s *oldArray;
+    beacon_oop_t oldArrayMigrationIndex;
 } beacon_InternedSymbolSet_t;
 
 typedef struct beacon_Slot_s
@@ -337,6 +354,10 @@ typedef struct beacon_BytecodeCode_s
     beacon_oop_t captureCount;
     beacon_Array_t *literals;
     beacon_ByteArray_t *bytecodes;
+    beacon_oop_t invocationCount;
+    beacon_oop_t backwardJumpCount;
+    beacon_oop_t sendCount;
+    beacon_oop_t jitCompiledCode;
 } beacon_BytecodeCode_t;
 
 typedef struct beacon_String_s
@@ -413,6 +434,7 @@ typedef struct beacon_SourceCode_s
     beacon_String_t *name;
     beacon_String_t *text;
     beacon_oop_t textSize;
+    beacon_UInt32Array_t *lineStartIndices;
 }beacon_SourceCode_t;
 
 typedef struct beacon_SourcePosition_s
@@ -573,6 +595,7 @@ typedef struct beacon_BytecodeCodeBuilder_t
     beacon_ArrayList_t *captures;
     beacon_ByteArrayList_t *bytecodes;
     beacon_oop_t parentBuilder;
+    beacon_Array_t *literalIndexTable;
 } beacon_BytecodeCodeBuilder_t;
 
 typedef struct beacon_AbstractCompilationEnvironment_s
@@ -612,6 +635,7 @@ typedef struct beacon_BlockClosureCompilationEnvironment_s
     beacon_AbstractCompilationEnvironment_t *parent;
     beacon_ArrayList_t *captureList;
     beacon_MethodDictionary_t *dictionary;
+    beacon_oop_t usesReceiverSlots;
 } beacon_BlockClosureCompilationEnvironment_t;
 
 typedef struct beacon_MethodCompilationEnvironment_s
@@ -662,6 +686,11 @@ typedef struct beacon_NonBooleanReceiver_s
     beacon_Error_t super;
 } beacon_NonBooleanReceiver_t;
 
+typedef struct beacon_StackOverflow_s
+{
+    beacon_Error_t super;
+} beacon_StackOverflow_t;
+
 typedef struct beacon_UnhandledException_s
 {
     beacon_Exception_t super;
@@ -682,6 +711,66 @@ typedef struct beacon_Stdio_s
     beacon_Object_t super;
 } beacon_Stdio_t;
 
+typedef struct beacon_Time_s
+{
+    beacon_Object_t super;
+} beacon_Time_t;
+
+typedef struct beacon_Process_s
+{
+    beacon_Object_t super;
+    beacon_oop_t nextLink;
+    beacon_oop_t block;
+    beacon_oop_t priority;
+    beacon_oop_t name;
+    beacon_oop_t myList;
+    beacon_oop_t handle;
+    beacon_oop_t isTerminated;
+} beacon_Process_t;
+
+typedef struct beacon_Semaphore_s
+{
+    beacon_Object_t super;
+    beacon_oop_t firstLink;
+    beacon_oop_t lastLink;
+    beacon_oop_t excessSignals;
+} beacon_Semaphore_t;
+
+typedef struct beacon_Processor_s
+{
+    beacon_Object_t super;
+} beacon_Processor_t;
+
+typedef struct beacon_Timer_s
+{
+    beacon_Object_t super;
+    beacon_oop_t handle;
+    beacon_oop_t semaphore;
+    beacon_oop_t block;
+} beacon_Timer_t;
+
+typedef struct beacon_Channel_s
+{
+    beacon_Object_t super;
+    beacon_oop_t handle;
+} beacon_Channel_t;
+
+typedef struct beacon_Worker_s
+{
+    beacon_Object_t super;
+    beacon_oop_t handle;
+    beacon_oop_t channel;
+} beacon_Worker_t;
+
+typedef struct beacon_Future_s
+{
+    beacon_Object_t super;
+    beacon_oop_t value;
+    beacon_oop_t error;
+    beacon_oop_t isDone;
+    beacon_oop_t semaphore;
+} beacon_Future_t;
+
 typedef struct beacon_Stream_s
 {
     beacon_Object_t super;
@@ -819,6 +908,8 @@ typedef struct beacon_Window_s
 
     beacon_oop_t useAcceleratedRendering;
     struct beacon_AGPUSwapChain_s *swapChainHandle;
+    beacon_oop_t needsRedraw;
+    beacon_oop_t reusesEvents;
 } beacon_Window_t;
 
 typedef struct beacon_WindowEvent_s
@@ -10,6 +10,19 @@
 extern "C" {
 #endif
 
+beacon_ParseTreeNode_t *beacon_parseWorkspaceTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer);
+beacon_ParseTreeNode_t *beacon_parseMethodTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer);
+
+/**
+ * Parses a source file that is being filed in. With lazy method compilation, the bodies of the method blocks are skipped, and only their headers and source positions are kept.
+ */
+beacon_ParseTreeNode_t *beacon_parseFileTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer);
+
+/**
+ * Parses a single method block, such as the tokens of the source range of a lazily compiled method.
+ */
+beacon_ParseTreeNode_t *beacon_parseMethodBlockTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer);
+
 beacon_ParseTreeNode_t *beacon_parseWorkspaceTokenList(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_ArrayList_t *tokenList);
 beacon_ParseTreeNode_t *beacon_parseMethodTokenList(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_ArrayList_t *tokenList);
 
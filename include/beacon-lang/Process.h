@@ -0,0 +1,66 @@
+#ifndef BEACON_LANG_PROCESS_H
+#define BEACON_LANG_PROCESS_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+typedef struct beacon_ProcessScheduler_s beacon_ProcessScheduler_t;
+
+#define BEACON_PROCESS_PRIORITY_COUNT 8
+#define BEACON_PROCESS_DEFAULT_PRIORITY 4
+#define BEACON_PROCESS_NATIVE_STACK_SIZE (8u << 20)
+#define BEACON_PROCESS_PREEMPTION_CHECK_INTERVAL 1024
+#define BEACON_PROCESS_TIME_SLICE_MICROSECONDS 10000
+
+/**
+ * Checks for the expired delays and for the end of the time slice of the active process. Called from the heap safepoints, every BEACON_PROCESS_PREEMPTION_CHECK_INTERVAL of them while there are other processes.
+ * The active process is preempted by a higher priority runnable process, and it is moved behind the runnable processes of its own priority when its time slice is over.
+ */
+void beacon_ProcessScheduler_preemptionCheck(beacon_context_t *context);
+
+/**
+ * Returns the microseconds that a main loop may block waiting for window system events: until the next timer expires,
+ * zero when a process that the main loop lets run is runnable, or -1 when nothing but an event can wake it up.
+ */
+int64_t beacon_ProcessScheduler_idleTimeout(beacon_context_t *context);
+
+/**
+ * Called by a main loop that would block for the given idle timeout. When processes of a lower priority are runnable, they run
+ * while the main loop sleeps for one time slice at most, or until the timeout, and true is returned. The main loop then checks
+ * its events again. Returns false when nothing else can run, so that the main loop blocks waiting for its events.
+ */
+bool beacon_ProcessScheduler_runLowerPriorityProcesses(beacon_context_t *context, int64_t idleTimeout);
+
+/**
+ * Lets the other runnable processes of the same or higher priority run, wakes the expired delays, and completes the futures of the finished thread pool tasks. The main loops call this on each iteration.
+ */
+void beacon_ProcessScheduler_yield(beacon_context_t *context);
+
+/**
+ * Signals a semaphore from native code that cannot switch processes, such as the callbacks of the timers. A woken process of higher priority only runs at the next preemption check.
+ */
+void beacon_Semaphore_signalWithoutPreemption(beacon_context_t *context, beacon_oop_t semaphore);
+
+/**
+ * Marks the process objects, and the stack frame records of the processes that are not running.
+ */
+void beacon_ProcessScheduler_markRoots(beacon_context_t *context);
+
+/**
+ * Frees the native stacks of the processes.
+ */
+void beacon_ProcessScheduler_destroy(beacon_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_PROCESS_H
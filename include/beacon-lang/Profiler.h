@@ -0,0 +1,55 @@
+#ifndef BEACON_LANG_PROFILER_H
+#define BEACON_LANG_PROFILER_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+
+#define BEACON_PROFILER_DEFAULT_SAMPLING_INTERVAL_MICROSECONDS 1000
+#define BEACON_PROFILER_SAMPLE_BUFFER_SIZE (16u << 20)
+#define BEACON_PROFILER_MAX_SAMPLED_FRAMES 256
+#define BEACON_PROFILER_ALTERNATE_SIGNAL_STACK_SIZE (64u << 10)
+#define BEACON_PROFILER_MAX_CRASH_REPORT_FRAMES 32
+
+/**
+ * Appends an entry for a range of generated machine code to /tmp/perf-<pid>.map, so that perf can attribute its samples to the Smalltalk method.
+ */
+void beacon_Profiler_recordGeneratedCode(beacon_context_t *context, beacon_CompiledCode_t *code, const void *codeStart, size_t codeSize);
+
+/**
+ * Starts sampling the stack of the calling thread with a CPU time timer. Each sample records the methods of the bytecode method stack frame records, and the classes of their receivers.
+ * Returns false when sampling is not supported by the platform, or when it is already running.
+ */
+bool beacon_Profiler_startSampling(beacon_context_t *context, size_t intervalMicroseconds);
+
+/**
+ * Stops sampling, and writes one line per distinct stack with its sample count. This is the folded stack format that is read by flamegraph.pl and similar tools.
+ */
+void beacon_Profiler_stopSamplingAndWriteFoldedStacks(beacon_context_t *context, FILE *output);
+
+/**
+ * Installs an alternate signal stack on the calling thread, and a handler for the segmentation faults and bus errors that writes the innermost Smalltalk frames before crashing.
+ * This reports the native stack overflows that are missed by the stack guard of the activations, such as a deep recursion inside of a primitive.
+ * Returns false when it is not supported by the platform.
+ */
+bool beacon_Profiler_installCrashHandler(beacon_context_t *context);
+
+/**
+ * Closes the perf map file.
+ */
+void beacon_Profiler_shutdown(beacon_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_PROFILER_H
@@ -4,6 +4,8 @@
 #pragma once
 
 #include "ObjectModel.h"
+#include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +22,58 @@ typedef enum beacon_TokenKind_e {
 } beacon_TokenKind_t;
 
 
+typedef struct beacon_TokenBufferError_s
+{
+    size_t tokenIndex;
+    const char *message;
+    size_t messageSize;
+} beacon_TokenBufferError_t;
+
+/**
+ * Packed scanned tokens. Each token is described by its kind and by the start and end indices of its text,
+ * and the lines and columns are only computed from the indices when a source position needs them.
+ */
+typedef struct beacon_TokenBuffer_s
+{
+    beacon_SourceCode_t *sourceCode;
+    size_t size;
+    size_t capacity;
+    uint8_t *kinds;
+    uint32_t *startIndices;
+    uint32_t *endIndices;
+
+    size_t errorCount;
+    size_t errorCapacity;
+    beacon_TokenBufferError_t *errors;
+} beacon_TokenBuffer_t;
+
+void beacon_TokenBuffer_initialize(beacon_TokenBuffer_t *buffer, beacon_SourceCode_t *sourceCode);
+void beacon_TokenBuffer_destroy(beacon_TokenBuffer_t *buffer);
+void beacon_TokenBuffer_add(beacon_TokenBuffer_t *buffer, beacon_TokenKind_t kind, size_t startIndex, size_t endIndex);
+void beacon_TokenBuffer_addError(beacon_TokenBuffer_t *buffer, size_t startIndex, size_t endIndex, const char *message, size_t messageSize);
+
+/**
+ * Gets the error message of an error token.
+ */
+const beacon_TokenBufferError_t *beacon_TokenBuffer_getError(beacon_TokenBuffer_t *buffer, size_t tokenIndex);
+
+/**
+ * Makes a scanner token object, for the tools that inspect the tokens from the image.
+ */
+beacon_ScannerToken_t *beacon_TokenBuffer_makeToken(beacon_context_t *context, beacon_TokenBuffer_t *buffer, size_t tokenIndex);
+
+/**
+ * Converts a list of scanner token objects back into a packed token buffer.
+ */
+void beacon_TokenBuffer_addTokenList(beacon_context_t *context, beacon_TokenBuffer_t *buffer, beacon_ArrayList_t *tokenList);
+
+void beacon_scanSourceCodeIntoTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *buffer);
+
+/**
+ * Scans only the text between the given indices, such as the source range of a single method.
+ */
+void beacon_scanSourceCodeRangeIntoTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t startIndex, size_t endIndex, beacon_TokenBuffer_t *buffer);
+
 beacon_ArrayList_t *beacon_scanSourceCode(beacon_context_t *context, beacon_SourceCode_t *sourceCode);
 
 const char *beacon_TokenKind_toString(beacon_TokenKind_t);
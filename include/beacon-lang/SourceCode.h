@@ -4,6 +4,7 @@
 #pragma once
 
 #include "ObjectModel.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,11 +15,24 @@ typedef struct beacon_context_s beacon_context_t;
 beacon_SourceCode_t *beacon_makeSourceCodeFromFileNamed(beacon_context_t *context, const char *fileName);
 beacon_SourceCode_t *beacon_makeSourceCodeFromString(beacon_context_t *context,const char *name, const char *string);
 
+beacon_SourcePosition_t *beacon_makeSourcePosition(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t startIndex, size_t endIndex);
+
+/**
+ * Fills the lines and columns of a source position, which are computed lazily from its start and end indices.
+ */
+void beacon_SourcePosition_computeLinesAndColumns(beacon_context_t *context, beacon_SourcePosition_t *sourcePosition);
+
 beacon_SourcePosition_t *beacon_sourcePosition_to(beacon_context_t *context, beacon_SourcePosition_t *start, beacon_SourcePosition_t *end);
 beacon_SourcePosition_t *beacon_sourcePosition_until(beacon_context_t *context, beacon_SourcePosition_t *start, beacon_SourcePosition_t *end);
 
 beacon_oop_t beacon_evaluateSourceCode(beacon_context_t *context, beacon_SourceCode_t *sourceCode);
 
+/**
+ * Loads several source files. The files are scanned and parsed in parallel, and then they are evaluated in order.
+ * Returns the result of evaluating the last file.
+ */
+beacon_oop_t beacon_evaluateSourceCodeFiles(beacon_context_t *context, size_t fileCount, const char **fileNames);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,6 +6,7 @@
 #include "ObjectModel.h"
 #include "Parser.h"
 #include "Bytecode.h"
+#include "BytecodeCache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +15,31 @@ extern "C" {
 beacon_CompiledMethod_t *beacon_compileFileSyntax(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode);
 beacon_oop_t beacon_evaluateFileSyntax(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode);
 
+/**
+ * Runs the doits of a file that are stored in the bytecode cache, without scanning and parsing its source.
+ */
+beacon_oop_t beacon_evaluateCachedFileSyntax(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_BytecodeCacheReader_t *cacheReader);
+
+/**
+ * Compiles the methods that are defined by a file without installing them. Returns the number of compiled methods.
+ */
+size_t beacon_compileFileSyntaxMethods(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode);
+
+/**
+ * Makes a method stub that keeps the source range of a method of the given behavior, which is defined in a file. The stub is compiled by its first invocation.
+ */
+beacon_CompiledMethod_t *beacon_makeLazyMethod(beacon_context_t *context, beacon_Symbol_t *selector, size_t argumentCount, beacon_SourcePosition_t *sourcePosition, beacon_Behavior_t *behavior);
+
+/**
+ * Is this a method stub that has not been compiled yet?
+ */
+bool beacon_isLazyMethod(beacon_context_t *context, beacon_CompiledCode_t *code);
+
+/**
+ * Parses and compiles the source range of a method stub, and stores the resulting bytecode in the same method object.
+ */
+void beacon_compileLazyMethod(beacon_context_t *context, beacon_CompiledMethod_t *lazyMethod);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,105 @@
+#ifndef BEACON_LANG_THREAD_POOL_H
+#define BEACON_LANG_THREAD_POOL_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+typedef struct beacon_AsyncTask_s beacon_AsyncTask_t;
+typedef struct beacon_AsyncTasks_s beacon_AsyncTasks_t;
+
+typedef void (*beacon_AsyncTaskRunFunction_t)(beacon_AsyncTask_t *task);
+typedef beacon_oop_t (*beacon_AsyncTaskCompleteFunction_t)(beacon_context_t *context, beacon_AsyncTask_t *task);
+typedef void (*beacon_AsyncTaskDestroyFunction_t)(beacon_AsyncTask_t *task);
+typedef void (*beacon_AsyncTasksWakeUpFunction_t)(beacon_context_t *context);
+
+/**
+ * A piece of work of a primitive that runs on the thread pool, and whose result is given by a Future.
+ * It is embedded at the start of a structure that holds the native buffers of the work.
+ */
+struct beacon_AsyncTask_s
+{
+    // Runs on a thread of the pool. It must not allocate objects, and it may only use the bytes of the objects in roots. NULL for the tasks that are finished by beacon_AsyncTask_finish.
+    beacon_AsyncTaskRunFunction_t run;
+
+    // Runs on the thread of the context once the work is done, and returns the value of the future. NULL gives nil.
+    beacon_AsyncTaskCompleteFunction_t complete;
+
+    // Frees the structure and its buffers. NULL uses free.
+    beacon_AsyncTaskDestroyFunction_t destroy;
+
+    // Set by run or by complete for failing the future with an error, instead of completing it.
+    const char *errorMessage;
+
+    // Kept alive until the task is complete, so that the garbage collector does not free their bytes.
+    beacon_oop_t roots[2];
+
+    beacon_context_t *context;
+    beacon_oop_t future;
+    beacon_AsyncTask_t *previousInContext;
+    beacon_AsyncTask_t *nextInContext;
+    beacon_AsyncTask_t *nextInQueue;
+};
+
+/**
+ * Returns the number of processors that are available for running threads.
+ */
+size_t beacon_getProcessorCount(void);
+
+/**
+ * Queues a task in the thread pool, which is shared by every context of the process. Returns the Future of its result.
+ */
+beacon_oop_t beacon_AsyncTask_start(beacon_context_t *context, beacon_AsyncTask_t *task);
+
+/**
+ * Registers a task whose work is done outside of the thread pool, such as waiting for the message of a channel, and returns its Future.
+ * The task stays running until it is given to beacon_AsyncTask_finish.
+ */
+beacon_oop_t beacon_AsyncTask_startWaiting(beacon_context_t *context, beacon_AsyncTask_t *task);
+
+/**
+ * Queues a running task for its completion on the thread of its context, and wakes up the context. This may be called from any thread.
+ */
+void beacon_AsyncTask_finish(beacon_AsyncTask_t *task);
+
+/**
+ * Completes the futures of the tasks that have finished running, and wakes up the processes that wait for them.
+ * This does not run any code of the image, so the scheduler calls it when it looks for a process to run.
+ */
+void beacon_AsyncTasks_completeFinished(beacon_context_t *context);
+
+/**
+ * Waits until a task of the context finishes running, for at most the given time. A negative time waits without limit.
+ * Returns false without waiting when the context has no running task.
+ */
+bool beacon_AsyncTasks_waitForFinished(beacon_context_t *context, int64_t timeoutMicroseconds);
+
+/**
+ * Sets the function that a thread of the pool calls after finishing a task of the context, or NULL for none.
+ * A main loop that blocks waiting for window system events uses it for waking itself up.
+ */
+void beacon_AsyncTasks_setWakeUpFunction(beacon_context_t *context, beacon_AsyncTasksWakeUpFunction_t wakeUpFunction);
+
+/**
+ * Marks the futures and the roots of the tasks that are not complete.
+ */
+void beacon_AsyncTasks_markRoots(beacon_context_t *context);
+
+/**
+ * Waits for the running tasks of the context, and frees them without completing their futures.
+ */
+void beacon_AsyncTasks_destroy(beacon_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_THREAD_POOL_H
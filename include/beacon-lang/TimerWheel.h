@@ -0,0 +1,117 @@
+#ifndef BEACON_LANG_TIMER_WHEEL_H
+#define BEACON_LANG_TIMER_WHEEL_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+typedef struct beacon_TimerWheel_s beacon_TimerWheel_t;
+typedef struct beacon_TimerWheelSlot_s beacon_TimerWheelSlot_t;
+typedef struct beacon_TimerWheelEntry_s beacon_TimerWheelEntry_t;
+
+// Each level has 256 slots, and the slots of a level span the whole level below it. The tick is one microsecond.
+#define BEACON_TIMER_WHEEL_LEVEL_COUNT 4
+#define BEACON_TIMER_WHEEL_SLOT_BITS 8
+#define BEACON_TIMER_WHEEL_SLOT_COUNT (1 << BEACON_TIMER_WHEEL_SLOT_BITS)
+
+typedef void (*beacon_TimerWheelCallback_t)(beacon_context_t *context, beacon_TimerWheelEntry_t *entry);
+
+/**
+ * A timer that is embedded in the structure that it wakes up. The callback is called by beacon_TimerWheel_advance, so it must not switch processes.
+ */
+struct beacon_TimerWheelEntry_s
+{
+    beacon_TimerWheelEntry_t *previous;
+    beacon_TimerWheelEntry_t *next;
+    beacon_TimerWheelSlot_t *slot;
+    uint64_t expirationTime;
+    beacon_TimerWheelCallback_t callback;
+
+    // Marked by the garbage collector while the timer is scheduled.
+    beacon_oop_t owner;
+};
+
+// The timers of a slot keep the order in which they were added.
+struct beacon_TimerWheelSlot_s
+{
+    beacon_TimerWheelEntry_t *first;
+    beacon_TimerWheelEntry_t *last;
+};
+
+struct beacon_TimerWheel_s
+{
+    uint64_t currentTime;
+    size_t timerCount;
+    beacon_TimerWheelSlot_t slots[BEACON_TIMER_WHEEL_LEVEL_COUNT][BEACON_TIMER_WHEEL_SLOT_COUNT];
+    uint64_t occupiedSlots[BEACON_TIMER_WHEEL_LEVEL_COUNT][BEACON_TIMER_WHEEL_SLOT_COUNT / 64];
+
+    // The timers that are further away than the span of the top level. They are placed again when it wraps around.
+    beacon_TimerWheelSlot_t overflow;
+
+    // The timers that were already due when they were scheduled.
+    beacon_TimerWheelSlot_t expired;
+
+    // The fired timers of the blocks, which wait for the main loop to run them.
+    beacon_TimerWheelSlot_t firedBlocks;
+};
+
+/**
+ * Returns the time of a monotonic clock, in nanoseconds.
+ */
+uint64_t beacon_getMonotonicClockNanoseconds(void);
+
+/**
+ * Returns the time of the monotonic clock, in the microseconds that are used by the timer wheel.
+ */
+uint64_t beacon_getMonotonicClockMicroseconds(void);
+
+/**
+ * Returns the timer wheel of the context, and creates it on first use.
+ */
+beacon_TimerWheel_t *beacon_TimerWheel_get(beacon_context_t *context);
+
+/**
+ * Schedules a timer for a monotonic clock time in microseconds. This is O(1).
+ */
+void beacon_TimerWheel_schedule(beacon_TimerWheel_t *wheel, beacon_TimerWheelEntry_t *entry, uint64_t expirationTime);
+
+/**
+ * Removes a timer that is scheduled, or that is waiting for the main loop. This is O(1).
+ */
+void beacon_TimerWheel_cancel(beacon_TimerWheel_t *wheel, beacon_TimerWheelEntry_t *entry);
+
+/**
+ * Fires the timers that have expired by the current time. Only the slots that hold timers are visited, so idle time costs nothing.
+ */
+void beacon_TimerWheel_advance(beacon_context_t *context);
+
+/**
+ * Returns the earliest time at which advancing the wheel may fire a timer, or false when there are no timers.
+ */
+bool beacon_TimerWheel_nextWakeUpTime(beacon_TimerWheel_t *wheel, uint64_t *outTime);
+
+/**
+ * Advances the wheel, and runs the blocks of the fired timers. The main loops call this on each iteration.
+ */
+void beacon_TimerWheel_runFiredTimers(beacon_context_t *context);
+
+/**
+ * Marks the owners of the scheduled timers.
+ */
+void beacon_TimerWheel_markRoots(beacon_context_t *context);
+
+void beacon_TimerWheel_destroy(beacon_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_TIMER_WHEEL_H
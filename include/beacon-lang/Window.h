@@ -2,6 +2,8 @@
 #define BEACON_LANG_WINDOW_HPP
 
 #include "ObjectModel.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 #pragma once
 
@@ -9,6 +11,36 @@
 extern "C" {
 #endif
 
+typedef struct beacon_context_s beacon_context_t;
+
+/**
+ * Stores a window in the window table, at the index that the window system gives to its handle. The SDL2 window identifiers are small consecutive integers,
+ * and the X11 ones are masked by the resource identifier mask of the connection.
+ */
+void beacon_Window_registerHandle(beacon_context_t *context, beacon_Window_t *window, uint32_t windowIndex);
+
+/**
+ * Removes a closed window from the window table.
+ */
+void beacon_Window_unregisterHandle(beacon_context_t *context, uint32_t windowIndex);
+
+/**
+ * Returns the window at an index of the window table, or NULL.
+ */
+beacon_Window_t *beacon_Window_fromHandle(beacon_context_t *context, uint32_t windowIndex);
+
+/**
+ * Sends render to the windows that have been invalidated since their last redraw. The main loops call this once they have dispatched the pending events.
+ * Returns true when a window has been invalidated again while rendering, so the main loop should not block.
+ */
+bool beacon_Window_renderInvalidWindows(beacon_context_t *context);
+
+/**
+ * Returns the event object that is dispatched to a window. The windows whose reusesEvents slot is true get the same event object
+ * of each kind again and again, so they must copy what they need out of it.
+ */
+void *beacon_Window_makeEvent(beacon_context_t *context, beacon_Window_t *window, beacon_oop_t *reusableEvent, beacon_Behavior_t *eventClass, size_t eventSize);
+
 #ifdef __cplusplus
 }
 #endif
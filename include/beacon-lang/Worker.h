@@ -0,0 +1,40 @@
+#ifndef BEACON_LANG_WORKER_H
+#define BEACON_LANG_WORKER_H
+
+#pragma once
+
+#include "ObjectModel.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beacon_context_s beacon_context_t;
+typedef struct beacon_NativeChannel_s beacon_NativeChannel_t;
+typedef struct beacon_WorkerRegistry_s beacon_WorkerRegistry_t;
+
+/**
+ * Queues a copy of an object graph in a channel. Any context may send and receive through a channel, from any thread.
+ * The symbols, the classes, true, false and the channels are sent by name or by identity, and the other objects are copied.
+ * Signals an error for the objects that cannot leave their heap, such as the blocks, the processes and the external addresses.
+ */
+void beacon_NativeChannel_send(beacon_context_t *context, beacon_NativeChannel_t *channel, beacon_oop_t object);
+
+/**
+ * Returns a Future of the oldest message of a channel, which is copied into the heap of the context. The classes are looked up by name in the receiving context.
+ * When the channel is empty, the future is done by the next send. Only the processes that wait for the future are blocked, and not the thread of the context.
+ */
+beacon_oop_t beacon_NativeChannel_receiveAsync(beacon_context_t *context, beacon_NativeChannel_t *channel);
+
+/**
+ * Joins the workers that were started by the context, and releases the channels that it references.
+ */
+void beacon_WorkerRegistry_destroy(beacon_context_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BEACON_LANG_WORKER_H
@@ -2,8 +2,10 @@
 #include "beacon-lang/Context.h"
 #include "beacon-lang/ArrayList.h"
 #include "beacon-lang/Exceptions.h"
+#include "beacon-lang/Jit.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 static inline bool beacon_bytecodeWritesToTemporary(beacon_BytecodeOpcode_t opcode)
 {
@@ -14,6 +16,7 @@ static inline bool beacon_bytecodeWritesToTemporary(beacon_BytecodeOpcode_t opco
     case BeaconBytecodeStoreValue:
     case BeaconBytecodeMakeArray:
     case BeaconBytecodeMakeClosureInstance:
+    case BeaconBytecodeInlinedPrimitive:
         return true;
     default:
         return false;
@@ -37,25 +40,228 @@ beacon_BytecodeCode_t *beacon_BytecodeCodeBuilder_finish(beacon_context_t *conte
     beacon_BytecodeCode_t *code = beacon_allocateObjectWithBehavior(context->heap, context->classes.bytecodeCodeClass, sizeof(beacon_BytecodeCode_t), BeaconObjectKindPointers);
     code->argumentCount = beacon_encodeSmallInteger(beacon_ArrayList_size(builder->arguments));
     code->temporaryCount = beacon_encodeSmallInteger(beacon_ArrayList_size(builder->temporaries));
-    code->literals = beacon_ArrayList_asArray(context, builder->literals);
+    code->literals = beacon_internLiteralFrame(context, beacon_ArrayList_size(builder->literals), builder->literals->array->elements);
     code->bytecodes = beacon_ByteArrayList_asByteArray(context, builder->bytecodes);
+    code->invocationCount = beacon_encodeSmallInteger(0);
+    code->backwardJumpCount = beacon_encodeSmallInteger(0);
+    code->sendCount = beacon_encodeSmallInteger(0);
     return code;
 }
 
-beacon_BytecodeValue_t beacon_BytecodeCodeBuilder_addLiteral(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder, beacon_oop_t literal)
+// Strings, byte arrays and boxed numbers, such as the floats that are not immediate, are deduplicated by their class and contents.
+// Every other literal is compared by identity.
+static bool beacon_BytecodeCodeBuilder_isLiteralComparedByValue(beacon_context_t *context, beacon_oop_t literal)
+{
+    if(beacon_isImmediate(literal))
+        return false;
+
+    beacon_Behavior_t *literalClass = beacon_getClass(context, literal);
+    if(literalClass == context->classes.stringClass || literalClass == context->classes.byteArrayClass)
+        return true;
+
+    if(((beacon_ObjectHeader_t*)literal)->objectKind != BeaconObjectKindBytes)
+        return false;
+
+    for(beacon_Behavior_t *behavior = literalClass; behavior; behavior = behavior->superclass)
+    {
+        if(behavior == context->classes.numberClass)
+            return true;
+    }
+
+    return false;
+}
+
+static uint32_t beacon_BytecodeCodeBuilder_hashLiteral(beacon_context_t *context, beacon_oop_t literal)
+{
+    if(beacon_BytecodeCodeBuilder_isLiteralComparedByValue(context, literal))
+    {
+        beacon_ObjectHeader_t *header = (beacon_ObjectHeader_t*)literal;
+        return beacon_computeStringHash(header->slotCount, (const char *)(header + 1));
+    }
+
+    return beacon_computeIdentityHash(literal);
+}
+
+static bool beacon_BytecodeCodeBuilder_literalEquals(beacon_context_t *context, beacon_oop_t first, beacon_oop_t second)
+{
+    if(first == second)
+        return true;
+    if(!beacon_BytecodeCodeBuilder_isLiteralComparedByValue(context, first) || beacon_isImmediate(second)
+        || beacon_getClass(context, first) != beacon_getClass(context, second))
+        return false;
+
+    beacon_ObjectHeader_t *firstHeader = (beacon_ObjectHeader_t*)first;
+    beacon_ObjectHeader_t *secondHeader = (beacon_ObjectHeader_t*)second;
+    return firstHeader->slotCount == secondHeader->slotCount && !memcmp(firstHeader + 1, secondHeader + 1, firstHeader->slotCount);
+}
+
+// Finds the slot of a literal in the index table, which holds the one-based literal indices as SmallIntegers.
+static size_t beacon_BytecodeCodeBuilder_findLiteralIndexSlot(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder, beacon_oop_t literal)
+{
+    beacon_Array_t *table = codeBuilder->literalIndexTable;
+    size_t capacityMask = table->super.super.super.super.super.header.slotCount - 1;
+    size_t slot = beacon_BytecodeCodeBuilder_hashLiteral(context, literal) & capacityMask;
+    while(beacon_isNotNil(table->elements[slot]))
+    {
+        size_t literalIndex = beacon_decodeSmallInteger(table->elements[slot]);
+        if(beacon_BytecodeCodeBuilder_literalEquals(context, literal, codeBuilder->literals->array->elements[literalIndex - 1]))
+            return slot;
+        slot = (slot + 1) & capacityMask;
+    }
+
+    return slot;
+}
+
+static void beacon_BytecodeCodeBuilder_rebuildLiteralIndexTable(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder)
 {
     size_t literalCount = beacon_ArrayList_size(codeBuilder->literals);
+    size_t capacity = 64;
+    while(capacity < literalCount * 4)
+        capacity *= 2;
 
+    codeBuilder->literalIndexTable = beacon_allocateObject(context->heap, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*capacity, BeaconObjectKindPointers);
     for(size_t i = 1; i <= literalCount; ++i)
     {
-        beacon_oop_t existingLiteral = beacon_ArrayList_at(context, codeBuilder->literals, i);
-        if(existingLiteral == literal)
-            return beacon_BytecodeValue_encode(i, BytecodeArgumentTypeLiteral);
+        size_t slot = beacon_BytecodeCodeBuilder_findLiteralIndexSlot(context, codeBuilder, codeBuilder->literals->array->elements[i - 1]);
+        codeBuilder->literalIndexTable->elements[slot] = beacon_encodeSmallInteger(i);
+    }
+}
+
+beacon_BytecodeValue_t beacon_BytecodeCodeBuilder_addLiteral(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder, beacon_oop_t literal)
+{
+    size_t literalCount = beacon_ArrayList_size(codeBuilder->literals);
+
+    // Small literal frames are scanned linearly. The hashed index is only built for the larger ones.
+    if(literalCount < BEACON_BYTECODE_LITERAL_INDEX_THRESHOLD)
+    {
+        for(size_t i = 1; i <= literalCount; ++i)
+        {
+            beacon_oop_t existingLiteral = beacon_ArrayList_at(context, codeBuilder->literals, i);
+            if(beacon_BytecodeCodeBuilder_literalEquals(context, literal, existingLiteral))
+                return beacon_BytecodeValue_encode(i, BytecodeArgumentTypeLiteral);
+        }
 
+        beacon_ArrayList_add(context, codeBuilder->literals, literal);
+        return beacon_BytecodeValue_encode(literalCount + 1, BytecodeArgumentTypeLiteral);
     }
 
+    if(beacon_isNil((beacon_oop_t)codeBuilder->literalIndexTable) ||
+        (literalCount + 1) * 2 > codeBuilder->literalIndexTable->super.super.super.super.super.header.slotCount)
+        beacon_BytecodeCodeBuilder_rebuildLiteralIndexTable(context, codeBuilder);
+
+    size_t slot = beacon_BytecodeCodeBuilder_findLiteralIndexSlot(context, codeBuilder, literal);
+    if(beacon_isNotNil(codeBuilder->literalIndexTable->elements[slot]))
+        return beacon_BytecodeValue_encode(beacon_decodeSmallInteger(codeBuilder->literalIndexTable->elements[slot]), BytecodeArgumentTypeLiteral);
+
+    BeaconAssert(context, literalCount + 1 <= BEACON_BYTECODE_MAX_LITERAL_COUNT);
     beacon_ArrayList_add(context, codeBuilder->literals, literal);
-    return beacon_BytecodeValue_encode(beacon_ArrayList_size(codeBuilder->literals), BytecodeArgumentTypeLiteral);
+    codeBuilder->literalIndexTable->elements[slot] = beacon_encodeSmallInteger(literalCount + 1);
+    return beacon_BytecodeValue_encode(literalCount + 1, BytecodeArgumentTypeLiteral);
+}
+
+static size_t beacon_LiteralFrameSet_findSlot(beacon_Array_t *storage, uint32_t hash, size_t literalCount, beacon_oop_t *literals)
+{
+    size_t capacityMask = storage->super.super.super.super.super.header.slotCount - 1;
+    size_t slot = hash & capacityMask;
+    while(beacon_isNotNil(storage->elements[slot]))
+    {
+        beacon_Array_t *frame = (beacon_Array_t *)storage->elements[slot];
+        if(frame->super.super.super.super.super.header.slotCount == literalCount && !memcmp(frame->elements, literals, literalCount*sizeof(beacon_oop_t)))
+            return slot;
+        slot = (slot + 1) & capacityMask;
+    }
+
+    return slot;
+}
+
+static void beacon_LiteralFrameSet_grow(beacon_context_t *context, beacon_HashedCollection_t *frameSet)
+{
+    beacon_Array_t *oldStorage = frameSet->array;
+    size_t oldCapacity = oldStorage->super.super.super.super.super.header.slotCount;
+    beacon_Array_t *newStorage = beacon_allocateObject(context->heap, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*oldCapacity*2, BeaconObjectKindWeakPointers);
+    size_t tally = 0;
+    for(size_t i = 0; i < oldCapacity; ++i)
+    {
+        beacon_oop_t element = oldStorage->elements[i];
+        if(beacon_isNil(element))
+            continue;
+
+        beacon_Array_t *frame = (beacon_Array_t *)element;
+        size_t frameSize = frame->super.super.super.super.super.header.slotCount;
+        uint32_t hash = beacon_computeStringHash(frameSize*sizeof(beacon_oop_t), (const char*)frame->elements);
+        newStorage->elements[beacon_LiteralFrameSet_findSlot(newStorage, hash, frameSize, frame->elements)] = element;
+        ++tally;
+    }
+
+    frameSet->array = newStorage;
+    frameSet->tally = beacon_encodeSmallInteger(tally);
+}
+
+beacon_Array_t *beacon_internLiteralFrame(beacon_context_t *context, size_t literalCount, beacon_oop_t *literals)
+{
+    if(literalCount == 0)
+        return (beacon_Array_t*)context->roots.emptyArray;
+
+    beacon_HashedCollection_t *frameSet = context->roots.literalFrameSet;
+    uint32_t hash = beacon_computeStringHash(literalCount*sizeof(beacon_oop_t), (const char*)literals);
+    size_t slot = beacon_LiteralFrameSet_findSlot(frameSet->array, hash, literalCount, literals);
+    if(beacon_isNotNil(frameSet->array->elements[slot]))
+        return (beacon_Array_t*)frameSet->array->elements[slot];
+
+    size_t tally = beacon_decodeSmallInteger(frameSet->tally);
+    size_t capacity = frameSet->array->super.super.super.super.super.header.slotCount;
+    if((tally + 1) * 4 > capacity * 3)
+    {
+        beacon_LiteralFrameSet_grow(context, frameSet);
+        slot = beacon_LiteralFrameSet_findSlot(frameSet->array, hash, literalCount, literals);
+    }
+
+    beacon_Array_t *frame = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*literalCount, BeaconObjectKindPointers);
+    memcpy(frame->elements, literals, literalCount*sizeof(beacon_oop_t));
+    frameSet->array->elements[slot] = (beacon_oop_t)frame;
+    frameSet->tally = beacon_encodeSmallInteger(tally + 1);
+    return frame;
+}
+
+void beacon_LiteralFrameSet_removeCollectedFrames(beacon_context_t *context)
+{
+    // This runs in the middle of a collection, so the storage is rebuilt in place instead of allocating a new one.
+    beacon_HashedCollection_t *frameSet = context->roots.literalFrameSet;
+    beacon_Array_t *storage = frameSet->array;
+    size_t capacity = storage->super.super.super.super.super.header.slotCount;
+    size_t survivorCount = 0;
+    bool hasCollectedFrames = false;
+    for(size_t i = 0; i < capacity; ++i)
+    {
+        if(storage->elements[i] == context->roots.weakTombstone)
+            hasCollectedFrames = true;
+        else if(beacon_isNotNil(storage->elements[i]))
+            ++survivorCount;
+    }
+
+    if(!hasCollectedFrames)
+        return;
+
+    beacon_Array_t **survivors = malloc(survivorCount * sizeof(beacon_Array_t*));
+    size_t destIndex = 0;
+    for(size_t i = 0; i < capacity; ++i)
+    {
+        beacon_oop_t element = storage->elements[i];
+        if(beacon_isNotNil(element) && element != context->roots.weakTombstone)
+            survivors[destIndex++] = (beacon_Array_t*)element;
+        storage->elements[i] = 0;
+    }
+
+    for(size_t i = 0; i < survivorCount; ++i)
+    {
+        beacon_Array_t *frame = survivors[i];
+        size_t frameSize = frame->super.super.super.super.super.header.slotCount;
+        uint32_t hash = beacon_computeStringHash(frameSize*sizeof(beacon_oop_t), (const char*)frame->elements);
+        storage->elements[beacon_LiteralFrameSet_findSlot(storage, hash, frameSize, frame->elements)] = (beacon_oop_t)frame;
+    }
+
+    free(survivors);
+    frameSet->tally = beacon_encodeSmallInteger(survivorCount);
 }
 
 beacon_BytecodeValue_t beacon_BytecodeCodeBuilder_superReceiverClass(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *codeBuilder, beacon_oop_t literalBehavior)
@@ -225,6 +431,231 @@ void beacon_BytecodeCodeBuilder_makeClosureInstance(beacon_context_t *context, b
         beacon_ByteArrayList_addUInt16(context, methodBuilder->bytecodes, captures[i]);
 }
 
+void beacon_BytecodeCodeBuilder_inlinedPrimitive(beacon_context_t *context, beacon_BytecodeCodeBuilder_t *methodBuilder, beacon_BytecodeValue_t resultTemporary, beacon_BytecodeInlinedPrimitive_t primitive, size_t operandCount, beacon_BytecodeValue_t *operands)
+{
+    beacon_BytecodeValue_t primitiveValue = beacon_BytecodeCodeBuilder_addLiteral(context, methodBuilder, beacon_encodeSmallInteger(primitive));
+    uint8_t argumentCountBits = beacon_BytecodeCodeBuilder_extendArgumentsIfNeeded(context, methodBuilder, 1 + operandCount);
+    beacon_ByteArrayList_add(context, methodBuilder->bytecodes, argumentCountBits | BeaconBytecodeInlinedPrimitive);
+    beacon_ByteArrayList_addUInt16(context, methodBuilder->bytecodes, resultTemporary);
+    beacon_ByteArrayList_addUInt16(context, methodBuilder->bytecodes, primitiveValue);
+    for(size_t i = 0; i < operandCount; ++i)
+        beacon_ByteArrayList_addUInt16(context, methodBuilder->bytecodes, operands[i]);
+}
+
+static inline beacon_BytecodeValue_t beacon_BytecodeCode_decodeValueAt(uint8_t *bytecodes, size_t offset)
+{
+    return bytecodes[offset] | (bytecodes[offset + 1] << 8);
+}
+
+void beacon_CompiledCode_detectQuickMethod(beacon_context_t *context, beacon_CompiledCode_t *method)
+{
+    (void)context;
+    beacon_BytecodeCode_t *code = method->bytecodeImplementation;
+    method->quickMethodKind = beacon_encodeSmallInteger(BeaconQuickMethodNone);
+    method->quickMethodValue = 0;
+    if(!code || beacon_decodeSmallInteger(code->temporaryCount) != 0)
+        return;
+
+    uint8_t *bytecodes = code->bytecodes->elements;
+    size_t bytecodesSize = code->bytecodes->super.super.super.super.super.header.slotCount;
+    intptr_t argumentCount = beacon_decodeSmallInteger(code->argumentCount);
+    if(bytecodesSize < 3)
+        return;
+
+    // ^ self, ^ literal, ^ instanceVariable
+    if(bytecodes[0] == (0x10 | BeaconBytecodeLocalReturn))
+    {
+        beacon_BytecodeValue_t returnedValue = beacon_BytecodeCode_decodeValueAt(bytecodes, 1);
+        uint16_t returnedValueIndex = beacon_BytecodeValue_getIndex(returnedValue);
+        switch(beacon_BytecodeValue_getType(returnedValue))
+        {
+        case BytecodeArgumentTypeArgument:
+            if(returnedValueIndex == 0)
+                method->quickMethodKind = beacon_encodeSmallInteger(BeaconQuickMethodReturnSelf);
+            break;
+        case BytecodeArgumentTypeLiteral:
+            method->quickMethodKind = beacon_encodeSmallInteger(BeaconQuickMethodReturnLiteral);
+            method->quickMethodValue = returnedValueIndex == 0 ? 0 : code->literals->elements[returnedValueIndex - 1];
+            break;
+        case BytecodeArgumentTypeReceiverSlot:
+            method->quickMethodKind = beacon_encodeSmallInteger(BeaconQuickMethodReturnInstanceVariable);
+            method->quickMethodValue = beacon_encodeSmallInteger(returnedValueIndex - 1);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    // instanceVariable := argument. ^ self
+    if(argumentCount == 1 && bytecodesSize >= 8 &&
+        bytecodes[0] == (0x10 | BeaconBytecodeStoreValue) &&
+        bytecodes[5] == (0x10 | BeaconBytecodeLocalReturn))
+    {
+        beacon_BytecodeValue_t storage = beacon_BytecodeCode_decodeValueAt(bytecodes, 1);
+        beacon_BytecodeValue_t storedValue = beacon_BytecodeCode_decodeValueAt(bytecodes, 3);
+        beacon_BytecodeValue_t returnedValue = beacon_BytecodeCode_decodeValueAt(bytecodes, 6);
+        if(beacon_BytecodeValue_getType(storage) == BytecodeArgumentTypeReceiverSlot &&
+            storedValue == beacon_BytecodeValue_encode(1, BytecodeArgumentTypeArgument) &&
+            returnedValue == beacon_BytecodeValue_encode(0, BytecodeArgumentTypeArgument))
+        {
+            method->quickMethodKind = beacon_encodeSmallInteger(BeaconQuickMethodSetInstanceVariable);
+            method->quickMethodValue = beacon_encodeSmallInteger(beacon_BytecodeValue_getIndex(storage) - 1);
+        }
+    }
+}
+
+bool beacon_CompiledCode_runQuickMethod(beacon_context_t *context, beacon_CompiledCode_t *method, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments, beacon_oop_t *outResult)
+{
+    (void)context;
+    switch(beacon_decodeSmallInteger(method->quickMethodKind))
+    {
+    case BeaconQuickMethodReturnSelf:
+        *outResult = receiver;
+        return true;
+    case BeaconQuickMethodReturnLiteral:
+        *outResult = method->quickMethodValue;
+        return true;
+    case BeaconQuickMethodReturnInstanceVariable:
+        {
+            intptr_t slotIndex = beacon_decodeSmallInteger(method->quickMethodValue);
+            if(beacon_isImmediate(receiver) || slotIndex >= (intptr_t)((beacon_ObjectHeader_t*)receiver)->slotCount)
+                return false;
+
+            *outResult = ((beacon_oop_t*)((beacon_ObjectHeader_t*)receiver + 1))[slotIndex];
+            return true;
+        }
+    case BeaconQuickMethodSetInstanceVariable:
+        {
+            intptr_t slotIndex = beacon_decodeSmallInteger(method->quickMethodValue);
+            if(argumentCount != 1 || beacon_isImmediate(receiver) || slotIndex >= (intptr_t)((beacon_ObjectHeader_t*)receiver)->slotCount)
+                return false;
+
+            ((beacon_oop_t*)((beacon_ObjectHeader_t*)receiver + 1))[slotIndex] = arguments[0];
+            *outResult = receiver;
+            return true;
+        }
+    default:
+        return false;
+    }
+}
+
+/**
+ * Captures are copied into the closure when it is instantiated, so they are
+ * read-only. A closure previously created by the same instruction can hence be
+ * reused when its receiver and all of its captured values are still identical.
+ */
+static inline bool beacon_BlockClosure_canBeReusedWithCaptures(beacon_oop_t previousClosureOop, beacon_oop_t receiver, beacon_CompiledBlock_t *code, size_t captureCount, beacon_oop_t *captures)
+{
+    if(!previousClosureOop || beacon_isImmediate(previousClosureOop))
+        return false;
+
+    beacon_BlockClosure_t *previousClosure = (beacon_BlockClosure_t*)previousClosureOop;
+    if(previousClosure->code != code || previousClosure->receiver != receiver)
+        return false;
+
+    beacon_Array_t *previousCaptures = (beacon_Array_t*)previousClosure->captures;
+    if(previousCaptures->super.super.super.super.super.header.slotCount != captureCount)
+        return false;
+
+    for(size_t i = 0; i < captureCount; ++i)
+    {
+        if(previousCaptures->elements[i] != captures[i])
+            return false;
+    }
+
+    return true;
+}
+
+beacon_oop_t beacon_BytecodeInterpreter_makeClosureInstance(beacon_context_t *context, beacon_oop_t previousClosure, beacon_oop_t receiver, beacon_CompiledBlock_t *code, size_t captureCount, beacon_oop_t *captures)
+{
+    // Reuse the closure from the previous iteration when it captured the same values.
+    if(beacon_BlockClosure_canBeReusedWithCaptures(previousClosure, receiver, code, captureCount, captures))
+        return previousClosure;
+
+    beacon_BlockClosure_t *blockClosure = beacon_allocateObjectWithBehavior(context->heap, context->classes.blockClosureClass, sizeof(beacon_BlockClosure_t), BeaconObjectKindPointers);
+    blockClosure->code = code;
+    blockClosure->receiver = receiver;
+
+    beacon_Array_t *capturesArray = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + captureCount*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+    blockClosure->captures = (beacon_oop_t)capturesArray;
+    for(size_t i = 0; i < captureCount; ++i)
+        capturesArray->elements[i] = captures[i];
+
+    return (beacon_oop_t)blockClosure;
+}
+
+static beacon_Array_t *beacon_BytecodeInterpreter_sequenceElements(beacon_context_t *context, beacon_oop_t sequence, intptr_t *outSize)
+{
+    beacon_Behavior_t *sequenceClass = beacon_getClass(context, sequence);
+    if(sequenceClass == context->classes.arrayClass)
+    {
+        *outSize = ((beacon_Array_t*)sequence)->super.super.super.super.super.header.slotCount;
+        return (beacon_Array_t*)sequence;
+    }
+
+    BeaconAssert(context, sequenceClass == context->classes.arrayListClass);
+    beacon_ArrayList_t *arrayList = (beacon_ArrayList_t*)sequence;
+    *outSize = beacon_decodeSmallInteger(arrayList->size);
+    return arrayList->array;
+}
+
+beacon_oop_t beacon_BytecodeInterpreter_inlinedPrimitive(beacon_context_t *context, intptr_t primitive, size_t operandCount, beacon_oop_t *operands)
+{
+    switch(primitive)
+    {
+    case BeaconBytecodeInlinedPrimitiveClassIdentityEquals:
+        BeaconAssert(context, operandCount == 2);
+        return (beacon_oop_t)beacon_getClass(context, operands[0]) == operands[1] ? context->roots.trueValue : context->roots.falseValue;
+    case BeaconBytecodeInlinedPrimitiveSequenceSize:
+        {
+            BeaconAssert(context, operandCount == 1);
+            intptr_t size = 0;
+            beacon_BytecodeInterpreter_sequenceElements(context, operands[0], &size);
+            return beacon_encodeSmallInteger(size);
+        }
+    case BeaconBytecodeInlinedPrimitiveSequenceAt:
+        {
+            BeaconAssert(context, operandCount == 2 && beacon_isSmallInteger(operands[1]));
+            intptr_t size = 0;
+            beacon_Array_t *elements = beacon_BytecodeInterpreter_sequenceElements(context, operands[0], &size);
+            intptr_t index = beacon_decodeSmallInteger(operands[1]);
+            if(index < 1 || index > (intptr_t)elements->super.super.super.super.super.header.slotCount)
+                beacon_exception_error(context, "Index out of bounds.");
+            return elements->elements[index - 1];
+        }
+    case BeaconBytecodeInlinedPrimitiveArrayAtPut:
+        {
+            BeaconAssert(context, operandCount == 3 && beacon_isSmallInteger(operands[1]));
+            intptr_t size = 0;
+            beacon_Array_t *elements = beacon_BytecodeInterpreter_sequenceElements(context, operands[0], &size);
+            BeaconAssert(context, elements == (beacon_Array_t*)operands[0]);
+            intptr_t index = beacon_decodeSmallInteger(operands[1]);
+            if(index < 1 || index > size)
+                beacon_exception_error(context, "Index out of bounds.");
+            elements->elements[index - 1] = operands[2];
+            return operands[2];
+        }
+    case BeaconBytecodeInlinedPrimitiveSmallIntegerAdd:
+        BeaconAssert(context, operandCount == 2 && beacon_isSmallInteger(operands[0]) && beacon_isSmallInteger(operands[1]));
+        return beacon_encodeSmallInteger(beacon_decodeSmallInteger(operands[0]) + beacon_decodeSmallInteger(operands[1]));
+    case BeaconBytecodeInlinedPrimitiveSmallIntegerLessOrEquals:
+        BeaconAssert(context, operandCount == 2 && beacon_isSmallInteger(operands[0]) && beacon_isSmallInteger(operands[1]));
+        return beacon_decodeSmallInteger(operands[0]) <= beacon_decodeSmallInteger(operands[1]) ? context->roots.trueValue : context->roots.falseValue;
+    default:
+        beacon_exception_error(context, "Unsupported inlined primitive.");
+        return 0;
+    }
+}
+
+static inline void beacon_checkStackOverflow(beacon_context_t *context, beacon_StackFrameRecord_t *newRecord)
+{
+    // The record of the new activation lives in its native frame, so its address tells how deep the native stack is.
+    beacon_StackFrameRecord_t *callerRecord = beacon_getTopStackFrameRecord();
+    if(callerRecord && (callerRecord->depth >= context->options.maxStackDepth || (uintptr_t)newRecord < beacon_getNativeStackLimit()))
+        beacon_exception_stackOverflow(context, callerRecord->depth, (uintptr_t)newRecord);
+}
+
 beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_CompiledCode_t *method, beacon_oop_t receiver, beacon_oop_t selector, beacon_oop_t captures, size_t argumentCount, beacon_oop_t *arguments)
 {
     (void)selector;
@@ -272,6 +703,8 @@ beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_Co
         }
     };
 
+    beacon_checkStackOverflow(context, &stackFrameRecord);
+
     if(setjmp(stackFrameRecord.bytecodeMethodStackRecord.nonLocalReturnJumpBuffer))
     {
         beacon_popStackFrameRecord(&stackFrameRecord);
@@ -279,7 +712,28 @@ beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_Co
     }
 
     beacon_pushStackFrameRecord(&stackFrameRecord);
-    
+    beacon_BytecodeCode_incrementCounter(&code->invocationCount);
+
+#ifdef BEACON_JIT
+    beacon_JitCompiledCode_t *jitCompiledCode = beacon_jit_getCompiledCodeFor(context, method);
+    if(jitCompiledCode && jitCompiledCode->requiredReceiverSlotCount <= receiverSlotCount && jitCompiledCode->requiredCaptureCount <= captureCount)
+    {
+        beacon_JitFrame_t jitFrame = {
+            .context = context,
+            .receiver = receiver,
+            .arguments = arguments,
+            .temporaries = temporaryStorage,
+            .captures = capturesArray ? capturesArray->elements : NULL,
+            .receiverSlots = receiverSlots,
+            .decodedArguments = bytecodeDecodedArguments,
+        };
+
+        stackFrameRecord.bytecodeMethodStackRecord.returnResultValue = jitCompiledCode->entryPoint(&jitFrame);
+        beacon_popStackFrameRecord(&stackFrameRecord);
+        return stackFrameRecord.bytecodeMethodStackRecord.returnResultValue;
+    }
+#endif
+
     while(pc < bytecodesSize)
     {
         uint32_t instructionPC = pc;
@@ -297,6 +751,7 @@ beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_Co
             extendedArgumentCount = instructionArgumentCount;
             continue;
         }
+        extendedArgumentCount = 0;
 
         // Decode the result destination.
         bool writesToTemporary = beacon_bytecodeWritesToTemporary(opcode);
@@ -368,14 +823,20 @@ beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_Co
         case BeaconBytecodeJump:
             pc = branchDestinationPC;
             if(branchDestinationDelta < 0)
+            {
+                beacon_BytecodeCode_incrementCounter(&code->backwardJumpCount);
                 beacon_memoryHeapSafepoint(context);
+            }
             break;
         case BeaconBytecodeJumpIfTrue:
             if(bytecodeDecodedArguments[0] == context->roots.trueValue)
             {
                 pc = branchDestinationPC;
                 if(branchDestinationDelta < 0)
+                {
+                    beacon_BytecodeCode_incrementCounter(&code->backwardJumpCount);
                     beacon_memoryHeapSafepoint(context);
+                }
             }
             break;
         case BeaconBytecodeJumpIfFalse:
@@ -383,15 +844,20 @@ beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_Co
             {
                 pc = branchDestinationPC;
                 if(branchDestinationDelta < 0)
+                {
+                    beacon_BytecodeCode_incrementCounter(&code->backwardJumpCount);
                     beacon_memoryHeapSafepoint(context);
+                }
             }
             break;
         case BeaconBytecodeSendMessage:
             BeaconAssert(context, writesToTemporary);
+            beacon_BytecodeCode_incrementCounter(&code->sendCount);
             instructionExecutionResult = beacon_performWithArguments(context, bytecodeDecodedArguments[0], bytecodeDecodedArguments[1], instructionArgumentCount - 2, bytecodeDecodedArguments + 2);
             break;
         case BeaconBytecodeSuperSendMessage:
             BeaconAssert(context, writesToTemporary);
+            beacon_BytecodeCode_incrementCounter(&code->sendCount);
             instructionExecutionResult = beacon_performWithArgumentsInSuperclass(context, receiver, bytecodeDecodedArguments[1], instructionArgumentCount - 2, bytecodeDecodedArguments + 2, bytecodeDecodedArguments[0]);
             break;
         case BeaconBytecodeStoreValue:
@@ -415,18 +881,16 @@ beacon_oop_t beacon_interpretBytecodeMethod(beacon_context_t *context, beacon_Co
         case BeaconBytecodeMakeClosureInstance:
             {
                 BeaconAssert(context, writesToTemporary);
+                BeaconAssert(context, !resultTemporaryIsReceiverSlot && resultTemporaryOrInstanceVarIndex > 0);
 
-                beacon_BlockClosure_t *blockClosure = beacon_allocateObjectWithBehavior(context->heap, context->classes.blockClosureClass, sizeof(beacon_BlockClosure_t), BeaconObjectKindPointers);
-                blockClosure->code = (beacon_CompiledBlock_t*)bytecodeDecodedArguments[0];
-
-                beacon_Array_t *captures = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + (instructionArgumentCount - 1)*sizeof(beacon_oop_t), BeaconObjectKindPointers);
-                blockClosure->captures = (beacon_oop_t)captures;
-                for(size_t i = 1; i < instructionArgumentCount; ++i)
-                    captures->elements[i - 1] = bytecodeDecodedArguments[i];
-
-                instructionExecutionResult = (beacon_oop_t)blockClosure;
+                beacon_oop_t previousClosure = temporaryStorage[resultTemporaryOrInstanceVarIndex - 1];
+                instructionExecutionResult = beacon_BytecodeInterpreter_makeClosureInstance(context, previousClosure, receiver, (beacon_CompiledBlock_t*)bytecodeDecodedArguments[0], instructionArgumentCount - 1, bytecodeDecodedArguments + 1);
             }
             break;
+        case BeaconBytecodeInlinedPrimitive:
+            BeaconAssert(context, writesToTemporary && instructionArgumentCount >= 1);
+            instructionExecutionResult = beacon_BytecodeInterpreter_inlinedPrimitive(context, beacon_decodeSmallInteger(bytecodeDecodedArguments[0]), instructionArgumentCount - 1, bytecodeDecodedArguments + 1);
+            break;
         default:
             {
                 char buffer[64];
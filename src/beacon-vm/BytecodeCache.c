@@ -0,0 +1,845 @@
+#include "beacon-lang/BytecodeCache.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/Dictionary.h"
+#include "beacon-lang/Bytecode.h"
+#include "beacon-lang/SyntaxCompiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define beacon_mkdir(path) _mkdir(path)
+#define beacon_getpid() _getpid()
+#else
+#include <unistd.h>
+#define beacon_mkdir(path) mkdir(path, 0755)
+#define beacon_getpid() getpid()
+#endif
+
+static const char beacon_BytecodeCache_magic[8] = {'B', 'C', 'N', 'C', 'A', 'C', 'H', 'E'};
+
+typedef enum beacon_BytecodeCacheCodeKind_e
+{
+    BytecodeCacheCodeMethod = 0,
+    BytecodeCacheCodeBlock,
+    BytecodeCacheCodeLazyMethod,
+} beacon_BytecodeCacheCodeKind_t;
+
+typedef enum beacon_BytecodeCacheLiteralKind_e
+{
+    BytecodeCacheLiteralImmediate = 0,
+    BytecodeCacheLiteralTrue,
+    BytecodeCacheLiteralFalse,
+    BytecodeCacheLiteralSymbol,
+    BytecodeCacheLiteralString,
+    BytecodeCacheLiteralByteArray,
+    BytecodeCacheLiteralArray,
+    BytecodeCacheLiteralGlobal,
+    BytecodeCacheLiteralClassOfGlobal,
+    BytecodeCacheLiteralFileDirectory,
+    BytecodeCacheLiteralFileName,
+    BytecodeCacheLiteralCompiledBlock,
+    BytecodeCacheLiteralCleanBlockClosure,
+    BytecodeCacheLiteralCompiledMethod,
+} beacon_BytecodeCacheLiteralKind_t;
+
+typedef struct beacon_BytecodeCacheBuffer_s
+{
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} beacon_BytecodeCacheBuffer_t;
+
+struct beacon_BytecodeCacheWriter_s
+{
+    beacon_SourceCode_t *sourceCode;
+    uint64_t key;
+    size_t statementCount;
+    size_t recordedStatementCount;
+    bool failed;
+
+    beacon_BytecodeCacheBuffer_t contents;
+    beacon_BytecodeCacheBuffer_t installations;
+    size_t installationCount;
+};
+
+struct beacon_BytecodeCacheReader_s
+{
+    beacon_SourceCode_t *sourceCode;
+    uint8_t *data;
+    size_t size;
+    size_t position;
+    size_t localVariableCount;
+    size_t statementCount;
+};
+
+static uint64_t beacon_BytecodeCache_hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    // FNV-1a
+    const uint8_t *bytes = (const uint8_t *)data;
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t beacon_BytecodeCache_computeKey(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
+{
+    // The compiled code depends on the version of the VM and the compiler options.
+    static const char vmVersion[] = BEACON_VM_VERSION " " __DATE__ " " __TIME__;
+    uint32_t formatVersion = BEACON_BYTECODE_CACHE_FORMAT_VERSION;
+    uint8_t inlineCollectionIterationSelectors = context->options.inlineCollectionIterationSelectors;
+    uint8_t lazyMethodCompilation = context->options.lazyMethodCompilation;
+
+    uint64_t hash = 14695981039346656037ull;
+    hash = beacon_BytecodeCache_hashBytes(hash, &formatVersion, sizeof(formatVersion));
+    hash = beacon_BytecodeCache_hashBytes(hash, vmVersion, sizeof(vmVersion));
+    hash = beacon_BytecodeCache_hashBytes(hash, &inlineCollectionIterationSelectors, sizeof(inlineCollectionIterationSelectors));
+    hash = beacon_BytecodeCache_hashBytes(hash, &lazyMethodCompilation, sizeof(lazyMethodCompilation));
+    hash = beacon_BytecodeCache_hashBytes(hash, sourceCode->text->data, sourceCode->text->super.super.super.super.super.header.slotCount);
+    return hash;
+}
+
+static bool beacon_BytecodeCache_isCacheable(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
+{
+    // Only the files are cached. Sources that are made from strings do not have a directory.
+    return context->options.bytecodeCacheDirectory && sourceCode && sourceCode->directory && sourceCode->name && sourceCode->text;
+}
+
+static char *beacon_BytecodeCache_makeEntryFileName(beacon_context_t *context, uint64_t key)
+{
+    const char *directory = context->options.bytecodeCacheDirectory;
+    size_t fileNameSize = strlen(directory) + 32;
+    char *fileName = malloc(fileNameSize);
+    snprintf(fileName, fileNameSize, "%s/%016llx.bcache", directory, (unsigned long long)key);
+    return fileName;
+}
+
+static void beacon_BytecodeCache_makeDirectories(const char *path)
+{
+    char *partialPath = strdup(path);
+    for(char *position = partialPath + 1; *position; ++position)
+    {
+        if(*position != '/' && *position != '\\')
+            continue;
+
+        char separator = *position;
+        *position = 0;
+        beacon_mkdir(partialPath);
+        *position = separator;
+    }
+
+    beacon_mkdir(partialPath);
+    free(partialPath);
+}
+
+//==============================================================================
+// Writer
+//==============================================================================
+
+static void beacon_BytecodeCacheBuffer_write(beacon_BytecodeCacheBuffer_t *buffer, const void *data, size_t size)
+{
+    if(buffer->size + size > buffer->capacity)
+    {
+        size_t newCapacity = buffer->capacity*2;
+        if(newCapacity < buffer->size + size)
+            newCapacity = buffer->size + size + 1024;
+        buffer->data = realloc(buffer->data, newCapacity);
+        buffer->capacity = newCapacity;
+    }
+
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+static void beacon_BytecodeCacheBuffer_writeU8(beacon_BytecodeCacheBuffer_t *buffer, uint8_t value)
+{
+    beacon_BytecodeCacheBuffer_write(buffer, &value, 1);
+}
+
+static void beacon_BytecodeCacheBuffer_writeU32(beacon_BytecodeCacheBuffer_t *buffer, uint32_t value)
+{
+    beacon_BytecodeCacheBuffer_write(buffer, &value, sizeof(value));
+}
+
+static void beacon_BytecodeCacheBuffer_writeU64(beacon_BytecodeCacheBuffer_t *buffer, uint64_t value)
+{
+    beacon_BytecodeCacheBuffer_write(buffer, &value, sizeof(value));
+}
+
+static void beacon_BytecodeCacheBuffer_writeBytes(beacon_BytecodeCacheBuffer_t *buffer, const void *data, size_t size)
+{
+    beacon_BytecodeCacheBuffer_writeU32(buffer, (uint32_t)size);
+    beacon_BytecodeCacheBuffer_write(buffer, data, size);
+}
+
+// A class knows its name, so it is only searched in the system dictionary when it is not bound to that name.
+static beacon_Symbol_t *beacon_BytecodeCache_findClassGlobalNamed(beacon_context_t *context, beacon_oop_t value, bool lookForClassOfGlobal)
+{
+    if(beacon_isImmediate(value))
+        return NULL;
+
+    beacon_Class_t *class = NULL;
+    if(lookForClassOfGlobal)
+    {
+        if(beacon_getClass(context, value) != context->classes.metaclassClass)
+            return NULL;
+        class = ((beacon_Metaclass_t*)value)->thisClass;
+    }
+    else
+    {
+        if(beacon_getClass(context, (beacon_oop_t)beacon_getClass(context, value)) != context->classes.metaclassClass)
+            return NULL;
+        class = (beacon_Class_t*)value;
+    }
+
+    if(!class || !class->name || beacon_getClass(context, (beacon_oop_t)class->name) != context->classes.symbolClass)
+        return NULL;
+
+    if(beacon_MethodDictionary_atOrNil(context, context->roots.systemDictionary, class->name) != (beacon_oop_t)class)
+        return NULL;
+
+    return class->name;
+}
+
+static beacon_Symbol_t *beacon_BytecodeCache_findGlobalNamed(beacon_context_t *context, beacon_oop_t value, bool lookForClassOfGlobal)
+{
+    beacon_Symbol_t *className = beacon_BytecodeCache_findClassGlobalNamed(context, value, lookForClassOfGlobal);
+    if(className)
+        return className;
+
+    beacon_Array_t *globals = context->roots.systemDictionary->super.super.array;
+    size_t globalsSize = globals->super.super.super.super.super.header.slotCount;
+    for(size_t i = 1; i < globalsSize; i += 2)
+    {
+        beacon_oop_t key = globals->elements[i - 1];
+        beacon_oop_t global = globals->elements[i];
+        if(!key)
+            continue;
+
+        if(lookForClassOfGlobal)
+        {
+            if(!beacon_isImmediate(global) && (beacon_oop_t)beacon_getClass(context, global) == value)
+                return (beacon_Symbol_t *)key;
+        }
+        else if(global == value)
+        {
+            return (beacon_Symbol_t *)key;
+        }
+    }
+
+    return NULL;
+}
+
+static bool beacon_BytecodeCacheWriter_writeCode(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_BytecodeCacheBuffer_t *buffer, beacon_CompiledCode_t *code);
+
+static bool beacon_BytecodeCacheWriter_writeLiteral(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_BytecodeCacheBuffer_t *buffer, beacon_oop_t literal)
+{
+    if(beacon_isImmediate(literal))
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralImmediate);
+        beacon_BytecodeCacheBuffer_writeU64(buffer, literal);
+        return true;
+    }
+    else if(literal == context->roots.trueValue)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralTrue);
+        return true;
+    }
+    else if(literal == context->roots.falseValue)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralFalse);
+        return true;
+    }
+    else if(literal == (beacon_oop_t)writer->sourceCode->directory)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralFileDirectory);
+        return true;
+    }
+    else if(literal == (beacon_oop_t)writer->sourceCode->name)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralFileName);
+        return true;
+    }
+
+    beacon_Behavior_t *literalClass = beacon_getClass(context, literal);
+    size_t slotCount = ((beacon_ObjectHeader_t*)literal)->slotCount;
+    if(literalClass == context->classes.symbolClass)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralSymbol);
+        beacon_BytecodeCacheBuffer_writeBytes(buffer, ((beacon_Symbol_t*)literal)->data, slotCount);
+        return true;
+    }
+
+    // References to the globals are resolved again when loading the cache.
+    beacon_Symbol_t *globalName = beacon_BytecodeCache_findGlobalNamed(context, literal, false);
+    if(globalName)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralGlobal);
+        beacon_BytecodeCacheBuffer_writeBytes(buffer, globalName->data, globalName->super.super.super.super.super.header.slotCount);
+        return true;
+    }
+
+    if(literalClass == context->classes.stringClass)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralString);
+        beacon_BytecodeCacheBuffer_writeBytes(buffer, ((beacon_String_t*)literal)->data, slotCount);
+        return true;
+    }
+    else if(literalClass == context->classes.byteArrayClass)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralByteArray);
+        beacon_BytecodeCacheBuffer_writeBytes(buffer, ((beacon_ByteArray_t*)literal)->elements, slotCount);
+        return true;
+    }
+    else if(literalClass == context->classes.arrayClass)
+    {
+        beacon_Array_t *array = (beacon_Array_t *)literal;
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralArray);
+        beacon_BytecodeCacheBuffer_writeU32(buffer, (uint32_t)slotCount);
+        for(size_t i = 0; i < slotCount; ++i)
+        {
+            if(!beacon_BytecodeCacheWriter_writeLiteral(context, writer, buffer, array->elements[i]))
+                return false;
+        }
+        return true;
+    }
+    else if(literalClass == context->classes.compiledBlockClass)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralCompiledBlock);
+        return beacon_BytecodeCacheWriter_writeCode(context, writer, buffer, (beacon_CompiledCode_t*)literal);
+    }
+    else if(literalClass == context->classes.compiledMethodClass)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralCompiledMethod);
+        return beacon_BytecodeCacheWriter_writeCode(context, writer, buffer, (beacon_CompiledCode_t*)literal);
+    }
+    else if(literalClass == context->classes.blockClosureClass)
+    {
+        beacon_BlockClosure_t *blockClosure = (beacon_BlockClosure_t *)literal;
+        if(blockClosure->captures != context->roots.emptyArray)
+            return false;
+
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralCleanBlockClosure);
+        return beacon_BytecodeCacheWriter_writeCode(context, writer, buffer, &blockClosure->code->super);
+    }
+
+    // Metaclasses and the classes of other globals.
+    globalName = beacon_BytecodeCache_findGlobalNamed(context, literal, true);
+    if(globalName)
+    {
+        beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheLiteralClassOfGlobal);
+        beacon_BytecodeCacheBuffer_writeBytes(buffer, globalName->data, globalName->super.super.super.super.super.header.slotCount);
+        return true;
+    }
+
+    return false;
+}
+
+// The method stubs only keep their source range, which is compiled again from the source text when they are invoked.
+static bool beacon_BytecodeCacheWriter_writeLazyMethod(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_BytecodeCacheBuffer_t *buffer, beacon_CompiledMethod_t *method)
+{
+    beacon_SourcePosition_t *sourcePosition = method->super.sourcePosition;
+    if(!sourcePosition || sourcePosition->sourceCode != writer->sourceCode ||
+       beacon_getClass(context, (beacon_oop_t)method->lazyCompilationEnvironment) != context->classes.behaviorCompilationEnvironmentClass)
+        return false;
+
+    beacon_BytecodeCacheBuffer_writeU8(buffer, BytecodeCacheCodeLazyMethod);
+    if(!beacon_BytecodeCacheWriter_writeLiteral(context, writer, buffer, (beacon_oop_t)method->name))
+        return false;
+
+    beacon_BytecodeCacheBuffer_writeU64(buffer, beacon_decodeSmallInteger(method->super.argumentCount));
+    beacon_BytecodeCacheBuffer_writeU64(buffer, sourcePosition->startIndex);
+    beacon_BytecodeCacheBuffer_writeU64(buffer, sourcePosition->endIndex);
+    return true;
+}
+
+static bool beacon_BytecodeCacheWriter_writeCode(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_BytecodeCacheBuffer_t *buffer, beacon_CompiledCode_t *code)
+{
+    if(beacon_isLazyMethod(context, code))
+        return beacon_BytecodeCacheWriter_writeLazyMethod(context, writer, buffer, (beacon_CompiledMethod_t*)code);
+
+    beacon_BytecodeCode_t *bytecode = code->bytecodeImplementation;
+    if(!bytecode || code->nativeImplementation)
+        return false;
+
+    bool isBlock = beacon_getClass(context, (beacon_oop_t)code) == context->classes.compiledBlockClass;
+    beacon_BytecodeCacheBuffer_writeU8(buffer, isBlock ? BytecodeCacheCodeBlock : BytecodeCacheCodeMethod);
+    if(isBlock)
+        beacon_BytecodeCacheBuffer_writeU64(buffer, ((beacon_CompiledBlock_t*)code)->captureCount);
+    else if(!beacon_BytecodeCacheWriter_writeLiteral(context, writer, buffer, (beacon_oop_t)((beacon_CompiledMethod_t*)code)->name))
+        return false;
+
+    beacon_BytecodeCacheBuffer_writeU64(buffer, code->argumentCount);
+    beacon_BytecodeCacheBuffer_writeU64(buffer, bytecode->argumentCount);
+    beacon_BytecodeCacheBuffer_writeU64(buffer, bytecode->temporaryCount);
+    beacon_BytecodeCacheBuffer_writeU64(buffer, bytecode->captureCount);
+
+    beacon_SourcePosition_t *sourcePosition = code->sourcePosition;
+    beacon_BytecodeCacheBuffer_writeU8(buffer, sourcePosition != NULL);
+    if(sourcePosition)
+    {
+        beacon_BytecodeCacheBuffer_writeU64(buffer, sourcePosition->startIndex);
+        beacon_BytecodeCacheBuffer_writeU64(buffer, sourcePosition->endIndex);
+    }
+
+    beacon_BytecodeCacheBuffer_writeBytes(buffer, bytecode->bytecodes->elements, bytecode->bytecodes->super.super.super.super.super.header.slotCount);
+
+    size_t literalCount = bytecode->literals->super.super.super.super.super.header.slotCount;
+    beacon_BytecodeCacheBuffer_writeU32(buffer, (uint32_t)literalCount);
+    for(size_t i = 0; i < literalCount; ++i)
+    {
+        if(!beacon_BytecodeCacheWriter_writeLiteral(context, writer, buffer, bytecode->literals->elements[i]))
+            return false;
+    }
+
+    return true;
+}
+
+beacon_BytecodeCacheWriter_t *beacon_BytecodeCacheWriter_begin(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t localVariableCount, size_t statementCount)
+{
+    if(!beacon_BytecodeCache_isCacheable(context, sourceCode))
+        return NULL;
+
+    beacon_BytecodeCacheWriter_t *writer = calloc(1, sizeof(beacon_BytecodeCacheWriter_t));
+    writer->sourceCode = sourceCode;
+    writer->key = beacon_BytecodeCache_computeKey(context, sourceCode);
+    writer->statementCount = statementCount;
+
+    beacon_BytecodeCacheBuffer_write(&writer->contents, beacon_BytecodeCache_magic, sizeof(beacon_BytecodeCache_magic));
+    beacon_BytecodeCacheBuffer_writeU32(&writer->contents, BEACON_BYTECODE_CACHE_FORMAT_VERSION);
+    beacon_BytecodeCacheBuffer_writeU64(&writer->contents, writer->key);
+    beacon_BytecodeCacheBuffer_writeU64(&writer->contents, sourceCode->text->super.super.super.super.super.header.slotCount);
+    beacon_BytecodeCacheBuffer_writeU32(&writer->contents, (uint32_t)localVariableCount);
+    beacon_BytecodeCacheBuffer_writeU32(&writer->contents, (uint32_t)statementCount);
+    return writer;
+}
+
+void beacon_BytecodeCacheWriter_recordMethodInstallation(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_Behavior_t *behavior, beacon_CompiledMethod_t *method)
+{
+    if(!writer || writer->failed)
+        return;
+
+    if(!beacon_BytecodeCacheWriter_writeLiteral(context, writer, &writer->installations, (beacon_oop_t)behavior) ||
+       !beacon_BytecodeCacheWriter_writeCode(context, writer, &writer->installations, &method->super))
+    {
+        writer->failed = true;
+        return;
+    }
+
+    ++writer->installationCount;
+}
+
+void beacon_BytecodeCacheWriter_recordDoIt(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer, beacon_CompiledMethod_t *doItMethod)
+{
+    if(!writer || writer->failed)
+        return;
+
+    beacon_BytecodeCacheBuffer_writeU32(&writer->contents, (uint32_t)writer->installationCount);
+    beacon_BytecodeCacheBuffer_write(&writer->contents, writer->installations.data, writer->installations.size);
+    writer->installations.size = 0;
+    writer->installationCount = 0;
+
+    if(!beacon_BytecodeCacheWriter_writeCode(context, writer, &writer->contents, &doItMethod->super))
+    {
+        writer->failed = true;
+        return;
+    }
+
+    ++writer->recordedStatementCount;
+}
+
+void beacon_BytecodeCacheWriter_end(beacon_context_t *context, beacon_BytecodeCacheWriter_t *writer)
+{
+    if(!writer)
+        return;
+
+    if(!writer->failed && writer->recordedStatementCount == writer->statementCount)
+    {
+        beacon_BytecodeCache_makeDirectories(context->options.bytecodeCacheDirectory);
+
+        // Write into a temporary file first, so that a partially written entry is never read. The workers of a process write with their own contexts.
+        char *fileName = beacon_BytecodeCache_makeEntryFileName(context, writer->key);
+        size_t temporaryFileNameSize = strlen(fileName) + 64;
+        char *temporaryFileName = malloc(temporaryFileNameSize);
+        snprintf(temporaryFileName, temporaryFileNameSize, "%s.%d.%p.tmp", fileName, (int)beacon_getpid(), (void*)context);
+
+        FILE *file = fopen(temporaryFileName, "wb");
+        if(file)
+        {
+            bool succeeded = fwrite(writer->contents.data, writer->contents.size, 1, file) == 1;
+            succeeded = fclose(file) == 0 && succeeded;
+            if(!succeeded || rename(temporaryFileName, fileName) != 0)
+                remove(temporaryFileName);
+        }
+
+        free(temporaryFileName);
+        free(fileName);
+    }
+
+    free(writer->contents.data);
+    free(writer->installations.data);
+    free(writer);
+}
+
+//==============================================================================
+// Reader
+//==============================================================================
+
+static bool beacon_BytecodeCacheReader_read(beacon_BytecodeCacheReader_t *reader, void *data, size_t size)
+{
+    if(reader->position + size > reader->size)
+        return false;
+
+    memcpy(data, reader->data + reader->position, size);
+    reader->position += size;
+    return true;
+}
+
+static bool beacon_BytecodeCacheReader_readU8(beacon_BytecodeCacheReader_t *reader, uint8_t *value)
+{
+    return beacon_BytecodeCacheReader_read(reader, value, 1);
+}
+
+static bool beacon_BytecodeCacheReader_readU32(beacon_BytecodeCacheReader_t *reader, uint32_t *value)
+{
+    return beacon_BytecodeCacheReader_read(reader, value, sizeof(*value));
+}
+
+static bool beacon_BytecodeCacheReader_readU64(beacon_BytecodeCacheReader_t *reader, uint64_t *value)
+{
+    return beacon_BytecodeCacheReader_read(reader, value, sizeof(*value));
+}
+
+static bool beacon_BytecodeCacheReader_readBytes(beacon_BytecodeCacheReader_t *reader, const uint8_t **data, size_t *size)
+{
+    uint32_t byteCount = 0;
+    if(!beacon_BytecodeCacheReader_readU32(reader, &byteCount) || reader->position + byteCount > reader->size)
+        return false;
+
+    *data = reader->data + reader->position;
+    *size = byteCount;
+    reader->position += byteCount;
+    return true;
+}
+
+static bool beacon_BytecodeCacheReader_readCode(beacon_context_t *context, beacon_BytecodeCacheReader_t *reader, beacon_Behavior_t *installationBehavior, beacon_CompiledCode_t **outCode);
+
+static bool beacon_BytecodeCacheReader_readLiteral(beacon_context_t *context, beacon_BytecodeCacheReader_t *reader, beacon_oop_t *outLiteral)
+{
+    uint8_t kind = 0;
+    if(!beacon_BytecodeCacheReader_readU8(reader, &kind))
+        return false;
+
+    const uint8_t *bytes = NULL;
+    size_t byteCount = 0;
+    switch(kind)
+    {
+    case BytecodeCacheLiteralImmediate:
+        {
+            uint64_t immediate = 0;
+            if(!beacon_BytecodeCacheReader_readU64(reader, &immediate))
+                return false;
+            *outLiteral = (beacon_oop_t)immediate;
+            return true;
+        }
+    case BytecodeCacheLiteralTrue:
+        *outLiteral = context->roots.trueValue;
+        return true;
+    case BytecodeCacheLiteralFalse:
+        *outLiteral = context->roots.falseValue;
+        return true;
+    case BytecodeCacheLiteralFileDirectory:
+        *outLiteral = (beacon_oop_t)reader->sourceCode->directory;
+        return true;
+    case BytecodeCacheLiteralFileName:
+        *outLiteral = (beacon_oop_t)reader->sourceCode->name;
+        return true;
+    case BytecodeCacheLiteralSymbol:
+        if(!beacon_BytecodeCacheReader_readBytes(reader, &bytes, &byteCount))
+            return false;
+        *outLiteral = (beacon_oop_t)beacon_internStringWithSize(context, byteCount, (const char*)bytes);
+        return true;
+    case BytecodeCacheLiteralString:
+    case BytecodeCacheLiteralByteArray:
+        {
+            if(!beacon_BytecodeCacheReader_readBytes(reader, &bytes, &byteCount))
+                return false;
+
+            beacon_Behavior_t *literalClass = kind == BytecodeCacheLiteralString ? context->classes.stringClass : context->classes.byteArrayClass;
+            beacon_ByteArray_t *byteArray = beacon_allocateObjectWithBehavior(context->heap, literalClass, sizeof(beacon_ByteArray_t) + byteCount, BeaconObjectKindBytes);
+            memcpy(byteArray->elements, bytes, byteCount);
+            *outLiteral = (beacon_oop_t)byteArray;
+            return true;
+        }
+    case BytecodeCacheLiteralArray:
+        {
+            uint32_t elementCount = 0;
+            if(!beacon_BytecodeCacheReader_readU32(reader, &elementCount))
+                return false;
+
+            beacon_Array_t *array = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + elementCount*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+            for(uint32_t i = 0; i < elementCount; ++i)
+            {
+                if(!beacon_BytecodeCacheReader_readLiteral(context, reader, &array->elements[i]))
+                    return false;
+            }
+            *outLiteral = (beacon_oop_t)array;
+            return true;
+        }
+    case BytecodeCacheLiteralGlobal:
+    case BytecodeCacheLiteralClassOfGlobal:
+        {
+            if(!beacon_BytecodeCacheReader_readBytes(reader, &bytes, &byteCount))
+                return false;
+
+            beacon_Symbol_t *globalName = beacon_internStringWithSize(context, byteCount, (const char*)bytes);
+            if(!beacon_MethodDictionary_includesKey(context, context->roots.systemDictionary, globalName))
+                return false;
+
+            beacon_oop_t global = beacon_MethodDictionary_atOrNil(context, context->roots.systemDictionary, globalName);
+            *outLiteral = kind == BytecodeCacheLiteralGlobal ? global : (beacon_oop_t)beacon_getClass(context, global);
+            return true;
+        }
+    case BytecodeCacheLiteralCompiledBlock:
+    case BytecodeCacheLiteralCompiledMethod:
+        return beacon_BytecodeCacheReader_readCode(context, reader, NULL, (beacon_CompiledCode_t**)outLiteral);
+    case BytecodeCacheLiteralCleanBlockClosure:
+        {
+            beacon_CompiledCode_t *code = NULL;
+            if(!beacon_BytecodeCacheReader_readCode(context, reader, NULL, &code))
+                return false;
+
+            beacon_BlockClosure_t *blockClosure = beacon_allocateObjectWithBehavior(context->heap, context->classes.blockClosureClass, sizeof(beacon_BlockClosure_t), BeaconObjectKindPointers);
+            blockClosure->captures = context->roots.emptyArray;
+            blockClosure->code = (beacon_CompiledBlock_t*)code;
+            *outLiteral = (beacon_oop_t)blockClosure;
+            return true;
+        }
+    default:
+        return false;
+    }
+}
+
+static bool beacon_BytecodeCacheReader_readLazyMethod(beacon_context_t *context, beacon_BytecodeCacheReader_t *reader, beacon_Behavior_t *behavior, beacon_CompiledCode_t **outCode)
+{
+    beacon_oop_t selector = 0;
+    uint64_t argumentCount = 0;
+    beacon_SourcePosition_t *sourcePosition = beacon_allocateObjectWithBehavior(context->heap, context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
+    sourcePosition->sourceCode = reader->sourceCode;
+    if(!behavior ||
+       !beacon_BytecodeCacheReader_readLiteral(context, reader, &selector) ||
+       !beacon_BytecodeCacheReader_readU64(reader, &argumentCount) ||
+       !beacon_BytecodeCacheReader_readU64(reader, (uint64_t*)&sourcePosition->startIndex) ||
+       !beacon_BytecodeCacheReader_readU64(reader, (uint64_t*)&sourcePosition->endIndex))
+        return false;
+
+    *outCode = &beacon_makeLazyMethod(context, (beacon_Symbol_t*)selector, argumentCount, sourcePosition, behavior)->super;
+    return true;
+}
+
+static bool beacon_BytecodeCacheReader_readCode(beacon_context_t *context, beacon_BytecodeCacheReader_t *reader, beacon_Behavior_t *installationBehavior, beacon_CompiledCode_t **outCode)
+{
+    uint8_t kind = 0;
+    if(!beacon_BytecodeCacheReader_readU8(reader, &kind))
+        return false;
+
+    if(kind == BytecodeCacheCodeLazyMethod)
+        return beacon_BytecodeCacheReader_readLazyMethod(context, reader, installationBehavior, outCode);
+
+    beacon_CompiledCode_t *code = NULL;
+    if(kind == BytecodeCacheCodeBlock)
+    {
+        beacon_CompiledBlock_t *compiledBlock = beacon_allocateObjectWithBehavior(context->heap, context->classes.compiledBlockClass, sizeof(beacon_CompiledBlock_t), BeaconObjectKindPointers);
+        uint64_t captureCount = 0;
+        if(!beacon_BytecodeCacheReader_readU64(reader, &captureCount))
+            return false;
+        compiledBlock->captureCount = (beacon_oop_t)captureCount;
+        code = &compiledBlock->super;
+    }
+    else if(kind == BytecodeCacheCodeMethod)
+    {
+        beacon_CompiledMethod_t *compiledMethod = beacon_allocateObjectWithBehavior(context->heap, context->classes.compiledMethodClass, sizeof(beacon_CompiledMethod_t), BeaconObjectKindPointers);
+        if(!beacon_BytecodeCacheReader_readLiteral(context, reader, (beacon_oop_t*)&compiledMethod->name))
+            return false;
+        code = &compiledMethod->super;
+    }
+    else
+    {
+        return false;
+    }
+
+    beacon_BytecodeCode_t *bytecode = beacon_allocateObjectWithBehavior(context->heap, context->classes.bytecodeCodeClass, sizeof(beacon_BytecodeCode_t), BeaconObjectKindPointers);
+    uint64_t argumentCount = 0;
+    uint64_t bytecodeArgumentCount = 0;
+    uint64_t temporaryCount = 0;
+    uint64_t captureCount = 0;
+    uint8_t hasSourcePosition = 0;
+    if(!beacon_BytecodeCacheReader_readU64(reader, &argumentCount) ||
+       !beacon_BytecodeCacheReader_readU64(reader, &bytecodeArgumentCount) ||
+       !beacon_BytecodeCacheReader_readU64(reader, &temporaryCount) ||
+       !beacon_BytecodeCacheReader_readU64(reader, &captureCount) ||
+       !beacon_BytecodeCacheReader_readU8(reader, &hasSourcePosition))
+        return false;
+
+    code->argumentCount = (beacon_oop_t)argumentCount;
+    bytecode->argumentCount = (beacon_oop_t)bytecodeArgumentCount;
+    bytecode->temporaryCount = (beacon_oop_t)temporaryCount;
+    bytecode->captureCount = (beacon_oop_t)captureCount;
+    bytecode->invocationCount = beacon_encodeSmallInteger(0);
+    bytecode->backwardJumpCount = beacon_encodeSmallInteger(0);
+    bytecode->sendCount = beacon_encodeSmallInteger(0);
+
+    if(hasSourcePosition)
+    {
+        beacon_SourcePosition_t *sourcePosition = beacon_allocateObjectWithBehavior(context->heap, context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
+        sourcePosition->sourceCode = reader->sourceCode;
+        if(!beacon_BytecodeCacheReader_readU64(reader, (uint64_t*)&sourcePosition->startIndex) ||
+           !beacon_BytecodeCacheReader_readU64(reader, (uint64_t*)&sourcePosition->endIndex))
+            return false;
+        code->sourcePosition = sourcePosition;
+    }
+
+    const uint8_t *bytecodes = NULL;
+    size_t bytecodesSize = 0;
+    if(!beacon_BytecodeCacheReader_readBytes(reader, &bytecodes, &bytecodesSize))
+        return false;
+    bytecode->bytecodes = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + bytecodesSize, BeaconObjectKindBytes);
+    memcpy(bytecode->bytecodes->elements, bytecodes, bytecodesSize);
+
+    uint32_t literalCount = 0;
+    if(!beacon_BytecodeCacheReader_readU32(reader, &literalCount))
+        return false;
+    bytecode->literals = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + literalCount*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+    for(uint32_t i = 0; i < literalCount; ++i)
+    {
+        if(!beacon_BytecodeCacheReader_readLiteral(context, reader, &bytecode->literals->elements[i]))
+            return false;
+    }
+    bytecode->literals = beacon_internLiteralFrame(context, literalCount, bytecode->literals->elements);
+
+    code->bytecodeImplementation = bytecode;
+    if(kind == BytecodeCacheCodeMethod && ((beacon_CompiledMethod_t*)code)->name)
+        beacon_CompiledCode_detectQuickMethod(context, code);
+
+    *outCode = code;
+    return true;
+}
+
+beacon_BytecodeCacheReader_t *beacon_BytecodeCacheReader_open(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
+{
+    if(!beacon_BytecodeCache_isCacheable(context, sourceCode))
+        return NULL;
+
+    uint64_t key = beacon_BytecodeCache_computeKey(context, sourceCode);
+    char *fileName = beacon_BytecodeCache_makeEntryFileName(context, key);
+    FILE *file = fopen(fileName, "rb");
+    free(fileName);
+    if(!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if(fileSize <= 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    beacon_BytecodeCacheReader_t *reader = calloc(1, sizeof(beacon_BytecodeCacheReader_t));
+    reader->sourceCode = sourceCode;
+    reader->size = (size_t)fileSize;
+    reader->data = malloc(reader->size);
+    bool succeeded = fread(reader->data, reader->size, 1, file) == 1;
+    fclose(file);
+
+    // Validate the header.
+    char magic[sizeof(beacon_BytecodeCache_magic)];
+    uint32_t formatVersion = 0;
+    uint64_t entryKey = 0;
+    uint64_t sourceSize = 0;
+    uint32_t localVariableCount = 0;
+    uint32_t statementCount = 0;
+    succeeded = succeeded &&
+        beacon_BytecodeCacheReader_read(reader, magic, sizeof(magic)) &&
+        beacon_BytecodeCacheReader_readU32(reader, &formatVersion) &&
+        beacon_BytecodeCacheReader_readU64(reader, &entryKey) &&
+        beacon_BytecodeCacheReader_readU64(reader, &sourceSize) &&
+        beacon_BytecodeCacheReader_readU32(reader, &localVariableCount) &&
+        beacon_BytecodeCacheReader_readU32(reader, &statementCount) &&
+        !memcmp(magic, beacon_BytecodeCache_magic, sizeof(magic)) &&
+        formatVersion == BEACON_BYTECODE_CACHE_FORMAT_VERSION &&
+        entryKey == key &&
+        sourceSize == sourceCode->text->super.super.super.super.super.header.slotCount;
+
+    if(!succeeded)
+    {
+        beacon_BytecodeCacheReader_close(reader);
+        return NULL;
+    }
+
+    reader->localVariableCount = localVariableCount;
+    reader->statementCount = statementCount;
+    return reader;
+}
+
+size_t beacon_BytecodeCacheReader_getLocalVariableCount(beacon_BytecodeCacheReader_t *reader)
+{
+    return reader->localVariableCount;
+}
+
+size_t beacon_BytecodeCacheReader_getStatementCount(beacon_BytecodeCacheReader_t *reader)
+{
+    return reader->statementCount;
+}
+
+beacon_CompiledMethod_t *beacon_BytecodeCacheReader_nextDoIt(beacon_context_t *context, beacon_BytecodeCacheReader_t *reader)
+{
+    // Nothing is installed until the whole statement is loaded, so that it can still be compiled from the source.
+    uint32_t installationCount = 0;
+    if(!beacon_BytecodeCacheReader_readU32(reader, &installationCount))
+        return NULL;
+
+    beacon_oop_t *installations = calloc(installationCount*2, sizeof(beacon_oop_t));
+    bool succeeded = true;
+    for(uint32_t i = 0; i < installationCount && succeeded; ++i)
+    {
+        succeeded = beacon_BytecodeCacheReader_readLiteral(context, reader, &installations[i*2]) &&
+            !beacon_isImmediate(installations[i*2]) &&
+            beacon_BytecodeCacheReader_readCode(context, reader, (beacon_Behavior_t*)installations[i*2], (beacon_CompiledCode_t**)&installations[i*2 + 1]);
+    }
+
+    beacon_CompiledCode_t *doItCode = NULL;
+    succeeded = succeeded && beacon_BytecodeCacheReader_readCode(context, reader, NULL, &doItCode);
+    if(succeeded)
+    {
+        for(uint32_t i = 0; i < installationCount; ++i)
+        {
+            beacon_Behavior_t *behavior = (beacon_Behavior_t *)installations[i*2];
+            beacon_CompiledMethod_t *method = (beacon_CompiledMethod_t *)installations[i*2 + 1];
+            if(!behavior->methodDict)
+                behavior->methodDict = beacon_MethodDictionary_new(context);
+            beacon_MethodDictionary_atPut(context, behavior->methodDict, method->name, (beacon_oop_t)method);
+        }
+    }
+
+    free(installations);
+    return succeeded ? (beacon_CompiledMethod_t *)doItCode : NULL;
+}
+
+void beacon_BytecodeCacheReader_close(beacon_BytecodeCacheReader_t *reader)
+{
+    if(!reader)
+        return;
+
+    free(reader->data);
+    free(reader);
+}
@@ -3,14 +3,23 @@
 #include "beacon-lang/Dictionary.h"
 #include "beacon-lang/Exceptions.h"
 #include "beacon-lang/Bytecode.h"
+#include "beacon-lang/Jit.h"
 #include "beacon-lang/ArrayList.h"
 #include "beacon-lang/SourceCode.h"
+#include "beacon-lang/SyntaxCompiler.h"
+#include "beacon-lang/Profiler.h"
+#include "beacon-lang/Process.h"
+#include "beacon-lang/TimerWheel.h"
+#include "beacon-lang/ThreadPool.h"
+#include "beacon-lang/Worker.h"
 #include "beacon-lang/AgpuRendering.h"
+#include "beacon-lang/Window.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 #include <unistd.h>
 
 void beacon_context_registerObjectBasicPrimitives(beacon_context_t *context);
@@ -25,6 +34,10 @@ void beacon_context_registerWindowSystemPrimitives(beacon_context_t *context);
 void beacon_context_registerSourceCodePrimitives(beacon_context_t *context);
 void beacon_context_registerParseTreeCompilationPrimitives(beacon_context_t *context);
 void beacon_context_registerLinearAlgebraPrimitives(beacon_context_t *context);
+void beacon_context_registerProcessPrimitives(beacon_context_t *context);
+void beacon_context_registerTimerWheelPrimitives(beacon_context_t *context);
+void beacon_context_registerWorkerPrimitives(beacon_context_t *context);
+void beacon_context_registerThreadPoolPrimitives(beacon_context_t *context);
 
 static size_t beacon_context_computeBehaviorSlotCount(beacon_context_t *context, beacon_Behavior_t *behavior)
 {
@@ -133,7 +146,16 @@ static void beacon_context_fixEarlyObjectClasses(beacon_context_t *context, beac
 
     beacon_Class_t *class = (beacon_Class_t*)earlyClassBehavior;
 
-    ((beacon_ObjectHeader_t*)earlyClassBehavior->slots)->behavior = context->classes.arrayClass;
+    beacon_Array_t *slots = (beacon_Array_t*)earlyClassBehavior->slots;
+    slots->super.super.super.super.super.header.behavior = context->classes.arrayClass;
+    size_t slotCount = slots->super.super.super.super.super.header.slotCount;
+    for(size_t i = 0; i < slotCount; ++i)
+    {
+        beacon_Slot_t *slot = (beacon_Slot_t*)slots->elements[i];
+        slot->super.super.header.behavior = context->classes.slotClass;
+        ((beacon_ObjectHeader_t*)slot->name)->behavior = context->classes.symbolClass;
+    }
+
     ((beacon_ObjectHeader_t*)class->name)->behavior = context->classes.symbolClass;
     ((beacon_ObjectHeader_t*)class->subclasses)->behavior = context->classes.arrayClass;
 }
@@ -219,22 +241,22 @@ static void beacon_context_createBaseClassHierarchy(beacon_context_t *context)
 
     context->classes.nativeCodeClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "NativeCode", sizeof(beacon_NativeCode_t), BeaconObjectKindBytes, NULL);
     context->classes.bytecodeCodeClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "BytecodeCode", sizeof(beacon_BytecodeCode_t), BeaconObjectKindPointers,
-        "argumentCount", "temporaryCount", "captureCount", "literals", "bytecodes", NULL);
+        "argumentCount", "temporaryCount", "captureCount", "literals", "bytecodes", "invocationCount", "backwardJumpCount", "sendCount", "jitCompiledCode", NULL);
     context->classes.bytecodeCodeBuilderClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "BytecodeCodeBuilder", sizeof(beacon_BytecodeCodeBuilder_t), BeaconObjectKindPointers,
         "arguments", "temporaries", "literals", "bytecodes", NULL);
     context->classes.compiledCodeClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "CompiledCode", sizeof(beacon_CompiledCode_t), BeaconObjectKindPointers,
-        "argumentCount",  "nativeImplementation", "bytecodeImplementation", "sourcePosition", NULL);
+        "argumentCount",  "nativeImplementation", "bytecodeImplementation", "sourcePosition", "quickMethodKind", "quickMethodValue", NULL);
     context->classes.compiledBlockClass = beacon_context_createClassAndMetaclass(context, context->classes.compiledCodeClass, "CompiledBlock", sizeof(beacon_CompiledBlock_t), BeaconObjectKindPointers,
         "captureCount", NULL);
     context->classes.compiledMethodClass = beacon_context_createClassAndMetaclass(context, context->classes.compiledCodeClass, "CompiledMethod", sizeof(beacon_CompiledMethod_t), BeaconObjectKindPointers,
-        "name", NULL);
+        "name", "lazyCompilationEnvironment", NULL);
     context->classes.blockClosureClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "BlockClosure", sizeof(beacon_BlockClosure_t), BeaconObjectKindPointers,
-        "code", "captures", NULL);
+        "code", "captures", "receiver", NULL);
     context->classes.messageClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Message", sizeof(beacon_Message_t), BeaconObjectKindPointers,
         "selector", "arguments", NULL);
 
     context->classes.sourceCodeClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "SourceCode", sizeof(beacon_SourceCode_t), BeaconObjectKindPointers,
-        "directory", "name", "text", "textSize", NULL);
+        "directory", "name", "text", "textSize", "lineStartIndices", NULL);
     context->classes.sourcePositionClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "SourcePosition", sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers,
         "sourceCode", "startIndex", "endIndex", "startLine", "endLine", "startColumn", "endColumn", NULL);
     context->classes.scannerTokenClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "ScannerToken", sizeof(beacon_ScannerToken_t), BeaconObjectKindPointers,
@@ -288,7 +310,7 @@ static void beacon_context_createBaseClassHierarchy(beacon_context_t *context)
     context->classes.lexicalCompilationEnvironmentClass = beacon_context_createClassAndMetaclass(context, context->classes.abstractCompilationEnvironmentClass, "LexicalCompilationEnvironment", sizeof(beacon_LexicalCompilationEnvironment_t), BeaconObjectKindPointers,
         "parent", "dictionary", NULL);
     context->classes.blockClosureCompilationEnvironmentClass = beacon_context_createClassAndMetaclass(context, context->classes.abstractCompilationEnvironmentClass, "BlockClosureCompilationEnvironment", sizeof(beacon_BlockClosureCompilationEnvironment_t), BeaconObjectKindPointers,
-        "parent", "captureList", "dictionary", NULL);
+        "parent", "captureList", "dictionary", "usesReceiverSlots", NULL);
 
     context->classes.methodCompilationEnvironmentClass = beacon_context_createClassAndMetaclass(context, context->classes.abstractCompilationEnvironmentClass, "MethodCompilationEnvironment", sizeof(beacon_MethodCompilationEnvironment_t), BeaconObjectKindPointers,
         "parent", "dictionary", NULL);
@@ -302,6 +324,7 @@ static void beacon_context_createBaseClassHierarchy(beacon_context_t *context)
     context->classes.messageNotUnderstoodClass = beacon_context_createClassAndMetaclass(context, context->classes.errorClass, "MessageNotUnderstood", sizeof(beacon_MessageNotUnderstood_t), BeaconObjectKindPointers,
         "message", "receiver", "reachedDefaultHandler", NULL);
     context->classes.nonBooleanReceiverClass = beacon_context_createClassAndMetaclass(context, context->classes.errorClass, "NonBooleanReceiver", sizeof(beacon_NonBooleanReceiver_t), BeaconObjectKindPointers, NULL);
+    context->classes.stackOverflowClass = beacon_context_createClassAndMetaclass(context, context->classes.errorClass, "StackOverflow", sizeof(beacon_StackOverflow_t), BeaconObjectKindPointers, NULL);
     context->classes.unhandledExceptionClass = beacon_context_createClassAndMetaclass(context, context->classes.exceptionClass, "UnhandledException", sizeof(beacon_UnhandledException_t), BeaconObjectKindPointers, NULL);
     context->classes.unhandledErrorClass = beacon_context_createClassAndMetaclass(context, context->classes.unhandledExceptionClass, "UnhandledError", sizeof(beacon_UnhandledError_t), BeaconObjectKindPointers, NULL);
 
@@ -312,6 +335,20 @@ static void beacon_context_createBaseClassHierarchy(beacon_context_t *context)
         "handle", NULL);
     context->classes.stdioClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Stdio", sizeof(beacon_Stdio_t), BeaconObjectKindPointers, NULL);
     context->classes.stdioStreamClass = beacon_context_createClassAndMetaclass(context, context->classes.abstractBinaryFileStreamClass, "StdioStream", sizeof(beacon_Stdio_t), BeaconObjectKindPointers, NULL);
+    context->classes.timeClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Time", sizeof(beacon_Time_t), BeaconObjectKindPointers, NULL);
+    context->classes.processClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Process", sizeof(beacon_Process_t), BeaconObjectKindPointers,
+        "nextLink", "block", "priority", "name", "myList", "handle", "isTerminated", NULL);
+    context->classes.semaphoreClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Semaphore", sizeof(beacon_Semaphore_t), BeaconObjectKindPointers,
+        "firstLink", "lastLink", "excessSignals", NULL);
+    context->classes.processorClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Processor", sizeof(beacon_Processor_t), BeaconObjectKindPointers, NULL);
+    context->classes.timerClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Timer", sizeof(beacon_Timer_t), BeaconObjectKindPointers,
+        "handle", "semaphore", "block", NULL);
+    context->classes.channelClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Channel", sizeof(beacon_Channel_t), BeaconObjectKindPointers,
+        "handle", NULL);
+    context->classes.workerClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Worker", sizeof(beacon_Worker_t), BeaconObjectKindPointers,
+        "handle", "channel", NULL);
+    context->classes.futureClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Future", sizeof(beacon_Future_t), BeaconObjectKindPointers,
+        "value", "error", "isDone", "semaphore", NULL);
 
     context->classes.pointClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Point", sizeof(beacon_Point_t), BeaconObjectKindPointers,
         "x", "y", NULL);
@@ -343,7 +380,7 @@ static void beacon_context_createBaseClassHierarchy(beacon_context_t *context)
 
     context->classes.windowClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "Window", sizeof(beacon_Window_t), BeaconObjectKindPointers,
         "width", "height", "handle", "rendererHandle", "textureHandle", "textureWidth", "textureHeight", "drawingForm",
-        "useAcceleratedRendering", "swapChainHandle", NULL);
+        "useAcceleratedRendering", "swapChainHandle", "needsRedraw", "reusesEvents", NULL);
 
     context->classes.windowEventClass = beacon_context_createClassAndMetaclass(context, context->classes.objectClass, "WindowEvent", sizeof(beacon_WindowEvent_t), BeaconObjectKindPointers, NULL);
     context->classes.windowExposeEventClass = beacon_context_createClassAndMetaclass(context, context->classes.windowEventClass, "WindowExposeEvent", sizeof(beacon_WindowExposeEvent_t), BeaconObjectKindPointers,
@@ -436,7 +473,32 @@ void beacon_context_createImportantRoots(beacon_context_t *context)
         context->roots.lessOrEqualsSelector = (beacon_oop_t)beacon_internCString(context, "<=");
     }
 
-    context->roots.windowHandleMap = beacon_MethodDictionary_new(context);
+    {
+        context->roots.doSelector = (beacon_oop_t)beacon_internCString(context, "do:");
+        context->roots.collectSelector = (beacon_oop_t)beacon_internCString(context, "collect:");
+        context->roots.selectSelector = (beacon_oop_t)beacon_internCString(context, "select:");
+        context->roots.injectIntoSelector = (beacon_oop_t)beacon_internCString(context, "inject:into:");
+    }
+
+    {
+        context->roots.newSelector = (beacon_oop_t)beacon_internCString(context, "new");
+        context->roots.newWithSizeSelector = (beacon_oop_t)beacon_internCString(context, "new:");
+        context->roots.addSelector = (beacon_oop_t)beacon_internCString(context, "add:");
+        context->roots.asArraySelector = (beacon_oop_t)beacon_internCString(context, "asArray");
+    }
+
+    context->roots.renderSelector = (beacon_oop_t)beacon_internCString(context, "render");
+    context->roots.onExposeSelector = (beacon_oop_t)beacon_internCString(context, "onExpose:");
+    context->roots.onMouseButtonDownSelector = (beacon_oop_t)beacon_internCString(context, "onMouseButtonDown:");
+    context->roots.onMouseButtonUpSelector = (beacon_oop_t)beacon_internCString(context, "onMouseButtonUp:");
+    context->roots.onMouseMotionSelector = (beacon_oop_t)beacon_internCString(context, "onMouseMotion:");
+    context->roots.onMouseWheelSelector = (beacon_oop_t)beacon_internCString(context, "onMouseWheel:");
+    context->roots.onKeyPressedSelector = (beacon_oop_t)beacon_internCString(context, "onKeyPressed:");
+    context->roots.onKeyReleasedSelector = (beacon_oop_t)beacon_internCString(context, "onKeyReleased:");
+    context->roots.onTextInputSelector = (beacon_oop_t)beacon_internCString(context, "onTextInput:");
+    context->roots.onSizeChangedSelector = (beacon_oop_t)beacon_internCString(context, "onSizeChanged");
+    context->roots.onCloseRequestSelector = (beacon_oop_t)beacon_internCString(context, "onCloseRequest");
+    context->roots.windowTable = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + BEACON_WINDOW_TABLE_INITIAL_CAPACITY*sizeof(beacon_oop_t), BeaconObjectKindPointers);
     context->roots.agpuCommon = beacon_allocateObjectWithBehavior(context->heap, context->classes.agpuClass, sizeof(beacon_AGPU_t), BeaconObjectKindBytes);
     context->roots.agpuCommon->debugLayerEnabled = true;
 }
@@ -478,15 +540,29 @@ void beacon_context_registerBasicPrimitives(beacon_context_t *context)
     beacon_context_registerSourceCodePrimitives(context);
     beacon_context_registerParseTreeCompilationPrimitives(context);
     beacon_context_registerLinearAlgebraPrimitives(context);
+    beacon_context_registerProcessPrimitives(context);
+    beacon_context_registerTimerWheelPrimitives(context);
+    beacon_context_registerWorkerPrimitives(context);
+    beacon_context_registerThreadPoolPrimitives(context);
 }
 
 beacon_context_t *beacon_context_new(void)
 {
     beacon_context_t *context = calloc(1, sizeof(beacon_context_t));
+    mtx_init(&context->internedSymbolSetMutex, mtx_plain);
     context->heap = beacon_createMemoryHeap(context);
+    context->options.inlineCollectionIterationSelectors = true;
+    context->options.maxStackDepth = BEACON_DEFAULT_MAX_STACK_DEPTH;
+#ifdef BEACON_JIT
+    context->options.jitCompilationThreshold = BEACON_JIT_DEFAULT_COMPILATION_THRESHOLD;
+#endif
     context->roots.internedSymbolSet = beacon_allocateObject(context->heap, sizeof(beacon_InternedSymbolSet_t), BeaconObjectKindPointers);
-    context->roots.internedSymbolSet->super.array = beacon_allocateObject(context->heap, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*2048, BeaconObjectKindPointers);
+    context->roots.internedSymbolSet->super.array = beacon_allocateObject(context->heap, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*BEACON_INTERNED_SYMBOL_SET_INITIAL_CAPACITY, BeaconObjectKindWeakPointers);
     context->roots.internedSymbolSet->super.tally = beacon_encodeSmallInteger(0);
+    context->roots.internedSymbolSet->oldArrayMigrationIndex = beacon_encodeSmallInteger(0);
+    context->roots.literalFrameSet = beacon_allocateObject(context->heap, sizeof(beacon_HashedCollection_t), BeaconObjectKindPointers);
+    context->roots.literalFrameSet->array = beacon_allocateObject(context->heap, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*BEACON_LITERAL_FRAME_SET_INITIAL_CAPACITY, BeaconObjectKindWeakPointers);
+    context->roots.literalFrameSet->tally = beacon_encodeSmallInteger(0);
     beacon_context_createBaseClassHierarchy(context);
     beacon_context_createImportantRoots(context);
     beacon_context_createSystemDictionary(context);
@@ -496,16 +572,128 @@ beacon_context_t *beacon_context_new(void)
 
 void beacon_context_destroy(beacon_context_t *context)
 {
+    beacon_Profiler_shutdown(context);
+    beacon_WorkerRegistry_destroy(context);
+    beacon_AsyncTasks_destroy(context);
+    beacon_TimerWheel_destroy(context);
+    beacon_ProcessScheduler_destroy(context);
+#ifdef BEACON_JIT
+    beacon_jit_destroy(context);
+#endif
     beacon_destroyMemoryHeap(context->heap);
+    mtx_destroy(&context->internedSymbolSetMutex);
     free(context);
 }
 
+void beacon_Window_registerHandle(beacon_context_t *context, beacon_Window_t *window, uint32_t windowIndex)
+{
+    beacon_Array_t *table = context->roots.windowTable;
+    size_t capacity = table->super.super.super.super.super.header.slotCount;
+    if(windowIndex >= capacity)
+    {
+        size_t newCapacity = capacity*2;
+        if(newCapacity <= windowIndex)
+            newCapacity = (size_t)windowIndex + 1;
+
+        beacon_Array_t *newTable = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + newCapacity*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+        memcpy(newTable->elements, table->elements, capacity*sizeof(beacon_oop_t));
+        context->roots.windowTable = table = newTable;
+    }
+
+    table->elements[windowIndex] = (beacon_oop_t)window;
+}
+
+void beacon_Window_unregisterHandle(beacon_context_t *context, uint32_t windowIndex)
+{
+    beacon_Array_t *table = context->roots.windowTable;
+    if(windowIndex < table->super.super.super.super.super.header.slotCount)
+        table->elements[windowIndex] = 0;
+}
+
+beacon_Window_t *beacon_Window_fromHandle(beacon_context_t *context, uint32_t windowIndex)
+{
+    beacon_Array_t *table = context->roots.windowTable;
+    if(windowIndex >= table->super.super.super.super.super.header.slotCount)
+        return NULL;
+    return (beacon_Window_t *)table->elements[windowIndex];
+}
+
+bool beacon_Window_renderInvalidWindows(beacon_context_t *context)
+{
+    bool hasInvalidWindows = false;
+
+    // The table is fetched again on each step, because a window that opens while rendering may grow it.
+    for(size_t i = 0; i < context->roots.windowTable->super.super.super.super.super.header.slotCount; ++i)
+    {
+        beacon_Window_t *window = (beacon_Window_t *)context->roots.windowTable->elements[i];
+        if(!window || window->needsRedraw != context->roots.trueValue)
+            continue;
+
+        window->needsRedraw = context->roots.falseValue;
+        beacon_perform(context, (beacon_oop_t)window, context->roots.renderSelector);
+        hasInvalidWindows = hasInvalidWindows || window->needsRedraw == context->roots.trueValue;
+    }
+
+    return hasInvalidWindows;
+}
+
+void *beacon_Window_makeEvent(beacon_context_t *context, beacon_Window_t *window, beacon_oop_t *reusableEvent, beacon_Behavior_t *eventClass, size_t eventSize)
+{
+    if(window->reusesEvents != context->roots.trueValue)
+        return beacon_allocateObjectWithBehavior(context->heap, eventClass, eventSize, BeaconObjectKindPointers);
+
+    if(!*reusableEvent)
+        *reusableEvent = (beacon_oop_t)beacon_allocateObjectWithBehavior(context->heap, eventClass, eventSize, BeaconObjectKindPointers);
+    return (void*)*reusableEvent;
+}
+
+static inline uint64_t beacon_rotateLeft64(uint64_t value, int shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
 uint32_t beacon_computeStringHash(size_t stringSize, const char *string)
 {
-    uint32_t hash = stringSize*1664525;
-    for(size_t i = 0; i < stringSize; ++i)
-        hash = (hash + string[i])*1664525;
-    return hash;
+    // Word at a time hashing, with the rounds and the final avalanche of xxHash64 for short inputs.
+    // See https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md [October, 2026]
+    const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t prime3 = 0x165667B19E3779F9ull;
+    const uint64_t prime4 = 0x85EBCA77C2B2AE63ull;
+    const uint64_t prime5 = 0x27D4EB2F165667C5ull;
+
+    const uint8_t *bytes = (const uint8_t *)string;
+    uint64_t hash = prime5 + stringSize;
+    size_t i = 0;
+    for(; i + 8 <= stringSize; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash ^= beacon_rotateLeft64(word * prime2, 31) * prime1;
+        hash = beacon_rotateLeft64(hash, 27) * prime1 + prime4;
+    }
+
+    if(i + 4 <= stringSize)
+    {
+        uint32_t halfWord;
+        memcpy(&halfWord, bytes + i, 4);
+        hash ^= (uint64_t)halfWord * prime1;
+        hash = beacon_rotateLeft64(hash, 23) * prime2 + prime3;
+        i += 4;
+    }
+
+    for(; i < stringSize; ++i)
+    {
+        hash ^= bytes[i] * prime5;
+        hash = beacon_rotateLeft64(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return (uint32_t)hash;
 }
 
 uint32_t beacon_computeIdentityHash(beacon_oop_t oop)
@@ -529,62 +717,166 @@ beacon_String_t *beacon_importStringWithSize(beacon_context_t *context, size_t s
     return importedString;
 }
 
-intptr_t beacon_InternedSymbolSet_scanForString(beacon_InternedSymbolSet_t *symbolSet, size_t stringSize, const char *string)
+intptr_t beacon_InternedSymbolSet_scanForString(beacon_Array_t *storage, uint32_t stringHash, size_t stringSize, const char *string)
 {
-    beacon_Array_t *storage = symbolSet->super.array;
+    // The capacity is always a power of two.
     size_t capacity = storage->super.super.super.super.super.header.slotCount;
-    size_t stringHash = beacon_computeStringHash(stringSize, string);
-
-    size_t naturalSlot = stringHash % capacity;
-    for(size_t i = naturalSlot; i < capacity; ++i)
+    size_t capacityMask = capacity - 1;
+    size_t slot = stringHash & capacityMask;
+    for(size_t probeCount = 0; probeCount < capacity; ++probeCount)
     {
-        beacon_Symbol_t *storedSymbol = (beacon_Symbol_t *)storage->elements[i];
+        beacon_Symbol_t *storedSymbol = (beacon_Symbol_t *)storage->elements[slot];
         if(beacon_isNil((beacon_oop_t)storedSymbol) || (storedSymbol->super.super.super.super.super.header.slotCount == stringSize
                             && !memcmp(storedSymbol->data, string, stringSize)))
-            return i;
+            return slot;
+        slot = (slot + 1) & capacityMask;
     }
 
-    for(size_t i = 0; i < naturalSlot; ++i)
+    return -1;
+}
+
+/**
+ * Moves a bounded number of symbols from the storage that was replaced by the last growth into the current storage.
+ * This spreads the cost of rehashing across the following interning operations.
+ */
+void beacon_InternedSymbolSet_migrateOldSymbols(beacon_context_t *context, beacon_InternedSymbolSet_t *symbolSet, size_t maxSlotCount)
+{
+    beacon_Array_t *oldStorage = symbolSet->oldArray;
+    if(beacon_isNil((beacon_oop_t)oldStorage))
+        return;
+
+    size_t oldCapacity = oldStorage->super.super.super.super.super.header.slotCount;
+    size_t migrationIndex = beacon_decodeSmallInteger(symbolSet->oldArrayMigrationIndex);
+    size_t migrationEnd = migrationIndex + maxSlotCount;
+    if(migrationEnd > oldCapacity)
+        migrationEnd = oldCapacity;
+
+    beacon_Array_t *storage = symbolSet->super.array;
+    for(; migrationIndex < migrationEnd; ++migrationIndex)
     {
-        beacon_Symbol_t *storedSymbol = (beacon_Symbol_t *)storage->elements[i];
-        if(beacon_isNil((beacon_oop_t)storedSymbol) || (storedSymbol->super.super.super.super.super.header.slotCount == stringSize
-                            && !memcmp(storedSymbol->data, string, stringSize)))
-            return i;
+        beacon_Symbol_t *symbol = (beacon_Symbol_t *)oldStorage->elements[migrationIndex];
+        if(beacon_isNil((beacon_oop_t)symbol) || (beacon_oop_t)symbol == context->roots.weakTombstone)
+            continue;
+
+        size_t symbolSize = symbol->super.super.super.super.super.header.slotCount;
+        uint32_t symbolHash = beacon_computeStringHash(symbolSize, (const char*)symbol->data);
+        intptr_t slot = beacon_InternedSymbolSet_scanForString(storage, symbolHash, symbolSize, (const char*)symbol->data);
+        storage->elements[slot] = (beacon_oop_t)symbol;
     }
 
-    return -1;
+    if(migrationIndex == oldCapacity)
+    {
+        symbolSet->oldArray = (beacon_Array_t*)0;
+        symbolSet->oldArrayMigrationIndex = beacon_encodeSmallInteger(0);
+    }
+    else
+    {
+        symbolSet->oldArrayMigrationIndex = beacon_encodeSmallInteger(migrationIndex);
+    }
 }
 
 void beacon_InternedSymbolSet_incrementCapacity(beacon_context_t *context, beacon_InternedSymbolSet_t *symbolSet)
 {
-    fprintf(stderr, "TODO: beacon_InternedSymbolSet_incrementCapacity");
-    abort();
+    // Finish the previous growth, so that there is at most a single old storage to look into.
+    if(beacon_isNotNil((beacon_oop_t)symbolSet->oldArray))
+        beacon_InternedSymbolSet_migrateOldSymbols(context, symbolSet, symbolSet->oldArray->super.super.super.super.super.header.slotCount);
+
+    size_t oldCapacity = symbolSet->super.array->super.super.super.super.super.header.slotCount;
+    size_t newCapacity = oldCapacity * 2;
+    symbolSet->oldArray = symbolSet->super.array;
+    symbolSet->oldArrayMigrationIndex = beacon_encodeSmallInteger(0);
+    symbolSet->super.array = beacon_allocateObject(context->heap, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*newCapacity, BeaconObjectKindWeakPointers);
 }
 
-beacon_Symbol_t *beacon_internStringWithSize(beacon_context_t *context, size_t stringSize, const char *string)
+void beacon_InternedSymbolSet_removeCollectedSymbols(beacon_context_t *context)
 {
-    intptr_t symbolSetPosition = beacon_InternedSymbolSet_scanForString(context->roots.internedSymbolSet, stringSize, string);
-    if(symbolSetPosition < 0)
+    beacon_InternedSymbolSet_t *symbolSet = context->roots.internedSymbolSet;
+    beacon_oop_t tombstone = context->roots.weakTombstone;
+    if(beacon_isNotNil((beacon_oop_t)symbolSet->oldArray))
+        beacon_InternedSymbolSet_migrateOldSymbols(context, symbolSet, symbolSet->oldArray->super.super.super.super.super.header.slotCount);
+
+    // Take the surviving symbols out of the storage, and insert them again. This keeps the probing sequences free of holes.
+    beacon_Array_t *storage = symbolSet->super.array;
+    size_t capacity = storage->super.super.super.super.super.header.slotCount;
+    size_t survivorCount = 0;
+    bool hasCollectedSymbols = false;
+    for(size_t i = 0; i < capacity; ++i)
     {
-        beacon_InternedSymbolSet_incrementCapacity(context, context->roots.internedSymbolSet);
-        symbolSetPosition = beacon_InternedSymbolSet_scanForString(context->roots.internedSymbolSet, stringSize, string);
-        BeaconAssert(context, symbolSetPosition >= 0);
+        if(storage->elements[i] == tombstone)
+            hasCollectedSymbols = true;
+        else if(beacon_isNotNil(storage->elements[i]))
+            ++survivorCount;
+    }
+
+    if(!hasCollectedSymbols)
+        return;
+
+    beacon_Symbol_t **survivors = malloc(survivorCount * sizeof(beacon_Symbol_t*));
+    size_t destIndex = 0;
+    for(size_t i = 0; i < capacity; ++i)
+    {
+        beacon_oop_t element = storage->elements[i];
+        if(beacon_isNotNil(element) && element != tombstone)
+            survivors[destIndex++] = (beacon_Symbol_t*)element;
+        storage->elements[i] = 0;
     }
 
-    if(beacon_isNotNil(context->roots.internedSymbolSet->super.array->elements[symbolSetPosition]))
-        return (beacon_Symbol_t *)context->roots.internedSymbolSet->super.array->elements[symbolSetPosition];
+    for(size_t i = 0; i < survivorCount; ++i)
+    {
+        beacon_Symbol_t *symbol = survivors[i];
+        size_t symbolSize = symbol->super.super.super.super.super.header.slotCount;
+        uint32_t symbolHash = beacon_computeStringHash(symbolSize, (const char*)symbol->data);
+        intptr_t slot = beacon_InternedSymbolSet_scanForString(storage, symbolHash, symbolSize, (const char*)symbol->data);
+        storage->elements[slot] = (beacon_oop_t)symbol;
+    }
 
+    free(survivors);
+    symbolSet->super.tally = beacon_encodeSmallInteger(survivorCount);
+}
+
+static beacon_Symbol_t *beacon_internStringWithSizeUnlocked(beacon_context_t *context, size_t stringSize, const char *string)
+{
+    beacon_InternedSymbolSet_t *symbolSet = context->roots.internedSymbolSet;
+    uint32_t stringHash = beacon_computeStringHash(stringSize, string);
+    beacon_InternedSymbolSet_migrateOldSymbols(context, symbolSet, BEACON_INTERNED_SYMBOL_SET_MIGRATION_STEP);
+
+    intptr_t symbolSetPosition = beacon_InternedSymbolSet_scanForString(symbolSet->super.array, stringHash, stringSize, string);
+    if(symbolSetPosition >= 0 && beacon_isNotNil(symbolSet->super.array->elements[symbolSetPosition]))
+        return (beacon_Symbol_t *)symbolSet->super.array->elements[symbolSetPosition];
+
+    if(beacon_isNotNil((beacon_oop_t)symbolSet->oldArray))
+    {
+        intptr_t oldPosition = beacon_InternedSymbolSet_scanForString(symbolSet->oldArray, stringHash, stringSize, string);
+        if(oldPosition >= 0 && beacon_isNotNil(symbolSet->oldArray->elements[oldPosition]))
+            return (beacon_Symbol_t *)symbolSet->oldArray->elements[oldPosition];
+    }
+
+    // Keep the load factor below 3/4, which keeps the linear probing sequences short.
+    size_t tally = beacon_decodeSmallInteger(symbolSet->super.tally);
+    size_t capacity = symbolSet->super.array->super.super.super.super.super.header.slotCount;
+    if(symbolSetPosition < 0 || (tally + 1) * 4 > capacity * 3)
+    {
+        beacon_InternedSymbolSet_incrementCapacity(context, symbolSet);
+        symbolSetPosition = beacon_InternedSymbolSet_scanForString(symbolSet->super.array, stringHash, stringSize, string);
+        BeaconAssert(context, symbolSetPosition >= 0);
+    }
 
     beacon_Symbol_t *internedSymbol = beacon_allocateObjectWithBehavior(context->heap, context->classes.symbolClass, sizeof(beacon_Symbol_t) + stringSize, BeaconObjectKindBytes);
     memcpy(internedSymbol->data, string, stringSize);
-    context->roots.internedSymbolSet->super.array->elements[symbolSetPosition] = (beacon_oop_t)internedSymbol;
-    context->roots.internedSymbolSet->super.tally = beacon_encodeSmallInteger(
-        beacon_decodeSmallInteger(context->roots.internedSymbolSet->super.tally) + 1
-    );
-
+    symbolSet->super.array->elements[symbolSetPosition] = (beacon_oop_t)internedSymbol;
+    symbolSet->super.tally = beacon_encodeSmallInteger(tally + 1);
     return internedSymbol;
 }
 
+beacon_Symbol_t *beacon_internStringWithSize(beacon_context_t *context, size_t stringSize, const char *string)
+{
+    // The parser interns symbols from the worker threads of beacon_evaluateSourceCodeFiles.
+    mtx_lock(&context->internedSymbolSetMutex);
+    beacon_Symbol_t *symbol = beacon_internStringWithSizeUnlocked(context, stringSize, string);
+    mtx_unlock(&context->internedSymbolSetMutex);
+    return symbol;
+}
+
 beacon_Symbol_t *beacon_internCString(beacon_context_t *context, const char *string)
 {
     return beacon_internStringWithSize(context, strlen(string), string);
@@ -616,22 +908,50 @@ beacon_Behavior_t *beacon_getClass(beacon_context_t *context, beacon_oop_t recei
 
 beacon_oop_t beacon_runMethodWithArguments(beacon_context_t *context, beacon_CompiledCode_t *method, beacon_oop_t receiver, beacon_oop_t selector, size_t argumentCount, beacon_oop_t *arguments)
 {
+    beacon_oop_t result = 0;
     (void)selector;
+    if(method->quickMethodKind && beacon_CompiledCode_runQuickMethod(context, method, receiver, argumentCount, arguments, &result))
+    {
+        beacon_BytecodeCode_incrementCounter(&method->bytecodeImplementation->invocationCount);
+        return result;
+    }
+
     if(method->nativeImplementation)
         return method->nativeImplementation->nativeFunction(context, receiver, argumentCount, arguments);
     else if(method->bytecodeImplementation)
         return beacon_interpretBytecodeMethod(context, method, receiver, selector, 0, argumentCount, arguments);
 
+    if(beacon_isLazyMethod(context, method))
+    {
+        // Keep the receiver and the arguments alive while the method is being compiled.
+        beacon_StackFrameRecord_t frameRecord = {
+            .kind = StackFramePrimitiveRoots,
+            .context = context,
+            .primitiveRoots = {
+                .receiver = receiver,
+                .argumentCount = argumentCount,
+                .arguments = arguments,
+                .allocatedObjects = {
+                    (beacon_oop_t)method
+                }
+            }
+        };
+        beacon_pushStackFrameRecord(&frameRecord);
+        beacon_compileLazyMethod(context, (beacon_CompiledMethod_t*)method);
+        beacon_popStackFrameRecord(&frameRecord);
+        return beacon_runMethodWithArguments(context, method, receiver, selector, argumentCount, arguments);
+    }
+
     beacon_exception_error(context, "Cannot evaluate a method without any kind of implementation.");
     return 0;
 }
 
-beacon_oop_t beacon_runBlockClosureWithArguments(beacon_context_t *context, beacon_CompiledCode_t *blockClosureCode, beacon_oop_t captures, size_t argumentCount, beacon_oop_t *arguments)
+beacon_oop_t beacon_runBlockClosureWithArguments(beacon_context_t *context, beacon_CompiledCode_t *blockClosureCode, beacon_oop_t receiver, beacon_oop_t captures, size_t argumentCount, beacon_oop_t *arguments)
 {
     if(blockClosureCode->nativeImplementation)
         return blockClosureCode->nativeImplementation->nativeFunction(context, captures, argumentCount, arguments);
     else if(blockClosureCode->bytecodeImplementation)
-        return beacon_interpretBytecodeMethod(context, blockClosureCode, 0, 0, captures, argumentCount, arguments);
+        return beacon_interpretBytecodeMethod(context, blockClosureCode, receiver, 0, captures, argumentCount, arguments);
 
     beacon_exception_error(context, "Cannot evaluate a block closure without code.");
     return 0;
@@ -663,8 +983,7 @@ beacon_oop_t beacon_performWithArgumentsInSuperclass(beacon_context_t *context,
             ((beacon_Symbol_t*)exception->message->selector)->super.super.super.super.super.header.slotCount,
             ((beacon_Symbol_t*)exception->message->selector)->data);
         exception->super.super.messageText = beacon_importCString(context, errorBuffer);
-        beacon_exception_signal(context, &exception->super.super);
-        return 0;
+        return beacon_exception_signal(context, &exception->super.super);
     }
 
     beacon_Array_t *argumentsArray = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + (sizeof(beacon_oop_t)*argumentCount), BeaconObjectKindPointers);
@@ -1293,6 +1612,31 @@ static beacon_oop_t beacon_Stdio_stderr(beacon_context_t *context, beacon_oop_t
     return context->roots.stderrStream;
 }
 
+static beacon_oop_t beacon_Time_microsecondClock(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+
+    return beacon_encodeSmallInteger((intptr_t)beacon_getMonotonicClockMicroseconds());
+}
+
+static beacon_oop_t beacon_Time_cpuMicrosecondClock(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    return beacon_encodeSmallInteger((intptr_t)((uint64_t)clock() * 1000000u / CLOCKS_PER_SEC));
+}
+
+static beacon_oop_t beacon_Time_nanosecondClock(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    return beacon_encodeSmallInteger((intptr_t)beacon_getMonotonicClockNanoseconds());
+}
+
 static beacon_oop_t beacon_AbstractBinaryFileStream_nextPut(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     (void)receiver;
@@ -1409,6 +1753,32 @@ static beacon_oop_t beacon_Symbol_asSymbol(beacon_context_t *context, beacon_oop
     return receiver;
 }
 
+static beacon_oop_t beacon_Symbol_internedSymbolCount(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    return context->roots.internedSymbolSet->super.tally;
+}
+
+static beacon_oop_t beacon_Symbol_internedSymbolTableCapacity(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    return beacon_encodeSmallInteger(context->roots.internedSymbolSet->super.array->super.super.super.super.super.header.slotCount);
+}
+
+static beacon_oop_t beacon_Symbol_internedSymbolTableLoadFactor(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_InternedSymbolSet_t *symbolSet = context->roots.internedSymbolSet;
+    size_t capacity = symbolSet->super.array->super.super.super.super.super.header.slotCount;
+    return beacon_encodeSmallFloat((double)beacon_decodeSmallInteger(symbolSet->super.tally) / (double)capacity);
+}
+
 static beacon_oop_t beacon_Object_value(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     (void)context;
@@ -1423,7 +1793,7 @@ static beacon_oop_t beacon_BlockClosure_value(beacon_context_t *context, beacon_
     intptr_t expectedArgumentCount = beacon_decodeSmallInteger(blockClosure->code->super.argumentCount);
     BeaconAssert(context, (intptr_t)argumentCount == expectedArgumentCount);
 
-    return beacon_runBlockClosureWithArguments(context, &blockClosure->code->super, blockClosure->captures, argumentCount, arguments);
+    return beacon_runBlockClosureWithArguments(context, &blockClosure->code->super, blockClosure->receiver, blockClosure->captures, argumentCount, arguments);
 }
 
 static beacon_oop_t beacon_BlockClosure_ensure(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1443,8 +1813,34 @@ static beacon_oop_t beacon_BlockClosure_ensure(beacon_context_t *context, beacon
     };
     beacon_pushStackFrameRecord(&ensureRecord);
 
-    ensureRecord.ensure.resultValue = beacon_runBlockClosureWithArguments(context, &blockClosureReceiver->code->super, blockClosureReceiver->captures, 0, NULL);
-    beacon_runBlockClosureWithArguments(context, &ensureBlock->code->super, ensureBlock->captures, 0, NULL);
+    ensureRecord.ensure.resultValue = beacon_runBlockClosureWithArguments(context, &blockClosureReceiver->code->super, blockClosureReceiver->receiver, blockClosureReceiver->captures, 0, NULL);
+    ensureRecord.ensure.ensureBlockActivated = true;
+    beacon_runBlockClosureWithArguments(context, &ensureBlock->code->super, ensureBlock->receiver, ensureBlock->captures, 0, NULL);
+
+    beacon_popStackFrameRecord(&ensureRecord);
+    return ensureRecord.ensure.resultValue;
+}
+
+static beacon_oop_t beacon_BlockClosure_ifCurtailed(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    beacon_BlockClosure_t* blockClosureReceiver = (beacon_BlockClosure_t*)receiver;
+    beacon_BlockClosure_t* curtailBlock = (beacon_BlockClosure_t*)arguments[0];
+
+    // The curtail block is only run by the unwinding of the stack.
+    beacon_StackFrameRecord_t ensureRecord = {
+        .context = context,
+        .kind = StackFrameEnsure,
+        .ensure = {
+            .ensureReceiver = (beacon_oop_t)blockClosureReceiver,
+            .ensureBlock = (beacon_oop_t)curtailBlock,
+            .resultValue = 0,
+        }
+    };
+    beacon_pushStackFrameRecord(&ensureRecord);
+
+    ensureRecord.ensure.resultValue = beacon_runBlockClosureWithArguments(context, &blockClosureReceiver->code->super, blockClosureReceiver->receiver, blockClosureReceiver->captures, 0, NULL);
+    ensureRecord.ensure.ensureBlockActivated = true;
 
     beacon_popStackFrameRecord(&ensureRecord);
     return ensureRecord.ensure.resultValue;
@@ -1470,15 +1866,23 @@ static beacon_oop_t beacon_BlockClosure_onDo(beacon_context_t *context, beacon_o
         }
     };
 
+    beacon_BytecodeCacheWriter_t *bytecodeCacheWriter = context->bytecodeCacheWriter;
     beacon_pushStackFrameRecord(&onDoRecord);
 
-    if(_setjmp(onDoRecord.onDo.handlerJumpBuffer))
+    switch(_setjmp(onDoRecord.onDo.handlerJumpBuffer))
     {
-        onDoRecord.onDo.resultValue = beacon_runBlockClosureWithArguments(context, &doBlock->code->super, doBlock->captures, 0, NULL); 
-    }
-    else
-    {
-        onDoRecord.onDo.resultValue = beacon_runBlockClosureWithArguments(context, &blockClosureReceiver->code->super, blockClosureReceiver->captures, 0, NULL);
+    case StackFrameOnDoJumpRetry:
+        context->bytecodeCacheWriter = bytecodeCacheWriter;
+        onDoRecord.onDo.exception = 0;
+        // Fallthrough
+    case StackFrameOnDoJumpNone:
+        onDoRecord.onDo.resultValue = beacon_runBlockClosureWithArguments(context, &blockClosureReceiver->code->super, blockClosureReceiver->receiver, blockClosureReceiver->captures, 0, NULL);
+        break;
+    case StackFrameOnDoJumpReturn:
+    default:
+        // The handler already stored the value to return before unwinding up to here.
+        context->bytecodeCacheWriter = bytecodeCacheWriter;
+        break;
     }
 
     beacon_popStackFrameRecord(&onDoRecord);
@@ -1501,6 +1905,126 @@ void *beacon_unboxExternalAddress(beacon_context_t *context, beacon_oop_t box)
     return ((beacon_ExternalAddress_t*)box)->address;
 }
 
+static beacon_oop_t beacon_CompiledCode_executionCounters(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_CompiledCode_t *method = (beacon_CompiledCode_t*)receiver;
+    beacon_Array_t *counters = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + 3*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+    counters->elements[0] = beacon_encodeSmallInteger(0);
+    counters->elements[1] = beacon_encodeSmallInteger(0);
+    counters->elements[2] = beacon_encodeSmallInteger(0);
+
+    beacon_BytecodeCode_t *code = method->bytecodeImplementation;
+    if(code)
+    {
+        counters->elements[0] = code->invocationCount;
+        counters->elements[1] = code->backwardJumpCount;
+        counters->elements[2] = code->sendCount;
+    }
+
+    return (beacon_oop_t)counters;
+}
+
+typedef struct beacon_HotMethodEntry_s
+{
+    beacon_Class_t *clazz;
+    bool isMeta;
+    beacon_CompiledMethod_t *method;
+    intptr_t invocationCount;
+    intptr_t backwardJumpCount;
+    intptr_t sendCount;
+} beacon_HotMethodEntry_t;
+
+static int beacon_HotMethodEntry_compare(const void *a, const void *b)
+{
+    const beacon_HotMethodEntry_t *first = (const beacon_HotMethodEntry_t *)a;
+    const beacon_HotMethodEntry_t *second = (const beacon_HotMethodEntry_t *)b;
+    intptr_t firstHotness = first->invocationCount + first->backwardJumpCount;
+    intptr_t secondHotness = second->invocationCount + second->backwardJumpCount;
+    if(firstHotness != secondHotness)
+        return firstHotness > secondHotness ? -1 : 1;
+    if(first->sendCount != second->sendCount)
+        return first->sendCount > second->sendCount ? -1 : 1;
+    return 0;
+}
+
+static void beacon_context_collectHotMethodsOf(beacon_Class_t *clazz, bool isMeta, beacon_MethodDictionary_t *methodDict, beacon_HotMethodEntry_t **entries, size_t *entryCount, size_t *entryCapacity)
+{
+    if(!methodDict)
+        return;
+
+    beacon_Array_t *storage = methodDict->super.super.array;
+    size_t storageSize = storage->super.super.super.super.super.header.slotCount;
+    for(size_t i = 1; i < storageSize; i += 2)
+    {
+        beacon_CompiledMethod_t *method = (beacon_CompiledMethod_t *)storage->elements[i];
+        if(!storage->elements[i - 1] || beacon_isImmediate((beacon_oop_t)method) || !method->super.bytecodeImplementation)
+            continue;
+
+        beacon_BytecodeCode_t *code = method->super.bytecodeImplementation;
+        if(code->invocationCount == beacon_encodeSmallInteger(0))
+            continue;
+
+        if(*entryCount >= *entryCapacity)
+        {
+            *entryCapacity = *entryCapacity ? *entryCapacity * 2 : 256;
+            *entries = realloc(*entries, *entryCapacity * sizeof(beacon_HotMethodEntry_t));
+        }
+
+        beacon_HotMethodEntry_t *entry = *entries + (*entryCount)++;
+        entry->clazz = clazz;
+        entry->isMeta = isMeta;
+        entry->method = method;
+        entry->invocationCount = beacon_decodeSmallInteger(code->invocationCount);
+        entry->backwardJumpCount = beacon_decodeSmallInteger(code->backwardJumpCount);
+        entry->sendCount = beacon_decodeSmallInteger(code->sendCount);
+    }
+}
+
+void beacon_context_printHotMethods(beacon_context_t *context, FILE *output, size_t topCount)
+{
+    beacon_HotMethodEntry_t *entries = NULL;
+    size_t entryCount = 0;
+    size_t entryCapacity = 0;
+
+    // Visit the classes that are registered in the system dictionary.
+    beacon_Array_t *globals = context->roots.systemDictionary->super.super.array;
+    size_t globalsSize = globals->super.super.super.super.super.header.slotCount;
+    for(size_t i = 1; i < globalsSize; i += 2)
+    {
+        beacon_oop_t global = globals->elements[i];
+        if(!globals->elements[i - 1] || beacon_isImmediate(global))
+            continue;
+
+        beacon_Behavior_t *metaclass = beacon_getClass(context, global);
+        if(beacon_getClass(context, (beacon_oop_t)metaclass) != context->classes.metaclassClass)
+            continue;
+
+        beacon_Class_t *clazz = (beacon_Class_t *)global;
+        beacon_context_collectHotMethodsOf(clazz, false, clazz->super.super.methodDict, &entries, &entryCount, &entryCapacity);
+        beacon_context_collectHotMethodsOf(clazz, true, metaclass->methodDict, &entries, &entryCount, &entryCapacity);
+    }
+
+    if(entryCount > 0)
+        qsort(entries, entryCount, sizeof(beacon_HotMethodEntry_t), beacon_HotMethodEntry_compare);
+
+    fprintf(output, "%12s %12s %12s  %s\n", "invocations", "backjumps", "sends", "method");
+    for(size_t i = 0; i < entryCount && i < topCount; ++i)
+    {
+        beacon_HotMethodEntry_t *entry = entries + i;
+        beacon_Symbol_t *className = entry->clazz->name;
+        beacon_Symbol_t *selector = entry->method->name;
+        fprintf(output, "%12ld %12ld %12ld  %.*s%s>>%.*s\n",
+            (long)entry->invocationCount, (long)entry->backwardJumpCount, (long)entry->sendCount,
+            className ? (int)className->super.super.super.super.super.header.slotCount : 1, className ? (const char*)className->data : "?",
+            entry->isMeta ? " class" : "",
+            selector ? (int)selector->super.super.super.super.super.header.slotCount : 1, selector ? (const char*)selector->data : "?");
+    }
+
+    free(entries);
+}
+
 void beacon_context_registerObjectBasicPrimitives(beacon_context_t *context)
 {
     beacon_addPrimitiveToClass(context, context->classes.protoObjectClass, "class", 0, beacon_ProtoObjectPrimitive_getClass);
@@ -1515,6 +2039,8 @@ void beacon_context_registerObjectBasicPrimitives(beacon_context_t *context)
     beacon_addPrimitiveToClass(context, context->classes.objectClass, "shallowCopy", 0, beacon_ObjectPrimitive_shallowCopy);
 
     beacon_addPrimitiveToClass(context, context->classes.objectClass, "printString", 0, beacon_ObjectPrimitive_printString);
+
+    beacon_addPrimitiveToClass(context, context->classes.compiledCodeClass, "executionCounters", 0, beacon_CompiledCode_executionCounters);
     beacon_addPrimitiveToClass(context, context->classes.trueClass, "printString", 0, beacon_True_printString);
     beacon_addPrimitiveToClass(context, context->classes.falseClass, "printString", 0, beacon_False_printString);
     beacon_addPrimitiveToClass(context, context->classes.undefinedObjectClass, "printString", 0, beacon_UndefinedObject_printString);
@@ -1577,6 +2103,9 @@ void beacon_context_registerObjectBasicPrimitives(beacon_context_t *context)
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.stdioClass), "stdin", 0, beacon_Stdio_stdin);
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.stdioClass), "stdout", 0, beacon_Stdio_stdout);
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.stdioClass), "stderr", 0, beacon_Stdio_stderr);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.timeClass), "microsecondClock", 0, beacon_Time_microsecondClock);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.timeClass), "nanosecondClock", 0, beacon_Time_nanosecondClock);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.timeClass), "cpuMicrosecondClock", 0, beacon_Time_cpuMicrosecondClock);
 
     beacon_addPrimitiveToClass(context, context->classes.abstractBinaryFileStreamClass, "nextPut:", 1, beacon_AbstractBinaryFileStream_nextPut);
     beacon_addPrimitiveToClass(context, context->classes.abstractBinaryFileStreamClass, "nextPutAll:", 1, beacon_AbstractBinaryFileStream_nextPutAll);
@@ -1588,6 +2117,9 @@ void beacon_context_registerObjectBasicPrimitives(beacon_context_t *context)
 
     beacon_addPrimitiveToClass(context, context->classes.symbolClass, "asString", 1, beacon_Symbol_asString);
     beacon_addPrimitiveToClass(context, context->classes.symbolClass, "asSymbol", 1, beacon_Symbol_asSymbol);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.symbolClass), "internedSymbolCount", 0, beacon_Symbol_internedSymbolCount);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.symbolClass), "internedSymbolTableCapacity", 0, beacon_Symbol_internedSymbolTableCapacity);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.symbolClass), "internedSymbolTableLoadFactor", 0, beacon_Symbol_internedSymbolTableLoadFactor);
 
     beacon_addPrimitiveToClass(context, context->classes.objectClass, "value", 0, beacon_Object_value);
 
@@ -1598,6 +2130,7 @@ void beacon_context_registerObjectBasicPrimitives(beacon_context_t *context)
     beacon_addPrimitiveToClass(context, context->classes.blockClosureClass, "value:value:value:value:", 4, beacon_BlockClosure_value);
 
     beacon_addPrimitiveToClass(context, context->classes.blockClosureClass, "ensure:", 1, beacon_BlockClosure_ensure);
+    beacon_addPrimitiveToClass(context, context->classes.blockClosureClass, "ifCurtailed:", 1, beacon_BlockClosure_ifCurtailed);
     beacon_addPrimitiveToClass(context, context->classes.blockClosureClass, "on:do:", 2, beacon_BlockClosure_onDo);
 
 }
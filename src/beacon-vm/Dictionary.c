@@ -67,6 +67,7 @@ void beacon_MethodDictionary_atPut(beacon_context_t *context, beacon_MethodDicti
     BeaconAssert(context, slotIndex >= 0);
 
     beacon_Array_t *storage = dictionary->super.super.array;
+    ++context->methodLookupEpoch;
     if(!storage->elements[slotIndex*2])
     {
         storage->elements[slotIndex*2] = (beacon_oop_t)symbol;
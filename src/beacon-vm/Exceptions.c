@@ -2,32 +2,179 @@
 #include "beacon-lang/ObjectModel.h"
 #include "beacon-lang/Memory.h"
 #include "beacon-lang/Context.h"
+#include "beacon-lang/SourceCode.h"
 #include <stdlib.h>
+#include <setjmp.h>
 #include <stdio.h>
 
+#define BEACON_DISPLAYED_INNERMOST_STACK_FRAMES 24
+#define BEACON_DISPLAYED_OUTERMOST_STACK_FRAMES 8
+
 static void beacon_displayExceptionStackTrace(beacon_context_t *context);
 
-void beacon_exception_signal(beacon_context_t *context, beacon_Exception_t *exception)
+static bool beacon_exception_handlerRecordHandles(beacon_context_t *context, beacon_StackFrameRecord_t *handlerRecord, beacon_oop_t exception)
+{
+    beacon_Behavior_t *behavior = beacon_getClass(context, exception);
+    while(behavior)
+    {
+        if((beacon_oop_t)behavior == handlerRecord->onDo.onFilter)
+            return true;
+        behavior = behavior->superclass;
+    }
+
+    return false;
+}
+
+static beacon_StackFrameRecord_t *beacon_exception_findHandlerRecordFrom(beacon_context_t *context, beacon_StackFrameRecord_t *startRecord, beacon_oop_t exception)
+{
+    beacon_StackFrameRecord_t *record = startRecord;
+    while(record)
+    {
+        // The handlers that are protected by an active handler cannot be activated from within it.
+        if(record->kind == StackFrameExceptionHandler)
+            record = record->exceptionHandler.handlerRecord;
+        else if(record->kind == StackFrameOnDo && record->context == context && beacon_exception_handlerRecordHandles(context, record, exception))
+            return record;
+
+        record = record->previousRecord;
+    }
+
+    return NULL;
+}
+
+static beacon_StackFrameRecord_t *beacon_exception_findActiveExceptionHandlerRecord(beacon_context_t *context, beacon_oop_t exception)
+{
+    beacon_StackFrameRecord_t *record = beacon_getTopStackFrameRecord();
+    while(record)
+    {
+        if(record->kind == StackFrameExceptionHandler && record->context == context && record->exceptionHandler.exception == exception)
+            return record;
+
+        record = record->previousRecord;
+    }
+
+    beacon_exception_error(context, "The exception is not being handled.");
+}
+
+BEACON_NORETURN static void beacon_exception_unwindToHandler(beacon_context_t *context, beacon_StackFrameRecord_t *handlerRecord, beacon_StackFrameOnDoJump_t jump, beacon_oop_t resultValue)
 {
     (void)context;
+    handlerRecord->onDo.resultValue = resultValue;
+    beacon_unwindStackFrameRecordsUntil(handlerRecord);
+    _longjmp(handlerRecord->onDo.handlerJumpBuffer, jump);
+}
+
+static beacon_oop_t beacon_exception_activateHandler(beacon_context_t *context, beacon_StackFrameRecord_t *handlerRecord, beacon_oop_t exception, bool isResumable)
+{
+    beacon_StackFrameRecord_t exceptionHandlerRecord = {
+        .context = context,
+        .kind = StackFrameExceptionHandler,
+        .exceptionHandler = {
+            .exception = exception,
+            .handlerRecord = handlerRecord,
+            .resumptionValue = 0,
+            .isResumable = isResumable,
+        }
+    };
+    beacon_BytecodeCacheWriter_t *bytecodeCacheWriter = context->bytecodeCacheWriter;
+    beacon_pushStackFrameRecord(&exceptionHandlerRecord);
+
+    // The handler block runs on top of the signaling frame. Resuming only unwinds the frames of the handler.
+    if(_setjmp(exceptionHandlerRecord.exceptionHandler.resumptionJumpBuffer))
+    {
+        context->bytecodeCacheWriter = bytecodeCacheWriter;
+        beacon_popStackFrameRecord(&exceptionHandlerRecord);
+        return exceptionHandlerRecord.exceptionHandler.resumptionValue;
+    }
+
+    handlerRecord->onDo.exception = exception;
+    beacon_BlockClosure_t *handlerBlock = (beacon_BlockClosure_t*)handlerRecord->onDo.doBlock;
+    size_t handlerArgumentCount = beacon_decodeSmallInteger(handlerBlock->code->super.argumentCount);
+    BeaconAssert(context, handlerArgumentCount <= 1);
+    beacon_oop_t handlerResult = beacon_runBlockClosureWithArguments(context, &handlerBlock->code->super, handlerBlock->receiver, handlerBlock->captures, handlerArgumentCount, &exceptionHandlerRecord.exceptionHandler.exception);
+
+    // Falling off the end of the handler block returns its value from on:do:.
+    beacon_popStackFrameRecord(&exceptionHandlerRecord);
+    beacon_exception_unwindToHandler(context, handlerRecord, StackFrameOnDoJumpReturn, handlerResult);
+}
+
+static bool beacon_exception_signalFrom(beacon_context_t *context, beacon_StackFrameRecord_t *startRecord, beacon_oop_t exception, bool isResumable, beacon_oop_t *outResumptionValue)
+{
+    beacon_StackFrameRecord_t *handlerRecord = beacon_exception_findHandlerRecordFrom(context, startRecord, exception);
+    if(!handlerRecord)
+        return false;
+
+    *outResumptionValue = beacon_exception_activateHandler(context, handlerRecord, exception, isResumable);
+    return true;
+}
+
+BEACON_NORETURN static void beacon_exception_unhandled(beacon_context_t *context, beacon_oop_t exception)
+{
+    beacon_perform(context, exception, (beacon_oop_t)beacon_internCString(context, "displayException"));
+    fprintf(stderr, "Unhandled exception. Aborting.\n");
+    beacon_displayExceptionStackTrace(context);
+    abort();
+}
+
+BEACON_NORETURN static void beacon_exception_unhandledFromVM(beacon_context_t *context, beacon_Exception_t *exception)
+{
     size_t messageTextSize = exception->messageText->super.super.super.super.super.header.slotCount;
     fprintf(stderr, "Exception: %.*s\n", (int)messageTextSize, exception->messageText->data);
     beacon_displayExceptionStackTrace(context);
     abort();
 }
 
+beacon_oop_t beacon_exception_signal(beacon_context_t *context, beacon_Exception_t *exception)
+{
+    beacon_oop_t resumptionValue = 0;
+    if(!beacon_exception_signalFrom(context, beacon_getTopStackFrameRecord(), (beacon_oop_t)exception, true, &resumptionValue))
+        beacon_exception_unhandledFromVM(context, exception);
+    return resumptionValue;
+}
+
+BEACON_NORETURN static void beacon_exception_signalNonResumable(beacon_context_t *context, beacon_Exception_t *exception)
+{
+    // The handler of a non resumable exception always leaves through its on:do:, so the signal does not come back here.
+    beacon_oop_t resumptionValue = 0;
+    beacon_exception_signalFrom(context, beacon_getTopStackFrameRecord(), (beacon_oop_t)exception, false, &resumptionValue);
+    beacon_exception_unhandledFromVM(context, exception);
+}
+
 void beacon_exception_error(beacon_context_t *context, const char *errorMessage)
 {
     beacon_Error_t *error = beacon_allocateObjectWithBehavior(context->heap, context->classes.errorClass, sizeof(beacon_Error_t), BeaconObjectKindPointers);
     error->super.messageText = beacon_importCString(context, errorMessage);
-    beacon_exception_signal(context, &error->super);
+    beacon_exception_signalNonResumable(context, &error->super);
 }
 
 void beacon_exception_assertionFailure(beacon_context_t *context, const char *errorMessage)
 {
     beacon_AssertionFailure_t *error = beacon_allocateObjectWithBehavior(context->heap, context->classes.assertionFailureClass, sizeof(beacon_AssertionFailure_t), BeaconObjectKindPointers);
     error->super.super.messageText = beacon_importCString(context, errorMessage);
-    beacon_exception_signal(context, &error->super.super);
+    beacon_exception_signalNonResumable(context, &error->super.super);
+}
+
+void beacon_exception_stackOverflow(beacon_context_t *context, size_t stackDepth, uintptr_t nativeStackAddress)
+{
+    // While an overflow is handled, every activation may use the reserve, whatever its depth. The ensure blocks that are
+    // unwound by the handler are run from shallower records, but on top of the native stack that is still overflowing.
+    if(beacon_getStackOverflowHandlingDepth())
+    {
+        uintptr_t nativeStackLimit = beacon_getNativeStackLimit();
+        if(stackDepth < context->options.maxStackDepth + BEACON_STACK_OVERFLOW_RESERVED_DEPTH &&
+            (!nativeStackLimit || nativeStackAddress >= nativeStackLimit - BEACON_NATIVE_STACK_OVERFLOW_RESERVED_SIZE))
+            return;
+
+        fprintf(stderr, "Stack overflow while handling a stack overflow. Aborting.\n");
+        beacon_displayExceptionStackTrace(context);
+        abort();
+    }
+
+    // The handler runs on top of the overflowing stack, so the activations above this depth may use the reserve.
+    beacon_setStackOverflowHandlingDepth(stackDepth);
+    beacon_StackOverflow_t *error = beacon_allocateObjectWithBehavior(context->heap, context->classes.stackOverflowClass, sizeof(beacon_StackOverflow_t), BeaconObjectKindPointers);
+    error->super.super.messageText = beacon_importCString(context, "Stack overflow");
+    beacon_exception_signalNonResumable(context, &error->super.super);
 }
 
 void beacon_exception_scannerError(beacon_context_t *context, beacon_ScannerToken_t *token)
@@ -56,6 +203,7 @@ static beacon_oop_t beacon_Exception_displayException(beacon_context_t *context,
 
 static void beacon_displaySourcePosition(beacon_context_t *context, beacon_SourcePosition_t *sourcePosition)
 {
+    beacon_SourcePosition_computeLinesAndColumns(context, sourcePosition);
     int nameSize = sourcePosition->sourceCode->name->super.super.super.super.super.header.slotCount;
     if(sourcePosition->sourceCode->directory)
     {
@@ -77,33 +225,90 @@ static void beacon_displaySourcePosition(beacon_context_t *context, beacon_Sourc
 
 static void beacon_displayExceptionStackTrace(beacon_context_t *context)
 {
-    beacon_StackFrameRecord_t *record =  beacon_getTopStackFrameRecord();
-    while(record)
+    size_t frameCount = 0;
+    for(beacon_StackFrameRecord_t *record = beacon_getTopStackFrameRecord(); record; record = record->previousRecord)
     {
-        switch(record->kind)
-        {
-        case StackFrameBytecodeMethodRecord:
+        if(record->kind == StackFrameBytecodeMethodRecord)
+            ++frameCount;
+    }
+
+    // Deep stacks, such as the ones of a stack overflow, only show their innermost and outermost frames.
+    size_t frameIndex = 0;
+    for(beacon_StackFrameRecord_t *record = beacon_getTopStackFrameRecord(); record; record = record->previousRecord)
+    {
+        if(record->kind != StackFrameBytecodeMethodRecord)
+            continue;
+
+        if(frameCount <= BEACON_DISPLAYED_INNERMOST_STACK_FRAMES + BEACON_DISPLAYED_OUTERMOST_STACK_FRAMES ||
+            frameIndex < BEACON_DISPLAYED_INNERMOST_STACK_FRAMES || frameIndex >= frameCount - BEACON_DISPLAYED_OUTERMOST_STACK_FRAMES)
             beacon_displaySourcePosition(context, record->bytecodeMethodStackRecord.code->sourcePosition);
-            break;
-        default:
-            break;
-        }
-        record = record->previousRecord;
+        else if(frameIndex == BEACON_DISPLAYED_INNERMOST_STACK_FRAMES)
+            fprintf(stderr, "... %zu frames omitted ...\n", frameCount - BEACON_DISPLAYED_INNERMOST_STACK_FRAMES - BEACON_DISPLAYED_OUTERMOST_STACK_FRAMES);
+        ++frameIndex;
     }
 }
 
 static beacon_oop_t beacon_Exception_signal(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
+    (void)arguments;
     BeaconAssert(context, (intptr_t)argumentCount == 0);
-    beacon_perform(context, receiver, (beacon_oop_t)beacon_internCString(context, "displayException"));
-    fprintf(stderr, "Unhandled exception. Aborting.\n");
-    beacon_displayExceptionStackTrace(context);
-    abort();
-    return receiver;
+    beacon_oop_t resumptionValue = 0;
+    if(!beacon_exception_signalFrom(context, beacon_getTopStackFrameRecord(), receiver, true, &resumptionValue))
+        beacon_exception_unhandled(context, receiver);
+    return resumptionValue;
+}
+
+static beacon_oop_t beacon_Exception_outer(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_StackFrameRecord_t *exceptionHandlerRecord = beacon_exception_findActiveExceptionHandlerRecord(context, receiver);
+
+    // Only the handlers that enclose the active one are searched. A resumption returns here, instead of to the signal.
+    beacon_oop_t resumptionValue = 0;
+    if(!beacon_exception_signalFrom(context, exceptionHandlerRecord->exceptionHandler.handlerRecord->previousRecord, receiver, exceptionHandlerRecord->exceptionHandler.isResumable, &resumptionValue))
+        beacon_exception_unhandled(context, receiver);
+    return resumptionValue;
+}
+
+static beacon_oop_t beacon_Exception_resumeUnchecked(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, (intptr_t)argumentCount == 1);
+    beacon_StackFrameRecord_t *exceptionHandlerRecord = beacon_exception_findActiveExceptionHandlerRecord(context, receiver);
+
+    // The VM errors cannot return to the C code that raised them, so their resumption value is returned from the on:do: instead.
+    if(!exceptionHandlerRecord->exceptionHandler.isResumable)
+        beacon_exception_unwindToHandler(context, exceptionHandlerRecord->exceptionHandler.handlerRecord, StackFrameOnDoJumpReturn, arguments[0]);
+
+    exceptionHandlerRecord->exceptionHandler.resumptionValue = arguments[0];
+    beacon_unwindStackFrameRecordsUntil(exceptionHandlerRecord);
+    _longjmp(exceptionHandlerRecord->exceptionHandler.resumptionJumpBuffer, 1);
+    return 0;
+}
+
+static beacon_oop_t beacon_Exception_return(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, (intptr_t)argumentCount == 1);
+    beacon_StackFrameRecord_t *exceptionHandlerRecord = beacon_exception_findActiveExceptionHandlerRecord(context, receiver);
+    beacon_exception_unwindToHandler(context, exceptionHandlerRecord->exceptionHandler.handlerRecord, StackFrameOnDoJumpReturn, arguments[0]);
+    return 0;
+}
+
+static beacon_oop_t beacon_Exception_retry(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_StackFrameRecord_t *exceptionHandlerRecord = beacon_exception_findActiveExceptionHandlerRecord(context, receiver);
+    beacon_exception_unwindToHandler(context, exceptionHandlerRecord->exceptionHandler.handlerRecord, StackFrameOnDoJumpRetry, 0);
+    return 0;
 }
 
 void beacon_context_registerExceptionPrimitives(beacon_context_t *context)
 {
     beacon_addPrimitiveToClass(context, context->classes.exceptionClass, "displayException", 0, beacon_Exception_displayException);
     beacon_addPrimitiveToClass(context, context->classes.exceptionClass, "signal", 0, beacon_Exception_signal);
+    beacon_addPrimitiveToClass(context, context->classes.exceptionClass, "outer", 0, beacon_Exception_outer);
+    beacon_addPrimitiveToClass(context, context->classes.exceptionClass, "resumeUnchecked:", 1, beacon_Exception_resumeUnchecked);
+    beacon_addPrimitiveToClass(context, context->classes.exceptionClass, "return:", 1, beacon_Exception_return);
+    beacon_addPrimitiveToClass(context, context->classes.exceptionClass, "retry", 0, beacon_Exception_retry);
 }
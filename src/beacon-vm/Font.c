@@ -1,5 +1,6 @@
 #include "Context.h"
 #include "Exceptions.h"
+#include "ThreadPool.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -25,6 +26,7 @@ void glyphRectangle_addPoint(BeaconGlyphRectange_t *rectangle, int x, int y)
 beacon_oop_t beacon_Font_LoadFontFromFile(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     BeaconAssert(context, argumentCount == 1);
+    BeaconAssert(context, beacon_getClass(context, arguments[0]) == context->classes.stringClass);
     
     beacon_String_t *fileName = (beacon_String_t *)arguments[0];
 
@@ -55,49 +57,190 @@ beacon_oop_t beacon_Font_LoadFontFromFile(beacon_context_t *context, beacon_oop_
     return (beacon_oop_t)font;
 }
 
-beacon_oop_t beacon_Font_createFaceWithHeight(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+static void beacon_Font_computeAtlasExtent(int fontHeight, size_t *bitmapWidth, size_t *bitmapHeight)
 {
-    BeaconAssert(context, argumentCount == 1);
-    beacon_Font_t *font = (beacon_Font_t *)receiver;
-    int fontHeight = beacon_decodeSmallInteger(arguments[0]);
-    size_t bitmapWidth = fontHeight < 20 ? 256 : 512;
-    size_t bitmapHeight = fontHeight < 30 ? 256 : 512;
-    size_t bitmapDepth = 8;
-    size_t bitmapByteSize = bitmapWidth*bitmapHeight*(bitmapDepth / 8);
-    beacon_ByteArray_t *bitmapData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + bitmapByteSize, BeaconObjectKindBytes); 
-
-    beacon_ByteArray_t *charData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + sizeof(stbtt_bakedchar)*(256-31), BeaconObjectKindBytes); 
-    stbtt_bakedchar *bakedChar = (stbtt_bakedchar *)charData->elements;
-    
-    stbtt_BakeFontBitmap(font->rawData->elements, 0, fontHeight, bitmapData->elements, bitmapWidth, bitmapHeight, 31, 256 - 31, bakedChar);
+    *bitmapWidth = fontHeight < 20 ? 256 : 512;
+    *bitmapHeight = fontHeight < 30 ? 256 : 512;
+}
 
+static beacon_FontFace_t *beacon_FontFace_createWithAtlas(beacon_context_t *context, int fontHeight, size_t bitmapWidth, size_t bitmapHeight, beacon_ByteArray_t *bitmapData, beacon_ByteArray_t *charData, float ascent, float descent, float linegap)
+{
     beacon_Form_t *bitmapForm = beacon_allocateObjectWithBehavior(context->heap, context->classes.formClass, sizeof(beacon_Form_t), BeaconObjectKindPointers); 
     bitmapForm->width = beacon_encodeSmallInteger(bitmapWidth);
     bitmapForm->height = beacon_encodeSmallInteger(bitmapHeight);
     bitmapForm->pitch = beacon_encodeSmallInteger(bitmapWidth);
-    bitmapForm->depth = beacon_encodeSmallInteger(bitmapDepth);
+    bitmapForm->depth = beacon_encodeSmallInteger(8);
     bitmapForm->bits = bitmapData;
 
     beacon_FontFace_t *fontFace = beacon_allocateObjectWithBehavior(context->heap, context->classes.fontFaceClass, sizeof(beacon_FontFace_t), BeaconObjectKindPointers);
     fontFace->charData = charData;
     fontFace->height = beacon_encodeSmallInteger(fontHeight);
     fontFace->atlasForm = bitmapForm;
+    fontFace->ascent = beacon_encodeSmallFloat(ascent);
+    fontFace->descent = beacon_encodeSmallFloat(descent);
+    fontFace->linegap = beacon_encodeSmallFloat(linegap);
+    return fontFace;
+}
+
+beacon_oop_t beacon_Font_createFaceWithHeight(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    beacon_Font_t *font = (beacon_Font_t *)receiver;
+    int fontHeight = beacon_decodeSmallInteger(arguments[0]);
+    size_t bitmapWidth;
+    size_t bitmapHeight;
+    beacon_Font_computeAtlasExtent(fontHeight, &bitmapWidth, &bitmapHeight);
+    size_t bitmapByteSize = bitmapWidth*bitmapHeight;
+    beacon_ByteArray_t *bitmapData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + bitmapByteSize, BeaconObjectKindBytes); 
+
+    beacon_ByteArray_t *charData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + sizeof(stbtt_bakedchar)*(256-31), BeaconObjectKindBytes); 
+    stbtt_bakedchar *bakedChar = (stbtt_bakedchar *)charData->elements;
+    
+    stbtt_BakeFontBitmap(font->rawData->elements, 0, fontHeight, bitmapData->elements, bitmapWidth, bitmapHeight, 31, 256 - 31, bakedChar);
 
     float ascent;
     float descent;
     float linegap;
     stbtt_GetScaledFontVMetrics(font->rawData->elements, 0, fontHeight, &ascent, &descent, &linegap);
-    fontFace->ascent = beacon_encodeSmallFloat(ascent);
-    fontFace->descent = beacon_encodeSmallFloat(descent);
-    fontFace->linegap = beacon_encodeSmallFloat(linegap);
-
 
     //char fileNameBuffer[64];
     //snprintf(fileNameBuffer, sizeof(fileNameBuffer), "atlas-%d.data", fontHeight);
     //FILE *f = fopen(fileNameBuffer, "wb");
     //fwrite(bitmapData->elements, bitmapByteSize, 1, f);
     //fclose(f);
-    return (beacon_oop_t)fontFace;
+    return (beacon_oop_t)beacon_FontFace_createWithAtlas(context, fontHeight, bitmapWidth, bitmapHeight, bitmapData, charData, ascent, descent, linegap);
+}
+
+/**
+ * Reads a font file on the thread pool. The file contents are in a native buffer until the task is complete.
+ */
+typedef struct beacon_FontLoadingTask_s
+{
+    beacon_AsyncTask_t super;
+    char *fileName;
+    uint8_t *fontData;
+    size_t fontDataSize;
+} beacon_FontLoadingTask_t;
+
+static void beacon_FontLoadingTask_run(beacon_AsyncTask_t *task)
+{
+    beacon_FontLoadingTask_t *loadingTask = (beacon_FontLoadingTask_t *)task;
+    FILE *fontFile = fopen(loadingTask->fileName, "rb");
+    if(!fontFile)
+    {
+        task->errorMessage = "Failed to open font file.";
+        return;
+    }
+
+    fseek(fontFile, 0, SEEK_END);
+    long fontFileSize = ftell(fontFile);
+    fseek(fontFile, 0, SEEK_SET);
+    loadingTask->fontData = fontFileSize > 0 ? malloc(fontFileSize) : NULL;
+    if(!loadingTask->fontData || fread(loadingTask->fontData, fontFileSize, 1, fontFile) != 1)
+        task->errorMessage = "Failed to read font file.";
+    else
+        loadingTask->fontDataSize = fontFileSize;
+    fclose(fontFile);
+}
+
+static beacon_oop_t beacon_FontLoadingTask_complete(beacon_context_t *context, beacon_AsyncTask_t *task)
+{
+    beacon_FontLoadingTask_t *loadingTask = (beacon_FontLoadingTask_t *)task;
+    beacon_ByteArray_t *fontData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + loadingTask->fontDataSize, BeaconObjectKindBytes);
+    memcpy(fontData->elements, loadingTask->fontData, loadingTask->fontDataSize);
+
+    beacon_Font_t *font = beacon_allocateObjectWithBehavior(context->heap, context->classes.fontClass, sizeof(beacon_Font_t), BeaconObjectKindPointers);
+    font->rawData = fontData;
+    return (beacon_oop_t)font;
+}
+
+static void beacon_FontLoadingTask_destroy(beacon_AsyncTask_t *task)
+{
+    beacon_FontLoadingTask_t *loadingTask = (beacon_FontLoadingTask_t *)task;
+    free(loadingTask->fileName);
+    free(loadingTask->fontData);
+    free(loadingTask);
+}
+
+beacon_oop_t beacon_Font_LoadFontFromFileAsync(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    BeaconAssert(context, argumentCount == 1);
+    BeaconAssert(context, beacon_getClass(context, arguments[0]) == context->classes.stringClass);
+    beacon_String_t *fileName = (beacon_String_t *)arguments[0];
+    size_t fileNameSize = fileName->super.super.super.super.super.header.slotCount;
+
+    beacon_FontLoadingTask_t *task = calloc(1, sizeof(beacon_FontLoadingTask_t));
+    task->super.run = beacon_FontLoadingTask_run;
+    task->super.complete = beacon_FontLoadingTask_complete;
+    task->super.destroy = beacon_FontLoadingTask_destroy;
+    task->fileName = calloc(1, fileNameSize + 1);
+    memcpy(task->fileName, fileName->data, fileNameSize);
+    return beacon_AsyncTask_start(context, &task->super);
+}
+
+/**
+ * Bakes the atlas of a font face on the thread pool, from a copy of the font data.
+ */
+typedef struct beacon_FontFaceBakingTask_s
+{
+    beacon_AsyncTask_t super;
+    uint8_t *fontData;
+    int fontHeight;
+    size_t bitmapWidth;
+    size_t bitmapHeight;
+    uint8_t *bitmap;
+    stbtt_bakedchar bakedChars[256-31];
+    float ascent;
+    float descent;
+    float linegap;
+} beacon_FontFaceBakingTask_t;
+
+static void beacon_FontFaceBakingTask_run(beacon_AsyncTask_t *task)
+{
+    beacon_FontFaceBakingTask_t *bakingTask = (beacon_FontFaceBakingTask_t *)task;
+    stbtt_BakeFontBitmap(bakingTask->fontData, 0, bakingTask->fontHeight, bakingTask->bitmap, bakingTask->bitmapWidth, bakingTask->bitmapHeight, 31, 256 - 31, bakingTask->bakedChars);
+    stbtt_GetScaledFontVMetrics(bakingTask->fontData, 0, bakingTask->fontHeight, &bakingTask->ascent, &bakingTask->descent, &bakingTask->linegap);
+}
+
+static beacon_oop_t beacon_FontFaceBakingTask_complete(beacon_context_t *context, beacon_AsyncTask_t *task)
+{
+    beacon_FontFaceBakingTask_t *bakingTask = (beacon_FontFaceBakingTask_t *)task;
+    size_t bitmapByteSize = bakingTask->bitmapWidth*bakingTask->bitmapHeight;
+    beacon_ByteArray_t *bitmapData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + bitmapByteSize, BeaconObjectKindBytes); 
+    memcpy(bitmapData->elements, bakingTask->bitmap, bitmapByteSize);
+
+    beacon_ByteArray_t *charData = beacon_allocateObjectWithBehavior(context->heap, context->classes.byteArrayClass, sizeof(beacon_ByteArray_t) + sizeof(bakingTask->bakedChars), BeaconObjectKindBytes); 
+    memcpy(charData->elements, bakingTask->bakedChars, sizeof(bakingTask->bakedChars));
+
+    return (beacon_oop_t)beacon_FontFace_createWithAtlas(context, bakingTask->fontHeight, bakingTask->bitmapWidth, bakingTask->bitmapHeight, bitmapData, charData,
+        bakingTask->ascent, bakingTask->descent, bakingTask->linegap);
+}
+
+static void beacon_FontFaceBakingTask_destroy(beacon_AsyncTask_t *task)
+{
+    beacon_FontFaceBakingTask_t *bakingTask = (beacon_FontFaceBakingTask_t *)task;
+    free(bakingTask->fontData);
+    free(bakingTask->bitmap);
+    free(bakingTask);
+}
+
+beacon_oop_t beacon_Font_createFaceWithHeightAsync(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    beacon_Font_t *font = (beacon_Font_t *)receiver;
+    size_t fontDataSize = font->rawData->super.super.super.super.super.header.slotCount;
+
+    beacon_FontFaceBakingTask_t *task = calloc(1, sizeof(beacon_FontFaceBakingTask_t));
+    task->super.run = beacon_FontFaceBakingTask_run;
+    task->super.complete = beacon_FontFaceBakingTask_complete;
+    task->super.destroy = beacon_FontFaceBakingTask_destroy;
+    task->fontHeight = beacon_decodeSmallInteger(arguments[0]);
+    beacon_Font_computeAtlasExtent(task->fontHeight, &task->bitmapWidth, &task->bitmapHeight);
+    task->bitmap = calloc(1, task->bitmapWidth*task->bitmapHeight);
+    task->fontData = malloc(fontDataSize);
+    memcpy(task->fontData, font->rawData->elements, fontDataSize);
+    return beacon_AsyncTask_start(context, &task->super);
 }
 
 beacon_oop_t beacon_FontFace_measureTextExtent(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -183,6 +326,8 @@ void beacon_context_registerFontFacePrimitives(beacon_context_t *context)
 {
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.fontClass), "loadFontFromFile:", 1, beacon_Font_LoadFontFromFile);
     beacon_addPrimitiveToClass(context, context->classes.fontClass, "createFaceWithHeight:", 1, beacon_Font_createFaceWithHeight);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.fontClass), "loadFontFromFileAsync:", 1, beacon_Font_LoadFontFromFileAsync);
+    beacon_addPrimitiveToClass(context, context->classes.fontClass, "createFaceWithHeightAsync:", 1, beacon_Font_createFaceWithHeightAsync);
     beacon_addPrimitiveToClass(context, context->classes.fontFaceClass, "measureTextExtent:", 1, beacon_FontFace_measureTextExtent);
     beacon_addPrimitiveToClass(context, context->classes.fontFaceClass, "measureTextExtent:until:", 2, beacon_FontFace_measureTextExtentUntil);
 }
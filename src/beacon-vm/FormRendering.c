@@ -23,17 +23,29 @@ static inline float clampFloat(float x, float minX, float maxX)
     return x;
 }
 
-beacon_oop_t beacon_SolidRectangleRenderingElement_drawInForm(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+/**
+ * The decoded parameters of a solid rectangle, which are enough for drawing it without touching the objects.
+ */
+typedef struct beacon_SolidRectangleFill_s
 {
-    BeaconAssert(context, argumentCount == 1);
-    BeaconAssert(context, beacon_getClass(context, arguments[0]) == context->classes.formClass);
+    int formWidth;
+    int formHeight;
+    int formPitch;
 
-    beacon_FormSolidRectangleRenderingElement_t *renderingElement = (beacon_FormSolidRectangleRenderingElement_t*)receiver;
-    beacon_Form_t *form = (beacon_Form_t*)arguments[0];
+    float colorR, colorG, colorB, colorA;
+    float borderColorR, borderColorG, borderColorB, borderColorA;
 
-    int formWidth = beacon_decodeSmallInteger(form->width);
-    int formHeight = beacon_decodeSmallInteger(form->height);
-    int formPitch = beacon_decodeSmallInteger(form->pitch);
+    int drawMinX, drawMinY;
+    int drawMaxX, drawMaxY;
+    int borderSize;
+} beacon_SolidRectangleFill_t;
+
+static void beacon_SolidRectangleFill_decode(beacon_context_t *context, beacon_SolidRectangleFill_t *fill, beacon_FormSolidRectangleRenderingElement_t *renderingElement, beacon_Form_t *form)
+{
+    (void)context;
+    fill->formWidth = beacon_decodeSmallInteger(form->width);
+    fill->formHeight = beacon_decodeSmallInteger(form->height);
+    fill->formPitch = beacon_decodeSmallInteger(form->pitch);
 
     beacon_Rectangle_t *rectangle = renderingElement->super.rectangle;
 
@@ -42,31 +54,42 @@ beacon_oop_t beacon_SolidRectangleRenderingElement_drawInForm(beacon_context_t *
     float maxX = beacon_decodeSmallNumber(rectangle->corner->x);
     float maxY = beacon_decodeSmallNumber(rectangle->corner->y);
 
-    float colorR = clampFloat(beacon_decodeSmallNumber(renderingElement->color->r), 0, 1);
-    float colorG = clampFloat(beacon_decodeSmallNumber(renderingElement->color->g), 0, 1);
-    float colorB = clampFloat(beacon_decodeSmallNumber(renderingElement->color->b), 0, 1);
-    float colorA = clampFloat(beacon_decodeSmallNumber(renderingElement->color->a), 0, 1);
+    fill->colorR = clampFloat(beacon_decodeSmallNumber(renderingElement->color->r), 0, 1);
+    fill->colorG = clampFloat(beacon_decodeSmallNumber(renderingElement->color->g), 0, 1);
+    fill->colorB = clampFloat(beacon_decodeSmallNumber(renderingElement->color->b), 0, 1);
+    fill->colorA = clampFloat(beacon_decodeSmallNumber(renderingElement->color->a), 0, 1);
     
-    float borderColorR = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->r), 0, 1);
-    float borderColorG = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->g), 0, 1);
-    float borderColorB = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->b), 0, 1);
-    float borderColorA = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->a), 0, 1);
+    fill->borderColorR = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->r), 0, 1);
+    fill->borderColorG = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->g), 0, 1);
+    fill->borderColorB = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->b), 0, 1);
+    fill->borderColorA = clampFloat(beacon_decodeSmallNumber(renderingElement->borderColor->a), 0, 1);
+
+    fill->drawMinX = floor(clampFloat(minX, 0, fill->formWidth) + 0.5);
+    fill->drawMinY = floor(clampFloat(minY, 0, fill->formHeight) + 0.5);
+    fill->drawMaxX = floor(clampFloat(maxX, 0, fill->formWidth) + 0.5);
+    fill->drawMaxY = floor(clampFloat(maxY, 0, fill->formHeight) + 0.5);
 
-    int drawMinX = floor(clampFloat(minX, 0, formWidth) + 0.5);
-    int drawMinY = floor(clampFloat(minY, 0, formHeight) + 0.5);
-    int drawMaxX = floor(clampFloat(maxX, 0, formWidth) + 0.5);
-    int drawMaxY = floor(clampFloat(maxY, 0, formHeight) + 0.5);
+    fill->borderSize = beacon_decodeSmallNumber(renderingElement->super.borderSize);
+}
+
+// The destination starts at the pixel at drawMinX, drawMinY, which is the form itself or a copy of the drawn part of it.
+static void beacon_SolidRectangleFill_draw(const beacon_SolidRectangleFill_t *fill, uint8_t *destinationBits, int destinationPitch)
+{
+    int formWidth = fill->formWidth;
+    int formHeight = fill->formHeight;
+    int drawMinX = fill->drawMinX;
+    int drawMinY = fill->drawMinY;
 
-    int borderSize = beacon_decodeSmallNumber(renderingElement->super.borderSize);
+    int borderSize = fill->borderSize;
     int interiorDrawMinX = drawMinX + borderSize;
     int interiorDrawMinY = drawMinY + borderSize;
-    int interiorDrawMaxX = drawMaxX - borderSize;
-    int interiorDrawMaxY = drawMaxY - borderSize;
+    int interiorDrawMaxX = fill->drawMaxX - borderSize;
+    int interiorDrawMaxY = fill->drawMaxY - borderSize;
 
-    int drawWidth = drawMaxX - drawMinX;
-    int drawHeight = drawMaxY - drawMinY;
+    int drawWidth = fill->drawMaxX - drawMinX;
+    int drawHeight = fill->drawMaxY - drawMinY;
 
-    uint8_t *destinationRow = form->bits->elements + drawMinY*formPitch;
+    uint8_t *destinationRow = destinationBits;
     for(int y = 0; y < drawHeight; ++y)
     {
         uint32_t *destinationRowPixel = (uint32_t*)destinationRow;
@@ -82,12 +105,12 @@ beacon_oop_t beacon_SolidRectangleRenderingElement_drawInForm(beacon_context_t *
                     interiorDrawMinY <= drawY && drawY < interiorDrawMaxY);
 
                 bool isInBorder = !isInInterior; 
-                float sourceR = isInBorder ? borderColorR : colorR;
-                float sourceG = isInBorder ? borderColorG : colorG;
-                float sourceB = isInBorder ? borderColorB : colorB;
-                float sourceA = isInBorder ? borderColorA : colorA;
+                float sourceR = isInBorder ? fill->borderColorR : fill->colorR;
+                float sourceG = isInBorder ? fill->borderColorG : fill->colorG;
+                float sourceB = isInBorder ? fill->borderColorB : fill->colorB;
+                float sourceA = isInBorder ? fill->borderColorA : fill->colorA;
             
-                uint32_t destinationPixel = destinationRowPixel[x + drawMinX];
+                uint32_t destinationPixel = destinationRowPixel[x];
                 float destB = (destinationPixel & 0xFF)/255.0;
                 float destG = ((destinationPixel >> 8) & 0xFF)/255.0;
                 float destR = ((destinationPixel >> 16) & 0xFF)/255.0;
@@ -103,12 +126,30 @@ beacon_oop_t beacon_SolidRectangleRenderingElement_drawInForm(beacon_context_t *
                 uint8_t blendB = (uint8_t)(pixelB*255);
                 uint8_t blendA = (uint8_t)(pixelA*255);
 
-                destinationRowPixel[x + drawMinX] = blendB | (blendG << 8) | (blendR << 16) | (blendA << 24);
+                destinationRowPixel[x] = blendB | (blendG << 8) | (blendR << 16) | (blendA << 24);
 
             }
         }
-        destinationRow += formPitch;
+        destinationRow += destinationPitch;
     }
+}
+
+static uint8_t *beacon_SolidRectangleFill_formDrawBits(const beacon_SolidRectangleFill_t *fill, uint8_t *formBits)
+{
+    return formBits + fill->drawMinY*fill->formPitch + fill->drawMinX*4;
+}
+
+beacon_oop_t beacon_SolidRectangleRenderingElement_drawInForm(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    BeaconAssert(context, beacon_getClass(context, arguments[0]) == context->classes.formClass);
+
+    beacon_FormSolidRectangleRenderingElement_t *renderingElement = (beacon_FormSolidRectangleRenderingElement_t*)receiver;
+    beacon_Form_t *form = (beacon_Form_t*)arguments[0];
+
+    beacon_SolidRectangleFill_t fill;
+    beacon_SolidRectangleFill_decode(context, &fill, renderingElement, form);
+    beacon_SolidRectangleFill_draw(&fill, beacon_SolidRectangleFill_formDrawBits(&fill, form->bits->elements), fill.formPitch);
     return receiver;
 }
 
@@ -0,0 +1,966 @@
+#include "beacon-lang/Jit.h"
+#include "beacon-lang/Bytecode.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Dictionary.h"
+#include "beacon-lang/Exceptions.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/Profiler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(BEACON_JIT) && defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+typedef enum beacon_JitRegister_e
+{
+    JitRAX = 0,
+    JitRCX = 1,
+    JitRDX = 2,
+    JitRBX = 3,
+    JitRSP = 4,
+    JitRBP = 5,
+    JitRSI = 6,
+    JitRDI = 7,
+    JitR12 = 12,
+    JitR13 = 13,
+} beacon_JitRegister_t;
+
+// Register holding the beacon_JitFrame_t pointer.
+#define JitFrameRegister JitRBX
+// Register holding the temporaries pointer.
+#define JitTemporariesRegister JitR12
+// Register holding the decoded arguments pointer.
+#define JitDecodedArgumentsRegister JitR13
+
+typedef enum beacon_JitCondition_e
+{
+    JitConditionOverflow = 0x0,
+    JitConditionEqual = 0x4,
+    JitConditionNotEqual = 0x5,
+    JitConditionLess = 0xC,
+    JitConditionGreaterOrEqual = 0xD,
+    JitConditionLessOrEqual = 0xE,
+    JitConditionGreater = 0xF,
+} beacon_JitCondition_t;
+
+typedef struct beacon_JitBranchFixup_s
+{
+    size_t nativeOffset;
+    uint32_t targetPC;
+} beacon_JitBranchFixup_t;
+
+typedef struct beacon_JitAssembler_s
+{
+    beacon_context_t *context;
+    uint8_t *code;
+    size_t size;
+    size_t capacity;
+
+    beacon_JitBranchFixup_t *fixups;
+    size_t fixupCount;
+    size_t fixupCapacity;
+
+    size_t *epilogueFixups;
+    size_t epilogueFixupCount;
+    size_t epilogueFixupCapacity;
+} beacon_JitAssembler_t;
+
+static void beacon_jit_emitByte(beacon_JitAssembler_t *assembler, uint8_t byte)
+{
+    if(assembler->size >= assembler->capacity)
+    {
+        assembler->capacity = assembler->capacity ? assembler->capacity * 2 : 256;
+        assembler->code = realloc(assembler->code, assembler->capacity);
+    }
+
+    assembler->code[assembler->size++] = byte;
+}
+
+static void beacon_jit_emitUInt32(beacon_JitAssembler_t *assembler, uint32_t value)
+{
+    for(int i = 0; i < 4; ++i)
+        beacon_jit_emitByte(assembler, (value >> (i*8)) & 0xFF);
+}
+
+static void beacon_jit_emitUInt64(beacon_JitAssembler_t *assembler, uint64_t value)
+{
+    for(int i = 0; i < 8; ++i)
+        beacon_jit_emitByte(assembler, (value >> (i*8)) & 0xFF);
+}
+
+static void beacon_jit_patchRelative32(beacon_JitAssembler_t *assembler, size_t relativeOffset, size_t target)
+{
+    int32_t delta = (int32_t)((intptr_t)target - (intptr_t)(relativeOffset + 4));
+    memcpy(assembler->code + relativeOffset, &delta, 4);
+}
+
+// mov destination, imm64
+static void beacon_jit_movImmediate(beacon_JitAssembler_t *assembler, beacon_JitRegister_t destination, uint64_t value)
+{
+    if(value == 0)
+    {
+        // xor destination32, destination32
+        if(destination >= 8)
+            beacon_jit_emitByte(assembler, 0x45);
+        beacon_jit_emitByte(assembler, 0x31);
+        beacon_jit_emitByte(assembler, 0xC0 | ((destination & 7) << 3) | (destination & 7));
+        return;
+    }
+
+    beacon_jit_emitByte(assembler, 0x48 | (destination >= 8 ? 1 : 0));
+    beacon_jit_emitByte(assembler, 0xB8 | (destination & 7));
+    beacon_jit_emitUInt64(assembler, value);
+}
+
+static void beacon_jit_emitMemoryOperand(beacon_JitAssembler_t *assembler, beacon_JitRegister_t reg, beacon_JitRegister_t base, int32_t displacement)
+{
+    beacon_jit_emitByte(assembler, 0x80 | ((reg & 7) << 3) | (base & 7));
+    if((base & 7) == JitRSP)
+        beacon_jit_emitByte(assembler, 0x24);
+    beacon_jit_emitUInt32(assembler, (uint32_t)displacement);
+}
+
+// mov destination, [base + displacement]
+static void beacon_jit_load(beacon_JitAssembler_t *assembler, beacon_JitRegister_t destination, beacon_JitRegister_t base, int32_t displacement)
+{
+    beacon_jit_emitByte(assembler, 0x48 | (destination >= 8 ? 4 : 0) | (base >= 8 ? 1 : 0));
+    beacon_jit_emitByte(assembler, 0x8B);
+    beacon_jit_emitMemoryOperand(assembler, destination, base, displacement);
+}
+
+// mov [base + displacement], source
+static void beacon_jit_store(beacon_JitAssembler_t *assembler, beacon_JitRegister_t base, int32_t displacement, beacon_JitRegister_t source)
+{
+    beacon_jit_emitByte(assembler, 0x48 | (source >= 8 ? 4 : 0) | (base >= 8 ? 1 : 0));
+    beacon_jit_emitByte(assembler, 0x89);
+    beacon_jit_emitMemoryOperand(assembler, source, base, displacement);
+}
+
+// mov destination, source
+static void beacon_jit_move(beacon_JitAssembler_t *assembler, beacon_JitRegister_t destination, beacon_JitRegister_t source)
+{
+    beacon_jit_emitByte(assembler, 0x48 | (source >= 8 ? 4 : 0) | (destination >= 8 ? 1 : 0));
+    beacon_jit_emitByte(assembler, 0x89);
+    beacon_jit_emitByte(assembler, 0xC0 | ((source & 7) << 3) | (destination & 7));
+}
+
+// call function
+static void beacon_jit_callFunction(beacon_JitAssembler_t *assembler, void *function)
+{
+    beacon_jit_movImmediate(assembler, JitRAX, (uint64_t)(uintptr_t)function);
+    beacon_jit_emitByte(assembler, 0xFF);
+    beacon_jit_emitByte(assembler, 0xD0);
+}
+
+// jmp rel32. Returns the offset of the relative displacement.
+static size_t beacon_jit_jump(beacon_JitAssembler_t *assembler)
+{
+    beacon_jit_emitByte(assembler, 0xE9);
+    size_t displacementOffset = assembler->size;
+    beacon_jit_emitUInt32(assembler, 0);
+    return displacementOffset;
+}
+
+// jcc rel32. Returns the offset of the relative displacement.
+static size_t beacon_jit_jumpIf(beacon_JitAssembler_t *assembler, beacon_JitCondition_t condition)
+{
+    beacon_jit_emitByte(assembler, 0x0F);
+    beacon_jit_emitByte(assembler, 0x80 | condition);
+    size_t displacementOffset = assembler->size;
+    beacon_jit_emitUInt32(assembler, 0);
+    return displacementOffset;
+}
+
+static void beacon_jit_addBranchFixup(beacon_JitAssembler_t *assembler, size_t nativeOffset, uint32_t targetPC)
+{
+    if(assembler->fixupCount >= assembler->fixupCapacity)
+    {
+        assembler->fixupCapacity = assembler->fixupCapacity ? assembler->fixupCapacity * 2 : 16;
+        assembler->fixups = realloc(assembler->fixups, assembler->fixupCapacity * sizeof(beacon_JitBranchFixup_t));
+    }
+
+    beacon_JitBranchFixup_t *fixup = assembler->fixups + assembler->fixupCount++;
+    fixup->nativeOffset = nativeOffset;
+    fixup->targetPC = targetPC;
+}
+
+static void beacon_jit_addEpilogueFixup(beacon_JitAssembler_t *assembler, size_t nativeOffset)
+{
+    if(assembler->epilogueFixupCount >= assembler->epilogueFixupCapacity)
+    {
+        assembler->epilogueFixupCapacity = assembler->epilogueFixupCapacity ? assembler->epilogueFixupCapacity * 2 : 16;
+        assembler->epilogueFixups = realloc(assembler->epilogueFixups, assembler->epilogueFixupCapacity * sizeof(size_t));
+    }
+
+    assembler->epilogueFixups[assembler->epilogueFixupCount++] = nativeOffset;
+}
+
+// Checks that the value in the register is a SmallInteger. Returns the offset of the failure branch displacement.
+static size_t beacon_jit_jumpIfNotSmallInteger(beacon_JitAssembler_t *assembler, beacon_JitRegister_t reg)
+{
+    // mov edx, reg32
+    beacon_jit_emitByte(assembler, 0x89);
+    beacon_jit_emitByte(assembler, 0xC0 | ((reg & 7) << 3) | JitRDX);
+    // and edx, 7
+    beacon_jit_emitByte(assembler, 0x83);
+    beacon_jit_emitByte(assembler, 0xE2);
+    beacon_jit_emitByte(assembler, ImmediateObjectTag_BitMask);
+    // cmp edx, SmallIntegerTag
+    beacon_jit_emitByte(assembler, 0x83);
+    beacon_jit_emitByte(assembler, 0xFA);
+    beacon_jit_emitByte(assembler, ImmediateObjectTag_SmallInteger);
+    return beacon_jit_jumpIf(assembler, JitConditionNotEqual);
+}
+
+static void beacon_jit_loadOperand(beacon_JitAssembler_t *assembler, beacon_JitRegister_t destination, beacon_BytecodeCode_t *code, beacon_BytecodeValue_t operand)
+{
+    uint16_t index = beacon_BytecodeValue_getIndex(operand);
+    switch(beacon_BytecodeValue_getType(operand))
+    {
+    case BytecodeArgumentTypeArgument:
+        if(index == 0)
+        {
+            beacon_jit_load(assembler, destination, JitFrameRegister, offsetof(beacon_JitFrame_t, receiver));
+        }
+        else
+        {
+            beacon_jit_load(assembler, destination, JitFrameRegister, offsetof(beacon_JitFrame_t, arguments));
+            beacon_jit_load(assembler, destination, destination, (index - 1) * sizeof(beacon_oop_t));
+        }
+        break;
+    case BytecodeArgumentTypeLiteral:
+    case BytecodeArgumentTypeSuperReceiver:
+        // Objects are never moved by the garbage collector, and the literal array keeps them alive.
+        beacon_jit_movImmediate(assembler, destination, index == 0 ? 0 : (uint64_t)code->literals->elements[index - 1]);
+        break;
+    case BytecodeArgumentTypeTemporary:
+        if(index == 0)
+            beacon_jit_movImmediate(assembler, destination, 0);
+        else
+            beacon_jit_load(assembler, destination, JitTemporariesRegister, (index - 1) * sizeof(beacon_oop_t));
+        break;
+    case BytecodeArgumentTypeCapture:
+        beacon_jit_load(assembler, destination, JitFrameRegister, offsetof(beacon_JitFrame_t, captures));
+        beacon_jit_load(assembler, destination, destination, (index - 1) * sizeof(beacon_oop_t));
+        break;
+    case BytecodeArgumentTypeReceiverSlot:
+        beacon_jit_load(assembler, destination, JitFrameRegister, offsetof(beacon_JitFrame_t, receiverSlots));
+        beacon_jit_load(assembler, destination, destination, (index - 1) * sizeof(beacon_oop_t));
+        break;
+    default:
+        abort();
+    }
+}
+
+static void beacon_jit_storeResult(beacon_JitAssembler_t *assembler, beacon_BytecodeValue_t resultStorage)
+{
+    uint16_t index = beacon_BytecodeValue_getIndex(resultStorage);
+    if(index == 0)
+        return;
+
+    if(beacon_BytecodeValue_getType(resultStorage) == BytecodeArgumentTypeReceiverSlot)
+    {
+        beacon_jit_load(assembler, JitRCX, JitFrameRegister, offsetof(beacon_JitFrame_t, receiverSlots));
+        beacon_jit_store(assembler, JitRCX, (index - 1) * sizeof(beacon_oop_t), JitRAX);
+    }
+    else
+    {
+        beacon_jit_store(assembler, JitTemporariesRegister, (index - 1) * sizeof(beacon_oop_t), JitRAX);
+    }
+}
+
+// Increments a SmallInteger execution counter. BytecodeCode objects are never moved, so the counter address is constant.
+static void beacon_jit_emitIncrementCounter(beacon_JitAssembler_t *assembler, beacon_oop_t *counter)
+{
+    beacon_jit_movImmediate(assembler, JitRCX, (uint64_t)(uintptr_t)counter);
+    // add qword [rcx], 1 << ImmediateObjectTag_BitCount
+    beacon_jit_emitByte(assembler, 0x48);
+    beacon_jit_emitByte(assembler, 0x83);
+    beacon_jit_emitByte(assembler, 0x01);
+    beacon_jit_emitByte(assembler, 1 << ImmediateObjectTag_BitCount);
+}
+
+static void beacon_jit_emitSafepoint(beacon_JitAssembler_t *assembler)
+{
+    beacon_jit_load(assembler, JitRDI, JitFrameRegister, offsetof(beacon_JitFrame_t, context));
+    beacon_jit_callFunction(assembler, (void*)beacon_memoryHeapSafepoint);
+}
+
+static beacon_CompiledCode_t *beacon_jit_lookupMethod(beacon_Behavior_t *behavior, beacon_context_t *context, beacon_oop_t selector)
+{
+    while(behavior)
+    {
+        if(behavior->methodDict)
+        {
+            beacon_CompiledCode_t *method = (beacon_CompiledCode_t *)beacon_MethodDictionary_atOrNil(context, behavior->methodDict, (beacon_Symbol_t*)selector);
+            if(method)
+                return method;
+        }
+
+        behavior = behavior->superclass;
+    }
+
+    return NULL;
+}
+
+static beacon_oop_t beacon_jit_sendWithInlineCache(beacon_JitFrame_t *frame, beacon_JitInlineCache_t *cache, size_t operandCount)
+{
+    beacon_context_t *context = frame->context;
+    beacon_oop_t *operands = frame->decodedArguments;
+    beacon_oop_t receiver = operands[0];
+    beacon_oop_t selector = operands[1];
+    beacon_Behavior_t *behavior = beacon_getClass(context, receiver);
+
+    if(cache->behavior != behavior || cache->selector != selector || cache->methodLookupEpoch != context->methodLookupEpoch)
+    {
+        beacon_CompiledCode_t *method = beacon_jit_lookupMethod(behavior, context, selector);
+        if(!method)
+            return beacon_performWithArguments(context, receiver, selector, operandCount - 2, operands + 2);
+
+        cache->behavior = behavior;
+        cache->selector = selector;
+        cache->method = method;
+        cache->methodLookupEpoch = context->methodLookupEpoch;
+    }
+
+    return beacon_runMethodWithArguments(context, cache->method, receiver, selector, operandCount - 2, operands + 2);
+}
+
+static beacon_oop_t beacon_jit_superSend(beacon_JitFrame_t *frame, size_t operandCount)
+{
+    beacon_oop_t *operands = frame->decodedArguments;
+    return beacon_performWithArgumentsInSuperclass(frame->context, frame->receiver, operands[1], operandCount - 2, operands + 2, operands[0]);
+}
+
+static beacon_oop_t beacon_jit_makeArray(beacon_JitFrame_t *frame, size_t elementCount)
+{
+    beacon_context_t *context = frame->context;
+    beacon_Array_t *resultArray = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + elementCount*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+    memcpy(resultArray->elements, frame->decodedArguments, elementCount*sizeof(beacon_oop_t));
+    return (beacon_oop_t)resultArray;
+}
+
+static beacon_oop_t beacon_jit_makeClosureInstance(beacon_JitFrame_t *frame, size_t operandCount, beacon_oop_t previousClosure)
+{
+    return beacon_BytecodeInterpreter_makeClosureInstance(frame->context, previousClosure, frame->receiver, (beacon_CompiledBlock_t*)frame->decodedArguments[0], operandCount - 1, frame->decodedArguments + 1);
+}
+
+static beacon_oop_t beacon_jit_inlinedPrimitive(beacon_JitFrame_t *frame, size_t operandCount)
+{
+    return beacon_BytecodeInterpreter_inlinedPrimitive(frame->context, beacon_decodeSmallInteger(frame->decodedArguments[0]), operandCount - 1, frame->decodedArguments + 1);
+}
+
+typedef struct beacon_JitDecodedInstruction_s
+{
+    uint32_t pc;
+    uint32_t nextPC;
+    beacon_BytecodeOpcode_t opcode;
+    uint8_t operandCount;
+    bool hasResult;
+    beacon_BytecodeValue_t result;
+    beacon_BytecodeValue_t operands[BEACON_MAX_SUPPORTED_BYTECODE_ARGUMENTS];
+    int32_t branchTargetPC;
+} beacon_JitDecodedInstruction_t;
+
+static bool beacon_jit_decodeInstruction(uint8_t *bytecodes, size_t bytecodesSize, uint32_t pc, beacon_JitDecodedInstruction_t *decoded)
+{
+    uint8_t extendedArgumentCount = 0;
+    for(;;)
+    {
+        if(pc >= bytecodesSize)
+            return false;
+
+        uint8_t instruction = bytecodes[pc];
+        uint8_t operandCount = (extendedArgumentCount << 4) | beacon_getBytecodeArgumentCount(instruction);
+        beacon_BytecodeOpcode_t opcode = beacon_getBytecodeOpcode(instruction);
+        if(operandCount > BEACON_MAX_SUPPORTED_BYTECODE_ARGUMENTS)
+            return false;
+
+        if(opcode == BeaconBytecodeExtendArguments)
+        {
+            extendedArgumentCount = operandCount;
+            ++pc;
+            continue;
+        }
+
+        decoded->pc = pc++;
+        decoded->opcode = opcode;
+        decoded->operandCount = 0;
+        decoded->branchTargetPC = -1;
+        decoded->hasResult = opcode == BeaconBytecodeSendMessage || opcode == BeaconBytecodeSuperSendMessage ||
+            opcode == BeaconBytecodeStoreValue || opcode == BeaconBytecodeMakeArray || opcode == BeaconBytecodeMakeClosureInstance ||
+            opcode == BeaconBytecodeInlinedPrimitive;
+
+        if(decoded->hasResult)
+        {
+            if(pc + 2 > bytecodesSize)
+                return false;
+            decoded->result = bytecodes[pc] | (bytecodes[pc + 1] << 8);
+            pc += 2;
+        }
+
+        for(uint8_t i = 0; i < operandCount; ++i)
+        {
+            if(pc + 2 > bytecodesSize)
+                return false;
+            beacon_BytecodeValue_t operand = bytecodes[pc] | (bytecodes[pc + 1] << 8);
+            pc += 2;
+
+            if(beacon_BytecodeValue_getType(operand) == BytecodeArgumentTypeJumpDelta)
+                decoded->branchTargetPC = (int32_t)decoded->pc + beacon_BytecodeValue_getSignedIndex(operand);
+            else
+                decoded->operands[decoded->operandCount++] = operand;
+        }
+
+        decoded->nextPC = pc;
+        return true;
+    }
+}
+
+static void beacon_jit_emitBranchTo(beacon_JitAssembler_t *assembler, beacon_BytecodeCode_t *code, beacon_JitDecodedInstruction_t *instruction, int conditionOrMinusOne)
+{
+    bool isBackward = instruction->branchTargetPC < (int32_t)instruction->pc;
+    if(conditionOrMinusOne < 0)
+    {
+        if(isBackward)
+        {
+            beacon_jit_emitIncrementCounter(assembler, &code->backwardJumpCount);
+            beacon_jit_emitSafepoint(assembler);
+        }
+        beacon_jit_addBranchFixup(assembler, beacon_jit_jump(assembler), instruction->branchTargetPC);
+        return;
+    }
+
+    if(!isBackward)
+    {
+        beacon_jit_addBranchFixup(assembler, beacon_jit_jumpIf(assembler, (beacon_JitCondition_t)conditionOrMinusOne), instruction->branchTargetPC);
+        return;
+    }
+
+    // Backward branches have to pass through a safepoint.
+    size_t skipBranch = beacon_jit_jumpIf(assembler, (beacon_JitCondition_t)(conditionOrMinusOne ^ 1));
+    beacon_jit_emitIncrementCounter(assembler, &code->backwardJumpCount);
+    beacon_jit_emitSafepoint(assembler);
+    beacon_jit_addBranchFixup(assembler, beacon_jit_jump(assembler), instruction->branchTargetPC);
+    beacon_jit_patchRelative32(assembler, skipBranch, assembler->size);
+}
+
+static bool beacon_jit_emitSmallIntegerFastPath(beacon_JitAssembler_t *assembler, beacon_BytecodeCode_t *code, beacon_JitDecodedInstruction_t *instruction, size_t *outSlowPathBranches)
+{
+    beacon_context_t *context = assembler->context;
+    if(instruction->operandCount != 3 || beacon_BytecodeValue_getType(instruction->operands[1]) != BytecodeArgumentTypeLiteral)
+        return false;
+
+    uint16_t selectorIndex = beacon_BytecodeValue_getIndex(instruction->operands[1]);
+    if(selectorIndex == 0)
+        return false;
+
+    beacon_oop_t selector = code->literals->elements[selectorIndex - 1];
+    int arithmetic = 0;
+    beacon_JitCondition_t condition = JitConditionEqual;
+    if(selector == context->roots.plusSelector)
+        arithmetic = 1;
+    else if(selector == (beacon_oop_t)beacon_internCString(context, "-"))
+        arithmetic = -1;
+    else if(selector == (beacon_oop_t)beacon_internCString(context, "<"))
+        condition = JitConditionLess;
+    else if(selector == context->roots.lessOrEqualsSelector)
+        condition = JitConditionLessOrEqual;
+    else if(selector == (beacon_oop_t)beacon_internCString(context, ">"))
+        condition = JitConditionGreater;
+    else if(selector == (beacon_oop_t)beacon_internCString(context, ">="))
+        condition = JitConditionGreaterOrEqual;
+    else if(selector == (beacon_oop_t)beacon_internCString(context, "="))
+        condition = JitConditionEqual;
+    else
+        return false;
+
+    beacon_jit_loadOperand(assembler, JitRAX, code, instruction->operands[0]);
+    beacon_jit_loadOperand(assembler, JitRCX, code, instruction->operands[2]);
+    outSlowPathBranches[0] = beacon_jit_jumpIfNotSmallInteger(assembler, JitRAX);
+    outSlowPathBranches[1] = beacon_jit_jumpIfNotSmallInteger(assembler, JitRCX);
+    outSlowPathBranches[2] = 0;
+
+    if(arithmetic)
+    {
+        // mov rdx, rax
+        beacon_jit_move(assembler, JitRDX, JitRAX);
+        if(arithmetic > 0)
+        {
+            // (2a + 1) + (2b + 1) - 1: sub rdx, 1; add rdx, rcx
+            beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x83); beacon_jit_emitByte(assembler, 0xEA); beacon_jit_emitByte(assembler, 0x01);
+            beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x01); beacon_jit_emitByte(assembler, 0xCA);
+            outSlowPathBranches[2] = beacon_jit_jumpIf(assembler, JitConditionOverflow);
+        }
+        else
+        {
+            // (2a + 1) - (2b + 1) + 1: sub rdx, rcx; add rdx, 1
+            beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x29); beacon_jit_emitByte(assembler, 0xCA);
+            outSlowPathBranches[2] = beacon_jit_jumpIf(assembler, JitConditionOverflow);
+            beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x83); beacon_jit_emitByte(assembler, 0xC2); beacon_jit_emitByte(assembler, 0x01);
+        }
+        // mov rax, rdx
+        beacon_jit_move(assembler, JitRAX, JitRDX);
+    }
+    else
+    {
+        // cmp rax, rcx
+        beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x39); beacon_jit_emitByte(assembler, 0xC8);
+        beacon_jit_movImmediate(assembler, JitRAX, context->roots.falseValue);
+        beacon_jit_movImmediate(assembler, JitRDX, context->roots.trueValue);
+        // cmovcc rax, rdx
+        beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x0F); beacon_jit_emitByte(assembler, 0x40 | condition); beacon_jit_emitByte(assembler, 0xC2);
+    }
+
+    return true;
+}
+
+// The compiler only emits the SmallInteger inlined primitives on loop indices and sizes, so their operands are not checked.
+static bool beacon_jit_emitInlinedSmallIntegerPrimitive(beacon_JitAssembler_t *assembler, beacon_BytecodeCode_t *code, beacon_JitDecodedInstruction_t *instruction)
+{
+    beacon_context_t *context = assembler->context;
+    uint16_t primitiveIndex = beacon_BytecodeValue_getIndex(instruction->operands[0]);
+    if(instruction->operandCount != 3 || primitiveIndex == 0)
+        return false;
+
+    intptr_t primitive = beacon_decodeSmallInteger(code->literals->elements[primitiveIndex - 1]);
+    if(primitive != BeaconBytecodeInlinedPrimitiveSmallIntegerAdd && primitive != BeaconBytecodeInlinedPrimitiveSmallIntegerLessOrEquals)
+        return false;
+
+    beacon_jit_loadOperand(assembler, JitRAX, code, instruction->operands[1]);
+    beacon_jit_loadOperand(assembler, JitRCX, code, instruction->operands[2]);
+    if(primitive == BeaconBytecodeInlinedPrimitiveSmallIntegerAdd)
+    {
+        // (2a + 1) + (2b + 1) - 1: sub rax, 1; add rax, rcx
+        beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x83); beacon_jit_emitByte(assembler, 0xE8); beacon_jit_emitByte(assembler, 0x01);
+        beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x01); beacon_jit_emitByte(assembler, 0xC8);
+    }
+    else
+    {
+        // cmp rax, rcx
+        beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x39); beacon_jit_emitByte(assembler, 0xC8);
+        beacon_jit_movImmediate(assembler, JitRAX, context->roots.falseValue);
+        beacon_jit_movImmediate(assembler, JitRDX, context->roots.trueValue);
+        // cmovle rax, rdx
+        beacon_jit_emitByte(assembler, 0x48); beacon_jit_emitByte(assembler, 0x0F); beacon_jit_emitByte(assembler, 0x40 | JitConditionLessOrEqual); beacon_jit_emitByte(assembler, 0xC2);
+    }
+
+    return true;
+}
+
+static void beacon_jit_emitStoreOperands(beacon_JitAssembler_t *assembler, beacon_BytecodeCode_t *code, beacon_JitDecodedInstruction_t *instruction)
+{
+    for(uint8_t i = 0; i < instruction->operandCount; ++i)
+    {
+        beacon_jit_loadOperand(assembler, JitRAX, code, instruction->operands[i]);
+        beacon_jit_store(assembler, JitDecodedArgumentsRegister, i * sizeof(beacon_oop_t), JitRAX);
+    }
+}
+
+static beacon_JitCompiledCode_t *beacon_jit_compile(beacon_context_t *context, beacon_BytecodeCode_t *code)
+{
+    uint8_t *bytecodes = code->bytecodes->elements;
+    size_t bytecodesSize = code->bytecodes->super.super.super.super.super.header.slotCount;
+    intptr_t temporaryCount = beacon_decodeSmallInteger(code->temporaryCount);
+    intptr_t argumentCount = beacon_decodeSmallInteger(code->argumentCount);
+    size_t requiredReceiverSlotCount = 0;
+    size_t requiredCaptureCount = 0;
+    size_t inlineCacheCount = 0;
+
+    // Validate the bytecode, and collect the requirements of the method.
+    for(uint32_t pc = 0; pc < bytecodesSize; )
+    {
+        beacon_JitDecodedInstruction_t instruction;
+        if(!beacon_jit_decodeInstruction(bytecodes, bytecodesSize, pc, &instruction))
+            return NULL;
+
+        switch(instruction.opcode)
+        {
+        case BeaconBytecodeNop:
+        case BeaconBytecodeMakeArray:
+            break;
+        case BeaconBytecodeJump:
+            if(instruction.operandCount != 0 || instruction.branchTargetPC < 0)
+                return NULL;
+            break;
+        case BeaconBytecodeJumpIfTrue:
+        case BeaconBytecodeJumpIfFalse:
+            if(instruction.operandCount != 1 || instruction.branchTargetPC < 0)
+                return NULL;
+            break;
+        case BeaconBytecodeLocalReturn:
+        case BeaconBytecodeStoreValue:
+            if(instruction.operandCount != 1)
+                return NULL;
+            break;
+        case BeaconBytecodeSuperSendMessage:
+            if(instruction.operandCount < 2)
+                return NULL;
+            break;
+        case BeaconBytecodeSendMessage:
+            if(instruction.operandCount < 2)
+                return NULL;
+            ++inlineCacheCount;
+            break;
+        case BeaconBytecodeMakeClosureInstance:
+            if(instruction.operandCount < 1 ||
+                beacon_BytecodeValue_getType(instruction.result) != BytecodeArgumentTypeTemporary ||
+                beacon_BytecodeValue_getIndex(instruction.result) == 0)
+                return NULL;
+            break;
+        case BeaconBytecodeInlinedPrimitive:
+            if(instruction.operandCount < 1 || beacon_BytecodeValue_getType(instruction.operands[0]) != BytecodeArgumentTypeLiteral)
+                return NULL;
+            break;
+        default:
+            return NULL;
+        }
+
+        if(instruction.opcode >= BeaconBytecodeJump && instruction.opcode <= BeaconBytecodeJumpIfFalse &&
+            instruction.branchTargetPC > (int32_t)bytecodesSize)
+            return NULL;
+
+        for(uint8_t i = 0; i <= instruction.operandCount; ++i)
+        {
+            beacon_BytecodeValue_t value;
+            if(i < instruction.operandCount)
+                value = instruction.operands[i];
+            else if(instruction.hasResult)
+                value = instruction.result;
+            else
+                break;
+
+            uint16_t index = beacon_BytecodeValue_getIndex(value);
+            switch(beacon_BytecodeValue_getType(value))
+            {
+            case BytecodeArgumentTypeArgument:
+                if(index > argumentCount)
+                    return NULL;
+                break;
+            case BytecodeArgumentTypeTemporary:
+                if(index > temporaryCount)
+                    return NULL;
+                break;
+            case BytecodeArgumentTypeLiteral:
+            case BytecodeArgumentTypeSuperReceiver:
+                if(index > code->literals->super.super.super.super.super.header.slotCount)
+                    return NULL;
+                break;
+            case BytecodeArgumentTypeCapture:
+                if(index == 0)
+                    return NULL;
+                if(index > requiredCaptureCount)
+                    requiredCaptureCount = index;
+                break;
+            case BytecodeArgumentTypeReceiverSlot:
+                if(index == 0)
+                    return NULL;
+                if(index > requiredReceiverSlotCount)
+                    requiredReceiverSlotCount = index;
+                break;
+            default:
+                return NULL;
+            }
+        }
+
+        pc = instruction.nextPC;
+    }
+
+    beacon_JitAssembler_t assembler = {.context = context};
+    int32_t *pcToNativeOffset = malloc((bytecodesSize + 1) * sizeof(int32_t));
+    for(size_t i = 0; i <= bytecodesSize; ++i)
+        pcToNativeOffset[i] = -1;
+
+    beacon_JitInlineCache_t *inlineCaches = calloc(inlineCacheCount ? inlineCacheCount : 1, sizeof(beacon_JitInlineCache_t));
+    size_t nextInlineCache = 0;
+
+    // Prologue: push rbx; push r12; push r13; mov rbx, rdi
+    beacon_jit_emitByte(&assembler, 0x53);
+    beacon_jit_emitByte(&assembler, 0x41); beacon_jit_emitByte(&assembler, 0x54);
+    beacon_jit_emitByte(&assembler, 0x41); beacon_jit_emitByte(&assembler, 0x55);
+    beacon_jit_move(&assembler, JitFrameRegister, JitRDI);
+    beacon_jit_load(&assembler, JitTemporariesRegister, JitFrameRegister, offsetof(beacon_JitFrame_t, temporaries));
+    beacon_jit_load(&assembler, JitDecodedArgumentsRegister, JitFrameRegister, offsetof(beacon_JitFrame_t, decodedArguments));
+
+    for(uint32_t pc = 0; pc < bytecodesSize; )
+    {
+        beacon_JitDecodedInstruction_t instruction;
+        beacon_jit_decodeInstruction(bytecodes, bytecodesSize, pc, &instruction);
+        for(uint32_t i = pc; i <= instruction.pc; ++i)
+            pcToNativeOffset[i] = (int32_t)assembler.size;
+
+        switch(instruction.opcode)
+        {
+        case BeaconBytecodeNop:
+            break;
+        case BeaconBytecodeJump:
+            beacon_jit_emitBranchTo(&assembler, code, &instruction, -1);
+            break;
+        case BeaconBytecodeJumpIfTrue:
+        case BeaconBytecodeJumpIfFalse:
+            beacon_jit_loadOperand(&assembler, JitRAX, code, instruction.operands[0]);
+            beacon_jit_movImmediate(&assembler, JitRCX, instruction.opcode == BeaconBytecodeJumpIfTrue ? context->roots.trueValue : context->roots.falseValue);
+            // cmp rax, rcx
+            beacon_jit_emitByte(&assembler, 0x48); beacon_jit_emitByte(&assembler, 0x39); beacon_jit_emitByte(&assembler, 0xC8);
+            beacon_jit_emitBranchTo(&assembler, code, &instruction, JitConditionEqual);
+            break;
+        case BeaconBytecodeLocalReturn:
+            beacon_jit_loadOperand(&assembler, JitRAX, code, instruction.operands[0]);
+            beacon_jit_addEpilogueFixup(&assembler, beacon_jit_jump(&assembler));
+            break;
+        case BeaconBytecodeSendMessage:
+            {
+                size_t slowPathBranches[3];
+                size_t fastPathMergeBranch = 0;
+                beacon_jit_emitIncrementCounter(&assembler, &code->sendCount);
+                bool hasFastPath = beacon_jit_emitSmallIntegerFastPath(&assembler, code, &instruction, slowPathBranches);
+                if(hasFastPath)
+                {
+                    fastPathMergeBranch = beacon_jit_jump(&assembler);
+                    for(int i = 0; i < 3; ++i)
+                    {
+                        if(slowPathBranches[i])
+                            beacon_jit_patchRelative32(&assembler, slowPathBranches[i], assembler.size);
+                    }
+                }
+
+                beacon_jit_emitStoreOperands(&assembler, code, &instruction);
+                beacon_jit_move(&assembler, JitRDI, JitFrameRegister);
+                beacon_jit_movImmediate(&assembler, JitRSI, (uint64_t)(uintptr_t)(inlineCaches + nextInlineCache++));
+                beacon_jit_movImmediate(&assembler, JitRDX, instruction.operandCount);
+                beacon_jit_callFunction(&assembler, (void*)beacon_jit_sendWithInlineCache);
+                if(hasFastPath)
+                    beacon_jit_patchRelative32(&assembler, fastPathMergeBranch, assembler.size);
+                beacon_jit_storeResult(&assembler, instruction.result);
+            }
+            break;
+        case BeaconBytecodeSuperSendMessage:
+            beacon_jit_emitIncrementCounter(&assembler, &code->sendCount);
+            beacon_jit_emitStoreOperands(&assembler, code, &instruction);
+            beacon_jit_move(&assembler, JitRDI, JitFrameRegister);
+            beacon_jit_movImmediate(&assembler, JitRSI, instruction.operandCount);
+            beacon_jit_callFunction(&assembler, (void*)beacon_jit_superSend);
+            beacon_jit_storeResult(&assembler, instruction.result);
+            break;
+        case BeaconBytecodeStoreValue:
+            beacon_jit_loadOperand(&assembler, JitRAX, code, instruction.operands[0]);
+            beacon_jit_storeResult(&assembler, instruction.result);
+            break;
+        case BeaconBytecodeMakeArray:
+            beacon_jit_emitStoreOperands(&assembler, code, &instruction);
+            beacon_jit_move(&assembler, JitRDI, JitFrameRegister);
+            beacon_jit_movImmediate(&assembler, JitRSI, instruction.operandCount);
+            beacon_jit_callFunction(&assembler, (void*)beacon_jit_makeArray);
+            beacon_jit_storeResult(&assembler, instruction.result);
+            break;
+        case BeaconBytecodeMakeClosureInstance:
+            beacon_jit_emitStoreOperands(&assembler, code, &instruction);
+            beacon_jit_loadOperand(&assembler, JitRDX, code, instruction.result);
+            beacon_jit_move(&assembler, JitRDI, JitFrameRegister);
+            beacon_jit_movImmediate(&assembler, JitRSI, instruction.operandCount);
+            beacon_jit_callFunction(&assembler, (void*)beacon_jit_makeClosureInstance);
+            beacon_jit_storeResult(&assembler, instruction.result);
+            break;
+        case BeaconBytecodeInlinedPrimitive:
+            if(!beacon_jit_emitInlinedSmallIntegerPrimitive(&assembler, code, &instruction))
+            {
+                beacon_jit_emitStoreOperands(&assembler, code, &instruction);
+                beacon_jit_move(&assembler, JitRDI, JitFrameRegister);
+                beacon_jit_movImmediate(&assembler, JitRSI, instruction.operandCount);
+                beacon_jit_callFunction(&assembler, (void*)beacon_jit_inlinedPrimitive);
+            }
+            beacon_jit_storeResult(&assembler, instruction.result);
+            break;
+        default:
+            abort();
+        }
+
+        pc = instruction.nextPC;
+    }
+
+    // Falling through the end of the method answers nil.
+    pcToNativeOffset[bytecodesSize] = (int32_t)assembler.size;
+    beacon_jit_movImmediate(&assembler, JitRAX, 0);
+
+    // Epilogue: pop r13; pop r12; pop rbx; ret
+    size_t epilogueOffset = assembler.size;
+    beacon_jit_emitByte(&assembler, 0x41); beacon_jit_emitByte(&assembler, 0x5D);
+    beacon_jit_emitByte(&assembler, 0x41); beacon_jit_emitByte(&assembler, 0x5C);
+    beacon_jit_emitByte(&assembler, 0x5B);
+    beacon_jit_emitByte(&assembler, 0xC3);
+
+    // Resolve the branches.
+    for(size_t i = 0; i < assembler.epilogueFixupCount; ++i)
+        beacon_jit_patchRelative32(&assembler, assembler.epilogueFixups[i], epilogueOffset);
+    bool succeeded = true;
+    for(size_t i = 0; i < assembler.fixupCount; ++i)
+    {
+        // Branches into the middle of an instruction are not supported.
+        int32_t targetOffset = pcToNativeOffset[assembler.fixups[i].targetPC];
+        if(targetOffset < 0)
+            succeeded = false;
+        else
+            beacon_jit_patchRelative32(&assembler, assembler.fixups[i].nativeOffset, targetOffset);
+    }
+
+    // Copy the machine code into executable memory.
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mappingSize = (assembler.size + pageSize - 1) & ~(pageSize - 1);
+    void *executableCode = MAP_FAILED;
+    if(succeeded)
+        executableCode = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    succeeded = executableCode != MAP_FAILED;
+    if(succeeded)
+    {
+        memcpy(executableCode, assembler.code, assembler.size);
+        succeeded = mprotect(executableCode, mappingSize, PROT_READ | PROT_EXEC) == 0;
+    }
+
+    free(pcToNativeOffset);
+    free(assembler.fixups);
+    free(assembler.epilogueFixups);
+    free(assembler.code);
+    if(!succeeded)
+    {
+        free(inlineCaches);
+        return NULL;
+    }
+
+    beacon_JitCompiledCode_t *compiledCode = calloc(1, sizeof(beacon_JitCompiledCode_t));
+    compiledCode->entryPoint = (beacon_JitEntryPoint_t)executableCode;
+    compiledCode->codeSize = assembler.size;
+    compiledCode->requiredReceiverSlotCount = requiredReceiverSlotCount;
+    compiledCode->requiredCaptureCount = requiredCaptureCount;
+    compiledCode->inlineCacheCount = inlineCacheCount;
+    compiledCode->inlineCaches = inlineCaches;
+    return compiledCode;
+}
+
+/**
+ * The machine code that is owned by the bytecode of the compiled methods. It is freed when their bytecode is collected.
+ */
+typedef struct beacon_JitCodeRegistryEntry_s
+{
+    beacon_BytecodeCode_t *code;
+    beacon_JitCompiledCode_t *compiledCode;
+} beacon_JitCodeRegistryEntry_t;
+
+typedef struct beacon_JitCodeRegistry_s
+{
+    size_t size;
+    size_t capacity;
+    beacon_JitCodeRegistryEntry_t *entries;
+} beacon_JitCodeRegistry_t;
+
+static void beacon_jit_registerCompiledCode(beacon_context_t *context, beacon_BytecodeCode_t *code, beacon_JitCompiledCode_t *compiledCode)
+{
+    if(!context->jitCodeRegistry)
+        context->jitCodeRegistry = calloc(1, sizeof(beacon_JitCodeRegistry_t));
+
+    beacon_JitCodeRegistry_t *registry = context->jitCodeRegistry;
+    if(registry->size == registry->capacity)
+    {
+        registry->capacity = registry->capacity ? registry->capacity * 2 : 64;
+        registry->entries = realloc(registry->entries, registry->capacity * sizeof(beacon_JitCodeRegistryEntry_t));
+    }
+
+    registry->entries[registry->size++] = (beacon_JitCodeRegistryEntry_t){
+        .code = code,
+        .compiledCode = compiledCode
+    };
+}
+
+static void beacon_jit_freeCompiledCode(beacon_JitCompiledCode_t *compiledCode)
+{
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    munmap((void*)compiledCode->entryPoint, (compiledCode->codeSize + pageSize - 1) & ~(pageSize - 1));
+    free(compiledCode->inlineCaches);
+    free(compiledCode);
+}
+
+void beacon_jit_releaseCollectedCode(beacon_context_t *context)
+{
+    beacon_JitCodeRegistry_t *registry = context->jitCodeRegistry;
+    if(!registry)
+        return;
+
+    size_t survivorCount = 0;
+    for(size_t i = 0; i < registry->size; ++i)
+    {
+        beacon_JitCodeRegistryEntry_t *entry = registry->entries + i;
+        if(((beacon_ObjectHeader_t*)entry->code)->gcColor == context->heap->whiteGCColor)
+            beacon_jit_freeCompiledCode(entry->compiledCode);
+        else
+            registry->entries[survivorCount++] = *entry;
+    }
+    registry->size = survivorCount;
+}
+
+void beacon_jit_destroy(beacon_context_t *context)
+{
+    beacon_JitCodeRegistry_t *registry = context->jitCodeRegistry;
+    if(!registry)
+        return;
+
+    for(size_t i = 0; i < registry->size; ++i)
+        beacon_jit_freeCompiledCode(registry->entries[i].compiledCode);
+    free(registry->entries);
+    free(registry);
+    context->jitCodeRegistry = NULL;
+}
+
+beacon_JitCompiledCode_t *beacon_jit_getCompiledCodeFor(beacon_context_t *context, beacon_CompiledCode_t *method)
+{
+    beacon_BytecodeCode_t *code = method->bytecodeImplementation;
+    if(code->jitCompiledCode)
+    {
+        if(code->jitCompiledCode == context->roots.falseValue)
+            return NULL;
+        return (beacon_JitCompiledCode_t*)beacon_unboxExternalAddress(context, code->jitCompiledCode);
+    }
+
+    if(context->options.jitCompilationThreshold == 0)
+        return NULL;
+
+    // The interpreter counts the invocations before asking for the machine code.
+    intptr_t invocationCount = beacon_decodeSmallInteger(code->invocationCount);
+    if((size_t)invocationCount < context->options.jitCompilationThreshold)
+        return NULL;
+
+    beacon_JitCompiledCode_t *compiledCode = beacon_jit_compile(context, code);
+    if(!compiledCode)
+    {
+        // Do not attempt compiling this method again.
+        code->jitCompiledCode = context->roots.falseValue;
+        return NULL;
+    }
+
+    code->jitCompiledCode = beacon_boxExternalAddress(context, compiledCode);
+    beacon_jit_registerCompiledCode(context, code, compiledCode);
+    if(context->options.writePerfMap)
+        beacon_Profiler_recordGeneratedCode(context, method, (const void*)compiledCode->entryPoint, compiledCode->codeSize);
+    return compiledCode;
+}
+
+#else
+
+void beacon_jit_releaseCollectedCode(beacon_context_t *context)
+{
+    (void)context;
+}
+
+void beacon_jit_destroy(beacon_context_t *context)
+{
+    (void)context;
+}
+
+beacon_JitCompiledCode_t *beacon_jit_getCompiledCodeFor(beacon_context_t *context, beacon_CompiledCode_t *method)
+{
+    (void)context;
+    (void)method;
+    return NULL;
+}
+
+#endif
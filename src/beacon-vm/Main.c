@@ -5,7 +5,9 @@
 #include "beacon-lang/SyntaxCompiler.h"
 #include "beacon-lang/Exceptions.h"
 #include "beacon-lang/AgpuRendering.h"
+#include "beacon-lang/Profiler.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static beacon_context_t *context;
@@ -17,7 +19,7 @@ void printHelp(void)
 
 void printVersion(void)
 {
-    printf("beacon-vm version 0.1\n");
+    printf("beacon-vm version " BEACON_VM_VERSION "\n");
 }
 
 void printObject(beacon_oop_t object)
@@ -41,8 +43,26 @@ void evaluateFileNamed(const char *fileName)
     beacon_evaluateSourceCode(context, sourceCode);
 }
 
+static void setDefaultBytecodeCacheDirectory(void)
+{
+    static char bytecodeCacheDirectory[4096];
+    const char *cacheHome = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if(cacheHome && *cacheHome)
+        snprintf(bytecodeCacheDirectory, sizeof(bytecodeCacheDirectory), "%s/beacon-lang/bytecode", cacheHome);
+    else if(home && *home)
+        snprintf(bytecodeCacheDirectory, sizeof(bytecodeCacheDirectory), "%s/.cache/beacon-lang/bytecode", home);
+    else
+        return;
+
+    context->options.bytecodeCacheDirectory = bytecodeCacheDirectory;
+}
+
 int main(int argc, const char **argv)
 {
+    size_t profileCountsTopCount = 0;
+    size_t samplingIntervalMicroseconds = BEACON_PROFILER_DEFAULT_SAMPLING_INTERVAL_MICROSECONDS;
+    const char *sampleProfileFileName = NULL;
     context = beacon_context_new();
     if(!context)
     {
@@ -50,6 +70,21 @@ int main(int argc, const char **argv)
         return 1;
     }
 
+    setDefaultBytecodeCacheDirectory();
+    beacon_Profiler_installCrashHandler(context);
+
+    // The sampling options are parsed first, so that the interval applies wherever it is given.
+    for(int i = 1; i + 1 < argc; ++i)
+    {
+        if(!strcmp(argv[i], "-sample-interval"))
+            samplingIntervalMicroseconds = (size_t)atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-sample-profile"))
+            sampleProfileFileName = argv[++i];
+    }
+
+    if(sampleProfileFileName && !beacon_Profiler_startSampling(context, samplingIntervalMicroseconds))
+        fprintf(stderr, "Stack sampling is not supported.\n");
+
     for(int i = 1; i < argc; ++i)
     {
         const char *arg = argv[i];
@@ -72,6 +107,57 @@ int main(int argc, const char **argv)
                 const char *script = argv[++i];
                 evaluateStringAndPrint(script);
             }
+            else if(!strcmp(arg, "-no-inline-collections"))
+            {
+                context->options.inlineCollectionIterationSelectors = false;
+            }
+#ifdef BEACON_JIT
+            else if(!strcmp(arg, "-no-jit"))
+            {
+                context->options.jitCompilationThreshold = 0;
+            }
+            else if(!strcmp(arg, "-jit-threshold"))
+            {
+                context->options.jitCompilationThreshold = (size_t)atoi(argv[++i]);
+            }
+#endif
+            else if(!strcmp(arg, "-ast-eval"))
+            {
+                context->options.evaluateScriptsWithAST = true;
+            }
+            else if(!strcmp(arg, "-no-bytecode-cache"))
+            {
+                context->options.bytecodeCacheDirectory = NULL;
+            }
+            else if(!strcmp(arg, "-bytecode-cache-dir"))
+            {
+                context->options.bytecodeCacheDirectory = argv[++i];
+            }
+            else if(!strcmp(arg, "-parsing-threads"))
+            {
+                context->options.sourceParsingThreadCount = (size_t)atoi(argv[++i]);
+            }
+            else if(!strcmp(arg, "-lazy-methods"))
+            {
+                context->options.lazyMethodCompilation = true;
+            }
+            else if(!strcmp(arg, "-max-stack-depth"))
+            {
+                context->options.maxStackDepth = (size_t)atoi(argv[++i]);
+            }
+            else if(!strcmp(arg, "-profile-counts"))
+            {
+                profileCountsTopCount = (size_t)atoi(argv[++i]);
+            }
+            else if(!strcmp(arg, "-perf-map"))
+            {
+                context->options.writePerfMap = true;
+            }
+            else if(!strcmp(arg, "-sample-interval") || !strcmp(arg, "-sample-profile"))
+            {
+                // Already parsed before starting the sampling.
+                ++i;
+            }
             else if(!strcmp(arg, "-gplatform"))
             {
                 context->roots.agpuCommon->platformIndex = atoi(argv[++i]);
@@ -87,6 +173,23 @@ int main(int argc, const char **argv)
         }
     }
 
+    if(profileCountsTopCount > 0)
+        beacon_context_printHotMethods(context, stderr, profileCountsTopCount);
+
+    if(sampleProfileFileName)
+    {
+        FILE *sampleProfileFile = fopen(sampleProfileFileName, "w");
+        if(sampleProfileFile)
+        {
+            beacon_Profiler_stopSamplingAndWriteFoldedStacks(context, sampleProfileFile);
+            fclose(sampleProfileFile);
+        }
+        else
+        {
+            fprintf(stderr, "Failed to write the sampled stacks into %s.\n", sampleProfileFileName);
+        }
+    }
+
     beacon_context_destroy(context);
     return 0;
 }
\ No newline at end of file
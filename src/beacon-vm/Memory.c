@@ -1,9 +1,26 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // For pthread_getattr_np
+#endif
+
 #include "beacon-lang/Memory.h"
 #include "beacon-lang/Context.h"
+#include "beacon-lang/Bytecode.h"
+#include "beacon-lang/Jit.h"
+#include "beacon-lang/Process.h"
+#include "beacon-lang/TimerWheel.h"
+#include "beacon-lang/ThreadPool.h"
 #include <stdlib.h>
 #include <assert.h>
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
 _Thread_local beacon_StackFrameRecord_t *beaconCurrentTopStackFrameRecord = 0;
+_Thread_local beacon_MemoryHeap_t *beaconThreadLocalMemoryArena = 0;
+_Thread_local uintptr_t beaconNativeStackLimit = 0;
+_Thread_local bool beaconNativeStackLimitIsComputed = false;
+_Thread_local size_t beaconStackOverflowHandlingDepth = 0;
 
 beacon_StackFrameRecord_t *beacon_getTopStackFrameRecord()
 {
@@ -13,6 +30,7 @@ beacon_StackFrameRecord_t *beacon_getTopStackFrameRecord()
 void beacon_pushStackFrameRecord(beacon_StackFrameRecord_t *record)
 {
     record->previousRecord = beaconCurrentTopStackFrameRecord;
+    record->depth = beaconCurrentTopStackFrameRecord ? beaconCurrentTopStackFrameRecord->depth + 1 : 0;
     beaconCurrentTopStackFrameRecord = record;
     beacon_memoryHeapSafepoint(record->context);
 }
@@ -23,6 +41,87 @@ void beacon_popStackFrameRecord(beacon_StackFrameRecord_t *record)
     beaconCurrentTopStackFrameRecord = record->previousRecord;
 }
 
+void beacon_unwindStackFrameRecordsUntil(beacon_StackFrameRecord_t *record)
+{
+    // The ensure blocks run on top of the native frames that are being unwound, which are only discarded by the longjmp afterwards.
+    beacon_StackFrameRecord_t *currentRecord = beaconCurrentTopStackFrameRecord;
+    while(currentRecord && currentRecord != record)
+    {
+        if(currentRecord->kind == StackFrameEnsure && !currentRecord->ensure.ensureBlockActivated)
+        {
+            currentRecord->ensure.ensureBlockActivated = true;
+            beaconCurrentTopStackFrameRecord = currentRecord;
+
+            beacon_BlockClosure_t *ensureBlock = (beacon_BlockClosure_t*)currentRecord->ensure.ensureBlock;
+            beacon_runBlockClosureWithArguments(currentRecord->context, &ensureBlock->code->super, ensureBlock->receiver, ensureBlock->captures, 0, NULL);
+        }
+
+        currentRecord = currentRecord->previousRecord;
+    }
+
+    if(!record || record->depth < beaconStackOverflowHandlingDepth)
+        beaconStackOverflowHandlingDepth = 0;
+    beaconCurrentTopStackFrameRecord = record;
+}
+
+static uintptr_t beacon_computeNativeStackLowestAddress(void)
+{
+#if defined(__linux__)
+    pthread_attr_t attributes;
+    if(pthread_getattr_np(pthread_self(), &attributes))
+        return 0;
+
+    void *stackAddress = NULL;
+    size_t stackSize = 0;
+    int error = pthread_attr_getstack(&attributes, &stackAddress, &stackSize);
+    pthread_attr_destroy(&attributes);
+    return error ? 0 : (uintptr_t)stackAddress;
+#elif defined(__APPLE__)
+    pthread_t thread = pthread_self();
+    return (uintptr_t)pthread_get_stackaddr_np(thread) - pthread_get_stacksize_np(thread);
+#else
+    return 0;
+#endif
+}
+
+uintptr_t beacon_getNativeStackLimit(void)
+{
+    if(!beaconNativeStackLimitIsComputed)
+    {
+        uintptr_t lowestAddress = beacon_computeNativeStackLowestAddress();
+        beaconNativeStackLimit = lowestAddress ? lowestAddress + BEACON_NATIVE_STACK_GUARD_SIZE + BEACON_NATIVE_STACK_OVERFLOW_RESERVED_SIZE : 0;
+        beaconNativeStackLimitIsComputed = true;
+    }
+
+    return beaconNativeStackLimit;
+}
+
+size_t beacon_getStackOverflowHandlingDepth(void)
+{
+    return beaconStackOverflowHandlingDepth;
+}
+
+void beacon_setStackOverflowHandlingDepth(size_t depth)
+{
+    beaconStackOverflowHandlingDepth = depth;
+}
+
+void beacon_saveStackState(beacon_StackState_t *state)
+{
+    state->topStackFrameRecord = beaconCurrentTopStackFrameRecord;
+    state->nativeStackLimit = beaconNativeStackLimit;
+    state->nativeStackLimitIsComputed = beaconNativeStackLimitIsComputed;
+    state->stackOverflowHandlingDepth = beaconStackOverflowHandlingDepth;
+}
+
+void beacon_restoreStackState(const beacon_StackState_t *state)
+{
+    beaconCurrentTopStackFrameRecord = state->topStackFrameRecord;
+    beaconNativeStackLimit = state->nativeStackLimit;
+    beaconNativeStackLimitIsComputed = state->nativeStackLimitIsComputed;
+    beaconStackOverflowHandlingDepth = state->stackOverflowHandlingDepth;
+}
+
 beacon_MemoryHeap_t *beacon_createMemoryHeap(beacon_context_t *context)
 {
     beacon_MemoryHeap_t *heap = calloc(1, sizeof(beacon_MemoryHeap_t));
@@ -38,6 +137,39 @@ beacon_MemoryHeap_t *beacon_createMemoryHeap(beacon_context_t *context)
     return heap;
 }
 
+beacon_MemoryHeap_t *beacon_createMemoryArena(beacon_MemoryHeap_t *heap)
+{
+    beacon_MemoryHeap_t *arena = calloc(1, sizeof(beacon_MemoryHeap_t));
+    arena->whiteGCColor = heap->whiteGCColor;
+    arena->grayGCColor = heap->grayGCColor;
+    arena->blackGCColor = heap->blackGCColor;
+    arena->gcDisableCount = 1;
+    arena->context = heap->context;
+    return arena;
+}
+
+void beacon_setThreadLocalMemoryArena(beacon_MemoryHeap_t *arena)
+{
+    beaconThreadLocalMemoryArena = arena;
+}
+
+void beacon_mergeMemoryArenaIntoHeap(beacon_MemoryHeap_t *heap, beacon_MemoryHeap_t *arena)
+{
+    assert(arena->whiteGCColor == heap->whiteGCColor);
+    if(arena->lastAllocation)
+    {
+        beacon_MemoryAllocationHeader_t *firstAllocation = arena->lastAllocation;
+        while(firstAllocation->nextAllocation)
+            firstAllocation = firstAllocation->nextAllocation;
+
+        firstAllocation->nextAllocation = heap->lastAllocation;
+        heap->lastAllocation = arena->lastAllocation;
+        heap->allocatedByteCount += arena->allocatedByteCount;
+    }
+
+    free(arena);
+}
+
 void beacon_heap_pushReachableObject(beacon_MemoryHeap_t *heap, beacon_oop_t object)
 {
     if (beacon_isImmediate(object) || !object)
@@ -67,6 +199,74 @@ void beacon_heap_pushReachableObject(beacon_MemoryHeap_t *heap, beacon_oop_t obj
     heap->markingStack[heap->markingStackSize++] = object;
 }
 
+void beacon_garbageCollect_markStackFrameRecords(beacon_context_t *context, beacon_StackFrameRecord_t *topRecord)
+{
+    beacon_StackFrameRecord_t *currentStackRecord = topRecord;
+    while(currentStackRecord)
+    {
+        switch (currentStackRecord->kind)
+        {
+        case StackFrameBytecodeMethodRecord:
+        {
+            beacon_heap_pushReachableObject(context->heap, (beacon_oop_t)currentStackRecord->bytecodeMethodStackRecord.code);
+            beacon_heap_pushReachableObject(context->heap, (beacon_oop_t)currentStackRecord->bytecodeMethodStackRecord.receiver);
+            for(size_t i = 0; i < currentStackRecord->bytecodeMethodStackRecord.argumentCount; ++i)
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.arguments[i]);
+            for(size_t i = 0; i < currentStackRecord->bytecodeMethodStackRecord.temporaryCount; ++i)
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.temporaries[i]);
+            for(size_t i = 0; i < currentStackRecord->bytecodeMethodStackRecord.decodedArgumentsTemporaryZoneSize; ++i)
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.decodedArgumentsTemporaryZone[i]);
+
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.captures);
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.returnResultValue);
+        }
+            break;
+        case StackFrameSourceCompilationRoots:
+        {
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.sourceCode);
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.tokenList);
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.parseTree);
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.evaluation);
+        }
+            break;
+        case StackFramePrimitiveRoots:
+            {
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.receiver);
+                for(size_t i = 0; i < currentStackRecord->primitiveRoots.argumentCount; ++i)
+                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.arguments[i]);
+                for(size_t i = 0; i < 4; ++i)
+                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.allocatedObjects[i]);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.result);
+            }
+            break;
+        case StackFrameEnsure:
+            {
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->ensure.ensureReceiver);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->ensure.ensureBlock);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->ensure.resultValue);
+            }
+            break;
+        case StackFrameOnDo:
+            {
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.onReceiver);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.onFilter);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.doBlock);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.exception);
+                beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.resultValue);
+            }
+            break;
+        case StackFrameExceptionHandler:
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->exceptionHandler.exception);
+            beacon_heap_pushReachableObject(context->heap, currentStackRecord->exceptionHandler.resumptionValue);
+            break;
+        default:
+            abort();
+            break;
+        }
+        currentStackRecord = currentStackRecord->previousRecord;
+    }
+}
+
 void beacon_garbageCollect_markRootsPhase(beacon_context_t *context)
 {
     // Mark the classes.
@@ -85,69 +285,11 @@ void beacon_garbageCollect_markRootsPhase(beacon_context_t *context)
             beacon_heap_pushReachableObject(context->heap, contextRoots[i]);
     }
 
-    // Mark the stack
-    {
-        beacon_StackFrameRecord_t *currentStackRecord = beacon_getTopStackFrameRecord();
-        while(currentStackRecord)
-        {
-            switch (currentStackRecord->kind)
-            {
-            case StackFrameBytecodeMethodRecord:
-            {
-                beacon_heap_pushReachableObject(context->heap, (beacon_oop_t)currentStackRecord->bytecodeMethodStackRecord.code);
-                beacon_heap_pushReachableObject(context->heap, (beacon_oop_t)currentStackRecord->bytecodeMethodStackRecord.receiver);
-                for(size_t i = 0; i < currentStackRecord->bytecodeMethodStackRecord.argumentCount; ++i)
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.arguments[i]);
-                for(size_t i = 0; i < currentStackRecord->bytecodeMethodStackRecord.temporaryCount; ++i)
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.temporaries[i]);
-                for(size_t i = 0; i < currentStackRecord->bytecodeMethodStackRecord.decodedArgumentsTemporaryZoneSize; ++i)
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.decodedArgumentsTemporaryZone[i]);
-
-                beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.captures);
-                beacon_heap_pushReachableObject(context->heap, currentStackRecord->bytecodeMethodStackRecord.returnResultValue);
-            }
-                break;
-            case StackFrameSourceCompilationRoots:
-            {
-                beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.sourceCode);
-                beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.tokenList);
-                beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.parseTree);
-                beacon_heap_pushReachableObject(context->heap, currentStackRecord->sourceCompilationRoots.evaluation);
-            }
-                break;
-            case StackFramePrimitiveRoots:
-                {
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.receiver);
-                    for(size_t i = 0; i < currentStackRecord->primitiveRoots.argumentCount; ++i)
-                        beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.arguments[i]);
-                    for(size_t i = 0; i < 4; ++i)
-                        beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.allocatedObjects[i]);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->primitiveRoots.result);
-                }
-                break;
-            case StackFrameEnsure:
-                {
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->ensure.ensureReceiver);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->ensure.ensureBlock);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->ensure.resultValue);
-                }
-                break;
-            case StackFrameOnDo:
-                {
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.onReceiver);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.onFilter);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.doBlock);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.exception);
-                    beacon_heap_pushReachableObject(context->heap, currentStackRecord->onDo.resultValue);
-                }
-                break;
-            default:
-                abort();
-                break;
-            }
-            currentStackRecord = currentStackRecord->previousRecord;
-        }
-    }
+    // Mark the stack, and the stacks of the suspended processes.
+    beacon_garbageCollect_markStackFrameRecords(context, beacon_getTopStackFrameRecord());
+    beacon_ProcessScheduler_markRoots(context);
+    beacon_TimerWheel_markRoots(context);
+    beacon_AsyncTasks_markRoots(context);
 }
 
 void beacon_garbageCollect_markPhase(beacon_context_t *context)
@@ -277,6 +419,14 @@ void beacon_memoryHeapEnableGC(beacon_MemoryHeap_t *heap)
 
 void beacon_memoryHeapSafepoint(beacon_context_t *context)
 {
+    // The worker threads that allocate into an arena never collect the shared heap.
+    if(beaconThreadLocalMemoryArena)
+        return;
+
+    // Only counts down while other processes exist.
+    if(context->preemptionCheckCountdown && !--context->preemptionCheckCountdown)
+        beacon_ProcessScheduler_preemptionCheck(context);
+
     beacon_MemoryHeap_t *heap = context->heap;
     if(heap->gcDisableCount > 0)
         return;
@@ -289,9 +439,17 @@ void beacon_memoryHeapSafepoint(beacon_context_t *context)
 
     beacon_garbageCollect_markPhase(context);
     beacon_garbageCollect_clearWeakObjects(context);
+    beacon_InternedSymbolSet_removeCollectedSymbols(context);
+    beacon_LiteralFrameSet_removeCollectedFrames(context);
+#ifdef BEACON_JIT
+    beacon_jit_releaseCollectedCode(context);
+#endif
     beacon_garbageCollect_sweepPhase(context->heap);
     beacon_garbageCollect_swapColors(context->heap);
 
+    // The addresses of the collected behaviors and methods can be reused.
+    ++context->methodLookupEpoch;
+
     size_t afterGC = heap->allocatedByteCount;
     if(afterGC > heap->gcTriggerLimit)
         heap->gcTriggerLimit = afterGC*2;
@@ -307,6 +465,9 @@ void *beacon_allocateObject(beacon_MemoryHeap_t *heap, size_t size, beacon_Objec
 void *beacon_allocateObjectWithBehavior(beacon_MemoryHeap_t *heap, beacon_Behavior_t *behavior, size_t size, beacon_ObjectKind_t kind)
 {
     assert(size >= sizeof(beacon_ObjectHeader_t));
+    if(beaconThreadLocalMemoryArena)
+        heap = beaconThreadLocalMemoryArena;
+
     size_t allocationSize = sizeof(beacon_MemoryAllocationHeader_t) + size;
     beacon_MemoryAllocationHeader_t *allocation = calloc(1, allocationSize);
     allocation->nextAllocation = heap->lastAllocation;
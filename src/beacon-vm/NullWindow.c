@@ -18,8 +18,18 @@ static beacon_oop_t beacon_WindowClass_enterMainLoop(beacon_context_t *context,
     return receiver;
 }
 
+static beacon_oop_t beacon_WindowClass_exitMainLoop(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)context;
+    (void)receiver;
+    (void)argumentCount;
+    (void)arguments;
+    return receiver;
+}
+
 void beacon_context_registerWindowSystemPrimitives(beacon_context_t *context)
 {
     beacon_addPrimitiveToClass(context, context->classes.windowClass, "open", 0, beacon_Window_open);
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.windowClass), "enterMainLoop", 0, beacon_WindowClass_enterMainLoop);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.windowClass), "exitMainLoop", 0, beacon_WindowClass_exitMainLoop);
 }
\ No newline at end of file
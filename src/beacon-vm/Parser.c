@@ -6,14 +6,17 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 
+// The token positions are one-based.
 typedef struct beacon_parserState_s
 {
     beacon_context_t *context;
     beacon_SourceCode_t *sourceCode;
     size_t tokenCount;
-    beacon_ArrayList_t *tokens;
+    beacon_TokenBuffer_t *tokens;
     size_t position;
+    bool skipMethodBodies;
 }beacon_parserState_t;
 
 beacon_ParseTreeNode_t *parser_parseExpression(beacon_parserState_t *state);
@@ -21,6 +24,7 @@ beacon_ParseTreeNode_t *parser_parseSequenceUntilEndOrDelimiter(beacon_parserSta
 beacon_ArrayList_t *parser_parseExpressionListUntilEndOrDelimiter(beacon_parserState_t *state, beacon_TokenKind_t delimiter);
 beacon_ParseTreeNode_t *parser_parseMethodSyntaxWithDelimiter(beacon_parserState_t *state, beacon_TokenKind_t delimiter);
 beacon_ParseTreeNode_t *parser_parseLiteralArrayElement(beacon_parserState_t *state);
+beacon_ParseTreeMethodNode_t *parser_parseMethodHeader(beacon_parserState_t *state);
 bool parser_isBinaryExpressionOperator(beacon_TokenKind_t kind);
 
 
@@ -29,28 +33,33 @@ bool parserState_atEnd(beacon_parserState_t *state)
     return state->position > state->tokenCount;
 }
 
-beacon_TokenKind_t parserState_peekKind(beacon_parserState_t *state, int offset)
+beacon_TokenKind_t parserState_tokenKind(beacon_parserState_t *state, size_t token)
 {
-    size_t peekPosition = state->position + offset;
-    if (peekPosition <= state->tokenCount)
-    {
-        beacon_ScannerToken_t *token = (beacon_ScannerToken_t*)beacon_ArrayList_at(state->context, state->tokens, peekPosition);
-        return beacon_decodeSmallInteger(token->kind);
-    }
-    else
-        return BeaconTokenEndOfSource;
+    return state->tokens->kinds[token - 1];
+}
+
+const char *parserState_tokenText(beacon_parserState_t *state, size_t token)
+{
+    return (const char*)state->sourceCode->text->data + state->tokens->startIndices[token - 1];
+}
+
+size_t parserState_tokenTextSize(beacon_parserState_t *state, size_t token)
+{
+    return state->tokens->endIndices[token - 1] - state->tokens->startIndices[token - 1];
+}
+
+beacon_SourcePosition_t *parserState_tokenSourcePosition(beacon_parserState_t *state, size_t token)
+{
+    return beacon_makeSourcePosition(state->context, state->sourceCode, state->tokens->startIndices[token - 1], state->tokens->endIndices[token - 1]);
 }
 
-beacon_ScannerToken_t *parserState_peek(beacon_parserState_t *state, int offset)
+beacon_TokenKind_t parserState_peekKind(beacon_parserState_t *state, int offset)
 {
     size_t peekPosition = state->position + offset;
     if (peekPosition <= state->tokenCount)
-    {
-        beacon_ScannerToken_t *token = (beacon_ScannerToken_t *)beacon_ArrayList_at(state->context, state->tokens, peekPosition);
-        return token;
-    }
+        return parserState_tokenKind(state, peekPosition);
     else
-        return NULL;
+        return BeaconTokenEndOfSource;
 }
 
 void parserState_advance(beacon_parserState_t *state)
@@ -59,21 +68,21 @@ void parserState_advance(beacon_parserState_t *state)
     ++state->position;
 }
 
-beacon_ScannerToken_t *parserState_next(beacon_parserState_t *state)
+size_t parserState_next(beacon_parserState_t *state)
 {
     BeaconAssert(state->context, state->position < state->tokenCount);
-    beacon_ScannerToken_t *token = (beacon_ScannerToken_t*)beacon_ArrayList_at(state->context, state->tokens, state->position);
-    ++state->position;
-    return token;
+    return state->position++;
 }
 
 beacon_ParseTreeNode_t *parserState_advanceWithExpectedError(beacon_parserState_t *state, const char *message)
 {
     if (parserState_peekKind(state, 0) == BeaconTokenError)
     {
-        beacon_ScannerToken_t *errorToken = parserState_next(state);
+        size_t errorToken = parserState_next(state);
+        const beacon_TokenBufferError_t *error = beacon_TokenBuffer_getError(state->tokens, errorToken - 1);
         beacon_ParseTreeErrorNode_t *errorNode = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeErrorNodeClass, sizeof(beacon_ParseTreeNode_t), BeaconObjectKindBytes);
-        errorNode->errorMessage = errorToken->errorMessage;
+        errorNode->errorMessage = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + error->messageSize, BeaconObjectKindBytes);
+        memcpy(errorNode->errorMessage->data, error->message, error->messageSize);
         return &errorNode->super;
     }
     else if (parserState_atEnd(state))
@@ -101,44 +110,32 @@ void parserState_restore(beacon_parserState_t *state, size_t memento)
     state->position = memento;
 }
 
-beacon_SourcePosition_t *parserState_previousSourcePosition(beacon_parserState_t *state)
+beacon_SourcePosition_t *parserState_sourcePositionFrom(beacon_parserState_t *state, size_t startingPosition)
 {
-    beacon_ScannerToken_t *token;
-    if(state->position == 1)
-        token = (beacon_ScannerToken_t *)beacon_ArrayList_at(state->context, state->tokens, 1);
-    else
-        token = (beacon_ScannerToken_t *)beacon_ArrayList_at(state->context, state->tokens, state->position - 1);
-    return token->sourcePosition;
+    BeaconAssert(state->context, startingPosition <= state->tokenCount);
+    size_t previousToken = state->position == 1 ? 1 : state->position - 1;
+    return beacon_makeSourcePosition(state->context, state->sourceCode, state->tokens->startIndices[startingPosition - 1], state->tokens->endIndices[previousToken - 1]);
 }
 
-beacon_SourcePosition_t *parserState_currentSourcePosition(beacon_parserState_t *state)
+// Concatenates the keyword tokens into a scratch buffer, and interns the resulting selector.
+beacon_Symbol_t *parserState_internKeywordSelector(beacon_parserState_t *state, beacon_ArrayList_t *keywords, size_t selectorSize)
 {
-    if (state->position >= 1 && state->position < state->tokenCount)
+    char inlineBuffer[256];
+    char *selector = selectorSize <= sizeof(inlineBuffer) ? inlineBuffer : malloc(selectorSize);
+    size_t destIndex = 0;
+    intptr_t keywordCount = beacon_ArrayList_size(keywords);
+    for(intptr_t i = 1; i <= keywordCount; ++i)
     {
-        beacon_ScannerToken_t *token = (beacon_ScannerToken_t *)beacon_ArrayList_at(state->context, state->tokens, state->position);
-        return token->sourcePosition;
+        size_t keywordToken = beacon_decodeSmallInteger(beacon_ArrayList_at(state->context, keywords, i));
+        size_t keywordSize = parserState_tokenTextSize(state, keywordToken);
+        memcpy(selector + destIndex, parserState_tokenText(state, keywordToken), keywordSize);
+        destIndex += keywordSize;
     }
 
-    BeaconAssert(state->context, state->tokenCount > 0);
-    beacon_ScannerToken_t *token = (beacon_ScannerToken_t *)beacon_ArrayList_at(state->context, state->tokens, state->tokenCount);
-    return token->sourcePosition;
-}
-
-beacon_SourcePosition_t *parserState_sourcePositionFrom(beacon_parserState_t *state, size_t startingPosition)
-{
-    BeaconAssert(state->context, startingPosition <= state->tokenCount);
-    beacon_ScannerToken_t *startingToken = (beacon_ScannerToken_t *)beacon_ArrayList_at(state->context, state->tokens, startingPosition);
-    beacon_SourcePosition_t *startSourcePosition = startingToken->sourcePosition;
-    if (state->position > 0)
-    {
-        beacon_SourcePosition_t *endSourcePosition = parserState_previousSourcePosition(state);
-        return beacon_sourcePosition_to(state->context, startSourcePosition, endSourcePosition);
-    }
-    else
-    {
-        beacon_SourcePosition_t *endSourcePosition = parserState_previousSourcePosition(state);
-        return beacon_sourcePosition_until(state->context, startSourcePosition, endSourcePosition);
-    }
+    beacon_Symbol_t *symbol = beacon_internStringWithSize(state->context, selectorSize, selector);
+    if(selector != inlineBuffer)
+        free(selector);
+    return symbol;
 }
 
 beacon_ParseTreeNode_t *parserState_makeErrorAtCurrentSourcePosition(beacon_parserState_t *state, const char *errorMessage)
@@ -162,10 +159,10 @@ beacon_ParseTreeNode_t *parserState_expectAddingErrorToNode(beacon_parserState_t
     return &errorNode->super;
 }
 
-intptr_t parser_parseIntegerConstant(beacon_ScannerToken_t *token)
+intptr_t parser_parseIntegerConstant(beacon_parserState_t *state, size_t token)
 {
-    size_t constantStringSize = beacon_decodeSmallInteger(token->textSize);
-    const char *constantString = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
+    size_t constantStringSize = parserState_tokenTextSize(state, token);
+    const char *constantString = parserState_tokenText(state, token);
     
     intptr_t result = 0;
     intptr_t radix = 10;
@@ -196,30 +193,30 @@ intptr_t parser_parseIntegerConstant(beacon_ScannerToken_t *token)
 
 beacon_ParseTreeNode_t *parser_parseLiteralInteger(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context,beacon_decodeSmallInteger(token->kind) == BeaconTokenInteger);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context,parserState_tokenKind(state, token) == BeaconTokenInteger);
 
-    intptr_t parsedConstant = parser_parseIntegerConstant(token);
+    intptr_t parsedConstant = parser_parseIntegerConstant(state, token);
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = parsedConstant;
     return &literal->super;
 }
 
 beacon_ParseTreeNode_t *parser_parseLiteralFloat(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenFloat);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenFloat);
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    intptr_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    intptr_t textDataSize = parserState_tokenTextSize(state, token);
     char *literalBuffer = calloc(1, textDataSize + 1);
     memcpy(literalBuffer, textData, textDataSize);
     double value = atof(literalBuffer);
     free(literalBuffer);
 
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = beacon_encodeSmallFloat(value);
     assert(beacon_decodeSmallFloat(literal->value) == value);
     return &literal->super;
@@ -227,23 +224,23 @@ beacon_ParseTreeNode_t *parser_parseLiteralFloat(beacon_parserState_t *state)
 
 beacon_ParseTreeNode_t *parser_parseLiteralCharacter(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenCharacter);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenCharacter);
 
-    char parsedConstant = token->sourcePosition->sourceCode->text->data[beacon_decodeSmallInteger(token->textPosition) + 1];
+    char parsedConstant = parserState_tokenText(state, token)[1];
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = beacon_encodeCharacter(parsedConstant);
     return &literal->super;
 }
 
 beacon_ParseTreeNode_t *parser_parseLiteralString(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenString);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenString);
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    size_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    size_t textDataSize = parserState_tokenTextSize(state, token);
 
     size_t textConstantSize = 0;
     for(size_t i = 1; i < textDataSize; ++i)
@@ -281,16 +278,16 @@ beacon_ParseTreeNode_t *parser_parseLiteralString(beacon_parserState_t *state)
     }
 
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = (beacon_oop_t)stringLiteral;
     return &literal->super;
 }
 
-beacon_ParseTreeNode_t *parser_parseLiteralStringSymbol(beacon_ScannerToken_t *token, beacon_parserState_t *state)
+beacon_ParseTreeNode_t *parser_parseLiteralStringSymbol(size_t token, beacon_parserState_t *state)
 {
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    size_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    size_t textDataSize = parserState_tokenTextSize(state, token);
 
     size_t textConstantSize = 0;
     for(size_t i = 2; i < textDataSize; ++i)
@@ -329,47 +326,43 @@ beacon_ParseTreeNode_t *parser_parseLiteralStringSymbol(beacon_ScannerToken_t *t
 
     beacon_Symbol_t *symbolLiteral = beacon_internString(state->context, stringLiteral);
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = (beacon_oop_t)symbolLiteral;
     return &literal->super;
 }
 
 beacon_ParseTreeNode_t *parser_parseLiteralSymbol(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenSymbol);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenSymbol);
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    intptr_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    intptr_t textDataSize = parserState_tokenTextSize(state, token);
     if(textDataSize >= 2 && textData[0] == '#' && textData[1] == '\'')
         return parser_parseLiteralStringSymbol(token, state);
 
-    intptr_t symbolSize = textDataSize - 1;
-    beacon_String_t *stringLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + symbolSize, BeaconObjectKindBytes);
-    memcpy(stringLiteral->data, textData + 1, symbolSize);
-    
-    beacon_Symbol_t *symbolLiteral = beacon_internString(state->context, stringLiteral);
+    beacon_Symbol_t *symbolLiteral = beacon_internStringWithSize(state->context, textDataSize - 1, textData + 1);
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = (beacon_oop_t)symbolLiteral;
     return &literal->super;
 }
 
 beacon_ParseTreeNode_t *parser_parseLiteralKeyword(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
+    size_t token = parserState_next(state);
     BeaconAssert(state->context,
-        beacon_decodeSmallInteger(token->kind) == BeaconTokenKeyword ||
-        beacon_decodeSmallInteger(token->kind) == BeaconTokenMultiKeyword ||
-        parser_isBinaryExpressionOperator(beacon_decodeSmallInteger(token->kind)));
+        parserState_tokenKind(state, token) == BeaconTokenKeyword ||
+        parserState_tokenKind(state, token) == BeaconTokenMultiKeyword ||
+        parser_isBinaryExpressionOperator(parserState_tokenKind(state, token)));
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    intptr_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    intptr_t textDataSize = parserState_tokenTextSize(state, token);
 
     beacon_Symbol_t *symbolLiteral = beacon_internStringWithSize(state->context, textDataSize, textData);
 
     beacon_ParseTreeLiteralNode_t *literal = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    literal->super.sourcePosition = token->sourcePosition;
+    literal->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     literal->value = (beacon_oop_t)symbolLiteral;
     return &literal->super;
 }
@@ -395,46 +388,40 @@ beacon_ParseTreeNode_t *parser_parseLiteral(beacon_parserState_t *state)
 
 beacon_ParseTreeNode_t *parser_parseIdentifier(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenIdentifier);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenIdentifier);
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    intptr_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    intptr_t textDataSize = parserState_tokenTextSize(state, token);
     
-    beacon_String_t *stringLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + textDataSize, BeaconObjectKindBytes);
-    memcpy(stringLiteral->data, textData, textDataSize);
-
-    beacon_Symbol_t *symbol = beacon_internString(state->context, stringLiteral);
+    beacon_Symbol_t *symbol = beacon_internStringWithSize(state->context, textDataSize, textData);
 
     beacon_ParseTreeIdentifierReferenceNode_t *identifierReference = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeIdentifierReferenceNodeClass, sizeof(beacon_ParseTreeIdentifierReferenceNode_t), BeaconObjectKindPointers);
-    identifierReference->super.sourcePosition = token->sourcePosition;
+    identifierReference->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     identifierReference->identifier = (beacon_oop_t)symbol;
     return &identifierReference->super;
 }
 
 beacon_ParseTreeNode_t *parser_parseIdentifierAsSymbol(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenIdentifier);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenIdentifier);
 
-    const char *textData = (const char*)token->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(token->textPosition);
-    intptr_t textDataSize = beacon_decodeSmallInteger(token->textSize);
+    const char *textData = parserState_tokenText(state, token);
+    intptr_t textDataSize = parserState_tokenTextSize(state, token);
     
-    beacon_String_t *stringLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + textDataSize, BeaconObjectKindBytes);
-    memcpy(stringLiteral->data, textData, textDataSize);
-
-    beacon_Symbol_t *symbol = beacon_internString(state->context, stringLiteral);
+    beacon_Symbol_t *symbol = beacon_internStringWithSize(state->context, textDataSize, textData);
 
     beacon_ParseTreeLiteralNode_t *identifierSymbol = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-    identifierSymbol->super.sourcePosition = token->sourcePosition;
+    identifierSymbol->super.sourcePosition = parserState_tokenSourcePosition(state, token);
     identifierSymbol->value = (beacon_oop_t)symbol;
     return &identifierSymbol->super;
 }
 
 beacon_ParseTreeNode_t *parser_parseParenthesis(beacon_parserState_t *state)
 {
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenLeftParent);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenLeftParent);
     
     beacon_ParseTreeNode_t *expression = parser_parseSequenceUntilEndOrDelimiter(state, BeaconTokenRightParent);
     expression = parserState_expectAddingErrorToNode(state, BeaconTokenRightParent, expression);
@@ -452,13 +439,13 @@ beacon_Array_t *parser_parseDelimitedListOfTemporaries(beacon_parserState_t *sta
         parserState_advance(state);
         while (parserState_peekKind(state, 0) == BeaconTokenIdentifier)
         {
-            beacon_ScannerToken_t *localNameToken = parserState_next(state);
-            const char *textData = (const char*)localNameToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(localNameToken->textPosition);
-            intptr_t textDataSize = beacon_decodeSmallInteger(localNameToken->textSize);
+            size_t localNameToken = parserState_next(state);
+            const char *textData = parserState_tokenText(state, localNameToken);
+            intptr_t textDataSize = parserState_tokenTextSize(state, localNameToken);
             beacon_Symbol_t *localName = beacon_internStringWithSize(state->context, textDataSize, textData);
 
             beacon_ParseTreeLocalVariableDefinitionNode_t *localDefinition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLocalVariableDefinitionNodeClass, sizeof(beacon_ParseTreeLocalVariableDefinitionNode_t), BeaconObjectKindPointers);
-            localDefinition->super.sourcePosition = localNameToken->sourcePosition;
+            localDefinition->super.sourcePosition = parserState_tokenSourcePosition(state, localNameToken);
             localDefinition->name = localName;
 
             beacon_ArrayList_add(state->context, localVariables, (beacon_oop_t)localDefinition);
@@ -480,8 +467,8 @@ beacon_Array_t *parser_parseDelimitedListOfTemporaries(beacon_parserState_t *sta
 beacon_ParseTreeNode_t *parser_parseBlockClosure(beacon_parserState_t *state)
 {
     size_t startingPosition = state->position;
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenLeftBracket);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenLeftBracket);
 
     beacon_ArrayList_t *arguments = beacon_ArrayList_new(state->context);
     bool hasArguments = false;
@@ -489,15 +476,15 @@ beacon_ParseTreeNode_t *parser_parseBlockClosure(beacon_parserState_t *state)
     {
         hasArguments = true;
         parserState_advance(state);
-        beacon_ScannerToken_t *argumentNameToken = parserState_next(state);
-        BeaconAssert(state->context, beacon_decodeSmallInteger(argumentNameToken->kind) == BeaconTokenIdentifier);
+        size_t argumentNameToken = parserState_next(state);
+        BeaconAssert(state->context, parserState_tokenKind(state, argumentNameToken) == BeaconTokenIdentifier);
         
-        const char *textData = (const char*)argumentNameToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(argumentNameToken->textPosition);
-        intptr_t textDataSize = beacon_decodeSmallInteger(argumentNameToken->textSize);
+        const char *textData = parserState_tokenText(state, argumentNameToken);
+        intptr_t textDataSize = parserState_tokenTextSize(state, argumentNameToken);
         beacon_Symbol_t *argumentName = beacon_internStringWithSize(state->context, textDataSize, textData);
 
         beacon_ParseTreeArgumentDefinitionNode_t *argumentDefinition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeArgumentDefinitionNodeClass, sizeof(beacon_ParseTreeArgumentDefinitionNode_t), BeaconObjectKindPointers);
-        argumentDefinition->super.sourcePosition = argumentNameToken->sourcePosition;
+        argumentDefinition->super.sourcePosition = parserState_tokenSourcePosition(state, argumentNameToken);
         argumentDefinition->name = argumentName;
 
         beacon_ArrayList_add(state->context, arguments, (beacon_oop_t)argumentDefinition);
@@ -529,12 +516,60 @@ beacon_ParseTreeNode_t *parser_parseBlockClosure(beacon_parserState_t *state)
     return &blockClosure->super;
 }
 
+// Moves past the tokens of a method body, up to its closing bracket. Fails on unbalanced brackets and on scanning errors, which are left for the full parser to report.
+bool parserState_skipUntilClosingBracket(beacon_parserState_t *state)
+{
+    size_t depth = 1;
+    while(!parserState_atEnd(state))
+    {
+        beacon_TokenKind_t kind = parserState_peekKind(state, 0);
+        if(kind == BeaconTokenEndOfSource || kind == BeaconTokenError)
+            return false;
+
+        if(kind == BeaconTokenLeftBracket || kind == BeaconTokenBangLeftBracket || kind == BeaconTokenByteArrayStart)
+            ++depth;
+        else if(kind == BeaconTokenRightBracket && --depth == 0)
+            return true;
+        parserState_advance(state);
+    }
+
+    return false;
+}
+
+// Parses only the header of a method block, leaving its body to be parsed when the method is invoked for the first time.
+beacon_ParseTreeNode_t *parser_parseMethodHeaderSkippingBody(beacon_parserState_t *state, size_t startingPosition)
+{
+    if(parserState_peekKind(state, 0) != BeaconTokenKeyword 
+    && parserState_peekKind(state, 0) != BeaconTokenIdentifier
+    && !parser_isBinaryExpressionOperator(parserState_peekKind(state, 0)))
+        return NULL;
+
+    size_t memento = parserState_memento(state);
+    beacon_ParseTreeMethodNode_t *methodNode = parser_parseMethodHeader(state);
+    if(!parserState_skipUntilClosingBracket(state))
+    {
+        parserState_restore(state, memento);
+        return NULL;
+    }
+
+    parserState_advance(state);
+    methodNode->expression = NULL;
+    methodNode->super.sourcePosition = parserState_sourcePositionFrom(state, startingPosition);
+    return &methodNode->super;
+}
+
 beacon_ParseTreeNode_t *parser_parseMethodBlock(beacon_parserState_t *state)
 {
     size_t startingPosition = state->position;
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenBangLeftBracket);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenBangLeftBracket);
 
+    if(state->skipMethodBodies)
+    {
+        beacon_ParseTreeNode_t *skippedMethodNode = parser_parseMethodHeaderSkippingBody(state, startingPosition);
+        if(skippedMethodNode)
+            return skippedMethodNode;
+    }
 
     beacon_ParseTreeNode_t *methodNode = parser_parseMethodSyntaxWithDelimiter(state, BeaconTokenRightBracket);
     methodNode = parserState_expectAddingErrorToNode(state, BeaconTokenRightBracket, methodNode);
@@ -546,8 +581,8 @@ beacon_ParseTreeNode_t *parser_parseMethodBlock(beacon_parserState_t *state)
 beacon_ParseTreeNode_t *parser_parseByteArray(beacon_parserState_t *state)
 {
     size_t startingPosition = state->position;
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenByteArrayStart);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenByteArrayStart);
 
     beacon_ArrayList_t *byteArrayElements = beacon_ArrayList_new(state->context);
     while(!parserState_atEnd(state) && parserState_peekKind(state, 0) != BeaconTokenRightBracket)
@@ -574,8 +609,8 @@ beacon_ParseTreeNode_t *parser_parseByteArray(beacon_parserState_t *state)
 beacon_ParseTreeNode_t *parser_parseArray(beacon_parserState_t *state)
 {
     size_t startingPosition = state->position;
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenLeftCurlyBracket);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenLeftCurlyBracket);
 
     beacon_ArrayList_t *arrayList = parser_parseExpressionListUntilEndOrDelimiter(state, BeaconTokenRightCurlyBracket);
 
@@ -591,9 +626,9 @@ beacon_ParseTreeNode_t *parser_parseArray(beacon_parserState_t *state)
 beacon_ParseTreeNode_t *parser_parseLiteralArray(beacon_parserState_t *state)
 {
     size_t startingPosition = state->position;
-    beacon_ScannerToken_t *token = parserState_next(state);
-    BeaconAssert(state->context, beacon_decodeSmallInteger(token->kind) == BeaconTokenLiteralArrayStart ||
-                                beacon_decodeSmallInteger(token->kind) == BeaconTokenLeftParent);
+    size_t token = parserState_next(state);
+    BeaconAssert(state->context, parserState_tokenKind(state, token) == BeaconTokenLiteralArrayStart ||
+                                parserState_tokenKind(state, token) == BeaconTokenLeftParent);
 
     beacon_ArrayList_t *literalArrayElements = beacon_ArrayList_new(state->context);
     while(!parserState_atEnd(state) && parserState_peekKind(state, 0) != BeaconTokenRightParent)
@@ -685,17 +720,14 @@ beacon_ParseTreeNode_t *parser_parseUnaryPostfixExpression(beacon_parserState_t
             continue;            
         }
 
-        beacon_ScannerToken_t *unaryToken = parserState_next(state);
+        size_t unaryToken = parserState_next(state);
         
-        const char *textData = (const char*)unaryToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(unaryToken->textPosition);
-        intptr_t textDataSize = beacon_decodeSmallInteger(unaryToken->textSize);
-
-        beacon_String_t *stringLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + textDataSize, BeaconObjectKindBytes);
-        memcpy(stringLiteral->data, textData, textDataSize);
+        const char *textData = parserState_tokenText(state, unaryToken);
+        intptr_t textDataSize = parserState_tokenTextSize(state, unaryToken);
 
-        beacon_Symbol_t *selectorSymbol = beacon_internString(state->context, stringLiteral);
+        beacon_Symbol_t *selectorSymbol = beacon_internStringWithSize(state->context, textDataSize, textData);
         beacon_ParseTreeLiteralNode_t *selectorLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-        selectorLiteral->super.sourcePosition = unaryToken->sourcePosition;
+        selectorLiteral->super.sourcePosition = parserState_tokenSourcePosition(state, unaryToken);
         selectorLiteral->value = (beacon_oop_t)selectorSymbol;
 
         beacon_Array_t *argumentsArray = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.arrayClass, sizeof(beacon_Array_t), BeaconObjectKindPointers);;
@@ -719,17 +751,14 @@ beacon_ParseTreeNode_t *parser_parseBinaryExpressionSequence(beacon_parserState_
 
     while(parser_isBinaryExpressionOperator(parserState_peekKind(state, 0)))
     {
-        beacon_ScannerToken_t *operatorToken = parserState_next(state);
+        size_t operatorToken = parserState_next(state);
         
-        const char *textData = (const char*)operatorToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(operatorToken->textPosition);
-        intptr_t textDataSize = beacon_decodeSmallInteger(operatorToken->textSize);
+        const char *textData = parserState_tokenText(state, operatorToken);
+        intptr_t textDataSize = parserState_tokenTextSize(state, operatorToken);
 
-        beacon_String_t *stringLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + textDataSize, BeaconObjectKindBytes);
-        memcpy(stringLiteral->data, textData, textDataSize);
-
-        beacon_Symbol_t *operatorSymbol = beacon_internString(state->context, stringLiteral);
+        beacon_Symbol_t *operatorSymbol = beacon_internStringWithSize(state->context, textDataSize, textData);
         beacon_ParseTreeLiteralNode_t *operatorLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-        operatorLiteral->super.sourcePosition = operatorToken->sourcePosition;
+        operatorLiteral->super.sourcePosition = parserState_tokenSourcePosition(state, operatorToken);
         operatorLiteral->value = (beacon_oop_t)operatorSymbol;
 
         beacon_ParseTreeNode_t *rightOperand = parser_parseUnaryPostfixExpression(state);
@@ -763,11 +792,11 @@ beacon_ParseTreeNode_t *parser_parseCascadedMessage(beacon_parserState_t *state)
     // Parse unary
     if(parserState_peekKind(state, 0) == BeaconTokenIdentifier)
     {
-        beacon_ScannerToken_t *unaryToken = parserState_next(state);
-        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, (size_t)beacon_decodeSmallInteger(unaryToken->textSize), (char*)unaryToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(unaryToken->textPosition));
+        size_t unaryToken = parserState_next(state);
+        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, parserState_tokenTextSize(state, unaryToken), parserState_tokenText(state, unaryToken));
 
         beacon_ParseTreeLiteralNode_t *selectorNode = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-        selectorNode->super.sourcePosition = unaryToken->sourcePosition;
+        selectorNode->super.sourcePosition = parserState_tokenSourcePosition(state, unaryToken);
         selectorNode->value = (beacon_oop_t)selector;
 
         beacon_ParseTreeCascadedMessageNode_t *cascadedMessage = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeCascadedMessageNodeClass, sizeof(beacon_ParseTreeCascadedMessageNode_t), BeaconObjectKindPointers);
@@ -781,11 +810,11 @@ beacon_ParseTreeNode_t *parser_parseCascadedMessage(beacon_parserState_t *state)
     // Parse binary
     if(parser_isBinaryExpressionOperator(parserState_peekKind(state, 0)))
     {
-        beacon_ScannerToken_t *operatorToken = parserState_next(state);
-        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, (size_t)beacon_decodeSmallInteger(operatorToken->textSize), (char*)operatorToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(operatorToken->textPosition));
+        size_t operatorToken = parserState_next(state);
+        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, parserState_tokenTextSize(state, operatorToken), parserState_tokenText(state, operatorToken));
 
         beacon_ParseTreeLiteralNode_t *selectorNode = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
-        selectorNode->super.sourcePosition = operatorToken->sourcePosition;
+        selectorNode->super.sourcePosition = parserState_tokenSourcePosition(state, operatorToken);
         selectorNode->value = (beacon_oop_t)selector;
 
         beacon_ParseTreeNode_t *argument = parser_parseBinaryExpressionSequence(state);
@@ -803,33 +832,18 @@ beacon_ParseTreeNode_t *parser_parseCascadedMessage(beacon_parserState_t *state)
     // Parse the keywords and arguments.
     while(parserState_peekKind(state, 0) == BeaconTokenKeyword)
     {
-        beacon_ScannerToken_t *keywordToken = parserState_next(state);
-        selectorSize += beacon_decodeSmallInteger(keywordToken->textSize);
-        beacon_ArrayList_add(state->context, keywords, (beacon_oop_t)keywordToken);
+        size_t keywordToken = parserState_next(state);
+        selectorSize += parserState_tokenTextSize(state, keywordToken);
+        beacon_ArrayList_add(state->context, keywords, beacon_encodeSmallInteger(keywordToken));
 
         beacon_ParseTreeNode_t *argument = parser_parseBinaryExpressionSequence(state);
         beacon_ArrayList_add(state->context, arguments, (beacon_oop_t)argument);
     }
 
-    // Reconstruct the selector;
-    beacon_String_t *selectorString = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + selectorSize, BeaconObjectKindBytes);
-    size_t destIndex = 0;
-    intptr_t keywordCount = beacon_ArrayList_size(keywords);
-    for(intptr_t i = 1; i <= keywordCount; ++i)
-    {
-        beacon_ScannerToken_t *keywordToken = (beacon_ScannerToken_t*)beacon_ArrayList_at(state->context, keywords, i);
-        intptr_t keywordSize = beacon_decodeSmallInteger(keywordToken->textSize);
-        intptr_t keywordPosition = beacon_decodeSmallInteger(keywordToken->textPosition);
-        for(intptr_t j = 0; j < keywordSize; ++j)
-        {
-            char c = keywordToken->sourcePosition->sourceCode->text->data[keywordPosition + j];
-            selectorString->data[destIndex++] = c;
-        }
-    }
 
     beacon_ParseTreeLiteralNode_t *selectorLiteral = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeLiteralNodeClass, sizeof(beacon_ParseTreeLiteralNode_t), BeaconObjectKindPointers);
     selectorLiteral->super.sourcePosition = parserState_sourcePositionFrom(state, startPosition);
-    selectorLiteral->value = (beacon_oop_t)beacon_internString(state->context, selectorString);
+    selectorLiteral->value = (beacon_oop_t)parserState_internKeywordSelector(state, keywords, selectorSize);
 
     // Make the cascaded message.
     beacon_ParseTreeCascadedMessageNode_t *cascadedMessage = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeCascadedMessageNodeClass, sizeof(beacon_ParseTreeCascadedMessageNode_t), BeaconObjectKindPointers);
@@ -972,8 +986,8 @@ beacon_ParseTreeMethodNode_t *parser_parseMethodHeader(beacon_parserState_t *sta
     // Parse unary
     if(parserState_peekKind(state, 0) == BeaconTokenIdentifier)
     {
-        beacon_ScannerToken_t *unaryToken = parserState_next(state);
-        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, (size_t)beacon_decodeSmallInteger(unaryToken->textSize), (char*)unaryToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(unaryToken->textPosition));
+        size_t unaryToken = parserState_next(state);
+        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, parserState_tokenTextSize(state, unaryToken), parserState_tokenText(state, unaryToken));
 
         beacon_ParseTreeMethodNode_t *methodNode = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeMethodNode, sizeof(beacon_ParseTreeMethodNode_t), BeaconObjectKindPointers);
         methodNode->selector = selector;
@@ -986,18 +1000,18 @@ beacon_ParseTreeMethodNode_t *parser_parseMethodHeader(beacon_parserState_t *sta
     // Parse binary
     if(parser_isBinaryExpressionOperator(parserState_peekKind(state, 0)))
     {
-        beacon_ScannerToken_t *operatorToken = parserState_next(state);
-        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, (size_t)beacon_decodeSmallInteger(operatorToken->textSize), (char*)operatorToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(operatorToken->textPosition));
+        size_t operatorToken = parserState_next(state);
+        beacon_Symbol_t *selector = beacon_internStringWithSize(state->context, parserState_tokenTextSize(state, operatorToken), parserState_tokenText(state, operatorToken));
 
-        beacon_ScannerToken_t *argumentNameToken = parserState_next(state);
-        BeaconAssert(state->context, beacon_decodeSmallInteger(argumentNameToken->kind) == BeaconTokenIdentifier);
+        size_t argumentNameToken = parserState_next(state);
+        BeaconAssert(state->context, parserState_tokenKind(state, argumentNameToken) == BeaconTokenIdentifier);
         
-        const char *textData = (const char*)argumentNameToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(argumentNameToken->textPosition);
-        intptr_t textDataSize = beacon_decodeSmallInteger(argumentNameToken->textSize);
+        const char *textData = parserState_tokenText(state, argumentNameToken);
+        intptr_t textDataSize = parserState_tokenTextSize(state, argumentNameToken);
         beacon_Symbol_t *argumentName = beacon_internStringWithSize(state->context, textDataSize, textData);
 
         beacon_ParseTreeArgumentDefinitionNode_t *argumentDefinition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeArgumentDefinitionNodeClass, sizeof(beacon_ParseTreeArgumentDefinitionNode_t), BeaconObjectKindPointers);
-        argumentDefinition->super.sourcePosition = argumentNameToken->sourcePosition;
+        argumentDefinition->super.sourcePosition = parserState_tokenSourcePosition(state, argumentNameToken);
         argumentDefinition->name = argumentName;
 
         beacon_Array_t *argumentDefinitionArray = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.arrayClass, sizeof(beacon_Array_t) + sizeof(beacon_oop_t), BeaconObjectKindPointers);
@@ -1018,42 +1032,27 @@ beacon_ParseTreeMethodNode_t *parser_parseMethodHeader(beacon_parserState_t *sta
 
     while(parserState_peekKind(state, 0) == BeaconTokenKeyword)
     {
-        beacon_ScannerToken_t *keywordToken = parserState_next(state);
-        selectorSize += beacon_decodeSmallInteger(keywordToken->textSize);
-        beacon_ArrayList_add(state->context, keywords, (beacon_oop_t)keywordToken);
+        size_t keywordToken = parserState_next(state);
+        selectorSize += parserState_tokenTextSize(state, keywordToken);
+        beacon_ArrayList_add(state->context, keywords, beacon_encodeSmallInteger(keywordToken));
 
-        beacon_ScannerToken_t *argumentNameToken = parserState_next(state);
-        BeaconAssert(state->context, beacon_decodeSmallInteger(argumentNameToken->kind) == BeaconTokenIdentifier);
+        size_t argumentNameToken = parserState_next(state);
+        BeaconAssert(state->context, parserState_tokenKind(state, argumentNameToken) == BeaconTokenIdentifier);
         
-        const char *textData = (const char*)argumentNameToken->sourcePosition->sourceCode->text->data + beacon_decodeSmallInteger(argumentNameToken->textPosition);
-        intptr_t textDataSize = beacon_decodeSmallInteger(argumentNameToken->textSize);
+        const char *textData = parserState_tokenText(state, argumentNameToken);
+        intptr_t textDataSize = parserState_tokenTextSize(state, argumentNameToken);
         beacon_Symbol_t *argumentName = beacon_internStringWithSize(state->context, textDataSize, textData);
 
         beacon_ParseTreeArgumentDefinitionNode_t *argumentDefinition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeArgumentDefinitionNodeClass, sizeof(beacon_ParseTreeArgumentDefinitionNode_t), BeaconObjectKindPointers);
-        argumentDefinition->super.sourcePosition = argumentNameToken->sourcePosition;
+        argumentDefinition->super.sourcePosition = parserState_tokenSourcePosition(state, argumentNameToken);
         argumentDefinition->name = argumentName;
 
         beacon_ArrayList_add(state->context, arguments,  (beacon_oop_t)argumentDefinition);
     }
 
-    // Reconstruct the selector.
-    beacon_String_t *selectorString = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.stringClass, sizeof(beacon_String_t) + selectorSize, BeaconObjectKindBytes);
-    size_t destIndex = 0;
-    intptr_t keywordCount = beacon_ArrayList_size(keywords);
-    for(intptr_t i = 1; i <= keywordCount; ++i)
-    {
-        beacon_ScannerToken_t *keywordToken = (beacon_ScannerToken_t*)beacon_ArrayList_at(state->context, keywords, i);
-        intptr_t keywordSize = beacon_decodeSmallInteger(keywordToken->textSize);
-        intptr_t keywordPosition = beacon_decodeSmallInteger(keywordToken->textPosition);
-        for(intptr_t j = 0; j < keywordSize; ++j)
-        {
-            char c = keywordToken->sourcePosition->sourceCode->text->data[keywordPosition + j];
-            selectorString->data[destIndex++] = c;
-        }
-    }
 
     beacon_ParseTreeMethodNode_t *methodNode = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.parseTreeMethodNode, sizeof(beacon_ParseTreeMethodNode_t), BeaconObjectKindPointers);
-    methodNode->selector = beacon_internString(state->context, selectorString);
+    methodNode->selector = parserState_internKeywordSelector(state, keywords, selectorSize);
     methodNode->arguments = beacon_ArrayList_asArray(state->context, arguments);
     methodNode->localVariables = (beacon_Array_t*)state->context->roots.emptyArray;
     methodNode->super.sourcePosition = parserState_sourcePositionFrom(state, startPosition);
@@ -1086,28 +1085,77 @@ beacon_ParseTreeNode_t *parser_parseWorkspaceScript(beacon_parserState_t *state)
     return &script->super;
 }
 
-beacon_ParseTreeNode_t *beacon_parseWorkspaceTokenList(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_ArrayList_t *tokenList)
+beacon_ParseTreeNode_t *beacon_parseWorkspaceTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer)
 {
     beacon_parserState_t state = {
         .context = context,
         .sourceCode = sourceCode,
-        .tokenCount = beacon_ArrayList_size(tokenList),
-        .tokens = tokenList,
+        .tokenCount = tokenBuffer->size,
+        .tokens = tokenBuffer,
         .position = 1,
     };
 
     return parser_parseWorkspaceScript(&state);
 }
 
-beacon_ParseTreeNode_t *beacon_parseMethodTokenList(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_ArrayList_t *tokenList)
+beacon_ParseTreeNode_t *beacon_parseMethodTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer)
 {
     beacon_parserState_t state = {
         .context = context,
         .sourceCode = sourceCode,
-        .tokenCount = beacon_ArrayList_size(tokenList),
-        .tokens = tokenList,
+        .tokenCount = tokenBuffer->size,
+        .tokens = tokenBuffer,
         .position = 1,
     };
 
     return parser_parseMethodSyntaxWithDelimiter(&state, BeaconTokenEndOfSource);
 }
+
+beacon_ParseTreeNode_t *beacon_parseFileTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer)
+{
+    beacon_parserState_t state = {
+        .context = context,
+        .sourceCode = sourceCode,
+        .tokenCount = tokenBuffer->size,
+        .tokens = tokenBuffer,
+        .position = 1,
+        .skipMethodBodies = context->options.lazyMethodCompilation,
+    };
+
+    return parser_parseWorkspaceScript(&state);
+}
+
+beacon_ParseTreeNode_t *beacon_parseMethodBlockTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokenBuffer)
+{
+    beacon_parserState_t state = {
+        .context = context,
+        .sourceCode = sourceCode,
+        .tokenCount = tokenBuffer->size,
+        .tokens = tokenBuffer,
+        .position = 1,
+    };
+
+    if(parserState_peekKind(&state, 0) != BeaconTokenBangLeftBracket)
+        return parserState_advanceWithExpectedError(&state, "Expected a method block.");
+    return parser_parseMethodBlock(&state);
+}
+
+beacon_ParseTreeNode_t *beacon_parseWorkspaceTokenList(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_ArrayList_t *tokenList)
+{
+    beacon_TokenBuffer_t tokenBuffer;
+    beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+    beacon_TokenBuffer_addTokenList(context, &tokenBuffer, tokenList);
+    beacon_ParseTreeNode_t *parseTree = beacon_parseWorkspaceTokenBuffer(context, sourceCode, &tokenBuffer);
+    beacon_TokenBuffer_destroy(&tokenBuffer);
+    return parseTree;
+}
+
+beacon_ParseTreeNode_t *beacon_parseMethodTokenList(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_ArrayList_t *tokenList)
+{
+    beacon_TokenBuffer_t tokenBuffer;
+    beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+    beacon_TokenBuffer_addTokenList(context, &tokenBuffer, tokenList);
+    beacon_ParseTreeNode_t *parseTree = beacon_parseMethodTokenBuffer(context, sourceCode, &tokenBuffer);
+    beacon_TokenBuffer_destroy(&tokenBuffer);
+    return parseTree;
+}
@@ -0,0 +1,916 @@
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600 // For the ucontext functions
+#define _DARWIN_C_SOURCE
+#endif
+
+#include "beacon-lang/Process.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/Exceptions.h"
+#include "beacon-lang/TimerWheel.h"
+#include "beacon-lang/ThreadPool.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <time.h>
+#include <threads.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define BEACON_PROCESS_ANNOTATE_STACK_SWITCHES 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define BEACON_PROCESS_ANNOTATE_STACK_SWITCHES 1
+#endif
+#endif
+
+#ifdef BEACON_PROCESS_ANNOTATE_STACK_SWITCHES
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+typedef enum beacon_ProcessState_e
+{
+    BeaconProcessStateSuspended = 0,
+    BeaconProcessStateRunnable,
+    BeaconProcessStateRunning,
+    BeaconProcessStateWaiting,
+    BeaconProcessStateDelayed,
+    BeaconProcessStateTerminated,
+} beacon_ProcessState_t;
+
+typedef struct beacon_NativeProcess_s beacon_NativeProcess_t;
+
+/**
+ * The native side of a Process. It owns the native stack, and it keeps the stack state of the process while it is not running.
+ */
+struct beacon_NativeProcess_s
+{
+    beacon_context_t *context;
+    beacon_Process_t *process;
+    beacon_ProcessState_t state;
+    size_t priorityIndex;
+
+    // The processes that are alive, which are the roots of the garbage collector.
+    beacon_NativeProcess_t *previousInRegistry;
+    beacon_NativeProcess_t *nextInRegistry;
+
+    // The link in a runnable queue.
+    beacon_NativeProcess_t *nextInQueue;
+
+    // Wakes up the process when it is delayed.
+    beacon_TimerWheelEntry_t delayTimer;
+
+    bool terminationRequested;
+    bool isTerminating;
+    beacon_StackState_t stackState;
+    beacon_BytecodeCacheWriter_t *bytecodeCacheWriter;
+
+    jmp_buf terminationJumpBuffer;
+#ifdef BEACON_PROCESS_ANNOTATE_STACK_SWITCHES
+    // The address sanitizer needs the bounds of the stack that is switched to. The ones of the main process are only known after it has switched away.
+    const void *sanitizerStackBottom;
+    size_t sanitizerStackSize;
+#endif
+#ifdef _WIN32
+    void *fiber;
+#else
+    void *nativeStack;
+    size_t nativeStackSize;
+    ucontext_t machineContext;
+#endif
+};
+
+typedef struct beacon_ProcessQueue_s
+{
+    beacon_NativeProcess_t *first;
+    beacon_NativeProcess_t *last;
+} beacon_ProcessQueue_t;
+
+struct beacon_ProcessScheduler_s
+{
+    beacon_NativeProcess_t mainProcess;
+    beacon_NativeProcess_t *activeProcess;
+
+    beacon_NativeProcess_t *firstInRegistry;
+    size_t processCount;
+
+    beacon_ProcessQueue_t runnableQueues[BEACON_PROCESS_PRIORITY_COUNT];
+
+    beacon_NativeProcess_t *switchingFromProcess;
+
+    // The process that has just finished. Its native stack is freed by the next process, once it is no longer in use.
+    beacon_NativeProcess_t *terminatedProcess;
+
+    int64_t timeSliceEndTime;
+};
+
+static int64_t beacon_ProcessScheduler_now(void)
+{
+    return (int64_t)beacon_getMonotonicClockMicroseconds();
+}
+
+static void beacon_ProcessScheduler_addToRegistry(beacon_ProcessScheduler_t *scheduler, beacon_NativeProcess_t *nativeProcess)
+{
+    nativeProcess->previousInRegistry = NULL;
+    nativeProcess->nextInRegistry = scheduler->firstInRegistry;
+    if(scheduler->firstInRegistry)
+        scheduler->firstInRegistry->previousInRegistry = nativeProcess;
+    scheduler->firstInRegistry = nativeProcess;
+    ++scheduler->processCount;
+}
+
+static void beacon_ProcessScheduler_removeFromRegistry(beacon_ProcessScheduler_t *scheduler, beacon_NativeProcess_t *nativeProcess)
+{
+    if(nativeProcess->previousInRegistry)
+        nativeProcess->previousInRegistry->nextInRegistry = nativeProcess->nextInRegistry;
+    else
+        scheduler->firstInRegistry = nativeProcess->nextInRegistry;
+    if(nativeProcess->nextInRegistry)
+        nativeProcess->nextInRegistry->previousInRegistry = nativeProcess->previousInRegistry;
+    nativeProcess->previousInRegistry = nativeProcess->nextInRegistry = NULL;
+    --scheduler->processCount;
+}
+
+static void beacon_ProcessScheduler_updatePreemptionCheckCountdown(beacon_context_t *context, beacon_ProcessScheduler_t *scheduler)
+{
+    bool hasTimers = context->timerWheel && context->timerWheel->timerCount > 0;
+    context->preemptionCheckCountdown = scheduler->processCount > 1 || hasTimers ? BEACON_PROCESS_PREEMPTION_CHECK_INTERVAL : 0;
+}
+
+static beacon_ProcessScheduler_t *beacon_ProcessScheduler_get(beacon_context_t *context)
+{
+    if(context->processScheduler)
+        return context->processScheduler;
+
+    // The thread that creates the scheduler becomes the main process.
+    beacon_ProcessScheduler_t *scheduler = calloc(1, sizeof(beacon_ProcessScheduler_t));
+    context->processScheduler = scheduler;
+
+    beacon_NativeProcess_t *mainProcess = &scheduler->mainProcess;
+    mainProcess->context = context;
+    mainProcess->state = BeaconProcessStateRunning;
+    mainProcess->priorityIndex = BEACON_PROCESS_DEFAULT_PRIORITY - 1;
+#ifdef _WIN32
+    mainProcess->fiber = ConvertThreadToFiber(NULL);
+#endif
+    scheduler->activeProcess = mainProcess;
+    scheduler->timeSliceEndTime = beacon_ProcessScheduler_now() + BEACON_PROCESS_TIME_SLICE_MICROSECONDS;
+
+    beacon_Process_t *process = beacon_allocateObjectWithBehavior(context->heap, context->classes.processClass, sizeof(beacon_Process_t), BeaconObjectKindPointers);
+    process->priority = beacon_encodeSmallInteger(BEACON_PROCESS_DEFAULT_PRIORITY);
+    process->name = (beacon_oop_t)beacon_importCString(context, "Main");
+    process->isTerminated = context->roots.falseValue;
+    mainProcess->process = process;
+    beacon_ProcessScheduler_addToRegistry(scheduler, mainProcess);
+    process->handle = beacon_boxExternalAddress(context, mainProcess);
+    return scheduler;
+}
+
+static void beacon_ProcessQueue_addLast(beacon_ProcessQueue_t *queue, beacon_NativeProcess_t *nativeProcess)
+{
+    nativeProcess->nextInQueue = NULL;
+    if(queue->last)
+        queue->last->nextInQueue = nativeProcess;
+    else
+        queue->first = nativeProcess;
+    queue->last = nativeProcess;
+}
+
+static void beacon_ProcessQueue_addFirst(beacon_ProcessQueue_t *queue, beacon_NativeProcess_t *nativeProcess)
+{
+    nativeProcess->nextInQueue = queue->first;
+    queue->first = nativeProcess;
+    if(!queue->last)
+        queue->last = nativeProcess;
+}
+
+static beacon_NativeProcess_t *beacon_ProcessQueue_removeFirst(beacon_ProcessQueue_t *queue)
+{
+    beacon_NativeProcess_t *first = queue->first;
+    if(!first)
+        return NULL;
+
+    queue->first = first->nextInQueue;
+    if(!queue->first)
+        queue->last = NULL;
+    first->nextInQueue = NULL;
+    return first;
+}
+
+static void beacon_ProcessQueue_remove(beacon_ProcessQueue_t *queue, beacon_NativeProcess_t *nativeProcess)
+{
+    beacon_NativeProcess_t *previous = NULL;
+    for(beacon_NativeProcess_t *position = queue->first; position; position = position->nextInQueue)
+    {
+        if(position != nativeProcess)
+        {
+            previous = position;
+            continue;
+        }
+
+        if(previous)
+            previous->nextInQueue = nativeProcess->nextInQueue;
+        else
+            queue->first = nativeProcess->nextInQueue;
+        if(queue->last == nativeProcess)
+            queue->last = previous;
+        nativeProcess->nextInQueue = NULL;
+        return;
+    }
+}
+
+static void beacon_ProcessScheduler_makeRunnable(beacon_ProcessScheduler_t *scheduler, beacon_NativeProcess_t *nativeProcess)
+{
+    nativeProcess->state = BeaconProcessStateRunnable;
+    beacon_ProcessQueue_addLast(&scheduler->runnableQueues[nativeProcess->priorityIndex], nativeProcess);
+}
+
+static intptr_t beacon_ProcessScheduler_highestRunnablePriorityIndex(beacon_ProcessScheduler_t *scheduler)
+{
+    for(intptr_t i = BEACON_PROCESS_PRIORITY_COUNT - 1; i >= 0; --i)
+    {
+        if(scheduler->runnableQueues[i].first)
+            return i;
+    }
+
+    return -1;
+}
+
+static void beacon_ProcessScheduler_delayExpired(beacon_context_t *context, beacon_TimerWheelEntry_t *entry)
+{
+    beacon_NativeProcess_t *nativeProcess = (beacon_NativeProcess_t*)((char*)entry - offsetof(beacon_NativeProcess_t, delayTimer));
+    beacon_ProcessScheduler_makeRunnable(context->processScheduler, nativeProcess);
+}
+
+/**
+ * Puts the active process to sleep until its delay timer expires. The caller has to schedule the next process.
+ */
+static void beacon_ProcessScheduler_delayActiveProcess(beacon_context_t *context, beacon_ProcessScheduler_t *scheduler, int64_t microseconds)
+{
+    beacon_NativeProcess_t *activeProcess = scheduler->activeProcess;
+    activeProcess->state = BeaconProcessStateDelayed;
+    activeProcess->delayTimer.callback = beacon_ProcessScheduler_delayExpired;
+    beacon_TimerWheel_schedule(beacon_TimerWheel_get(context), &activeProcess->delayTimer, beacon_ProcessScheduler_now() + microseconds);
+}
+
+static void beacon_ProcessScheduler_freeNativeProcess(beacon_NativeProcess_t *nativeProcess)
+{
+#ifdef _WIN32
+    if(nativeProcess->fiber)
+        DeleteFiber(nativeProcess->fiber);
+#else
+    if(nativeProcess->nativeStack)
+        munmap(nativeProcess->nativeStack, nativeProcess->nativeStackSize);
+#endif
+    free(nativeProcess);
+}
+
+static void beacon_ProcessScheduler_terminateActiveProcess(beacon_context_t *context);
+
+static void beacon_ProcessScheduler_switchedIn(beacon_context_t *context, void *sanitizerFakeStack)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    beacon_NativeProcess_t *activeProcess = scheduler->activeProcess;
+#ifdef BEACON_PROCESS_ANNOTATE_STACK_SWITCHES
+    const void *previousStackBottom = NULL;
+    size_t previousStackSize = 0;
+    __sanitizer_finish_switch_fiber(sanitizerFakeStack, &previousStackBottom, &previousStackSize);
+    if(!scheduler->switchingFromProcess->sanitizerStackBottom)
+    {
+        scheduler->switchingFromProcess->sanitizerStackBottom = previousStackBottom;
+        scheduler->switchingFromProcess->sanitizerStackSize = previousStackSize;
+    }
+#else
+    (void)sanitizerFakeStack;
+#endif
+    beacon_restoreStackState(&activeProcess->stackState);
+    context->bytecodeCacheWriter = activeProcess->bytecodeCacheWriter;
+    scheduler->timeSliceEndTime = beacon_ProcessScheduler_now() + BEACON_PROCESS_TIME_SLICE_MICROSECONDS;
+
+    if(scheduler->terminatedProcess && scheduler->terminatedProcess != activeProcess)
+    {
+        beacon_ProcessScheduler_freeNativeProcess(scheduler->terminatedProcess);
+        scheduler->terminatedProcess = NULL;
+    }
+
+    beacon_ProcessScheduler_updatePreemptionCheckCountdown(context, scheduler);
+}
+
+static void beacon_ProcessScheduler_switchTo(beacon_context_t *context, beacon_NativeProcess_t *nextProcess)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    beacon_NativeProcess_t *currentProcess = scheduler->activeProcess;
+    nextProcess->state = BeaconProcessStateRunning;
+    if(nextProcess == currentProcess)
+    {
+        scheduler->timeSliceEndTime = beacon_ProcessScheduler_now() + BEACON_PROCESS_TIME_SLICE_MICROSECONDS;
+        return;
+    }
+
+    beacon_saveStackState(&currentProcess->stackState);
+    currentProcess->bytecodeCacheWriter = context->bytecodeCacheWriter;
+    scheduler->activeProcess = nextProcess;
+    scheduler->switchingFromProcess = currentProcess;
+
+    void *sanitizerFakeStack = NULL;
+#ifdef BEACON_PROCESS_ANNOTATE_STACK_SWITCHES
+    __sanitizer_start_switch_fiber(currentProcess->state == BeaconProcessStateTerminated ? NULL : &sanitizerFakeStack,
+        nextProcess->sanitizerStackBottom, nextProcess->sanitizerStackSize);
+#endif
+#ifdef _WIN32
+    SwitchToFiber(nextProcess->fiber);
+#else
+    swapcontext(&currentProcess->machineContext, &nextProcess->machineContext);
+#endif
+
+    // Another process has switched back into this one.
+    beacon_ProcessScheduler_switchedIn(context, sanitizerFakeStack);
+    if(scheduler->activeProcess->terminationRequested)
+        beacon_ProcessScheduler_terminateActiveProcess(context);
+}
+
+static void beacon_ProcessScheduler_detachNativeProcess(beacon_context_t *context, beacon_NativeProcess_t *nativeProcess);
+
+static void beacon_ProcessScheduler_scheduleNext(beacon_context_t *context)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    for(;;)
+    {
+        beacon_TimerWheel_advance(context);
+        beacon_AsyncTasks_completeFinished(context);
+        intptr_t priorityIndex = beacon_ProcessScheduler_highestRunnablePriorityIndex(scheduler);
+        if(priorityIndex >= 0)
+        {
+            beacon_ProcessScheduler_switchTo(context, beacon_ProcessQueue_removeFirst(&scheduler->runnableQueues[priorityIndex]));
+            return;
+        }
+
+        // Sleep until the next timer expires, or until a task of the thread pool finishes.
+        uint64_t wakeUpTime;
+        bool hasWakeUpTime = context->timerWheel && beacon_TimerWheel_nextWakeUpTime(context->timerWheel, &wakeUpTime);
+        int64_t sleepTime = hasWakeUpTime ? (int64_t)wakeUpTime - beacon_ProcessScheduler_now() : -1;
+        if(hasWakeUpTime && sleepTime < 0)
+            sleepTime = 0;
+        if(beacon_AsyncTasks_waitForFinished(context, sleepTime))
+            continue;
+
+        if(!hasWakeUpTime)
+            break;
+        if(sleepTime > 0)
+            thrd_sleep(&(struct timespec){.tv_sec = sleepTime / 1000000, .tv_nsec = (sleepTime % 1000000) * 1000}, NULL);
+    }
+
+    // Nothing can wake up the active process anymore, so it gets the error.
+    beacon_NativeProcess_t *activeProcess = scheduler->activeProcess;
+    if(activeProcess->state != BeaconProcessStateTerminated)
+    {
+        beacon_ProcessScheduler_detachNativeProcess(context, activeProcess);
+        activeProcess->state = BeaconProcessStateRunning;
+        beacon_exception_error(context, "All of the processes are waiting.");
+    }
+
+    fprintf(stderr, "All of the processes are waiting. Aborting.\n");
+    abort();
+}
+
+/**
+ * Moves the active process into its runnable queue, and switches to the process that should run instead of it.
+ */
+static void beacon_ProcessScheduler_preemptActiveProcess(beacon_context_t *context, bool atFrontOfItsQueue)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    beacon_NativeProcess_t *activeProcess = scheduler->activeProcess;
+    activeProcess->state = BeaconProcessStateRunnable;
+    if(atFrontOfItsQueue)
+        beacon_ProcessQueue_addFirst(&scheduler->runnableQueues[activeProcess->priorityIndex], activeProcess);
+    else
+        beacon_ProcessQueue_addLast(&scheduler->runnableQueues[activeProcess->priorityIndex], activeProcess);
+    beacon_ProcessScheduler_scheduleNext(context);
+}
+
+/**
+ * Makes a process runnable. It runs immediately when its priority is higher than the priority of the active process.
+ */
+static void beacon_ProcessScheduler_resumeNativeProcess(beacon_context_t *context, beacon_NativeProcess_t *nativeProcess)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    beacon_ProcessScheduler_makeRunnable(scheduler, nativeProcess);
+    beacon_ProcessScheduler_updatePreemptionCheckCountdown(context, scheduler);
+    if(nativeProcess->priorityIndex > scheduler->activeProcess->priorityIndex)
+        beacon_ProcessScheduler_preemptActiveProcess(context, true);
+}
+
+void beacon_ProcessScheduler_preemptionCheck(beacon_context_t *context)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    beacon_ProcessScheduler_updatePreemptionCheckCountdown(context, scheduler);
+
+    // The native code that disables the garbage collector expects its objects to stay where they are.
+    if(context->heap->gcDisableCount > 0 || scheduler->activeProcess->isTerminating)
+        return;
+
+    beacon_TimerWheel_advance(context);
+    beacon_AsyncTasks_completeFinished(context);
+    int64_t now = beacon_ProcessScheduler_now();
+
+    size_t activePriorityIndex = scheduler->activeProcess->priorityIndex;
+    intptr_t highestPriorityIndex = beacon_ProcessScheduler_highestRunnablePriorityIndex(scheduler);
+    if(highestPriorityIndex > (intptr_t)activePriorityIndex)
+        beacon_ProcessScheduler_preemptActiveProcess(context, true);
+    else if(now >= scheduler->timeSliceEndTime)
+    {
+        if(highestPriorityIndex == (intptr_t)activePriorityIndex)
+            beacon_ProcessScheduler_preemptActiveProcess(context, false);
+        else
+            scheduler->timeSliceEndTime = now + BEACON_PROCESS_TIME_SLICE_MICROSECONDS;
+    }
+}
+
+void beacon_ProcessScheduler_yield(beacon_context_t *context)
+{
+    beacon_AsyncTasks_completeFinished(context);
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    if(!scheduler)
+        return;
+
+    beacon_TimerWheel_advance(context);
+    if(beacon_ProcessScheduler_highestRunnablePriorityIndex(scheduler) >= (intptr_t)scheduler->activeProcess->priorityIndex)
+        beacon_ProcessScheduler_preemptActiveProcess(context, false);
+}
+
+int64_t beacon_ProcessScheduler_idleTimeout(beacon_context_t *context)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    if(scheduler && beacon_ProcessScheduler_highestRunnablePriorityIndex(scheduler) >= (intptr_t)scheduler->activeProcess->priorityIndex)
+        return 0;
+
+    uint64_t wakeUpTime;
+    if(!context->timerWheel || !beacon_TimerWheel_nextWakeUpTime(context->timerWheel, &wakeUpTime))
+        return -1;
+
+    int64_t timeout = (int64_t)wakeUpTime - beacon_ProcessScheduler_now();
+    return timeout > 0 ? timeout : 0;
+}
+
+bool beacon_ProcessScheduler_runLowerPriorityProcesses(beacon_context_t *context, int64_t idleTimeout)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    if(!scheduler || beacon_ProcessScheduler_highestRunnablePriorityIndex(scheduler) < 0)
+        return false;
+
+    // The main loop sleeps like a delay, so it goes back to its events after one time slice at most.
+    int64_t sleepTime = BEACON_PROCESS_TIME_SLICE_MICROSECONDS;
+    if(idleTimeout >= 0 && idleTimeout < sleepTime)
+        sleepTime = idleTimeout;
+
+    beacon_ProcessScheduler_delayActiveProcess(context, scheduler, sleepTime);
+    beacon_ProcessScheduler_scheduleNext(context);
+    return true;
+}
+
+void beacon_ProcessScheduler_markRoots(beacon_context_t *context)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    if(!scheduler)
+        return;
+
+    for(beacon_NativeProcess_t *nativeProcess = scheduler->firstInRegistry; nativeProcess; nativeProcess = nativeProcess->nextInRegistry)
+    {
+        beacon_heap_pushReachableObject(context->heap, (beacon_oop_t)nativeProcess->process);
+        if(nativeProcess != scheduler->activeProcess)
+            beacon_garbageCollect_markStackFrameRecords(context, nativeProcess->stackState.topStackFrameRecord);
+    }
+}
+
+void beacon_ProcessScheduler_destroy(beacon_context_t *context)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    if(!scheduler)
+        return;
+
+    beacon_NativeProcess_t *nativeProcess = scheduler->firstInRegistry;
+    while(nativeProcess)
+    {
+        beacon_NativeProcess_t *nextProcess = nativeProcess->nextInRegistry;
+        if(nativeProcess != &scheduler->mainProcess && nativeProcess != scheduler->activeProcess)
+            beacon_ProcessScheduler_freeNativeProcess(nativeProcess);
+        nativeProcess = nextProcess;
+    }
+
+    if(scheduler->terminatedProcess && scheduler->terminatedProcess != scheduler->activeProcess)
+        beacon_ProcessScheduler_freeNativeProcess(scheduler->terminatedProcess);
+
+#ifdef _WIN32
+    ConvertFiberToThread();
+#endif
+    free(scheduler);
+    context->processScheduler = NULL;
+    context->preemptionCheckCountdown = 0;
+}
+
+static void beacon_ProcessScheduler_finishActiveProcess(beacon_context_t *context)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    beacon_NativeProcess_t *activeProcess = scheduler->activeProcess;
+    beacon_Process_t *process = activeProcess->process;
+    ((beacon_ExternalAddress_t*)process->handle)->address = NULL;
+    process->handle = 0;
+    process->myList = 0;
+    process->isTerminated = context->roots.trueValue;
+
+    activeProcess->state = BeaconProcessStateTerminated;
+    beacon_ProcessScheduler_removeFromRegistry(scheduler, activeProcess);
+    scheduler->terminatedProcess = activeProcess;
+    beacon_ProcessScheduler_scheduleNext(context);
+    abort();
+}
+
+static void beacon_ProcessScheduler_terminateActiveProcess(beacon_context_t *context)
+{
+    beacon_NativeProcess_t *activeProcess = context->processScheduler->activeProcess;
+    if(activeProcess == &context->processScheduler->mainProcess)
+        beacon_exception_error(context, "The main process cannot be terminated.");
+
+    // Run the pending ensure blocks, and leave the block of the process.
+    activeProcess->terminationRequested = false;
+    activeProcess->isTerminating = true;
+    beacon_unwindStackFrameRecordsUntil(NULL);
+    _longjmp(activeProcess->terminationJumpBuffer, 1);
+}
+
+static void beacon_ProcessScheduler_entryPoint(unsigned int contextLow, unsigned int contextHigh)
+{
+    beacon_context_t *context = (beacon_context_t*)(((uintptr_t)contextHigh << 16 << 16) | (uintptr_t)contextLow);
+    beacon_ProcessScheduler_switchedIn(context, NULL);
+
+    beacon_NativeProcess_t *activeProcess = context->processScheduler->activeProcess;
+    if(!_setjmp(activeProcess->terminationJumpBuffer) && !activeProcess->terminationRequested)
+    {
+        beacon_BlockClosure_t *block = (beacon_BlockClosure_t*)activeProcess->process->block;
+        beacon_runBlockClosureWithArguments(context, &block->code->super, block->receiver, block->captures, 0, NULL);
+    }
+
+    beacon_ProcessScheduler_finishActiveProcess(context);
+}
+
+#ifdef _WIN32
+static void WINAPI beacon_ProcessScheduler_fiberEntryPoint(void *context)
+{
+    beacon_ProcessScheduler_entryPoint((unsigned int)(uintptr_t)context, (unsigned int)((uintptr_t)context >> 16 >> 16));
+}
+#endif
+
+static beacon_NativeProcess_t *beacon_ProcessScheduler_createNativeProcess(beacon_context_t *context, beacon_Process_t *process)
+{
+    beacon_ProcessScheduler_t *scheduler = beacon_ProcessScheduler_get(context);
+    beacon_NativeProcess_t *nativeProcess = calloc(1, sizeof(beacon_NativeProcess_t));
+    nativeProcess->context = context;
+    nativeProcess->process = process;
+    nativeProcess->state = BeaconProcessStateSuspended;
+    nativeProcess->priorityIndex = beacon_decodeSmallInteger(process->priority) - 1;
+
+#ifdef _WIN32
+    nativeProcess->fiber = CreateFiber(BEACON_PROCESS_NATIVE_STACK_SIZE, beacon_ProcessScheduler_fiberEntryPoint, context);
+    if(!nativeProcess->fiber)
+    {
+        free(nativeProcess);
+        beacon_exception_error(context, "Failed to allocate the native stack of a process.");
+        return NULL;
+    }
+
+    // The stack guard of the activations is left to the depth limit.
+    nativeProcess->stackState.nativeStackLimitIsComputed = true;
+#else
+    // The pages of the stack are committed on their first use. The lowest ones are a guard against the native stack overflows that are missed by the activations.
+    nativeProcess->nativeStackSize = BEACON_PROCESS_NATIVE_STACK_SIZE;
+    nativeProcess->nativeStack = mmap(NULL, nativeProcess->nativeStackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if(nativeProcess->nativeStack == MAP_FAILED)
+    {
+        free(nativeProcess);
+        beacon_exception_error(context, "Failed to allocate the native stack of a process.");
+        return NULL;
+    }
+    mprotect(nativeProcess->nativeStack, BEACON_NATIVE_STACK_GUARD_SIZE, PROT_NONE);
+
+    nativeProcess->stackState.nativeStackLimit = (uintptr_t)nativeProcess->nativeStack + BEACON_NATIVE_STACK_GUARD_SIZE + BEACON_NATIVE_STACK_OVERFLOW_RESERVED_SIZE;
+    nativeProcess->stackState.nativeStackLimitIsComputed = true;
+#ifdef BEACON_PROCESS_ANNOTATE_STACK_SWITCHES
+    nativeProcess->sanitizerStackBottom = nativeProcess->nativeStack;
+    nativeProcess->sanitizerStackSize = nativeProcess->nativeStackSize;
+#endif
+
+    getcontext(&nativeProcess->machineContext);
+    nativeProcess->machineContext.uc_stack.ss_sp = nativeProcess->nativeStack;
+    nativeProcess->machineContext.uc_stack.ss_size = nativeProcess->nativeStackSize;
+    nativeProcess->machineContext.uc_link = NULL;
+    makecontext(&nativeProcess->machineContext, (void (*)(void))beacon_ProcessScheduler_entryPoint, 2,
+        (unsigned int)(uintptr_t)context, (unsigned int)((uintptr_t)context >> 16 >> 16));
+#endif
+
+    beacon_ProcessScheduler_addToRegistry(scheduler, nativeProcess);
+    process->handle = beacon_boxExternalAddress(context, nativeProcess);
+    return nativeProcess;
+}
+
+static beacon_NativeProcess_t *beacon_ProcessScheduler_getNativeProcess(beacon_context_t *context, beacon_oop_t processOop)
+{
+    BeaconAssert(context, beacon_getClass(context, processOop) == context->classes.processClass);
+    beacon_ProcessScheduler_get(context);
+    beacon_Process_t *process = (beacon_Process_t*)processOop;
+    if(process->isTerminated == context->roots.trueValue)
+        beacon_exception_error(context, "The process is terminated.");
+
+    if(process->handle)
+        return beacon_unboxExternalAddress(context, process->handle);
+    return beacon_ProcessScheduler_createNativeProcess(context, process);
+}
+
+static void beacon_Semaphore_addLastProcess(beacon_Semaphore_t *semaphore, beacon_Process_t *process)
+{
+    process->nextLink = 0;
+    if(semaphore->lastLink)
+        ((beacon_Process_t*)semaphore->lastLink)->nextLink = (beacon_oop_t)process;
+    else
+        semaphore->firstLink = (beacon_oop_t)process;
+    semaphore->lastLink = (beacon_oop_t)process;
+    process->myList = (beacon_oop_t)semaphore;
+}
+
+static beacon_Process_t *beacon_Semaphore_removeFirstProcess(beacon_Semaphore_t *semaphore)
+{
+    beacon_Process_t *first = (beacon_Process_t*)semaphore->firstLink;
+    if(!first)
+        return NULL;
+
+    semaphore->firstLink = first->nextLink;
+    if(!semaphore->firstLink)
+        semaphore->lastLink = 0;
+    first->nextLink = 0;
+    first->myList = 0;
+    return first;
+}
+
+static void beacon_Semaphore_removeProcess(beacon_Semaphore_t *semaphore, beacon_Process_t *process)
+{
+    beacon_Process_t *previous = NULL;
+    for(beacon_Process_t *position = (beacon_Process_t*)semaphore->firstLink; position; position = (beacon_Process_t*)position->nextLink)
+    {
+        if(position != process)
+        {
+            previous = position;
+            continue;
+        }
+
+        if(previous)
+            previous->nextLink = process->nextLink;
+        else
+            semaphore->firstLink = process->nextLink;
+        if(semaphore->lastLink == (beacon_oop_t)process)
+            semaphore->lastLink = (beacon_oop_t)previous;
+        break;
+    }
+
+    process->nextLink = 0;
+    process->myList = 0;
+}
+
+/**
+ * Takes a process out of the list that it is in, and leaves it suspended.
+ */
+static void beacon_ProcessScheduler_detachNativeProcess(beacon_context_t *context, beacon_NativeProcess_t *nativeProcess)
+{
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    switch(nativeProcess->state)
+    {
+    case BeaconProcessStateRunnable:
+        beacon_ProcessQueue_remove(&scheduler->runnableQueues[nativeProcess->priorityIndex], nativeProcess);
+        break;
+    case BeaconProcessStateWaiting:
+        beacon_Semaphore_removeProcess((beacon_Semaphore_t*)nativeProcess->process->myList, nativeProcess->process);
+        break;
+    case BeaconProcessStateDelayed:
+        beacon_TimerWheel_cancel(context->timerWheel, &nativeProcess->delayTimer);
+        break;
+    default:
+        break;
+    }
+
+    nativeProcess->state = BeaconProcessStateSuspended;
+}
+
+static beacon_oop_t beacon_BlockClosure_newProcess(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_BlockClosure_t *block = (beacon_BlockClosure_t*)receiver;
+    BeaconAssert(context, beacon_decodeSmallInteger(block->code->super.argumentCount) == 0);
+
+    intptr_t priority = context->processScheduler ? (intptr_t)context->processScheduler->activeProcess->priorityIndex + 1 : BEACON_PROCESS_DEFAULT_PRIORITY;
+    beacon_Process_t *process = beacon_allocateObjectWithBehavior(context->heap, context->classes.processClass, sizeof(beacon_Process_t), BeaconObjectKindPointers);
+    process->block = receiver;
+    process->priority = beacon_encodeSmallInteger(priority);
+    process->isTerminated = context->roots.falseValue;
+    return (beacon_oop_t)process;
+}
+
+static beacon_oop_t beacon_Process_resume(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_NativeProcess_t *nativeProcess = beacon_ProcessScheduler_getNativeProcess(context, receiver);
+    if(nativeProcess->state == BeaconProcessStateSuspended)
+        beacon_ProcessScheduler_resumeNativeProcess(context, nativeProcess);
+    return receiver;
+}
+
+static beacon_oop_t beacon_Process_suspend(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_NativeProcess_t *nativeProcess = beacon_ProcessScheduler_getNativeProcess(context, receiver);
+    if(nativeProcess->state == BeaconProcessStateRunning)
+    {
+        nativeProcess->state = BeaconProcessStateSuspended;
+        beacon_ProcessScheduler_scheduleNext(context);
+    }
+    else
+    {
+        beacon_ProcessScheduler_detachNativeProcess(context, nativeProcess);
+    }
+
+    return receiver;
+}
+
+static beacon_oop_t beacon_Process_terminate(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_Process_t *process = (beacon_Process_t*)receiver;
+    if(process->isTerminated == context->roots.trueValue)
+        return receiver;
+
+    // A process that has never been resumed has nothing to unwind.
+    if(!process->handle)
+    {
+        process->isTerminated = context->roots.trueValue;
+        return receiver;
+    }
+
+    beacon_NativeProcess_t *nativeProcess = beacon_ProcessScheduler_getNativeProcess(context, receiver);
+    if(nativeProcess->state == BeaconProcessStateRunning)
+        beacon_ProcessScheduler_terminateActiveProcess(context);
+
+    if(nativeProcess == &context->processScheduler->mainProcess)
+        beacon_exception_error(context, "The main process cannot be terminated.");
+    if(nativeProcess->isTerminating)
+        return receiver;
+
+    // The process runs its own ensure blocks, before the active process continues.
+    beacon_ProcessScheduler_detachNativeProcess(context, nativeProcess);
+    nativeProcess->terminationRequested = true;
+    nativeProcess->state = BeaconProcessStateRunnable;
+    beacon_ProcessQueue_addFirst(&context->processScheduler->runnableQueues[context->processScheduler->activeProcess->priorityIndex], context->processScheduler->activeProcess);
+    context->processScheduler->activeProcess->state = BeaconProcessStateRunnable;
+    beacon_ProcessScheduler_switchTo(context, nativeProcess);
+    return receiver;
+}
+
+static beacon_oop_t beacon_Process_primitivePriority(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    BeaconAssert(context, beacon_isSmallInteger(arguments[0]));
+    intptr_t priority = beacon_decodeSmallInteger(arguments[0]);
+    if(priority < 1 || priority > BEACON_PROCESS_PRIORITY_COUNT)
+        beacon_exception_error(context, "The process priority is out of range.");
+
+    beacon_Process_t *process = (beacon_Process_t*)receiver;
+    process->priority = arguments[0];
+    if(!process->handle)
+        return receiver;
+
+    beacon_NativeProcess_t *nativeProcess = beacon_ProcessScheduler_getNativeProcess(context, receiver);
+    beacon_ProcessScheduler_t *scheduler = context->processScheduler;
+    if(nativeProcess->state == BeaconProcessStateRunnable)
+    {
+        beacon_ProcessQueue_remove(&scheduler->runnableQueues[nativeProcess->priorityIndex], nativeProcess);
+        nativeProcess->priorityIndex = priority - 1;
+        beacon_ProcessScheduler_resumeNativeProcess(context, nativeProcess);
+    }
+    else
+    {
+        nativeProcess->priorityIndex = priority - 1;
+        if(nativeProcess->state == BeaconProcessStateRunning && beacon_ProcessScheduler_highestRunnablePriorityIndex(scheduler) > (intptr_t)nativeProcess->priorityIndex)
+            beacon_ProcessScheduler_preemptActiveProcess(context, true);
+    }
+
+    return receiver;
+}
+
+static beacon_oop_t beacon_Semaphore_wait(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_Semaphore_t *semaphore = (beacon_Semaphore_t*)receiver;
+    intptr_t excessSignals = semaphore->excessSignals ? beacon_decodeSmallInteger(semaphore->excessSignals) : 0;
+    if(excessSignals > 0)
+    {
+        semaphore->excessSignals = beacon_encodeSmallInteger(excessSignals - 1);
+        return receiver;
+    }
+
+    beacon_ProcessScheduler_t *scheduler = beacon_ProcessScheduler_get(context);
+    beacon_NativeProcess_t *activeProcess = scheduler->activeProcess;
+    beacon_Semaphore_addLastProcess(semaphore, activeProcess->process);
+    activeProcess->state = BeaconProcessStateWaiting;
+    beacon_ProcessScheduler_scheduleNext(context);
+    return receiver;
+}
+
+/**
+ * Takes the first waiting process out of a semaphore, or counts the signal as an excess one when there is none.
+ */
+static beacon_NativeProcess_t *beacon_Semaphore_takeProcessToWake(beacon_context_t *context, beacon_Semaphore_t *semaphore)
+{
+    beacon_Process_t *waitingProcess = beacon_Semaphore_removeFirstProcess(semaphore);
+    if(!waitingProcess)
+    {
+        intptr_t excessSignals = semaphore->excessSignals ? beacon_decodeSmallInteger(semaphore->excessSignals) : 0;
+        semaphore->excessSignals = beacon_encodeSmallInteger(excessSignals + 1);
+        return NULL;
+    }
+
+    return beacon_unboxExternalAddress(context, waitingProcess->handle);
+}
+
+void beacon_Semaphore_signalWithoutPreemption(beacon_context_t *context, beacon_oop_t semaphore)
+{
+    BeaconAssert(context, beacon_getClass(context, semaphore) == context->classes.semaphoreClass);
+    beacon_NativeProcess_t *nativeProcess = beacon_Semaphore_takeProcessToWake(context, (beacon_Semaphore_t*)semaphore);
+    if(!nativeProcess)
+        return;
+
+    beacon_ProcessScheduler_makeRunnable(context->processScheduler, nativeProcess);
+    beacon_ProcessScheduler_updatePreemptionCheckCountdown(context, context->processScheduler);
+}
+
+static beacon_oop_t beacon_Semaphore_signal(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_NativeProcess_t *nativeProcess = beacon_Semaphore_takeProcessToWake(context, (beacon_Semaphore_t*)receiver);
+    if(nativeProcess)
+        beacon_ProcessScheduler_resumeNativeProcess(context, nativeProcess);
+    return receiver;
+}
+
+static beacon_oop_t beacon_ProcessorClass_activeProcess(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    return (beacon_oop_t)beacon_ProcessScheduler_get(context)->activeProcess->process;
+}
+
+static beacon_oop_t beacon_ProcessorClass_yield(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_ProcessScheduler_yield(context);
+    return receiver;
+}
+
+static beacon_oop_t beacon_ProcessorClass_waitMicroseconds(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    BeaconAssert(context, beacon_isSmallInteger(arguments[0]));
+    beacon_ProcessScheduler_t *scheduler = beacon_ProcessScheduler_get(context);
+    beacon_ProcessScheduler_delayActiveProcess(context, scheduler, beacon_decodeSmallInteger(arguments[0]));
+    beacon_ProcessScheduler_scheduleNext(context);
+    return receiver;
+}
+
+void beacon_context_registerProcessPrimitives(beacon_context_t *context)
+{
+    beacon_addPrimitiveToClass(context, context->classes.blockClosureClass, "newProcess", 0, beacon_BlockClosure_newProcess);
+
+    beacon_addPrimitiveToClass(context, context->classes.processClass, "resume", 0, beacon_Process_resume);
+    beacon_addPrimitiveToClass(context, context->classes.processClass, "suspend", 0, beacon_Process_suspend);
+    beacon_addPrimitiveToClass(context, context->classes.processClass, "terminate", 0, beacon_Process_terminate);
+    beacon_addPrimitiveToClass(context, context->classes.processClass, "priority:", 1, beacon_Process_primitivePriority);
+
+    beacon_addPrimitiveToClass(context, context->classes.semaphoreClass, "wait", 0, beacon_Semaphore_wait);
+    beacon_addPrimitiveToClass(context, context->classes.semaphoreClass, "signal", 0, beacon_Semaphore_signal);
+
+    beacon_Behavior_t *processorClass = beacon_getClass(context, (beacon_oop_t)context->classes.processorClass);
+    beacon_addPrimitiveToClass(context, processorClass, "activeProcess", 0, beacon_ProcessorClass_activeProcess);
+    beacon_addPrimitiveToClass(context, processorClass, "yield", 0, beacon_ProcessorClass_yield);
+    beacon_addPrimitiveToClass(context, processorClass, "waitMicroseconds:", 1, beacon_ProcessorClass_waitMicroseconds);
+}
@@ -0,0 +1,484 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // For SIGEV_THREAD_ID
+#endif
+
+#include "beacon-lang/Profiler.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/SourceCode.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BEACON_PROFILER_HAS_SAMPLING 1
+#include <signal.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#define BEACON_PROFILER_HAS_THREAD_TIMER 1
+#include <sys/syscall.h>
+#include <time.h>
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+// The names are written into fixed size buffers, because the samples are taken from a signal handler.
+typedef struct beacon_ProfilerWriter_s
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+    bool overflowed;
+} beacon_ProfilerWriter_t;
+
+static void beacon_ProfilerWriter_appendBytes(beacon_ProfilerWriter_t *writer, const void *data, size_t size)
+{
+    if(writer->size + size > writer->capacity)
+    {
+        writer->overflowed = true;
+        return;
+    }
+
+    memcpy(writer->data + writer->size, data, size);
+    writer->size += size;
+}
+
+static void beacon_ProfilerWriter_appendCString(beacon_ProfilerWriter_t *writer, const char *string)
+{
+    beacon_ProfilerWriter_appendBytes(writer, string, strlen(string));
+}
+
+static void beacon_ProfilerWriter_appendString(beacon_ProfilerWriter_t *writer, beacon_String_t *string)
+{
+    if(!string)
+    {
+        beacon_ProfilerWriter_appendCString(writer, "?");
+        return;
+    }
+
+    // Some strings that are imported from C keep their null terminator.
+    size_t stringSize = string->super.super.super.super.super.header.slotCount;
+    const uint8_t *terminator = memchr(string->data, 0, stringSize);
+    if(terminator)
+        stringSize = terminator - string->data;
+    beacon_ProfilerWriter_appendBytes(writer, string->data, stringSize);
+}
+
+static void beacon_ProfilerWriter_appendSymbol(beacon_ProfilerWriter_t *writer, beacon_Symbol_t *symbol)
+{
+    if(!symbol)
+    {
+        beacon_ProfilerWriter_appendCString(writer, "?");
+        return;
+    }
+
+    beacon_ProfilerWriter_appendBytes(writer, symbol->data, symbol->super.super.super.super.super.header.slotCount);
+}
+
+static void beacon_ProfilerWriter_appendUnsigned(beacon_ProfilerWriter_t *writer, size_t value)
+{
+    char digits[24];
+    size_t digitCount = 0;
+    do
+    {
+        digits[sizeof(digits) - 1 - digitCount++] = (char)('0' + value % 10);
+        value /= 10;
+    } while(value != 0);
+
+    beacon_ProfilerWriter_appendBytes(writer, digits + sizeof(digits) - digitCount, digitCount);
+}
+
+static void beacon_ProfilerWriter_appendBehaviorName(beacon_context_t *context, beacon_ProfilerWriter_t *writer, beacon_Behavior_t *behavior)
+{
+    if(beacon_getClass(context, (beacon_oop_t)behavior) == context->classes.metaclassClass)
+    {
+        beacon_Class_t *thisClass = ((beacon_Metaclass_t*)behavior)->thisClass;
+        beacon_ProfilerWriter_appendSymbol(writer, thisClass ? thisClass->name : NULL);
+        beacon_ProfilerWriter_appendCString(writer, " class");
+        return;
+    }
+
+    beacon_ProfilerWriter_appendSymbol(writer, ((beacon_Class_t*)behavior)->name);
+}
+
+// Only uses the lines that were already computed, because the line table of a source cannot be allocated from the signal handler.
+static void beacon_ProfilerWriter_appendSourceLocation(beacon_ProfilerWriter_t *writer, beacon_SourcePosition_t *sourcePosition)
+{
+    if(!sourcePosition || !sourcePosition->sourceCode)
+    {
+        beacon_ProfilerWriter_appendCString(writer, "?");
+        return;
+    }
+
+    beacon_SourceCode_t *sourceCode = sourcePosition->sourceCode;
+    beacon_ProfilerWriter_appendString(writer, sourceCode->name);
+
+    size_t startIndex = beacon_decodeSmallInteger(sourcePosition->startIndex);
+    if(sourcePosition->startLine)
+    {
+        beacon_ProfilerWriter_appendCString(writer, ":");
+        beacon_ProfilerWriter_appendUnsigned(writer, beacon_decodeSmallInteger(sourcePosition->startLine));
+    }
+    else if(sourceCode->lineStartIndices)
+    {
+        beacon_UInt32Array_t *lineStartIndices = sourceCode->lineStartIndices;
+        size_t lower = 0;
+        size_t upper = lineStartIndices->super.super.super.super.super.header.slotCount / sizeof(uint32_t);
+        while(upper - lower > 1)
+        {
+            size_t middle = lower + (upper - lower) / 2;
+            if(lineStartIndices->elements[middle] <= startIndex)
+                lower = middle;
+            else
+                upper = middle;
+        }
+
+        beacon_ProfilerWriter_appendCString(writer, ":");
+        beacon_ProfilerWriter_appendUnsigned(writer, lower + 1);
+    }
+    else
+    {
+        beacon_ProfilerWriter_appendCString(writer, "@");
+        beacon_ProfilerWriter_appendUnsigned(writer, startIndex);
+    }
+}
+
+// Methods are named by the class of their receiver when it is known, and blocks and doits by their source location.
+static void beacon_ProfilerWriter_appendCodeName(beacon_context_t *context, beacon_ProfilerWriter_t *writer, beacon_CompiledCode_t *code, beacon_Behavior_t *receiverClass)
+{
+    if(beacon_getClass(context, (beacon_oop_t)code) == context->classes.compiledMethodClass && ((beacon_CompiledMethod_t*)code)->name)
+    {
+        if(receiverClass)
+        {
+            beacon_ProfilerWriter_appendBehaviorName(context, writer, receiverClass);
+            beacon_ProfilerWriter_appendCString(writer, ">>");
+        }
+        beacon_ProfilerWriter_appendSymbol(writer, ((beacon_CompiledMethod_t*)code)->name);
+        return;
+    }
+
+    bool isBlock = beacon_getClass(context, (beacon_oop_t)code) == context->classes.compiledBlockClass;
+    beacon_ProfilerWriter_appendCString(writer, isBlock ? "[] in " : "doIt in ");
+    beacon_ProfilerWriter_appendSourceLocation(writer, code->sourcePosition);
+}
+
+//==============================================================================
+// Perf map
+//==============================================================================
+
+static FILE *beaconProfilerPerfMapFile;
+
+void beacon_Profiler_recordGeneratedCode(beacon_context_t *context, beacon_CompiledCode_t *code, const void *codeStart, size_t codeSize)
+{
+#if defined(__linux__)
+    if(!beaconProfilerPerfMapFile)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "/tmp/perf-%d.map", (int)getpid());
+        beaconProfilerPerfMapFile = fopen(fileName, "a");
+        if(!beaconProfilerPerfMapFile)
+            return;
+    }
+
+    if(code->sourcePosition)
+        beacon_SourcePosition_computeLinesAndColumns(context, code->sourcePosition);
+
+    char name[512];
+    beacon_ProfilerWriter_t writer = {
+        .data = name,
+        .capacity = sizeof(name),
+    };
+    beacon_ProfilerWriter_appendCodeName(context, &writer, code, NULL);
+    if(beacon_getClass(context, (beacon_oop_t)code) == context->classes.compiledMethodClass && ((beacon_CompiledMethod_t*)code)->name)
+    {
+        beacon_ProfilerWriter_appendCString(&writer, " [");
+        beacon_ProfilerWriter_appendSourceLocation(&writer, code->sourcePosition);
+        beacon_ProfilerWriter_appendCString(&writer, "]");
+    }
+
+    // perf reads each line as: <start address> <size> <symbol name>, with the numbers in hexadecimal.
+    fprintf(beaconProfilerPerfMapFile, "%lx %zx Beacon %.*s\n", (unsigned long)(uintptr_t)codeStart, codeSize, (int)writer.size, name);
+    fflush(beaconProfilerPerfMapFile);
+#else
+    (void)context;
+    (void)code;
+    (void)codeStart;
+    (void)codeSize;
+#endif
+}
+
+void beacon_Profiler_shutdown(beacon_context_t *context)
+{
+    // The perf map is only written by the main context, and not by the workers.
+    if(beaconProfilerPerfMapFile && context->options.writePerfMap)
+    {
+        fclose(beaconProfilerPerfMapFile);
+        beaconProfilerPerfMapFile = NULL;
+    }
+}
+
+//==============================================================================
+// Stack sampling
+//==============================================================================
+
+#ifdef BEACON_PROFILER_HAS_SAMPLING
+
+// The samples are stored as null terminated folded stacks, which are only counted when the sampling is stopped.
+static beacon_context_t *beaconProfilerContext;
+static char *beaconProfilerSampleBuffer;
+static size_t beaconProfilerSampleBufferSize;
+static size_t beaconProfilerDroppedSampleCount;
+static volatile sig_atomic_t beaconProfilerSamplingActive;
+static struct sigaction beaconProfilerPreviousAction;
+
+// The sample buffer is only written by the sampled thread. Linux sends the signal only to it, and the other platforms drop the signals that reach the worker, pool and parsing threads.
+static _Thread_local bool beaconProfilerIsSampledThread;
+#ifdef BEACON_PROFILER_HAS_THREAD_TIMER
+static timer_t beaconProfilerTimer;
+#endif
+
+static void beacon_Profiler_takeSample(int signalNumber)
+{
+    (void)signalNumber;
+    if(!beaconProfilerSamplingActive || !beaconProfilerIsSampledThread)
+        return;
+
+    beacon_context_t *context = beaconProfilerContext;
+    beacon_StackFrameRecord_t *frames[BEACON_PROFILER_MAX_SAMPLED_FRAMES];
+    size_t frameCount = 0;
+    for(beacon_StackFrameRecord_t *record = beacon_getTopStackFrameRecord(); record && frameCount < BEACON_PROFILER_MAX_SAMPLED_FRAMES; record = record->previousRecord)
+    {
+        if(record->kind == StackFrameBytecodeMethodRecord && record->context == context)
+            frames[frameCount++] = record;
+    }
+
+    beacon_ProfilerWriter_t writer = {
+        .data = beaconProfilerSampleBuffer + beaconProfilerSampleBufferSize,
+        .capacity = BEACON_PROFILER_SAMPLE_BUFFER_SIZE - beaconProfilerSampleBufferSize,
+    };
+
+    // The folded stacks start from the outermost frame.
+    beacon_ProfilerWriter_appendCString(&writer, "beacon-vm");
+    for(size_t i = frameCount; i > 0; --i)
+    {
+        beacon_StackFrameRecord_t *record = frames[i - 1];
+        beacon_CompiledCode_t *code = record->bytecodeMethodStackRecord.code;
+        beacon_ProfilerWriter_appendCString(&writer, ";");
+        beacon_ProfilerWriter_appendCodeName(context, &writer, code, beacon_getClass(context, record->bytecodeMethodStackRecord.receiver));
+    }
+    beacon_ProfilerWriter_appendBytes(&writer, "", 1);
+
+    if(writer.overflowed)
+        ++beaconProfilerDroppedSampleCount;
+    else
+        beaconProfilerSampleBufferSize += writer.size;
+}
+
+bool beacon_Profiler_startSampling(beacon_context_t *context, size_t intervalMicroseconds)
+{
+    if(beaconProfilerSampleBuffer)
+        return false;
+
+    beaconProfilerContext = context;
+    beaconProfilerSampleBuffer = malloc(BEACON_PROFILER_SAMPLE_BUFFER_SIZE);
+    beaconProfilerSampleBufferSize = 0;
+    beaconProfilerDroppedSampleCount = 0;
+    if(!beaconProfilerSampleBuffer)
+        return false;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = beacon_Profiler_takeSample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &beaconProfilerPreviousAction);
+    beaconProfilerIsSampledThread = true;
+    beaconProfilerSamplingActive = 1;
+
+    if(intervalMicroseconds == 0)
+        intervalMicroseconds = BEACON_PROFILER_DEFAULT_SAMPLING_INTERVAL_MICROSECONDS;
+
+#ifdef BEACON_PROFILER_HAS_THREAD_TIMER
+    // The timer counts the CPU time of the calling thread, and signals only that thread.
+    struct sigevent timerEvent;
+    memset(&timerEvent, 0, sizeof(timerEvent));
+    timerEvent.sigev_notify = SIGEV_THREAD_ID;
+    timerEvent.sigev_signo = SIGPROF;
+    timerEvent.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+
+    struct itimerspec timer;
+    timer.it_interval.tv_sec = (time_t)(intervalMicroseconds / 1000000);
+    timer.it_interval.tv_nsec = (long)(intervalMicroseconds % 1000000) * 1000;
+    timer.it_value = timer.it_interval;
+    if(timer_create(CLOCK_THREAD_CPUTIME_ID, &timerEvent, &beaconProfilerTimer) || timer_settime(beaconProfilerTimer, 0, &timer, NULL))
+    {
+        beaconProfilerSamplingActive = 0;
+        sigaction(SIGPROF, &beaconProfilerPreviousAction, NULL);
+        free(beaconProfilerSampleBuffer);
+        beaconProfilerSampleBuffer = NULL;
+        return false;
+    }
+#else
+    struct itimerval timer;
+    timer.it_interval.tv_sec = (time_t)(intervalMicroseconds / 1000000);
+    timer.it_interval.tv_usec = (suseconds_t)(intervalMicroseconds % 1000000);
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+#endif
+    return true;
+}
+
+static int beacon_Profiler_compareSamples(const void *first, const void *second)
+{
+    return strcmp(*(const char * const*)first, *(const char * const*)second);
+}
+
+void beacon_Profiler_stopSamplingAndWriteFoldedStacks(beacon_context_t *context, FILE *output)
+{
+    (void)context;
+    if(!beaconProfilerSampleBuffer)
+        return;
+
+#ifdef BEACON_PROFILER_HAS_THREAD_TIMER
+    timer_delete(beaconProfilerTimer);
+#else
+    struct itimerval disabledTimer;
+    memset(&disabledTimer, 0, sizeof(disabledTimer));
+    setitimer(ITIMER_PROF, &disabledTimer, NULL);
+#endif
+    beaconProfilerSamplingActive = 0;
+    beaconProfilerIsSampledThread = false;
+    sigaction(SIGPROF, &beaconProfilerPreviousAction, NULL);
+
+    // Sort the samples for counting the identical stacks.
+    size_t sampleCount = 0;
+    for(size_t i = 0; i < beaconProfilerSampleBufferSize; ++i)
+        sampleCount += beaconProfilerSampleBuffer[i] == 0;
+
+    const char **samples = calloc(sampleCount, sizeof(const char *));
+    size_t sampleIndex = 0;
+    for(size_t i = 0; i < beaconProfilerSampleBufferSize; i += strlen(beaconProfilerSampleBuffer + i) + 1)
+        samples[sampleIndex++] = beaconProfilerSampleBuffer + i;
+    qsort(samples, sampleCount, sizeof(const char *), beacon_Profiler_compareSamples);
+
+    for(size_t i = 0; i < sampleCount; )
+    {
+        size_t runEnd = i + 1;
+        while(runEnd < sampleCount && !strcmp(samples[i], samples[runEnd]))
+            ++runEnd;
+
+        fprintf(output, "%s %zu\n", samples[i], runEnd - i);
+        i = runEnd;
+    }
+
+    if(beaconProfilerDroppedSampleCount > 0)
+        fprintf(stderr, "The profiler dropped %zu samples, because its sample buffer is full.\n", beaconProfilerDroppedSampleCount);
+
+    free(samples);
+    free(beaconProfilerSampleBuffer);
+    beaconProfilerSampleBuffer = NULL;
+    beaconProfilerSampleBufferSize = 0;
+    beaconProfilerContext = NULL;
+}
+
+#else
+
+bool beacon_Profiler_startSampling(beacon_context_t *context, size_t intervalMicroseconds)
+{
+    (void)context;
+    (void)intervalMicroseconds;
+    return false;
+}
+
+void beacon_Profiler_stopSamplingAndWriteFoldedStacks(beacon_context_t *context, FILE *output)
+{
+    (void)context;
+    (void)output;
+}
+
+#endif
+
+//==============================================================================
+// Crash diagnostics
+//==============================================================================
+
+#ifdef BEACON_PROFILER_HAS_SAMPLING
+
+static beacon_context_t *beaconProfilerCrashContext;
+static char beaconProfilerAlternateSignalStack[BEACON_PROFILER_ALTERNATE_SIGNAL_STACK_SIZE];
+
+static void beacon_Profiler_writeToStandardError(beacon_ProfilerWriter_t *writer)
+{
+    size_t writtenSize = 0;
+    while(writtenSize < writer->size)
+    {
+        ssize_t result = write(STDERR_FILENO, writer->data + writtenSize, writer->size - writtenSize);
+        if(result <= 0)
+            return;
+        writtenSize += (size_t)result;
+    }
+}
+
+static void beacon_Profiler_handleFatalSignal(int signalNumber)
+{
+    // This runs on the alternate signal stack, because the native stack may be exhausted.
+    beacon_context_t *context = beaconProfilerCrashContext;
+    char buffer[512];
+    beacon_ProfilerWriter_t writer = {
+        .data = buffer,
+        .capacity = sizeof(buffer),
+    };
+    beacon_ProfilerWriter_appendCString(&writer, signalNumber == SIGSEGV ? "Segmentation fault" : "Bus error");
+    beacon_ProfilerWriter_appendCString(&writer, ", which may be a native stack overflow that was missed by the stack guard. Innermost frames:\n");
+    beacon_Profiler_writeToStandardError(&writer);
+
+    size_t frameCount = 0;
+    for(beacon_StackFrameRecord_t *record = beacon_getTopStackFrameRecord(); record && frameCount < BEACON_PROFILER_MAX_CRASH_REPORT_FRAMES; record = record->previousRecord)
+    {
+        if(record->kind != StackFrameBytecodeMethodRecord || record->context != context)
+            continue;
+
+        writer.size = 0;
+        writer.overflowed = false;
+        beacon_ProfilerWriter_appendCString(&writer, "    ");
+        beacon_ProfilerWriter_appendCodeName(context, &writer, record->bytecodeMethodStackRecord.code, beacon_getClass(context, record->bytecodeMethodStackRecord.receiver));
+        beacon_ProfilerWriter_appendCString(&writer, "\n");
+        beacon_Profiler_writeToStandardError(&writer);
+        ++frameCount;
+    }
+
+    // The handler was reset to the default action, which crashes with a core dump.
+    raise(signalNumber);
+}
+
+bool beacon_Profiler_installCrashHandler(beacon_context_t *context)
+{
+    stack_t alternateStack;
+    memset(&alternateStack, 0, sizeof(alternateStack));
+    alternateStack.ss_sp = beaconProfilerAlternateSignalStack;
+    alternateStack.ss_size = sizeof(beaconProfilerAlternateSignalStack);
+    if(sigaltstack(&alternateStack, NULL))
+        return false;
+
+    beaconProfilerCrashContext = context;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = beacon_Profiler_handleFatalSignal;
+    action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    return !sigaction(SIGSEGV, &action, NULL) && !sigaction(SIGBUS, &action, NULL);
+}
+
+#else
+
+bool beacon_Profiler_installCrashHandler(beacon_context_t *context)
+{
+    (void)context;
+    return false;
+}
+
+#endif
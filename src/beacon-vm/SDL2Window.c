@@ -4,13 +4,18 @@
 #include "SDL_syswm.h"
 #include "Context.h"
 #include "Exceptions.h"
+#include "Process.h"
+#include "TimerWheel.h"
+#include "ThreadPool.h"
 #include "Window.h"
 #include "Dictionary.h"
 #include "AgpuRendering.h"
 #include <stdlib.h>
+#include <limits.h>
 
 static bool hasInitializedSDL2;
 static bool isQuitting;
+static uint32_t wakeUpEventType;
 static void ensureSDL2Initialization(void)
 {
     if(hasInitializedSDL2)
@@ -18,6 +23,8 @@ static void ensureSDL2Initialization(void)
 
     SDL_SetHint(SDL_HINT_NO_SIGNAL_HANDLERS, "1");    
     SDL_Init(SDL_INIT_VIDEO);
+    wakeUpEventType = SDL_RegisterEvents(1);
+    hasInitializedSDL2 = true;
 }
 
 static void beacon_sdl2_updateDisplayTextureExtent(beacon_context_t *context, beacon_Window_t *beaconWindow)
@@ -136,7 +143,7 @@ static beacon_oop_t beacon_Window_open(beacon_context_t *context, beacon_oop_t r
 
     uint32_t sdlWindowID = SDL_GetWindowID(sdlWindow);
     beaconWindow->handle = beacon_encodeSmallInteger(sdlWindowID);
-    beacon_MethodDictionary_atPut(context, context->roots.windowHandleMap, (beacon_Symbol_t*)beaconWindow->handle, (beacon_oop_t)beaconWindow);
+    beacon_Window_registerHandle(context, beaconWindow, sdlWindowID);
 
     if(beaconWindow->useAcceleratedRendering != context->roots.trueValue)
     {
@@ -162,11 +169,9 @@ static beacon_oop_t beacon_Window_close(beacon_context_t *context, beacon_oop_t
 
     beacon_Window_t *beaconWindow = (beacon_Window_t *)receiver;
 
-    SDL_Window *sdlWindow = SDL_GetWindowFromID(beacon_decodeCharacter(beaconWindow->handle));
-
-    uint32_t sdlWindowID = SDL_GetWindowID(sdlWindow);
-    beaconWindow->handle = beacon_encodeSmallInteger(sdlWindowID);
-    beacon_MethodDictionary_atPut(context, context->roots.windowHandleMap, (beacon_Symbol_t*)beaconWindow->handle, (beacon_oop_t)beaconWindow);
+    uint32_t sdlWindowID = beacon_decodeSmallInteger(beaconWindow->handle);
+    SDL_Window *sdlWindow = SDL_GetWindowFromID(sdlWindowID);
+    beacon_Window_unregisterHandle(context, sdlWindowID);
 
     if(beaconWindow->useAcceleratedRendering == context->roots.trueValue)
     {
@@ -243,178 +248,196 @@ static beacon_oop_t beacon_Window_displayForm(beacon_context_t *context, beacon_
     return receiver;
 }
 
-static void beacon_sdl2_fetchAndDispatchEvents(beacon_context_t *context)
+static void beacon_sdl2_dispatchEvent(beacon_context_t *context, const SDL_Event *sdlEvent)
 {
-    SDL_Event sdlEvent;
-    while(SDL_PollEvent(&sdlEvent))
+    switch(sdlEvent->type)
+    {
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
     {
-        switch(sdlEvent.type)
+        beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->button.windowID);
+        if(beaconWindow)
         {
-        case SDL_MOUSEBUTTONDOWN:
+            beacon_WindowMouseButtonEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableMouseButtonEvent, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t));
+            event->button = beacon_encodeSmallInteger(sdlEvent->button.button);
+            event->x = beacon_encodeSmallInteger(sdlEvent->button.x);
+            event->y = beacon_encodeSmallInteger(sdlEvent->button.y);
+            beacon_performWith(context, (beacon_oop_t)beaconWindow, sdlEvent->type == SDL_MOUSEBUTTONDOWN ? context->roots.onMouseButtonDownSelector : context->roots.onMouseButtonUpSelector, (beacon_oop_t)event);
+        }
+    }
+        break;
+    case SDL_MOUSEMOTION:
+    {
+        beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->motion.windowID);
+        if(beaconWindow)
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.button.windowID));
-            if(beaconWindow)
-            {
-                beacon_WindowMouseButtonEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t), BeaconObjectKindPointers);
-                event->button = beacon_encodeSmallInteger(sdlEvent.button.button);
-                event->x = beacon_encodeSmallInteger(sdlEvent.button.x);
-                event->y = beacon_encodeSmallInteger(sdlEvent.button.y);
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onMouseButtonDown:"), (beacon_oop_t)event);
-            }
+            beacon_WindowMouseMotionEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableMouseMotionEvent, context->classes.windowMouseMotionEventClass, sizeof(beacon_WindowMouseMotionEvent_t));
+            event->buttons = beacon_encodeSmallInteger(sdlEvent->motion.state);
+            event->x = beacon_encodeSmallInteger(sdlEvent->motion.x);
+            event->y = beacon_encodeSmallInteger(sdlEvent->motion.y);
+            event->xrel = beacon_encodeSmallInteger(sdlEvent->motion.xrel);
+            event->yrel = beacon_encodeSmallInteger(sdlEvent->motion.yrel);
+            beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onMouseMotionSelector, (beacon_oop_t)event);
         }
-            break;
-        case SDL_MOUSEBUTTONUP:
+    }
+        break;
+    case SDL_MOUSEWHEEL:
+    {
+        beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->wheel.windowID);
+        if(beaconWindow)
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.button.windowID));
-            if(beaconWindow)
-            {
-                beacon_WindowMouseButtonEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t), BeaconObjectKindPointers);
-                event->button = beacon_encodeSmallInteger(sdlEvent.button.button);
-                event->x = beacon_encodeSmallInteger(sdlEvent.button.x);
-                event->y = beacon_encodeSmallInteger(sdlEvent.button.y);
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onMouseButtonUp:"), (beacon_oop_t)event);
-            }
+            beacon_WindowMouseWheelEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableMouseWheelEvent, context->classes.windowMouseWheelEventClass, sizeof(beacon_WindowMouseWheelEvent_t));
+            int x = 0;
+            int y = 0;
+            SDL_GetMouseState(&x, &y);
+
+            event->x = beacon_encodeSmallInteger(x);
+            event->y = beacon_encodeSmallInteger(y);
+            event->scrollX = beacon_encodeSmallInteger(sdlEvent->wheel.x);
+            event->scrollY = beacon_encodeSmallInteger(sdlEvent->wheel.y);
+            beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onMouseWheelSelector, (beacon_oop_t)event);
         }
-            break;
-        case SDL_MOUSEMOTION:
+    }
+        break;     
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    {
+        beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->key.windowID);
+        if(beaconWindow)
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.motion.windowID));
-            if(beaconWindow)
-            {
-                beacon_WindowMouseMotionEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseMotionEventClass, sizeof(beacon_WindowMouseMotionEvent_t), BeaconObjectKindPointers);
-                event->buttons = beacon_encodeSmallInteger(sdlEvent.motion.state);
-                event->x = beacon_encodeSmallInteger(sdlEvent.motion.x);
-                event->y = beacon_encodeSmallInteger(sdlEvent.motion.y);
-                event->xrel = beacon_encodeSmallInteger(sdlEvent.motion.xrel);
-                event->yrel = beacon_encodeSmallInteger(sdlEvent.motion.yrel);
-
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onMouseMotion:"), (beacon_oop_t)event);
-            }
+            beacon_WindowKeyboardEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableKeyboardEvent, context->classes.windowKeyboardEventClass, sizeof(beacon_WindowKeyboardEvent_t));
+            event->scancode = beacon_encodeSmallInteger(sdlEvent->key.keysym.scancode);
+            event->symbol = beacon_encodeSmallInteger(sdlEvent->key.keysym.sym);
+            event->modstate = beacon_encodeSmallInteger(sdlEvent->key.keysym.mod);
+            beacon_performWith(context, (beacon_oop_t)beaconWindow, sdlEvent->type == SDL_KEYDOWN ? context->roots.onKeyPressedSelector : context->roots.onKeyReleasedSelector, (beacon_oop_t)event);
         }
-            break;
-        case SDL_MOUSEWHEEL:
+    }
+        break;
+    case SDL_TEXTINPUT:
+    {
+        beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->text.windowID);
+        if(beaconWindow)
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.motion.windowID));
-            if(beaconWindow)
-            {
-                beacon_WindowMouseWheelEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseWheelEventClass, sizeof(beacon_WindowMouseWheelEvent_t), BeaconObjectKindPointers);
-                int x = 0;
-                int y = 0;
-                SDL_GetMouseState(&x, &y);
-
-                event->x = beacon_encodeSmallInteger(x);
-                event->y = beacon_encodeSmallInteger(y);
-                event->scrollX = beacon_encodeSmallInteger(sdlEvent.wheel.x);
-                event->scrollY = beacon_encodeSmallInteger(sdlEvent.wheel.y);
-
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onMouseWheel:"), (beacon_oop_t)event);
-            }
+            beacon_WindowTextInputEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableTextInputEvent, context->classes.windowTextInputEventClass, sizeof(beacon_WindowTextInputEvent_t));
+            event->text = (beacon_oop_t)beacon_importCString(context, sdlEvent->text.text);
+            beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onTextInputSelector, (beacon_oop_t)event);
         }
-            break;     
-        case SDL_KEYDOWN:
+
+    }
+        break;
+    case SDL_WINDOWEVENT:
+        switch(sdlEvent->window.event)
+        {
+        case SDL_WINDOWEVENT_EXPOSED:
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.key.windowID));
+            beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->window.windowID);
             if(beaconWindow)
             {
-                beacon_WindowKeyboardEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowKeyboardEventClass, sizeof(beacon_WindowKeyboardEvent_t), BeaconObjectKindPointers);
-                event->scancode = beacon_encodeSmallInteger(sdlEvent.key.keysym.scancode);
-                event->symbol = beacon_encodeSmallInteger(sdlEvent.key.keysym.sym);
-                event->modstate = beacon_encodeSmallInteger(sdlEvent.key.keysym.mod);
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onKeyPressed:"), (beacon_oop_t)event);
+                if (beaconWindow->useAcceleratedRendering != context->roots.trueValue)
+                    beacon_sdl2_updateDisplayTextureExtent(context, beaconWindow);
+                beacon_WindowExposeEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableExposeEvent, context->classes.windowExposeEventClass, sizeof(beacon_WindowExposeEvent_t));
+                beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onExposeSelector, (beacon_oop_t)event);
             }
         }
             break;
-        case SDL_KEYUP:
+        case SDL_WINDOWEVENT_SIZE_CHANGED:
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.key.windowID));
+            beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->window.windowID);
             if(beaconWindow)
             {
-                beacon_WindowKeyboardEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowKeyboardEventClass, sizeof(beacon_WindowKeyboardEvent_t), BeaconObjectKindPointers);
-                event->scancode = beacon_encodeSmallInteger(sdlEvent.key.keysym.scancode);
-                event->symbol = beacon_encodeSmallInteger(sdlEvent.key.keysym.sym);
-                event->modstate = beacon_encodeSmallInteger(sdlEvent.key.keysym.mod);
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onKeyReleased:"), (beacon_oop_t)event);
+                SDL_Window *sdlWindow = SDL_GetWindowFromID(sdlEvent->window.windowID);
+                int newWidth = 0;
+                int newHeight = 0;
+
+                SDL_GetWindowSize(sdlWindow, &newWidth, &newHeight);
+
+                beaconWindow->width = beacon_encodeSmallInteger(newWidth);
+                beaconWindow->height = beacon_encodeSmallInteger(newHeight);
+
+                if (beaconWindow->useAcceleratedRendering == context->roots.trueValue)
+                    beacon_sdl2_createOrUpdateSwapChain(context, beaconWindow, sdlWindow);
+                else
+                    beacon_sdl2_updateDisplayTextureExtent(context, beaconWindow);
+                
+                beacon_perform(context, (beacon_oop_t)beaconWindow, context->roots.onSizeChangedSelector);
             }
         }
-            break;
-        case SDL_TEXTINPUT:
+        break;
+        case SDL_WINDOWEVENT_CLOSE:
         {
-            beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.key.windowID));
+            beacon_Window_t *beaconWindow = beacon_Window_fromHandle(context, sdlEvent->window.windowID);
             if(beaconWindow)
-            {
-                beacon_WindowTextInputEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowTextInputEventClass, sizeof(beacon_WindowTextInputEvent_t), BeaconObjectKindPointers);
-                event->text = (beacon_oop_t)beacon_importCString(context, sdlEvent.text.text);
-                beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onTextInput:"), (beacon_oop_t)event);
-            }
-
+                beacon_perform(context, (beacon_oop_t)beaconWindow, context->roots.onCloseRequestSelector);
         }
-            break;
-        case SDL_WINDOWEVENT:
-            switch(sdlEvent.window.event)
-            {
-            case SDL_WINDOWEVENT_EXPOSED:
-            {
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.window.windowID));
-                if(beaconWindow)
-                {
-                    SDL_Window *sdlWindow = SDL_GetWindowFromID(sdlEvent.window.windowID);
-                    if (beaconWindow->useAcceleratedRendering != context->roots.trueValue)
-                        beacon_sdl2_updateDisplayTextureExtent(context, beaconWindow);
-                    beacon_WindowExposeEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowExposeEventClass, sizeof(beacon_WindowExposeEvent_t), BeaconObjectKindPointers);
-                    beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onExpose:"), (beacon_oop_t)event);
-                }
-            }
-                break;
-            case SDL_WINDOWEVENT_SIZE_CHANGED:
-            {
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.window.windowID));
-                if(beaconWindow)
-                {
-                    SDL_Window *sdlWindow = SDL_GetWindowFromID(sdlEvent.window.windowID);
-                    int newWidth = 0;
-                    int newHeight = 0;
-
-                    SDL_GetWindowSize(sdlWindow, &newWidth, &newHeight);
-
-                    beaconWindow->width = beacon_encodeSmallInteger(newWidth);
-                    beaconWindow->height = beacon_encodeSmallInteger(newHeight);
-
-                    if (beaconWindow->useAcceleratedRendering == context->roots.trueValue)
-                        beacon_sdl2_createOrUpdateSwapChain(context, beaconWindow, sdlWindow);
-                    else
-                        beacon_sdl2_updateDisplayTextureExtent(context, beaconWindow);
-                    
-                    beacon_perform(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onSizeChanged"));
-                }
-            }
-            break;
-            case SDL_WINDOWEVENT_CLOSE:
-            {
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(sdlEvent.window.windowID));
-                if(beaconWindow)
-                {
-                    SDL_Window *sdlWindow = SDL_GetWindowFromID(sdlEvent.window.windowID);
-                    beacon_perform(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onCloseRequest"));
-                }
-            }
-            break;
-            }
-            break;
-        case SDL_QUIT:
-            isQuitting = true;
-            break;
+        break;
         }
+        break;
+    case SDL_QUIT:
+        isQuitting = true;
+        break;
+    }
+}
+
+/**
+ * Merges an event into the previous one when both are mouse motions with the same buttons, or size changes, of the same window.
+ */
+static bool beacon_sdl2_coalesceEvent(SDL_Event *previousEvent, const SDL_Event *sdlEvent)
+{
+    if(previousEvent->type != sdlEvent->type)
+        return false;
+
+    if(sdlEvent->type == SDL_MOUSEMOTION)
+    {
+        if(previousEvent->motion.windowID != sdlEvent->motion.windowID || previousEvent->motion.state != sdlEvent->motion.state)
+            return false;
+
+        previousEvent->motion.x = sdlEvent->motion.x;
+        previousEvent->motion.y = sdlEvent->motion.y;
+        previousEvent->motion.xrel += sdlEvent->motion.xrel;
+        previousEvent->motion.yrel += sdlEvent->motion.yrel;
+        return true;
+    }
+
+    // The size of the window is queried when the size change is dispatched, so the last one is as good as all of them.
+    return sdlEvent->type == SDL_WINDOWEVENT &&
+        previousEvent->window.event == SDL_WINDOWEVENT_SIZE_CHANGED && sdlEvent->window.event == SDL_WINDOWEVENT_SIZE_CHANGED &&
+        previousEvent->window.windowID == sdlEvent->window.windowID;
+}
+
+/**
+ * Dispatches the queued events, after the one that woke up the main loop, if any. A flood of mouse motions costs a single dispatch per frame.
+ */
+static void beacon_sdl2_fetchAndDispatchEvents(beacon_context_t *context, const SDL_Event *firstEvent)
+{
+    SDL_Event pendingEvent;
+    bool hasPendingEvent = false;
+    if(firstEvent)
+    {
+        pendingEvent = *firstEvent;
+        hasPendingEvent = true;
+    }
+
+    SDL_Event sdlEvent;
+    while(SDL_PollEvent(&sdlEvent))
+    {
+        if(hasPendingEvent && beacon_sdl2_coalesceEvent(&pendingEvent, &sdlEvent))
+            continue;
+
+        if(hasPendingEvent)
+            beacon_sdl2_dispatchEvent(context, &pendingEvent);
+        pendingEvent = sdlEvent;
+        hasPendingEvent = true;
     }
+
+    if(hasPendingEvent)
+        beacon_sdl2_dispatchEvent(context, &pendingEvent);
+}
+
+static void beacon_sdl2_wakeUpMainLoop(beacon_context_t *context)
+{
+    (void)context;
+    SDL_Event wakeUpEvent = {.type = wakeUpEventType};
+    SDL_PushEvent(&wakeUpEvent);
 }
 
 static beacon_oop_t beacon_WindowClass_enterMainLoop(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -424,11 +447,46 @@ static beacon_oop_t beacon_WindowClass_enterMainLoop(beacon_context_t *context,
     (void)argumentCount;
     (void)arguments;
 
+    ensureSDL2Initialization();
+    beacon_AsyncTasks_setWakeUpFunction(context, beacon_sdl2_wakeUpMainLoop);
+    isQuitting = false;
+    SDL_Event sdlEvent;
+    bool hasWaitedEvent = false;
     while(!isQuitting)
     {
-        beacon_sdl2_fetchAndDispatchEvents(context);
+        beacon_sdl2_fetchAndDispatchEvents(context, hasWaitedEvent ? &sdlEvent : NULL);
+
+        // Run the expired timers, and let the background processes run between the events.
+        beacon_TimerWheel_runFiredTimers(context);
+        beacon_ProcessScheduler_yield(context);
+        bool hasInvalidWindows = beacon_Window_renderInvalidWindows(context);
+        if(isQuitting)
+            break;
+
+        // Sleep until an event arrives, a timer expires, or a task of the thread pool finishes.
+        int64_t timeout = hasInvalidWindows ? 0 : beacon_ProcessScheduler_idleTimeout(context);
+        if(timeout != 0 && beacon_ProcessScheduler_runLowerPriorityProcesses(context, timeout))
+        {
+            hasWaitedEvent = false;
+            continue;
+        }
+
+        if(timeout < 0)
+            hasWaitedEvent = SDL_WaitEvent(&sdlEvent) != 0;
+        else
+            hasWaitedEvent = SDL_WaitEventTimeout(&sdlEvent, (int)(timeout < INT_MAX*INT64_C(1000) ? (timeout + 999) / 1000 : INT_MAX)) != 0;
     }
 
+    beacon_AsyncTasks_setWakeUpFunction(context, NULL);
+    return receiver;
+}
+
+static beacon_oop_t beacon_WindowClass_exitMainLoop(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)context;
+    (void)argumentCount;
+    (void)arguments;
+    isQuitting = true;
     return receiver;
 }
 
@@ -438,4 +496,5 @@ void beacon_context_registerWindowSystemPrimitives(beacon_context_t *context)
     beacon_addPrimitiveToClass(context, context->classes.windowClass, "close", 0, beacon_Window_close);
     beacon_addPrimitiveToClass(context, context->classes.windowClass, "displayForm:", 1, beacon_Window_displayForm);
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.windowClass), "enterMainLoop", 0, beacon_WindowClass_enterMainLoop);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.windowClass), "exitMainLoop", 0, beacon_WindowClass_exitMainLoop);
 }
\ No newline at end of file
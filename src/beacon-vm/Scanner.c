@@ -3,8 +3,11 @@
 #include "beacon-lang/Context.h"
 #include "beacon-lang/ArrayList.h"
 #include "beacon-lang/Exceptions.h"
+#include "beacon-lang/SourceCode.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 static const char* tokenKindNames[] = {
 #define TokenKindName(name) "BeaconToken" #name,
@@ -17,6 +20,104 @@ const char *beacon_TokenKind_toString(beacon_TokenKind_t kind)
     return tokenKindNames[kind];
 }
 
+void beacon_TokenBuffer_initialize(beacon_TokenBuffer_t *buffer, beacon_SourceCode_t *sourceCode)
+{
+    memset(buffer, 0, sizeof(beacon_TokenBuffer_t));
+    buffer->sourceCode = sourceCode;
+}
+
+void beacon_TokenBuffer_destroy(beacon_TokenBuffer_t *buffer)
+{
+    free(buffer->kinds);
+    free(buffer->startIndices);
+    free(buffer->endIndices);
+    free(buffer->errors);
+    memset(buffer, 0, sizeof(beacon_TokenBuffer_t));
+}
+
+void beacon_TokenBuffer_add(beacon_TokenBuffer_t *buffer, beacon_TokenKind_t kind, size_t startIndex, size_t endIndex)
+{
+    if(buffer->size >= buffer->capacity)
+    {
+        size_t newCapacity = buffer->capacity * 2;
+        if(newCapacity < 1024)
+            newCapacity = 1024;
+
+        buffer->kinds = realloc(buffer->kinds, newCapacity * sizeof(uint8_t));
+        buffer->startIndices = realloc(buffer->startIndices, newCapacity * sizeof(uint32_t));
+        buffer->endIndices = realloc(buffer->endIndices, newCapacity * sizeof(uint32_t));
+        buffer->capacity = newCapacity;
+    }
+
+    buffer->kinds[buffer->size] = (uint8_t)kind;
+    buffer->startIndices[buffer->size] = (uint32_t)startIndex;
+    buffer->endIndices[buffer->size] = (uint32_t)endIndex;
+    ++buffer->size;
+}
+
+void beacon_TokenBuffer_addError(beacon_TokenBuffer_t *buffer, size_t startIndex, size_t endIndex, const char *message, size_t messageSize)
+{
+    if(buffer->errorCount >= buffer->errorCapacity)
+    {
+        buffer->errorCapacity = buffer->errorCapacity ? buffer->errorCapacity * 2 : 4;
+        buffer->errors = realloc(buffer->errors, buffer->errorCapacity * sizeof(beacon_TokenBufferError_t));
+    }
+
+    beacon_TokenBufferError_t *error = buffer->errors + buffer->errorCount++;
+    error->tokenIndex = buffer->size;
+    error->message = message;
+    error->messageSize = messageSize;
+    beacon_TokenBuffer_add(buffer, BeaconTokenError, startIndex, endIndex);
+}
+
+const beacon_TokenBufferError_t *beacon_TokenBuffer_getError(beacon_TokenBuffer_t *buffer, size_t tokenIndex)
+{
+    for(size_t i = 0; i < buffer->errorCount; ++i)
+    {
+        if(buffer->errors[i].tokenIndex == tokenIndex)
+            return buffer->errors + i;
+    }
+
+    return NULL;
+}
+
+beacon_ScannerToken_t *beacon_TokenBuffer_makeToken(beacon_context_t *context, beacon_TokenBuffer_t *buffer, size_t tokenIndex)
+{
+    size_t startIndex = buffer->startIndices[tokenIndex];
+    size_t endIndex = buffer->endIndices[tokenIndex];
+
+    beacon_ScannerToken_t *token = beacon_allocateObjectWithBehavior(context->heap, context->classes.scannerTokenClass, sizeof(beacon_ScannerToken_t), BeaconObjectKindPointers);
+    token->kind = beacon_encodeSmallInteger(buffer->kinds[tokenIndex]);
+    token->sourcePosition = beacon_makeSourcePosition(context, buffer->sourceCode, startIndex, endIndex);
+    token->textPosition = beacon_encodeSmallInteger(startIndex);
+    token->textSize = beacon_encodeSmallInteger(endIndex - startIndex);
+
+    const beacon_TokenBufferError_t *error = buffer->kinds[tokenIndex] == BeaconTokenError ? beacon_TokenBuffer_getError(buffer, tokenIndex) : NULL;
+    if(error)
+    {
+        token->errorMessage = beacon_allocateObjectWithBehavior(context->heap, context->classes.stringClass, sizeof(beacon_String_t) + error->messageSize, BeaconObjectKindBytes);
+        memcpy(token->errorMessage->data, error->message, error->messageSize);
+    }
+
+    return token;
+}
+
+void beacon_TokenBuffer_addTokenList(beacon_context_t *context, beacon_TokenBuffer_t *buffer, beacon_ArrayList_t *tokenList)
+{
+    intptr_t tokenCount = beacon_ArrayList_size(tokenList);
+    for(intptr_t i = 1; i <= tokenCount; ++i)
+    {
+        beacon_ScannerToken_t *token = (beacon_ScannerToken_t *)beacon_ArrayList_at(context, tokenList, i);
+        beacon_TokenKind_t kind = beacon_decodeSmallInteger(token->kind);
+        size_t startIndex = beacon_decodeSmallInteger(token->sourcePosition->startIndex);
+        size_t endIndex = beacon_decodeSmallInteger(token->sourcePosition->endIndex);
+        if(kind == BeaconTokenError)
+            beacon_TokenBuffer_addError(buffer, startIndex, endIndex, (const char *)token->errorMessage->data, token->errorMessage->super.super.super.super.super.header.slotCount);
+        else
+            beacon_TokenBuffer_add(buffer, kind, startIndex, endIndex);
+    }
+}
+
 bool scanner_isDigit(int character)
 {
     return '0' <= character && character <= '9';
@@ -52,19 +153,21 @@ typedef struct beacon_scannerState_s
 {
     beacon_context_t *context;
     beacon_SourceCode_t *sourceCode;
+    beacon_TokenBuffer_t *tokens;
+    const uint8_t *text;
     int32_t position;
-    int32_t line;
-    int32_t column;
-    bool isPreviousCR;
+    int32_t size;
 }beacon_scannerState_t;
 
-beacon_scannerState_t scannerState_newForSourceCode(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
+beacon_scannerState_t scannerState_newForSourceCode(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *tokens)
 {
     beacon_scannerState_t state = {
         .context = context,
         .sourceCode = sourceCode,
-        .position = 0, .line = 1, .column = 1,
-        .isPreviousCR = false 
+        .tokens = tokens,
+        .text = sourceCode->text->data,
+        .position = 0,
+        .size = (int32_t)beacon_decodeSmallInteger(sourceCode->textSize),
     };
 
     return state;
@@ -72,113 +175,43 @@ beacon_scannerState_t scannerState_newForSourceCode(beacon_context_t *context, b
 
 bool scannerState_atEnd(beacon_scannerState_t *state)
 {
-    return state->position >= beacon_decodeSmallInteger(state->sourceCode->textSize);
+    return state->position >= state->size;
 }
 
 int scannerState_peek(beacon_scannerState_t *state, int peekOffset)
 {
     intptr_t peekPosition = state->position + peekOffset;
-    if(peekPosition < beacon_decodeSmallInteger(state->sourceCode->textSize))
-        return state->sourceCode->text->data[peekPosition];
+    if(peekPosition < state->size)
+        return state->text[peekPosition];
     else
         return -1;
 }
 
-void scannerState_advanceSinglePosition(beacon_scannerState_t *state)
-{
-    BeaconAssert(state->context, !scannerState_atEnd(state));
-    char c = state->sourceCode->text->data[state->position];
-    ++state->position;
-    switch(c)
-    {
-    case '\r':
-        ++state->line;
-        state->column = 1;
-        state->isPreviousCR = true;
-        break;
-    case '\n':
-        if (!state->isPreviousCR)
-        {
-            ++state->line;
-            state->column = 1;
-        }
-        state->isPreviousCR = false;
-        break;
-    case '\t':
-        state->column = (state->column + 4) % 4 * 4 + 1;
-        state->isPreviousCR = false;
-        break;
-    default:
-        ++state->column;
-        state->isPreviousCR = false;
-        break;
-    }
-}
-
 void scannerState_advance(beacon_scannerState_t *state, int count)
 {
-    for(int i = 0; i < count; ++i)
-    {
-        scannerState_advanceSinglePosition(state);
-    }
+    BeaconAssert(state->context, state->position + count <= state->size);
+    state->position += count;
 }
 
-beacon_ScannerToken_t *scannerState_makeToken(beacon_scannerState_t *state, beacon_TokenKind_t kind)
+beacon_TokenKind_t scannerState_makeToken(beacon_scannerState_t *state, beacon_TokenKind_t kind)
 {
-    beacon_SourcePosition_t *sourcePosition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
-    sourcePosition->sourceCode  = state->sourceCode;
-    sourcePosition->startIndex  = beacon_encodeSmallInteger(state->position);
-    sourcePosition->startLine   = beacon_encodeSmallInteger(state->line);
-    sourcePosition->startColumn = beacon_encodeSmallInteger(state->column);
-    sourcePosition->endIndex    = beacon_encodeSmallInteger(state->position);
-    sourcePosition->endLine     = beacon_encodeSmallInteger(state->line);
-    sourcePosition->endColumn   = beacon_encodeSmallInteger(state->column);
-
-    beacon_ScannerToken_t *token = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.scannerTokenClass, sizeof(beacon_ScannerToken_t), BeaconObjectKindPointers);
-    token->kind = beacon_encodeSmallInteger(kind);
-    token->sourcePosition = sourcePosition;
-    return token;
+    beacon_TokenBuffer_add(state->tokens, kind, state->position, state->position);
+    return kind;
 }
 
-beacon_ScannerToken_t *scannerState_makeTokenStartingFrom(beacon_scannerState_t *state, beacon_TokenKind_t kind, beacon_scannerState_t *initialState)
+beacon_TokenKind_t scannerState_makeTokenStartingFrom(beacon_scannerState_t *state, beacon_TokenKind_t kind, beacon_scannerState_t *initialState)
 {
-    beacon_SourcePosition_t *sourcePosition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
-    sourcePosition->sourceCode  = state->sourceCode,
-    sourcePosition->startIndex  = beacon_encodeSmallInteger(initialState->position);
-    sourcePosition->startLine   = beacon_encodeSmallInteger(initialState->line);
-    sourcePosition->startColumn = beacon_encodeSmallInteger(initialState->column);
-    sourcePosition->endIndex    = beacon_encodeSmallInteger(state->position);
-    sourcePosition->endLine     = beacon_encodeSmallInteger(state->line);
-    sourcePosition->endColumn   = beacon_encodeSmallInteger(state->column);
-
-    beacon_ScannerToken_t *token = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.scannerTokenClass, sizeof(beacon_ScannerToken_t), BeaconObjectKindPointers);
-    token->kind = beacon_encodeSmallInteger(kind),
-    token->sourcePosition = sourcePosition;
-    token->textPosition = beacon_encodeSmallInteger(initialState->position);
-    token->textSize = beacon_encodeSmallInteger(state->position - initialState->position);
-    return token;
+    beacon_TokenBuffer_add(state->tokens, kind, initialState->position, state->position);
+    return kind;
 }
 
-beacon_ScannerToken_t *scannerState_makeErrorTokenStartingFrom(beacon_scannerState_t *state, const char *errorMessage, const beacon_scannerState_t *initialState)
+beacon_TokenKind_t scannerState_makeErrorTokenStartingFrom(beacon_scannerState_t *state, const char *errorMessage, const beacon_scannerState_t *initialState)
 {
-    beacon_SourcePosition_t *sourcePosition = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
-    sourcePosition->sourceCode = state->sourceCode,
-    sourcePosition->startIndex  = beacon_encodeSmallInteger(initialState->position);
-    sourcePosition->startLine   = beacon_encodeSmallInteger(initialState->line);
-    sourcePosition->startColumn = beacon_encodeSmallInteger(initialState->column);
-    sourcePosition->endIndex    = beacon_encodeSmallInteger(state->position);
-    sourcePosition->endLine     = beacon_encodeSmallInteger(state->line);
-    sourcePosition->endColumn   = beacon_encodeSmallInteger(state->column);
-
-    beacon_ScannerToken_t *token = beacon_allocateObjectWithBehavior(state->context->heap, state->context->classes.scannerTokenClass, sizeof(beacon_ScannerToken_t), BeaconObjectKindPointers);
-    token->kind = beacon_encodeSmallInteger(BeaconTokenError);
-    token->sourcePosition = sourcePosition;
-    token->errorMessage = beacon_importCString(state->context, errorMessage);
-    
-    return token;
+    beacon_TokenBuffer_addError(state->tokens, initialState->position, state->position, errorMessage, strlen(errorMessage));
+    return BeaconTokenError;
 }
 
-beacon_ScannerToken_t *beacon_scanner_skipWhite(beacon_scannerState_t *state)
+beacon_TokenKind_t beacon_scanner_skipWhite(beacon_scannerState_t *state)
 {
     bool hasSeenComment = false;
     
@@ -211,7 +244,7 @@ beacon_ScannerToken_t *beacon_scanner_skipWhite(beacon_scannerState_t *state)
         }
     } while (hasSeenComment);
     
-    return NULL;
+    return BeaconTokenNullToken;
 }
 
 bool scanAdvanceKeyword(beacon_scannerState_t *state)
@@ -236,10 +269,10 @@ bool scanAdvanceKeyword(beacon_scannerState_t *state)
     return true;
 }
 
-beacon_ScannerToken_t *beacon_scanSingleToken(beacon_scannerState_t *state)
+beacon_TokenKind_t beacon_scanSingleToken(beacon_scannerState_t *state)
 {
-    beacon_ScannerToken_t *whiteToken = beacon_scanner_skipWhite(state);
-    if(whiteToken)
+    beacon_TokenKind_t whiteToken = beacon_scanner_skipWhite(state);
+    if(whiteToken != BeaconTokenNullToken)
         return whiteToken;
 
     if(scannerState_atEnd(state))
@@ -512,21 +545,33 @@ beacon_ScannerToken_t *beacon_scanSingleToken(beacon_scannerState_t *state)
     return scannerState_makeErrorTokenStartingFrom(state, "Unknown character", &initialState);
 }
 
+void beacon_scanSourceCodeIntoTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_TokenBuffer_t *buffer)
+{
+    beacon_scannerState_t currentState = scannerState_newForSourceCode(context, sourceCode, buffer);
+    while(beacon_scanSingleToken(&currentState) != BeaconTokenEndOfSource)
+        ;
+}
+
+void beacon_scanSourceCodeRangeIntoTokenBuffer(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t startIndex, size_t endIndex, beacon_TokenBuffer_t *buffer)
+{
+    beacon_scannerState_t currentState = scannerState_newForSourceCode(context, sourceCode, buffer);
+    BeaconAssert(context, startIndex <= endIndex && endIndex <= (size_t)currentState.size);
+    currentState.position = (int32_t)startIndex;
+    currentState.size = (int32_t)endIndex;
+    while(beacon_scanSingleToken(&currentState) != BeaconTokenEndOfSource)
+        ;
+}
+
 beacon_ArrayList_t *beacon_scanSourceCode(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
 {
+    beacon_TokenBuffer_t buffer;
+    beacon_TokenBuffer_initialize(&buffer, sourceCode);
+    beacon_scanSourceCodeIntoTokenBuffer(context, sourceCode, &buffer);
+
     beacon_ArrayList_t *arrayList = beacon_ArrayList_new(context);
-    beacon_scannerState_t currentState = scannerState_newForSourceCode(context, sourceCode);
-    beacon_ScannerToken_t *scannedToken = NULL;
-    do
-    {
-        scannedToken = beacon_scanSingleToken(&currentState);
-        if(beacon_decodeSmallInteger(scannedToken->kind) != BeaconTokenNullToken)
-        {
-            beacon_ArrayList_add(context, arrayList, (beacon_oop_t)scannedToken);
-            if (beacon_decodeSmallInteger(scannedToken->kind) == BeaconTokenEndOfSource)
-                break;
-        }
-    } while (beacon_decodeSmallInteger(scannedToken->kind) != BeaconTokenEndOfSource);
+    for(size_t i = 0; i < buffer.size; ++i)
+        beacon_ArrayList_add(context, arrayList, (beacon_oop_t)beacon_TokenBuffer_makeToken(context, &buffer, i));
 
+    beacon_TokenBuffer_destroy(&buffer);
     return arrayList;
-}
\ No newline at end of file
+}
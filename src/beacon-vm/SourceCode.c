@@ -6,8 +6,13 @@
 #include "beacon-lang/Parser.h"
 #include "beacon-lang/ArrayList.h"
 #include "beacon-lang/Exceptions.h"
+#include "beacon-lang/BytecodeCache.h"
+#include "beacon-lang/ThreadPool.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdatomic.h>
+#include <threads.h>
 
 void beacon_splitFileName(beacon_context_t *context, const char *inFileName, beacon_String_t **outDirectory, beacon_String_t **outBasename)
 {
@@ -77,6 +82,91 @@ beacon_SourceCode_t *beacon_makeSourceCodeFromString(beacon_context_t *context,
     return sourceCode;
 }
 
+beacon_SourcePosition_t *beacon_makeSourcePosition(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t startIndex, size_t endIndex)
+{
+    beacon_SourcePosition_t *sourcePosition = beacon_allocateObjectWithBehavior(context->heap, context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
+    sourcePosition->sourceCode = sourceCode;
+    sourcePosition->startIndex = beacon_encodeSmallInteger(startIndex);
+    sourcePosition->endIndex   = beacon_encodeSmallInteger(endIndex);
+    return sourcePosition;
+}
+
+static beacon_UInt32Array_t *beacon_SourceCode_getLineStartIndices(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
+{
+    if(sourceCode->lineStartIndices)
+        return sourceCode->lineStartIndices;
+
+    // A line starts after a CR, a LF or a CR LF pair.
+    size_t textSize = beacon_decodeSmallInteger(sourceCode->textSize);
+    const uint8_t *text = sourceCode->text->data;
+    size_t lineCount = 1;
+    for(size_t i = 0; i < textSize; ++i)
+    {
+        if(text[i] == '\r' || (text[i] == '\n' && (i == 0 || text[i - 1] != '\r')))
+            ++lineCount;
+    }
+
+    beacon_UInt32Array_t *lineStartIndices = beacon_allocateObjectWithBehavior(context->heap, context->classes.uint32ArrayClass, sizeof(beacon_UInt32Array_t) + lineCount * sizeof(uint32_t), BeaconObjectKindBytes);
+    size_t lineIndex = 0;
+    lineStartIndices->elements[lineIndex++] = 0;
+    for(size_t i = 0; i < textSize; ++i)
+    {
+        if(text[i] == '\r' || (text[i] == '\n' && (i == 0 || text[i - 1] != '\r')))
+            lineStartIndices->elements[lineIndex++] = (uint32_t)(i + 1);
+    }
+
+    sourceCode->lineStartIndices = lineStartIndices;
+    return lineStartIndices;
+}
+
+static void beacon_SourceCode_computeLineAndColumn(beacon_context_t *context, beacon_SourceCode_t *sourceCode, size_t index, beacon_oop_t *outLine, beacon_oop_t *outColumn)
+{
+    beacon_UInt32Array_t *lineStartIndices = beacon_SourceCode_getLineStartIndices(context, sourceCode);
+    size_t lineCount = lineStartIndices->super.super.super.super.super.header.slotCount / sizeof(uint32_t);
+
+    // Find the last line that starts before the index.
+    size_t lower = 0;
+    size_t upper = lineCount;
+    while(upper - lower > 1)
+    {
+        size_t middle = lower + (upper - lower) / 2;
+        if(lineStartIndices->elements[middle] <= index)
+            lower = middle;
+        else
+            upper = middle;
+    }
+
+    const uint8_t *text = sourceCode->text->data;
+    intptr_t column = 1;
+    for(size_t i = lineStartIndices->elements[lower]; i < index; ++i)
+    {
+        switch(text[i])
+        {
+        case '\n':
+            // The LF of a CR LF pair.
+            break;
+        case '\t':
+            column = (column + 4) % 4 * 4 + 1;
+            break;
+        default:
+            ++column;
+            break;
+        }
+    }
+
+    *outLine = beacon_encodeSmallInteger(lower + 1);
+    *outColumn = beacon_encodeSmallInteger(column);
+}
+
+void beacon_SourcePosition_computeLinesAndColumns(beacon_context_t *context, beacon_SourcePosition_t *sourcePosition)
+{
+    if(sourcePosition->startLine && sourcePosition->startColumn && sourcePosition->endLine && sourcePosition->endColumn)
+        return;
+
+    beacon_SourceCode_computeLineAndColumn(context, sourcePosition->sourceCode, beacon_decodeSmallInteger(sourcePosition->startIndex), &sourcePosition->startLine, &sourcePosition->startColumn);
+    beacon_SourceCode_computeLineAndColumn(context, sourcePosition->sourceCode, beacon_decodeSmallInteger(sourcePosition->endIndex), &sourcePosition->endLine, &sourcePosition->endColumn);
+}
+
 beacon_SourcePosition_t *beacon_sourcePosition_to(beacon_context_t *context, beacon_SourcePosition_t *start, beacon_SourcePosition_t *end)
 {
     beacon_SourcePosition_t *merged = beacon_allocateObjectWithBehavior(context->heap, context->classes.sourcePositionClass, sizeof(beacon_SourcePosition_t), BeaconObjectKindPointers);
@@ -103,6 +193,13 @@ beacon_SourcePosition_t *beacon_sourcePosition_until(beacon_context_t *context,
     return merged;
 }
 
+static beacon_ScannerToken_t *beacon_getFirstScannerError(beacon_context_t *context, beacon_TokenBuffer_t *tokenBuffer)
+{
+    if(tokenBuffer->errorCount == 0)
+        return NULL;
+    return beacon_TokenBuffer_makeToken(context, tokenBuffer, tokenBuffer->errors[0].tokenIndex);
+}
+
 beacon_oop_t beacon_evaluateSourceCode(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
 {
     beacon_StackFrameRecord_t frameRecord = {
@@ -112,22 +209,33 @@ beacon_oop_t beacon_evaluateSourceCode(beacon_context_t *context, beacon_SourceC
     };
     beacon_pushStackFrameRecord(&frameRecord);
 
-    beacon_ArrayList_t *scannedSource = beacon_scanSourceCode(context, sourceCode);
-    frameRecord.sourceCompilationRoots.tokenList = (beacon_oop_t)scannedSource;
+    // Use the compiled doits from the bytecode cache when the source has not changed.
+    if(!context->options.evaluateScriptsWithAST)
+    {
+        beacon_BytecodeCacheReader_t *cacheReader = beacon_BytecodeCacheReader_open(context, sourceCode);
+        if(cacheReader)
+        {
+            frameRecord.sourceCompilationRoots.evaluation = beacon_evaluateCachedFileSyntax(context, sourceCode, cacheReader);
+            beacon_BytecodeCacheReader_close(cacheReader);
+            beacon_popStackFrameRecord(&frameRecord);
+            return frameRecord.sourceCompilationRoots.evaluation;
+        }
+    }
 
-    intptr_t tokenCount = beacon_ArrayList_size(scannedSource);
-    for(intptr_t i = 1; i <= tokenCount; ++i)
+    beacon_TokenBuffer_t tokenBuffer;
+    beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+    beacon_scanSourceCodeIntoTokenBuffer(context, sourceCode, &tokenBuffer);
+
+    beacon_ScannerToken_t *scannerError = beacon_getFirstScannerError(context, &tokenBuffer);
+    if(scannerError)
     {
-        beacon_ScannerToken_t *token = (beacon_ScannerToken_t *)beacon_ArrayList_at(context, scannedSource, i);
-        beacon_TokenKind_t kind = beacon_decodeSmallInteger(token->kind);
-        if(kind == BeaconTokenError)
-            beacon_exception_scannerError(context, token);
-           
-        //printf("Token %d: %s\n", (int)i, beacon_TokenKind_toString());
+        beacon_TokenBuffer_destroy(&tokenBuffer);
+        beacon_exception_scannerError(context, scannerError);
     }
 
-    beacon_ParseTreeNode_t *parseTree = beacon_parseWorkspaceTokenList(context, sourceCode, scannedSource);
+    beacon_ParseTreeNode_t *parseTree = beacon_parseFileTokenBuffer(context, sourceCode, &tokenBuffer);
     frameRecord.sourceCompilationRoots.parseTree = (beacon_oop_t)parseTree;
+    beacon_TokenBuffer_destroy(&tokenBuffer);
 
     // Disable GC during file evaluation.
     //beacon_memoryHeapDisableGC(context->heap);
@@ -138,6 +246,154 @@ beacon_oop_t beacon_evaluateSourceCode(beacon_context_t *context, beacon_SourceC
     return frameRecord.sourceCompilationRoots.evaluation;
 }
 
+// Each file occupies three consecutive elements of the loaded files array: the source code, its first scanner error and the parse tree.
+#define BEACON_LOADED_FILE_ELEMENT_COUNT 3
+
+typedef struct beacon_SourceCodeParsingJob_s
+{
+    beacon_context_t *context;
+    beacon_Array_t *loadedFiles;
+    beacon_BytecodeCacheReader_t **cacheReaders;
+    size_t fileCount;
+    atomic_size_t nextFileIndex;
+} beacon_SourceCodeParsingJob_t;
+
+typedef struct beacon_SourceCodeParsingWorker_s
+{
+    beacon_SourceCodeParsingJob_t *job;
+    beacon_MemoryHeap_t *arena;
+    thrd_t thread;
+} beacon_SourceCodeParsingWorker_t;
+
+static int beacon_SourceCodeParsingWorker_run(void *argument)
+{
+    beacon_SourceCodeParsingWorker_t *worker = (beacon_SourceCodeParsingWorker_t *)argument;
+    beacon_SourceCodeParsingJob_t *job = worker->job;
+    beacon_context_t *context = job->context;
+
+    // Scanning and parsing only interns symbols in the shared state, so everything else is allocated without synchronization.
+    beacon_setThreadLocalMemoryArena(worker->arena);
+    for(;;)
+    {
+        size_t fileIndex = atomic_fetch_add(&job->nextFileIndex, 1);
+        if(fileIndex >= job->fileCount)
+            break;
+        if(job->cacheReaders[fileIndex])
+            continue;
+
+        beacon_oop_t *loadedFile = job->loadedFiles->elements + fileIndex * BEACON_LOADED_FILE_ELEMENT_COUNT;
+        beacon_SourceCode_t *sourceCode = (beacon_SourceCode_t *)loadedFile[0];
+        beacon_TokenBuffer_t tokenBuffer;
+        beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+        beacon_scanSourceCodeIntoTokenBuffer(context, sourceCode, &tokenBuffer);
+        loadedFile[1] = (beacon_oop_t)beacon_getFirstScannerError(context, &tokenBuffer);
+        loadedFile[2] = (beacon_oop_t)beacon_parseFileTokenBuffer(context, sourceCode, &tokenBuffer);
+        beacon_TokenBuffer_destroy(&tokenBuffer);
+    }
+    beacon_setThreadLocalMemoryArena(NULL);
+
+    return 0;
+}
+
+static void beacon_parseSourceCodeFilesInParallel(beacon_context_t *context, beacon_Array_t *loadedFiles, beacon_BytecodeCacheReader_t **cacheReaders, size_t fileCount)
+{
+    size_t pendingFileCount = 0;
+    for(size_t i = 0; i < fileCount; ++i)
+    {
+        if(!cacheReaders[i])
+            ++pendingFileCount;
+    }
+    if(pendingFileCount == 0)
+        return;
+
+    size_t workerCount = context->options.sourceParsingThreadCount;
+    if(workerCount == 0)
+        workerCount = beacon_getProcessorCount();
+    if(workerCount > pendingFileCount)
+        workerCount = pendingFileCount;
+
+    beacon_SourceCodeParsingJob_t job = {
+        .context = context,
+        .loadedFiles = loadedFiles,
+        .cacheReaders = cacheReaders,
+        .fileCount = fileCount,
+    };
+    atomic_init(&job.nextFileIndex, 0);
+
+    // The calling thread is the first worker.
+    beacon_SourceCodeParsingWorker_t *workers = calloc(workerCount, sizeof(beacon_SourceCodeParsingWorker_t));
+    size_t startedWorkerCount = 1;
+    for(size_t i = 0; i < workerCount; ++i)
+    {
+        workers[i].job = &job;
+        workers[i].arena = beacon_createMemoryArena(context->heap);
+    }
+    for(size_t i = 1; i < workerCount; ++i)
+    {
+        if(thrd_create(&workers[i].thread, beacon_SourceCodeParsingWorker_run, workers + i) != thrd_success)
+            break;
+        ++startedWorkerCount;
+    }
+
+    beacon_SourceCodeParsingWorker_run(workers);
+    for(size_t i = 1; i < startedWorkerCount; ++i)
+        thrd_join(workers[i].thread, NULL);
+
+    for(size_t i = 0; i < workerCount; ++i)
+        beacon_mergeMemoryArenaIntoHeap(context->heap, workers[i].arena);
+    free(workers);
+}
+
+beacon_oop_t beacon_evaluateSourceCodeFiles(beacon_context_t *context, size_t fileCount, const char **fileNames)
+{
+    beacon_StackFrameRecord_t frameRecord = {
+        .kind = StackFramePrimitiveRoots,
+        .context = context,
+    };
+    beacon_pushStackFrameRecord(&frameRecord);
+
+    beacon_Array_t *loadedFiles = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + fileCount * BEACON_LOADED_FILE_ELEMENT_COUNT * sizeof(beacon_oop_t), BeaconObjectKindPointers);
+    frameRecord.primitiveRoots.allocatedObjects[0] = (beacon_oop_t)loadedFiles;
+
+    // Read the files, and look for their compiled doits in the bytecode cache.
+    beacon_BytecodeCacheReader_t **cacheReaders = calloc(fileCount, sizeof(beacon_BytecodeCacheReader_t *));
+    for(size_t i = 0; i < fileCount; ++i)
+    {
+        beacon_SourceCode_t *sourceCode = beacon_makeSourceCodeFromFileNamed(context, fileNames[i]);
+        BeaconAssert(context, sourceCode);
+        loadedFiles->elements[i * BEACON_LOADED_FILE_ELEMENT_COUNT] = (beacon_oop_t)sourceCode;
+        if(!context->options.evaluateScriptsWithAST)
+            cacheReaders[i] = beacon_BytecodeCacheReader_open(context, sourceCode);
+    }
+
+    beacon_parseSourceCodeFilesInParallel(context, loadedFiles, cacheReaders, fileCount);
+
+    for(size_t i = 0; i < fileCount; ++i)
+    {
+        beacon_oop_t *loadedFile = loadedFiles->elements + i * BEACON_LOADED_FILE_ELEMENT_COUNT;
+        beacon_SourceCode_t *sourceCode = (beacon_SourceCode_t *)loadedFile[0];
+        if(cacheReaders[i])
+        {
+            frameRecord.primitiveRoots.result = beacon_evaluateCachedFileSyntax(context, sourceCode, cacheReaders[i]);
+            beacon_BytecodeCacheReader_close(cacheReaders[i]);
+        }
+        else
+        {
+            if(loadedFile[1])
+                beacon_exception_scannerError(context, (beacon_ScannerToken_t *)loadedFile[1]);
+            frameRecord.primitiveRoots.result = beacon_evaluateFileSyntax(context, (beacon_ParseTreeNode_t *)loadedFile[2], sourceCode);
+        }
+
+        // The syntax of the evaluated files is no longer needed.
+        loadedFile[1] = 0;
+        loadedFile[2] = 0;
+    }
+    free(cacheReaders);
+
+    beacon_popStackFrameRecord(&frameRecord);
+    return frameRecord.primitiveRoots.result;
+}
+
 static beacon_oop_t beacon_SourceCode_scan(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     BeaconAssert(context, (intptr_t)argumentCount == 0);
@@ -157,6 +413,20 @@ static beacon_oop_t beacon_SourceCode_parseScannedSource(beacon_context_t *conte
     return (beacon_oop_t)parsedSource;
 }
 
+static beacon_oop_t beacon_SourceCode_parse(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_SourceCode_t *sourceCode = (beacon_SourceCode_t*)receiver;
+
+    beacon_TokenBuffer_t tokenBuffer;
+    beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+    beacon_scanSourceCodeIntoTokenBuffer(context, sourceCode, &tokenBuffer);
+    beacon_ParseTreeNode_t *parsedSource = beacon_parseWorkspaceTokenBuffer(context, sourceCode, &tokenBuffer);
+    beacon_TokenBuffer_destroy(&tokenBuffer);
+    return (beacon_oop_t)parsedSource;
+}
+
 static beacon_oop_t beacon_SourceCode_evaluateFileSyntaxWithParsedCode(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     BeaconAssert(context, (intptr_t)argumentCount == 1);
@@ -166,11 +436,104 @@ static beacon_oop_t beacon_SourceCode_evaluateFileSyntaxWithParsedCode(beacon_co
     return beacon_evaluateFileSyntax(context, parseTreeNode, sourceCode);
 }
 
+static beacon_oop_t beacon_SourceCode_compileMethodsOfParsedCode(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, (intptr_t)argumentCount == 1);
+    beacon_SourceCode_t *sourceCode = (beacon_SourceCode_t*)receiver;
+    beacon_ParseTreeNode_t *parseTreeNode = (beacon_ParseTreeNode_t*)arguments[0];
+
+    return beacon_encodeSmallInteger(beacon_compileFileSyntaxMethods(context, parseTreeNode, sourceCode));
+}
+
+static beacon_oop_t beacon_SourceCode_fromFileNamed(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    BeaconAssert(context, (intptr_t)argumentCount == 1);
+    beacon_String_t *fileNameString = (beacon_String_t *)arguments[0];
+    size_t fileNameSize = fileNameString->super.super.super.super.super.header.slotCount;
+
+    char *fileNameBuffer = calloc(1, fileNameSize + 1);
+    memcpy(fileNameBuffer, fileNameString->data, fileNameSize);
+
+    beacon_SourceCode_t *sourceCode = beacon_makeSourceCodeFromFileNamed(context, fileNameBuffer);
+    free(fileNameBuffer);
+    return (beacon_oop_t)sourceCode;
+}
+
+static beacon_oop_t beacon_SourceCode_fileInAll(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    BeaconAssert(context, (intptr_t)argumentCount == 1);
+    beacon_Array_t *fileNameArray = (beacon_Array_t *)arguments[0];
+    size_t fileCount = fileNameArray->super.super.super.super.super.header.slotCount;
+
+    const char **fileNames = calloc(fileCount, sizeof(const char *));
+    for(size_t i = 0; i < fileCount; ++i)
+    {
+        beacon_String_t *fileNameString = (beacon_String_t *)fileNameArray->elements[i];
+        size_t fileNameSize = fileNameString->super.super.super.super.super.header.slotCount;
+        char *fileNameBuffer = calloc(1, fileNameSize + 1);
+        memcpy(fileNameBuffer, fileNameString->data, fileNameSize);
+        fileNames[i] = fileNameBuffer;
+    }
+
+    beacon_oop_t result = beacon_evaluateSourceCodeFiles(context, fileCount, fileNames);
+    for(size_t i = 0; i < fileCount; ++i)
+        free((void *)fileNames[i]);
+    free(fileNames);
+    return result;
+}
+
+static beacon_oop_t beacon_SourcePosition_startLine(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_SourcePosition_t *sourcePosition = (beacon_SourcePosition_t*)receiver;
+    beacon_SourcePosition_computeLinesAndColumns(context, sourcePosition);
+    return sourcePosition->startLine;
+}
+
+static beacon_oop_t beacon_SourcePosition_startColumn(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_SourcePosition_t *sourcePosition = (beacon_SourcePosition_t*)receiver;
+    beacon_SourcePosition_computeLinesAndColumns(context, sourcePosition);
+    return sourcePosition->startColumn;
+}
+
+static beacon_oop_t beacon_SourcePosition_endLine(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_SourcePosition_t *sourcePosition = (beacon_SourcePosition_t*)receiver;
+    beacon_SourcePosition_computeLinesAndColumns(context, sourcePosition);
+    return sourcePosition->endLine;
+}
+
+static beacon_oop_t beacon_SourcePosition_endColumn(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, (intptr_t)argumentCount == 0);
+    beacon_SourcePosition_t *sourcePosition = (beacon_SourcePosition_t*)receiver;
+    beacon_SourcePosition_computeLinesAndColumns(context, sourcePosition);
+    return sourcePosition->endColumn;
+}
 
 void beacon_context_registerSourceCodePrimitives(beacon_context_t *context)
 {
     beacon_addPrimitiveToClass(context, context->classes.sourceCodeClass, "scan", 0, beacon_SourceCode_scan);
     beacon_addPrimitiveToClass(context, context->classes.sourceCodeClass, "parseScannedSource:", 1, beacon_SourceCode_parseScannedSource);
+    beacon_addPrimitiveToClass(context, context->classes.sourceCodeClass, "parse", 0, beacon_SourceCode_parse);
     beacon_addPrimitiveToClass(context, context->classes.sourceCodeClass, "evaluateFileSyntaxWithParsedCode:", 1, beacon_SourceCode_evaluateFileSyntaxWithParsedCode);
+    beacon_addPrimitiveToClass(context, context->classes.sourceCodeClass, "compileMethodsOfParsedCode:", 1, beacon_SourceCode_compileMethodsOfParsedCode);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.sourceCodeClass), "fromFileNamed:", 1, beacon_SourceCode_fromFileNamed);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.sourceCodeClass), "fileInAll:", 1, beacon_SourceCode_fileInAll);
+
+    // The lines and columns are computed on demand from the start and end indices.
+    beacon_addPrimitiveToClass(context, context->classes.sourcePositionClass, "startLine", 0, beacon_SourcePosition_startLine);
+    beacon_addPrimitiveToClass(context, context->classes.sourcePositionClass, "startColumn", 0, beacon_SourcePosition_startColumn);
+    beacon_addPrimitiveToClass(context, context->classes.sourcePositionClass, "endLine", 0, beacon_SourcePosition_endLine);
+    beacon_addPrimitiveToClass(context, context->classes.sourcePositionClass, "endColumn", 0, beacon_SourcePosition_endColumn);
     
 }
\ No newline at end of file
@@ -3,9 +3,21 @@
 #include "beacon-lang/Dictionary.h"
 #include "beacon-lang/Exceptions.h"
 #include "beacon-lang/ArrayList.h"
+#include "beacon-lang/BytecodeCache.h"
+#include "beacon-lang/Scanner.h"
 #include <stdlib.h>
 #include <stdio.h>
 
+#define BEACON_INLINED_COLLECTION_ITERATION_MAX_BLOCK_SOURCE_SIZE 256
+
+// The compiler primitives of the built-in parse tree nodes and environments are called directly, without
+// going through a method lookup. The message sends are only used for the classes that are defined by the image.
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInCompileFunction(beacon_context_t *context, beacon_Behavior_t *nodeClass);
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInEvaluateFunction(beacon_context_t *context, beacon_Behavior_t *nodeClass);
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInLookupSymbolWithBytecodeBuilderFunction(beacon_context_t *context, beacon_Behavior_t *environmentClass);
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInLookupSymbolFunction(beacon_context_t *context, beacon_Behavior_t *environmentClass);
+static beacon_oop_t beacon_SyntaxCompiler_compileInlineBlock(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments);
+
 static beacon_BytecodeValue_t beacon_compileNodeWithEnvironmentAndBytecodeBuilder(beacon_context_t *context, beacon_ParseTreeNode_t *node, beacon_AbstractCompilationEnvironment_t *environment, beacon_BytecodeCodeBuilder_t *builder)
 {
     beacon_oop_t arguments[2] = {
@@ -13,6 +25,10 @@ static beacon_BytecodeValue_t beacon_compileNodeWithEnvironmentAndBytecodeBuilde
         (beacon_oop_t)builder
     };
 
+    beacon_NativeCodeFunction_t compileFunction = beacon_SyntaxCompiler_getBuiltInCompileFunction(context, beacon_getClass(context, (beacon_oop_t)node));
+    if(compileFunction)
+        return beacon_decodeSmallInteger(compileFunction(context, (beacon_oop_t)node, 2, arguments));
+
     return beacon_decodeSmallInteger(beacon_performWithArguments(context, (beacon_oop_t)node, context->roots.compileWithEnvironmentAndBytecodeBuilderSelector, 2, arguments));
 }
 
@@ -22,6 +38,10 @@ static beacon_oop_t beacon_evaluateNodeWithEnvironment(beacon_context_t *context
         (beacon_oop_t)environment
     };
 
+    beacon_NativeCodeFunction_t evaluateFunction = beacon_SyntaxCompiler_getBuiltInEvaluateFunction(context, beacon_getClass(context, (beacon_oop_t)node));
+    if(evaluateFunction)
+        return evaluateFunction(context, (beacon_oop_t)node, 1, arguments);
+
     return beacon_performWithArguments(context, (beacon_oop_t)node, context->roots.evaluateWithEnvironmentSelector, 1, arguments);
 }
 
@@ -33,10 +53,40 @@ static beacon_BytecodeValue_t beacon_compileInlineNodeWithEnvironmentAndBytecode
         (beacon_oop_t)builder
     };
 
+    if(beacon_getClass(context, (beacon_oop_t)node) == context->classes.parseTreeBlockClosureNodeClass)
+        return beacon_decodeSmallInteger(beacon_SyntaxCompiler_compileInlineBlock(context, (beacon_oop_t)node, 3, arguments));
+
     return beacon_decodeSmallInteger(beacon_performWithArguments(context, (beacon_oop_t)node, context->roots.compileInlineBlockWithArgumentsWithEnvironmentAndBytecodeBuilderSelector, 3, arguments));
 }
 
-beacon_CompiledMethod_t *beacon_compileFileSyntax(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode)
+static beacon_oop_t beacon_lookupSymbolRecursivelyWithBytecodeBuilder(beacon_context_t *context, beacon_AbstractCompilationEnvironment_t *environment, beacon_oop_t symbol, beacon_BytecodeCodeBuilder_t *builder)
+{
+    beacon_oop_t arguments[2] = {
+        symbol,
+        (beacon_oop_t)builder
+    };
+
+    beacon_NativeCodeFunction_t lookupFunction = beacon_SyntaxCompiler_getBuiltInLookupSymbolWithBytecodeBuilderFunction(context, beacon_getClass(context, (beacon_oop_t)environment));
+    if(lookupFunction)
+        return lookupFunction(context, (beacon_oop_t)environment, 2, arguments);
+
+    return beacon_performWithArguments(context, (beacon_oop_t)environment, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, 2, arguments);
+}
+
+static beacon_oop_t beacon_lookupSymbolRecursively(beacon_context_t *context, beacon_AbstractCompilationEnvironment_t *environment, beacon_oop_t symbol)
+{
+    beacon_oop_t arguments[1] = {
+        symbol
+    };
+
+    beacon_NativeCodeFunction_t lookupFunction = beacon_SyntaxCompiler_getBuiltInLookupSymbolFunction(context, beacon_getClass(context, (beacon_oop_t)environment));
+    if(lookupFunction)
+        return lookupFunction(context, (beacon_oop_t)environment, 1, arguments);
+
+    return beacon_performWithArguments(context, (beacon_oop_t)environment, context->roots.lookupSymbolRecursivelySelector, 1, arguments);
+}
+
+static beacon_FileCompilationEnvironment_t *beacon_SyntaxCompiler_makeFileEnvironment(beacon_context_t *context, beacon_SourceCode_t *sourceCode)
 {
     beacon_EmptyCompilationEnvironment_t *emptyEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.emptyCompilationEnvironmentClass, sizeof(beacon_EmptyCompilationEnvironment_t), BeaconObjectKindPointers);
     beacon_SystemCompilationEnvironment_t *systemEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.systemCompilationEnvironmentClass, sizeof(beacon_SystemCompilationEnvironment_t), BeaconObjectKindPointers);
@@ -49,6 +99,12 @@ beacon_CompiledMethod_t *beacon_compileFileSyntax(beacon_context_t *context, bea
     fileEnvironment->dictionary = beacon_MethodDictionary_new(context);
     beacon_MethodDictionary_atPut(context, fileEnvironment->dictionary, beacon_internCString(context, "__FileDir__"), (beacon_oop_t)sourceCode->directory);
     beacon_MethodDictionary_atPut(context, fileEnvironment->dictionary, beacon_internCString(context, "__FileName__"), (beacon_oop_t)sourceCode->name);
+    return fileEnvironment;
+}
+
+beacon_CompiledMethod_t *beacon_compileFileSyntax(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode)
+{
+    beacon_FileCompilationEnvironment_t *fileEnvironment = beacon_SyntaxCompiler_makeFileEnvironment(context, sourceCode);
 
     beacon_BytecodeCodeBuilder_t *bytecodeBuilder = beacon_BytecodeCodeBuilder_new(context, NULL);
     
@@ -66,22 +122,164 @@ beacon_CompiledMethod_t *beacon_compileFileSyntax(beacon_context_t *context, bea
     return compiledMethod;
 }
 
+static beacon_oop_t beacon_SyntaxCompiler_runDoItMethod(beacon_context_t *context, beacon_CompiledMethod_t *doItMethod, beacon_StackFrameRecord_t *frameRecord)
+{
+    frameRecord->primitiveRoots.allocatedObjects[3] = (beacon_oop_t)doItMethod;
+
+    // The workspace variables are the receiver slots of the doit.
+    return beacon_interpretBytecodeMethod(context, &doItMethod->super, frameRecord->primitiveRoots.allocatedObjects[1], 0, 0, 0, NULL);
+}
+
+static beacon_oop_t beacon_SyntaxCompiler_runDoIt(beacon_context_t *context, beacon_ParseTreeNode_t *node, beacon_AbstractCompilationEnvironment_t *environment, beacon_StackFrameRecord_t *frameRecord, beacon_BytecodeCacheWriter_t *cacheWriter)
+{
+    beacon_BytecodeCodeBuilder_t *bytecodeBuilder = beacon_BytecodeCodeBuilder_new(context, NULL);
+    frameRecord->primitiveRoots.allocatedObjects[2] = (beacon_oop_t)bytecodeBuilder;
+
+    // The methods that are installed by the compiler are recorded along with the doit.
+    beacon_BytecodeCacheWriter_t *previousCacheWriter = context->bytecodeCacheWriter;
+    context->bytecodeCacheWriter = cacheWriter;
+    beacon_BytecodeValue_t resultValue = beacon_compileNodeWithEnvironmentAndBytecodeBuilder(context, node, environment, bytecodeBuilder);
+    context->bytecodeCacheWriter = previousCacheWriter;
+
+    beacon_BytecodeCodeBuilder_localReturn(context, bytecodeBuilder, resultValue);
+    beacon_BytecodeCode_t *bytecode = beacon_BytecodeCodeBuilder_finish(context, bytecodeBuilder);
+
+    beacon_CompiledMethod_t *doItMethod = beacon_allocateObjectWithBehavior(context->heap, context->classes.compiledMethodClass, sizeof(beacon_CompiledMethod_t), BeaconObjectKindPointers);
+    doItMethod->super.argumentCount = bytecode->argumentCount;
+    doItMethod->super.bytecodeImplementation = bytecode;
+    doItMethod->super.sourcePosition = node->sourcePosition;
+
+    // The doit has to be recorded before running it, when the globals still have the values that were seen by the compiler.
+    beacon_BytecodeCacheWriter_recordDoIt(context, cacheWriter, doItMethod);
+    return beacon_SyntaxCompiler_runDoItMethod(context, doItMethod, frameRecord);
+}
+
+/**
+ * Compiles each top-level statement of a workspace script into a temporary method and runs it through the
+ * bytecode interpreter. Statements are compiled one at a time because they can refer to globals that are
+ * defined by the previous statements. The script variables are kept in an array, which is used as the
+ * receiver of the doits. When resuming a script that was partially loaded from the bytecode cache, the
+ * existing script variables are passed, and the statements before the first statement index are skipped.
+ */
+static beacon_oop_t beacon_SyntaxCompiler_runWorkspaceScriptDoIts(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode, beacon_Array_t *existingLocalVariables, size_t firstStatementIndex)
+{
+    beacon_FileCompilationEnvironment_t *fileEnvironment = beacon_SyntaxCompiler_makeFileEnvironment(context, sourceCode);
+    beacon_LexicalCompilationEnvironment_t *lexicalEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.lexicalCompilationEnvironmentClass, sizeof(beacon_LexicalCompilationEnvironment_t), BeaconObjectKindPointers);
+    lexicalEnvironment->parent = &fileEnvironment->super;
+
+    beacon_StackFrameRecord_t frameRecord = {
+        .kind = StackFramePrimitiveRoots,
+        .context = context,
+        .primitiveRoots = {
+            .receiver = (beacon_oop_t)parseTree,
+            .allocatedObjects = {
+                (beacon_oop_t)lexicalEnvironment,
+                (beacon_oop_t)existingLocalVariables
+            }
+        }
+    };
+    beacon_pushStackFrameRecord(&frameRecord);
+
+    beacon_ParseTreeNode_t *expression = parseTree;
+    size_t localVariableCount = 0;
+    if(beacon_getClass(context, (beacon_oop_t)parseTree) == context->classes.parseTreeWorkspaceScriptNode)
+    {
+        beacon_ParseTreeWorkspaceScriptNode_t *scriptNode = (beacon_ParseTreeWorkspaceScriptNode_t *)parseTree;
+        expression = scriptNode->expression;
+        localVariableCount = scriptNode->localVariables->super.super.super.super.super.header.slotCount;
+        for(size_t i = 0; i < localVariableCount; ++i)
+        {
+            beacon_ParseTreeLocalVariableDefinitionNode_t *definition = (beacon_ParseTreeLocalVariableDefinitionNode_t*)scriptNode->localVariables->elements[i];
+            beacon_BytecodeValue_t slotValue = beacon_BytecodeCodeBuilder_getReceiverSlot(context, NULL, i + 1);
+
+            if(!lexicalEnvironment->dictionary)
+                lexicalEnvironment->dictionary = beacon_MethodDictionary_new(context);
+
+            beacon_MethodDictionary_atPut(context, lexicalEnvironment->dictionary, definition->name, beacon_encodeSmallInteger(slotValue));
+        }
+    }
+
+    beacon_Array_t *localVariables = existingLocalVariables;
+    if(!localVariables)
+    {
+        localVariables = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + localVariableCount*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+        frameRecord.primitiveRoots.allocatedObjects[1] = (beacon_oop_t)localVariables;
+    }
+    BeaconAssert(context, localVariables->super.super.super.super.super.header.slotCount == localVariableCount);
+
+    size_t statementCount = 1;
+    beacon_ParseTreeNode_t **statements = &expression;
+    if(beacon_getClass(context, (beacon_oop_t)expression) == context->classes.parseTreeSequenceNodeClass)
+    {
+        beacon_ParseTreeSequenceNode_t *sequenceNode = (beacon_ParseTreeSequenceNode_t *)expression;
+        statementCount = sequenceNode->elements->super.super.super.super.super.header.slotCount;
+        statements = (beacon_ParseTreeNode_t **)sequenceNode->elements->elements;
+    }
+
+    // Only the complete evaluation of a file is recorded in the bytecode cache.
+    beacon_BytecodeCacheWriter_t *cacheWriter = NULL;
+    if(firstStatementIndex == 0)
+        cacheWriter = beacon_BytecodeCacheWriter_begin(context, sourceCode, localVariableCount, statementCount);
+
+    for(size_t i = firstStatementIndex; i < statementCount; ++i)
+        frameRecord.primitiveRoots.result = beacon_SyntaxCompiler_runDoIt(context, statements[i], &lexicalEnvironment->super, &frameRecord, cacheWriter);
+
+    beacon_BytecodeCacheWriter_end(context, cacheWriter);
+
+    beacon_popStackFrameRecord(&frameRecord);
+    return frameRecord.primitiveRoots.result;
+}
+
 beacon_oop_t beacon_evaluateFileSyntax(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode)
 {
-    beacon_EmptyCompilationEnvironment_t *emptyEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.emptyCompilationEnvironmentClass, sizeof(beacon_EmptyCompilationEnvironment_t), BeaconObjectKindPointers);
-    beacon_SystemCompilationEnvironment_t *systemEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.systemCompilationEnvironmentClass, sizeof(beacon_SystemCompilationEnvironment_t), BeaconObjectKindPointers);
-    beacon_FileCompilationEnvironment_t *fileEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.fileCompilationEnvironmentClass, sizeof(beacon_FileCompilationEnvironment_t), BeaconObjectKindPointers);
+    if(context->options.evaluateScriptsWithAST)
+    {
+        beacon_FileCompilationEnvironment_t *fileEnvironment = beacon_SyntaxCompiler_makeFileEnvironment(context, sourceCode);
+        return beacon_evaluateNodeWithEnvironment(context, parseTree, &fileEnvironment->super);
+    }
 
-    systemEnvironment->parent = &emptyEnvironment->super;
-    systemEnvironment->systemDictionary = context->roots.systemDictionary;
+    return beacon_SyntaxCompiler_runWorkspaceScriptDoIts(context, parseTree, sourceCode, NULL, 0);
+}
 
-    fileEnvironment->parent = &systemEnvironment->super;
-    fileEnvironment->dictionary = beacon_MethodDictionary_new(context);
-    beacon_MethodDictionary_atPut(context, fileEnvironment->dictionary, beacon_internCString(context, "__FileDir__"), (beacon_oop_t)sourceCode->directory);
-    beacon_MethodDictionary_atPut(context, fileEnvironment->dictionary, beacon_internCString(context, "__FileName__"), (beacon_oop_t)sourceCode->name);
-    
-    beacon_oop_t result = beacon_evaluateNodeWithEnvironment(context, parseTree, &fileEnvironment->super);
-    return result;
+beacon_oop_t beacon_evaluateCachedFileSyntax(beacon_context_t *context, beacon_SourceCode_t *sourceCode, beacon_BytecodeCacheReader_t *cacheReader)
+{
+    size_t localVariableCount = beacon_BytecodeCacheReader_getLocalVariableCount(cacheReader);
+    size_t statementCount = beacon_BytecodeCacheReader_getStatementCount(cacheReader);
+
+    beacon_StackFrameRecord_t frameRecord = {
+        .kind = StackFramePrimitiveRoots,
+        .context = context,
+        .primitiveRoots = {
+            .receiver = (beacon_oop_t)sourceCode,
+        }
+    };
+    beacon_pushStackFrameRecord(&frameRecord);
+
+    beacon_Array_t *localVariables = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + localVariableCount*sizeof(beacon_oop_t), BeaconObjectKindPointers);
+    frameRecord.primitiveRoots.allocatedObjects[1] = (beacon_oop_t)localVariables;
+
+    for(size_t i = 0; i < statementCount; ++i)
+    {
+        beacon_CompiledMethod_t *doItMethod = beacon_BytecodeCacheReader_nextDoIt(context, cacheReader);
+        if(!doItMethod)
+        {
+            // A global that was seen by the compiler is missing. Compile the remaining statements from the source.
+            beacon_TokenBuffer_t tokenBuffer;
+            beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+            beacon_scanSourceCodeIntoTokenBuffer(context, sourceCode, &tokenBuffer);
+            beacon_ParseTreeNode_t *parseTree = beacon_parseFileTokenBuffer(context, sourceCode, &tokenBuffer);
+            frameRecord.primitiveRoots.allocatedObjects[2] = (beacon_oop_t)parseTree;
+            beacon_TokenBuffer_destroy(&tokenBuffer);
+
+            frameRecord.primitiveRoots.result = beacon_SyntaxCompiler_runWorkspaceScriptDoIts(context, parseTree, sourceCode, localVariables, i);
+            break;
+        }
+
+        frameRecord.primitiveRoots.result = beacon_SyntaxCompiler_runDoItMethod(context, doItMethod, &frameRecord);
+    }
+
+    beacon_popStackFrameRecord(&frameRecord);
+    return frameRecord.primitiveRoots.result;
 }
 
 static beacon_oop_t beacon_SyntaxCompiler_evaluateNode(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -111,7 +309,7 @@ static beacon_oop_t beacon_SyntaxCompiler_evaluateIdentifierReference(beacon_con
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
 
     beacon_ParseTreeIdentifierReferenceNode_t *identifierReferenceNode = (beacon_ParseTreeIdentifierReferenceNode_t*)receiver;
-    beacon_oop_t result = beacon_performWith(context, (beacon_oop_t)environment, context->roots.lookupSymbolRecursivelySelector, identifierReferenceNode->identifier);
+    beacon_oop_t result = beacon_lookupSymbolRecursively(context, environment, identifierReferenceNode->identifier);
     if(beacon_getClass(context, result) == context->classes.associationClass)
     {
         beacon_Association_t *assoc = (beacon_Association_t*)result;
@@ -133,7 +331,7 @@ static beacon_oop_t beacon_SyntaxCompiler_evaluateByteArray(beacon_context_t *co
     for(size_t i = 0; i < byteArraySize; ++i)
     {
         beacon_oop_t integerNode = byteArrayNode->elements->elements[i];
-        beacon_oop_t integerValue = beacon_performWith(context, integerNode, context->roots.evaluateWithEnvironmentSelector, (beacon_oop_t)environment);
+        beacon_oop_t integerValue = beacon_evaluateNodeWithEnvironment(context, (beacon_ParseTreeNode_t*)integerNode, environment);
         byteArray->elements[i] = beacon_decodeSmallInteger(integerValue);
     }
 
@@ -154,7 +352,7 @@ static beacon_oop_t beacon_SyntaxCompiler_evaluateLiteralArray(beacon_context_t
     for(size_t i = 0; i < literalArraySize; ++i)
     {
         beacon_oop_t elementNode = literalArrayNode->elements->elements[i];
-        beacon_oop_t elementValue = beacon_performWith(context, elementNode, context->roots.evaluateWithEnvironmentSelector, (beacon_oop_t)environment);
+        beacon_oop_t elementValue = beacon_evaluateNodeWithEnvironment(context, (beacon_ParseTreeNode_t*)elementNode, environment);
         literalArray->elements[i] = elementValue;
     }
 
@@ -427,6 +625,204 @@ static beacon_oop_t beacon_SyntaxCompiler_whileFalseDo(beacon_context_t *context
     return 0;
 }
 
+typedef enum beacon_InlinedCollectionIterationKind_e
+{
+    BeaconInlinedCollectionIterationNone = 0,
+    BeaconInlinedCollectionIterationDo,
+    BeaconInlinedCollectionIterationCollect,
+    BeaconInlinedCollectionIterationSelect,
+    BeaconInlinedCollectionIterationInjectInto,
+} beacon_InlinedCollectionIterationKind_t;
+
+static bool beacon_SyntaxCompiler_isLiteralBlockWithArgumentCount(beacon_context_t *context, beacon_ParseTreeNode_t *node, size_t expectedArgumentCount)
+{
+    if(beacon_getClass(context, (beacon_oop_t)node) != context->classes.parseTreeBlockClosureNodeClass)
+        return false;
+
+    beacon_ParseTreeBlockClosureNode_t *blockClosureNode = (beacon_ParseTreeBlockClosureNode_t*)node;
+    if((size_t)blockClosureNode->arguments->super.super.super.super.super.header.slotCount != expectedArgumentCount)
+        return false;
+
+    // The inlined block is also compiled as a closure for the fallback send, so only the short ones are worth the doubled code.
+    beacon_SourcePosition_t *sourcePosition = node->sourcePosition;
+    return !sourcePosition ||
+        beacon_decodeSmallInteger(sourcePosition->endIndex) - beacon_decodeSmallInteger(sourcePosition->startIndex) <= BEACON_INLINED_COLLECTION_ITERATION_MAX_BLOCK_SOURCE_SIZE;
+}
+
+static beacon_InlinedCollectionIterationKind_t beacon_SyntaxCompiler_getInlinedCollectionIterationKind(beacon_context_t *context, beacon_oop_t selector, beacon_ParseTreeMessageSendNode_t *messageSendNode)
+{
+    if(!context->options.inlineCollectionIterationSelectors)
+        return BeaconInlinedCollectionIterationNone;
+
+    size_t argumentValueCount = messageSendNode->arguments->super.super.super.super.super.header.slotCount;
+    beacon_ParseTreeNode_t *lastArgument = argumentValueCount > 0 ? (beacon_ParseTreeNode_t*)messageSendNode->arguments->elements[argumentValueCount - 1] : NULL;
+    if(selector == context->roots.doSelector && beacon_SyntaxCompiler_isLiteralBlockWithArgumentCount(context, lastArgument, 1))
+        return BeaconInlinedCollectionIterationDo;
+    else if(selector == context->roots.collectSelector && beacon_SyntaxCompiler_isLiteralBlockWithArgumentCount(context, lastArgument, 1))
+        return BeaconInlinedCollectionIterationCollect;
+    else if(selector == context->roots.selectSelector && beacon_SyntaxCompiler_isLiteralBlockWithArgumentCount(context, lastArgument, 1))
+        return BeaconInlinedCollectionIterationSelect;
+    else if(selector == context->roots.injectIntoSelector && beacon_SyntaxCompiler_isLiteralBlockWithArgumentCount(context, lastArgument, 2))
+        return BeaconInlinedCollectionIterationInjectInto;
+    return BeaconInlinedCollectionIterationNone;
+}
+
+/**
+ * Inlines an iteration selector into an indexed loop when the receiver is exactly an Array or an ArrayList.
+ * Any other receiver falls back into the actual message send with the block closure.
+ * The loop accesses the elements and counts with inlined primitives, so an iteration only runs the body of the block.
+ */
+static beacon_oop_t beacon_SyntaxCompiler_collectionIteration(beacon_context_t *context, beacon_AbstractCompilationEnvironment_t *environment, beacon_BytecodeCodeBuilder_t *builder, beacon_BytecodeValue_t receiver, beacon_ParseTreeMessageSendNode_t *messageSendNode, beacon_oop_t selector, beacon_InlinedCollectionIterationKind_t kind)
+{
+    beacon_BytecodeValue_t result = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeValue_t collection = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeCodeBuilder_storeValue(context, builder, collection, receiver);
+
+    size_t argumentValueCount = messageSendNode->arguments->super.super.super.super.super.header.slotCount;
+    beacon_ParseTreeNode_t *blockNode = (beacon_ParseTreeNode_t*)messageSendNode->arguments->elements[argumentValueCount - 1];
+    beacon_BytecodeValue_t accumulator = 0;
+    if(kind == BeaconInlinedCollectionIterationInjectInto)
+    {
+        accumulator = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+        beacon_BytecodeValue_t initialValue = beacon_compileNodeWithEnvironmentAndBytecodeBuilder(context, (beacon_ParseTreeNode_t*)messageSendNode->arguments->elements[0], environment, builder);
+        beacon_BytecodeCodeBuilder_storeValue(context, builder, accumulator, initialValue);
+    }
+
+    // Receiver class guard.
+    beacon_BytecodeValue_t isArrayList = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeValue_t isArray = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeValue_t arrayListClass = beacon_BytecodeCodeBuilder_addLiteral(context, builder, (beacon_oop_t)context->classes.arrayListClass);
+    beacon_BytecodeValue_t arrayClass = beacon_BytecodeCodeBuilder_addLiteral(context, builder, (beacon_oop_t)context->classes.arrayClass);
+
+    beacon_BytecodeValue_t arrayListGuardOperands[2] = {collection, arrayListClass};
+    beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, isArrayList, BeaconBytecodeInlinedPrimitiveClassIdentityEquals, 2, arrayListGuardOperands);
+    uint16_t arrayListGuardJump = beacon_BytecodeCodeBuilder_jumpIfTrue(context, builder, isArrayList, 0);
+    beacon_BytecodeValue_t arrayGuardOperands[2] = {collection, arrayClass};
+    beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, isArray, BeaconBytecodeInlinedPrimitiveClassIdentityEquals, 2, arrayGuardOperands);
+    uint16_t arrayGuardJump = beacon_BytecodeCodeBuilder_jumpIfTrue(context, builder, isArray, 0);
+
+    // Fallback into the actual message send.
+    {
+        beacon_BytecodeValue_t argumentValues[2] = {};
+        if(kind == BeaconInlinedCollectionIterationInjectInto)
+            argumentValues[0] = accumulator;
+        argumentValues[argumentValueCount - 1] = beacon_compileNodeWithEnvironmentAndBytecodeBuilder(context, blockNode, environment, builder);
+        beacon_BytecodeCodeBuilder_sendMessage(context, builder, result, collection, beacon_BytecodeCodeBuilder_addLiteral(context, builder, selector), argumentValueCount, argumentValues);
+    }
+    uint16_t fallbackMergeJump = beacon_BytecodeCodeBuilder_jump(context, builder, 0);
+
+    // Inlined loop.
+    uint16_t inlinedLoopLocation = beacon_BytecodeCodeBuilder_label(builder);
+    beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, arrayListGuardJump, inlinedLoopLocation);
+    beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, arrayGuardJump, inlinedLoopLocation);
+
+    beacon_BytecodeValue_t size = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, size, BeaconBytecodeInlinedPrimitiveSequenceSize, 1, &collection);
+    switch(kind)
+    {
+    case BeaconInlinedCollectionIterationDo:
+        beacon_BytecodeCodeBuilder_storeValue(context, builder, result, collection);
+        break;
+    case BeaconInlinedCollectionIterationCollect:
+        {
+            // An array is filled in place, and a list gets its elements added with the final capacity.
+            beacon_BytecodeValue_t newWithSizeSelector = beacon_BytecodeCodeBuilder_addLiteral(context, builder, context->roots.newWithSizeSelector);
+            uint16_t arrayListResultJump = beacon_BytecodeCodeBuilder_jumpIfTrue(context, builder, isArrayList, 0);
+            beacon_BytecodeCodeBuilder_sendMessage(context, builder, result, arrayClass, newWithSizeSelector, 1, &size);
+            uint16_t resultMergeJump = beacon_BytecodeCodeBuilder_jump(context, builder, 0);
+            beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, arrayListResultJump, beacon_BytecodeCodeBuilder_label(builder));
+            beacon_BytecodeCodeBuilder_sendMessage(context, builder, result, arrayListClass, newWithSizeSelector, 1, &size);
+            beacon_BytecodeCodeBuilder_fixup_jump(context, builder, resultMergeJump, beacon_BytecodeCodeBuilder_label(builder));
+        }
+        break;
+    case BeaconInlinedCollectionIterationSelect:
+        beacon_BytecodeCodeBuilder_sendMessage(context, builder, result, arrayListClass, beacon_BytecodeCodeBuilder_addLiteral(context, builder, context->roots.newSelector), 0, NULL);
+        break;
+    default:
+        break;
+    }
+
+    beacon_BytecodeValue_t index = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeValue_t canContinue = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeValue_t element = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+    beacon_BytecodeValue_t one = beacon_BytecodeCodeBuilder_addLiteral(context, builder, beacon_encodeSmallInteger(1));
+    beacon_BytecodeCodeBuilder_storeValue(context, builder, index, one);
+    uint16_t loopIterationStart = beacon_BytecodeCodeBuilder_label(builder);
+
+    beacon_BytecodeValue_t conditionOperands[2] = {index, size};
+    beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, canContinue, BeaconBytecodeInlinedPrimitiveSmallIntegerLessOrEquals, 2, conditionOperands);
+    uint16_t loopEndJump = beacon_BytecodeCodeBuilder_jumpIfFalse(context, builder, canContinue, 0);
+
+    beacon_BytecodeValue_t elementOperands[2] = {collection, index};
+    beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, element, BeaconBytecodeInlinedPrimitiveSequenceAt, 2, elementOperands);
+
+    // Inline the block
+    size_t blockArgumentCount = kind == BeaconInlinedCollectionIterationInjectInto ? 2 : 1;
+    beacon_Array_t *blockArguments = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*blockArgumentCount, BeaconObjectKindPointers);
+    if(kind == BeaconInlinedCollectionIterationInjectInto)
+    {
+        blockArguments->elements[0] = beacon_encodeSmallInteger(accumulator);
+        blockArguments->elements[1] = beacon_encodeSmallInteger(element);
+    }
+    else
+    {
+        blockArguments->elements[0] = beacon_encodeSmallInteger(element);
+    }
+    beacon_BytecodeValue_t blockValue = beacon_compileInlineNodeWithEnvironmentAndBytecodeBuilder(context, blockNode, blockArguments, environment, builder);
+
+    switch(kind)
+    {
+    case BeaconInlinedCollectionIterationCollect:
+        {
+            beacon_BytecodeValue_t storeResult = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+            uint16_t arrayListAddJump = beacon_BytecodeCodeBuilder_jumpIfTrue(context, builder, isArrayList, 0);
+            beacon_BytecodeValue_t atPutOperands[3] = {result, index, blockValue};
+            beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, storeResult, BeaconBytecodeInlinedPrimitiveArrayAtPut, 3, atPutOperands);
+            uint16_t storeMergeJump = beacon_BytecodeCodeBuilder_jump(context, builder, 0);
+            beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, arrayListAddJump, beacon_BytecodeCodeBuilder_label(builder));
+            beacon_BytecodeCodeBuilder_sendMessage(context, builder, storeResult, result, beacon_BytecodeCodeBuilder_addLiteral(context, builder, context->roots.addSelector), 1, &blockValue);
+            beacon_BytecodeCodeBuilder_fixup_jump(context, builder, storeMergeJump, beacon_BytecodeCodeBuilder_label(builder));
+        }
+        break;
+    case BeaconInlinedCollectionIterationSelect:
+        {
+            uint16_t skipJump = beacon_BytecodeCodeBuilder_jumpIfFalse(context, builder, blockValue, 0);
+            beacon_BytecodeValue_t addResult = beacon_BytecodeCodeBuilder_newTemporary(context, builder, 0);
+            beacon_BytecodeCodeBuilder_sendMessage(context, builder, addResult, result, beacon_BytecodeCodeBuilder_addLiteral(context, builder, context->roots.addSelector), 1, &element);
+            beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, skipJump, beacon_BytecodeCodeBuilder_label(builder));
+        }
+        break;
+    case BeaconInlinedCollectionIterationInjectInto:
+        beacon_BytecodeCodeBuilder_storeValue(context, builder, accumulator, blockValue);
+        break;
+    default:
+        break;
+    }
+
+    // Increment the index
+    beacon_BytecodeValue_t incrementOperands[2] = {index, one};
+    beacon_BytecodeCodeBuilder_inlinedPrimitive(context, builder, index, BeaconBytecodeInlinedPrimitiveSmallIntegerAdd, 2, incrementOperands);
+    beacon_BytecodeCodeBuilder_jump(context, builder, loopIterationStart);
+
+    // Loop end.
+    beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, loopEndJump, beacon_BytecodeCodeBuilder_label(builder));
+    if(kind == BeaconInlinedCollectionIterationSelect)
+    {
+        // Selecting from an array answers an array.
+        uint16_t keepArrayListJump = beacon_BytecodeCodeBuilder_jumpIfTrue(context, builder, isArrayList, 0);
+        beacon_BytecodeCodeBuilder_sendMessage(context, builder, result, result, beacon_BytecodeCodeBuilder_addLiteral(context, builder, context->roots.asArraySelector), 0, NULL);
+        beacon_BytecodeCodeBuilder_fixup_jumpIf(context, builder, keepArrayListJump, beacon_BytecodeCodeBuilder_label(builder));
+    }
+    else if(kind == BeaconInlinedCollectionIterationInjectInto)
+    {
+        beacon_BytecodeCodeBuilder_storeValue(context, builder, result, accumulator);
+    }
+
+    // Merge section.
+    beacon_BytecodeCodeBuilder_fixup_jump(context, builder, fallbackMergeJump, beacon_BytecodeCodeBuilder_label(builder));
+    return beacon_encodeSmallInteger(result);
+}
+
 static beacon_oop_t beacon_SyntaxCompiler_messageSend(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     BeaconAssert(context, argumentCount == 2);
@@ -434,7 +830,7 @@ static beacon_oop_t beacon_SyntaxCompiler_messageSend(beacon_context_t *context,
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *builder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
 
-    beacon_oop_t selectorEvaluatedValue = beacon_performWith(context, (beacon_oop_t)messageSendNode->selector, context->roots.evaluateWithEnvironmentSelector, (beacon_oop_t)environment);
+    beacon_oop_t selectorEvaluatedValue = beacon_evaluateNodeWithEnvironment(context, (beacon_ParseTreeNode_t*)messageSendNode->selector, environment);
     bool receiverIsBlock = beacon_getClass(context, (beacon_oop_t)messageSendNode->receiver) == context->classes.parseTreeBlockClosureNodeClass;
     size_t argumentValueCount = messageSendNode->arguments->super.super.super.super.super.header.slotCount;
     if(receiverIsBlock)
@@ -501,6 +897,10 @@ static beacon_oop_t beacon_SyntaxCompiler_messageSend(beacon_context_t *context,
             BeaconAssert(context, argumentValueCount == 2);
             return beacon_SyntaxCompiler_toDo(context, environment, builder, receiverValue, (beacon_ParseTreeNode_t*)messageSendNode->arguments->elements[0], (beacon_ParseTreeNode_t*)messageSendNode->arguments->elements[1]);
         }
+
+        beacon_InlinedCollectionIterationKind_t collectionIterationKind = beacon_SyntaxCompiler_getInlinedCollectionIterationKind(context, selectorEvaluatedValue, messageSendNode);
+        if(collectionIterationKind != BeaconInlinedCollectionIterationNone)
+            return beacon_SyntaxCompiler_collectionIteration(context, environment, builder, receiverValue, messageSendNode, selectorEvaluatedValue, collectionIterationKind);
     }
     
 
@@ -688,7 +1088,7 @@ static beacon_oop_t beacon_SyntaxCompiler_identifierReference(beacon_context_t *
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *builder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
 
-    beacon_oop_t result = beacon_performWithWith(context, (beacon_oop_t)environment, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, identifierReference->identifier, (beacon_oop_t)builder);
+    beacon_oop_t result = beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment, identifierReference->identifier, builder);
     if(result == 0)
     {
         beacon_Symbol_t *symbol = (beacon_Symbol_t *)identifierReference->identifier;
@@ -728,7 +1128,7 @@ static beacon_oop_t beacon_SyntaxCompiler_evaluateAssignment(beacon_context_t *c
 
     beacon_ParseTreeIdentifierReferenceNode_t *storageIdentifier = (beacon_ParseTreeIdentifierReferenceNode_t*)assignmentNode->storage;
 
-    beacon_oop_t result = beacon_performWith(context, (beacon_oop_t)environment, context->roots.lookupSymbolRecursivelySelector, storageIdentifier->identifier);
+    beacon_oop_t result = beacon_lookupSymbolRecursively(context, environment, storageIdentifier->identifier);
     BeaconAssert(context, beacon_getClass(context, result) == context->classes.associationClass);
 
     beacon_Association_t *assoc = (beacon_Association_t*)result;
@@ -776,12 +1176,13 @@ static beacon_oop_t beacon_SyntaxCompiler_returnNode(beacon_context_t *context,
     return  beacon_encodeSmallInteger(0);
 }
 
-static beacon_CompiledBlock_t *beacon_SyntaxCompiler_compileBlockClosureNode(beacon_context_t *context, beacon_ParseTreeBlockClosureNode_t *blockClosureNode, beacon_AbstractCompilationEnvironment_t *environment, beacon_BytecodeCodeBuilder_t *parentBuilder, beacon_ArrayList_t **outCaptureList)
+static beacon_CompiledBlock_t *beacon_SyntaxCompiler_compileBlockClosureNode(beacon_context_t *context, beacon_ParseTreeBlockClosureNode_t *blockClosureNode, beacon_AbstractCompilationEnvironment_t *environment, beacon_BytecodeCodeBuilder_t *parentBuilder, beacon_ArrayList_t **outCaptureList, bool *outUsesReceiverSlots)
 {
     beacon_BlockClosureCompilationEnvironment_t *blockEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.blockClosureCompilationEnvironmentClass, sizeof(beacon_BlockClosureCompilationEnvironment_t), BeaconObjectKindPointers);
     blockEnvironment->parent = environment;
     blockEnvironment->dictionary = beacon_MethodDictionary_new(context);
     blockEnvironment->captureList = beacon_ArrayList_new(context);
+    blockEnvironment->usesReceiverSlots = context->roots.falseValue;
     *outCaptureList = blockEnvironment->captureList;
 
     beacon_BytecodeCodeBuilder_t *blockBuilder = beacon_BytecodeCodeBuilder_new(context, parentBuilder);
@@ -816,6 +1217,7 @@ static beacon_CompiledBlock_t *beacon_SyntaxCompiler_compileBlockClosureNode(bea
     compiledBlock->super.sourcePosition = blockClosureNode->super.sourcePosition;
     compiledBlock->captureCount = beacon_encodeSmallInteger(beacon_ArrayList_size(blockEnvironment->captureList));
 
+    *outUsesReceiverSlots = blockEnvironment->usesReceiverSlots == context->roots.trueValue;
     return compiledBlock;
 }
 
@@ -825,12 +1227,13 @@ static beacon_oop_t beacon_SyntaxCompiler_blockClosure(beacon_context_t *context
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *parentBuilder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
     beacon_ArrayList_t *captureList = NULL;
+    bool usesReceiverSlots = false;
 
-    beacon_CompiledBlock_t *compiledBlock = beacon_SyntaxCompiler_compileBlockClosureNode(context, (beacon_ParseTreeBlockClosureNode_t*)receiver, environment, parentBuilder, &captureList);
+    beacon_CompiledBlock_t *compiledBlock = beacon_SyntaxCompiler_compileBlockClosureNode(context, (beacon_ParseTreeBlockClosureNode_t*)receiver, environment, parentBuilder, &captureList, &usesReceiverSlots);
 
-    // If capture list 
+    // Clean blocks do not capture anything, so a single closure literal is shared by every activation of the method.
     size_t captureListSize = beacon_ArrayList_size(captureList);
-    if(captureListSize == 0)
+    if(captureListSize == 0 && !usesReceiverSlots)
     {
         beacon_BlockClosure_t *blockClosure = beacon_allocateObjectWithBehavior(context->heap, context->classes.blockClosureClass, sizeof(beacon_BlockClosure_t), BeaconObjectKindPointers);
         blockClosure->captures = context->roots.emptyArray;
@@ -840,7 +1243,7 @@ static beacon_oop_t beacon_SyntaxCompiler_blockClosure(beacon_context_t *context
         return beacon_encodeSmallInteger(blockClosureLiteral);
     }
 
-    // Closure with capture values.
+    // Copying block: the captured values and the receiver are copied into the closure, which is reused by the interpreter while they do not change.
     beacon_BytecodeValue_t *captures = calloc(captureListSize, sizeof(beacon_BytecodeValue_t));
     for(size_t i = 0; i < captureListSize; ++i)
         captures[i] = beacon_decodeSmallInteger(beacon_ArrayList_at(context, captureList, i + 1));
@@ -937,17 +1340,108 @@ static beacon_CompiledMethod_t *beacon_SyntaxCompiler_compileMethodNode(beacon_c
     compiledMethod->super.argumentCount = bytecode->argumentCount;
     compiledMethod->super.bytecodeImplementation = bytecode;
     compiledMethod->super.sourcePosition = methodNode->super.sourcePosition;
+    beacon_CompiledCode_detectQuickMethod(context, &compiledMethod->super);
 
     return compiledMethod;
 }
 
+static beacon_CompiledMethod_t *beacon_SyntaxCompiler_makeLazyMethod(beacon_context_t *context, beacon_ParseTreeMethodNode_t *methodNode, beacon_AbstractCompilationEnvironment_t *environment)
+{
+    beacon_CompiledMethod_t *lazyMethod = beacon_allocateObjectWithBehavior(context->heap, context->classes.compiledMethodClass, sizeof(beacon_CompiledMethod_t), BeaconObjectKindPointers);
+    lazyMethod->name = methodNode->selector;
+    lazyMethod->super.argumentCount = beacon_encodeSmallInteger(methodNode->arguments->super.super.super.super.super.header.slotCount);
+    lazyMethod->super.sourcePosition = methodNode->super.sourcePosition;
+    lazyMethod->lazyCompilationEnvironment = environment;
+    return lazyMethod;
+}
+
+// The methods whose body was skipped by the parser, and all of the methods in lazy mode, are installed as stubs that are compiled by their first invocation.
+static beacon_CompiledMethod_t *beacon_SyntaxCompiler_compileOrMakeLazyMethod(beacon_context_t *context, beacon_ParseTreeMethodNode_t *methodNode, beacon_AbstractCompilationEnvironment_t *environment, beacon_oop_t superBehavior)
+{
+    if(beacon_getClass(context, (beacon_oop_t)methodNode) == context->classes.parseTreeMethodNode && methodNode->super.sourcePosition &&
+        (!methodNode->expression || context->options.lazyMethodCompilation))
+        return beacon_SyntaxCompiler_makeLazyMethod(context, methodNode, environment);
+
+    return beacon_SyntaxCompiler_compileMethodNode(context, methodNode, environment, superBehavior);
+}
+
+beacon_CompiledMethod_t *beacon_makeLazyMethod(beacon_context_t *context, beacon_Symbol_t *selector, size_t argumentCount, beacon_SourcePosition_t *sourcePosition, beacon_Behavior_t *behavior)
+{
+    beacon_BehaviorCompilationEnvironment_t *behaviorEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.behaviorCompilationEnvironmentClass, sizeof(beacon_BehaviorCompilationEnvironment_t), BeaconObjectKindPointers);
+    behaviorEnvironment->behavior = behavior;
+    behaviorEnvironment->parent = &beacon_SyntaxCompiler_makeFileEnvironment(context, sourcePosition->sourceCode)->super;
+
+    beacon_CompiledMethod_t *lazyMethod = beacon_allocateObjectWithBehavior(context->heap, context->classes.compiledMethodClass, sizeof(beacon_CompiledMethod_t), BeaconObjectKindPointers);
+    lazyMethod->name = selector;
+    lazyMethod->super.argumentCount = beacon_encodeSmallInteger(argumentCount);
+    lazyMethod->super.sourcePosition = sourcePosition;
+    lazyMethod->lazyCompilationEnvironment = &behaviorEnvironment->super;
+    return lazyMethod;
+}
+
+bool beacon_isLazyMethod(beacon_context_t *context, beacon_CompiledCode_t *code)
+{
+    return beacon_getClass(context, (beacon_oop_t)code) == context->classes.compiledMethodClass && ((beacon_CompiledMethod_t*)code)->lazyCompilationEnvironment;
+}
+
+void beacon_compileLazyMethod(beacon_context_t *context, beacon_CompiledMethod_t *lazyMethod)
+{
+    beacon_AbstractCompilationEnvironment_t *environment = lazyMethod->lazyCompilationEnvironment;
+    beacon_SourcePosition_t *sourcePosition = lazyMethod->super.sourcePosition;
+    beacon_SourceCode_t *sourceCode = sourcePosition->sourceCode;
+
+    beacon_StackFrameRecord_t frameRecord = {
+        .kind = StackFramePrimitiveRoots,
+        .context = context,
+        .primitiveRoots = {
+            .receiver = (beacon_oop_t)lazyMethod,
+            .allocatedObjects = {
+                (beacon_oop_t)environment
+            }
+        }
+    };
+    beacon_pushStackFrameRecord(&frameRecord);
+
+    // Only the source range of the method is scanned and parsed again.
+    beacon_TokenBuffer_t tokenBuffer;
+    beacon_TokenBuffer_initialize(&tokenBuffer, sourceCode);
+    beacon_scanSourceCodeRangeIntoTokenBuffer(context, sourceCode, beacon_decodeSmallInteger(sourcePosition->startIndex), beacon_decodeSmallInteger(sourcePosition->endIndex), &tokenBuffer);
+    beacon_ParseTreeNode_t *parseTree = beacon_parseMethodBlockTokenBuffer(context, sourceCode, &tokenBuffer);
+    frameRecord.primitiveRoots.allocatedObjects[1] = (beacon_oop_t)parseTree;
+    beacon_TokenBuffer_destroy(&tokenBuffer);
+
+    beacon_oop_t superBehavior = 0;
+    if(beacon_getClass(context, (beacon_oop_t)environment) == context->classes.behaviorCompilationEnvironmentClass)
+        superBehavior = (beacon_oop_t)((beacon_BehaviorCompilationEnvironment_t*)environment)->behavior->superclass;
+
+    if(beacon_getClass(context, (beacon_oop_t)parseTree) == context->classes.parseTreeErrorNodeClass)
+    {
+        beacon_ParseTreeErrorNode_t *errorNode = (beacon_ParseTreeErrorNode_t*)parseTree;
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "Parse error %.*s\n", errorNode->errorMessage->super.super.super.super.super.header.slotCount, errorNode->errorMessage->data);
+        beacon_exception_error(context, buffer);
+    }
+    BeaconAssert(context, beacon_getClass(context, (beacon_oop_t)parseTree) == context->classes.parseTreeMethodNode);
+
+    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileMethodNode(context, (beacon_ParseTreeMethodNode_t*)parseTree, environment, superBehavior);
+
+    // Keep the identity of the installed method, because it is referenced by the method dictionaries and the inline caches.
+    lazyMethod->super.argumentCount = compiledMethod->super.argumentCount;
+    lazyMethod->super.bytecodeImplementation = compiledMethod->super.bytecodeImplementation;
+    lazyMethod->super.quickMethodKind = compiledMethod->super.quickMethodKind;
+    lazyMethod->super.quickMethodValue = compiledMethod->super.quickMethodValue;
+    lazyMethod->lazyCompilationEnvironment = NULL;
+
+    beacon_popStackFrameRecord(&frameRecord);
+}
+
 static beacon_oop_t beacon_SyntaxCompiler_methodNode(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
     BeaconAssert(context, argumentCount == 2);
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *parentBuilder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
 
-    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileMethodNode(context, (beacon_ParseTreeMethodNode_t*)receiver, environment, 0);
+    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileOrMakeLazyMethod(context, (beacon_ParseTreeMethodNode_t*)receiver, environment, 0);
     beacon_BytecodeValue_t compiledMethodLiteralValue = beacon_BytecodeCodeBuilder_addLiteral(context, parentBuilder, (beacon_oop_t)compiledMethod);
     return beacon_encodeSmallInteger(compiledMethodLiteralValue);
 }
@@ -960,18 +1454,19 @@ static beacon_oop_t beacon_SyntaxCompiler_addMethodNode(beacon_context_t *contex
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *builder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
 
-    beacon_oop_t behavior = beacon_performWith(context, (beacon_oop_t)addMethodNode->behavior, context->roots.evaluateWithEnvironmentSelector, (beacon_oop_t)environment);
+    beacon_oop_t behavior = beacon_evaluateNodeWithEnvironment(context, (beacon_ParseTreeNode_t*)addMethodNode->behavior, environment);
     // TODO: Assert for behavior.
 
     beacon_BehaviorCompilationEnvironment_t *behaviorEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.behaviorCompilationEnvironmentClass, sizeof(beacon_BehaviorCompilationEnvironment_t), BeaconObjectKindPointers);
     behaviorEnvironment->behavior = (beacon_Behavior_t*)behavior;
     behaviorEnvironment->parent = environment;
 
-    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileMethodNode(context, (beacon_ParseTreeMethodNode_t*)addMethodNode->method, &behaviorEnvironment->super, (beacon_oop_t)behaviorEnvironment->behavior->superclass);
+    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileOrMakeLazyMethod(context, (beacon_ParseTreeMethodNode_t*)addMethodNode->method, &behaviorEnvironment->super, (beacon_oop_t)behaviorEnvironment->behavior->superclass);
     beacon_Behavior_t *targetBehavior = (beacon_Behavior_t *)behavior;
     if(!targetBehavior->methodDict)
         targetBehavior->methodDict = beacon_MethodDictionary_new(context);
     beacon_MethodDictionary_atPut(context, targetBehavior->methodDict, compiledMethod->name, (beacon_oop_t)compiledMethod);
+    beacon_BytecodeCacheWriter_recordMethodInstallation(context, context->bytecodeCacheWriter, targetBehavior, compiledMethod);
 
     return beacon_encodeSmallInteger(beacon_BytecodeCodeBuilder_addLiteral(context, builder, behavior));
 }
@@ -989,7 +1484,7 @@ static beacon_oop_t beacon_SyntaxCompiler_evaluateAddMethodNode(beacon_context_t
     behaviorEnvironment->behavior = (beacon_Behavior_t*)behaviorValue;
     behaviorEnvironment->parent = environment;
 
-    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileMethodNode(context, (beacon_ParseTreeMethodNode_t*)addMethodNode->method, &behaviorEnvironment->super, (beacon_oop_t)behaviorEnvironment->behavior->superclass);
+    beacon_CompiledMethod_t *compiledMethod = beacon_SyntaxCompiler_compileOrMakeLazyMethod(context, (beacon_ParseTreeMethodNode_t*)addMethodNode->method, &behaviorEnvironment->super, (beacon_oop_t)behaviorEnvironment->behavior->superclass);
     beacon_Behavior_t *targetBehavior = (beacon_Behavior_t *)behaviorValue;
     if(!targetBehavior->methodDict)
         targetBehavior->methodDict = beacon_MethodDictionary_new(context);
@@ -1031,7 +1526,7 @@ static beacon_oop_t beacon_SyntaxCompiler_byteArrayNode(beacon_context_t *contex
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *builder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
 
-    beacon_oop_t value = beacon_performWith(context, (beacon_oop_t)byteArrayNode, context->roots.evaluateWithEnvironmentSelector, (beacon_oop_t)environment);
+    beacon_oop_t value = beacon_evaluateNodeWithEnvironment(context, (beacon_ParseTreeNode_t*)byteArrayNode, environment);
     return beacon_encodeSmallInteger(beacon_BytecodeCodeBuilder_addLiteral(context, builder, value));
 }
 
@@ -1043,7 +1538,7 @@ static beacon_oop_t beacon_SyntaxCompiler_literalArrayNode(beacon_context_t *con
     beacon_AbstractCompilationEnvironment_t *environment = (beacon_AbstractCompilationEnvironment_t*)arguments[0];
     beacon_BytecodeCodeBuilder_t *builder = (beacon_BytecodeCodeBuilder_t *)arguments[1];
 
-    beacon_oop_t value = beacon_performWith(context, (beacon_oop_t)literalArrayNode, context->roots.evaluateWithEnvironmentSelector, (beacon_oop_t)environment);
+    beacon_oop_t value = beacon_evaluateNodeWithEnvironment(context, (beacon_ParseTreeNode_t*)literalArrayNode, environment);
     return beacon_encodeSmallInteger(beacon_BytecodeCodeBuilder_addLiteral(context, builder, value));
 }
 
@@ -1071,7 +1566,7 @@ static beacon_oop_t beacon_SystemCompilationEnvironment_lookupSymbolRecursivelyW
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWithWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, (beacon_oop_t)symbolToSearch, (beacon_oop_t)bytecodeBuilder);
+    return beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment->parent, (beacon_oop_t)symbolToSearch, bytecodeBuilder);
 }
 
 static beacon_oop_t beacon_FileCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1089,7 +1584,7 @@ static beacon_oop_t beacon_FileCompilationEnvironment_lookupSymbolRecursivelyWit
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWithWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, (beacon_oop_t)symbolToSearch, (beacon_oop_t)bytecodeBuilder);
+    return beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment->parent, (beacon_oop_t)symbolToSearch, bytecodeBuilder);
 }
 
 
@@ -1108,7 +1603,7 @@ static beacon_oop_t beacon_LexicalCompilationEnvironment_lookupSymbolRecursively
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWithWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, (beacon_oop_t)symbolToSearch, (beacon_oop_t)bytecodeBuilder);
+    return beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment->parent, (beacon_oop_t)symbolToSearch, bytecodeBuilder);
 }
 
 static beacon_oop_t beacon_BehaviorCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1136,7 +1631,7 @@ static beacon_oop_t beacon_BehaviorCompilationEnvironment_lookupSymbolRecursivel
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWithWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, (beacon_oop_t)symbolToSearch, (beacon_oop_t)bytecodeBuilder);
+    return beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment->parent, (beacon_oop_t)symbolToSearch, bytecodeBuilder);
 }
 
 static beacon_oop_t beacon_MethodCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1154,7 +1649,7 @@ static beacon_oop_t beacon_MethodCompilationEnvironment_lookupSymbolRecursivelyW
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWithWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, (beacon_oop_t)symbolToSearch, (beacon_oop_t)bytecodeBuilder);
+    return beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment->parent, (beacon_oop_t)symbolToSearch, bytecodeBuilder);
 }
 
 static beacon_oop_t beacon_BlockClosureCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1175,7 +1670,7 @@ static beacon_oop_t beacon_BlockClosureCompilationEnvironment_lookupSymbolRecurs
     BeaconAssert(context, bytecodeBuilder->parentBuilder);
     beacon_BytecodeCodeBuilder_t *parentBuilder = (beacon_BytecodeCodeBuilder_t *)bytecodeBuilder->parentBuilder;
 
-    beacon_oop_t parentResultOop = beacon_performWithWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelyWithBytecodeBuilderSelector, (beacon_oop_t)symbolToSearch, (beacon_oop_t)parentBuilder);
+    beacon_oop_t parentResultOop = beacon_lookupSymbolRecursivelyWithBytecodeBuilder(context, environment->parent, (beacon_oop_t)symbolToSearch, parentBuilder);
 
     beacon_BytecodeValue_t parentValue = beacon_decodeSmallInteger(parentResultOop);
     beacon_BytecodeValueType_t parentValueType = beacon_BytecodeValue_getType(parentValue);
@@ -1187,12 +1682,15 @@ static beacon_oop_t beacon_BlockClosureCompilationEnvironment_lookupSymbolRecurs
     case BytecodeArgumentTypeLiteral:
         {
             beacon_oop_t parentLiteral = beacon_ArrayList_at(context, parentBuilder->literals, parentValueIndex);
-            return beacon_BytecodeCodeBuilder_addLiteral(context, bytecodeBuilder, parentLiteral);
+            return beacon_encodeSmallInteger(beacon_BytecodeCodeBuilder_addLiteral(context, bytecodeBuilder, parentLiteral));
         }
+    case BytecodeArgumentTypeReceiverSlot:
+        // The closure runs with the receiver of its home method, so the slots are accessed in place, and they can be assigned.
+        environment->usesReceiverSlots = context->roots.trueValue;
+        return parentResultOop;
     case BytecodeArgumentTypeArgument:
     case BytecodeArgumentTypeTemporary:
     case BytecodeArgumentTypeCapture:
-    case BytecodeArgumentTypeReceiverSlot:
         {
             beacon_ArrayList_add(context, environment->captureList, parentResultOop);
             beacon_BytecodeValue_t captureValue = beacon_BytecodeCodeBuilder_newCapture(context, bytecodeBuilder);
@@ -1231,7 +1729,7 @@ static beacon_oop_t beacon_SystemCompilationEnvironment_lookupSymbolRecursively(
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelySelector, (beacon_oop_t)symbolToSearch);
+    return beacon_lookupSymbolRecursively(context, environment->parent, (beacon_oop_t)symbolToSearch);
 }
 
 static beacon_oop_t beacon_FileCompilationEnvironment_lookupSymbolRecursively(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1248,7 +1746,7 @@ static beacon_oop_t beacon_FileCompilationEnvironment_lookupSymbolRecursively(be
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelySelector, (beacon_oop_t)symbolToSearch);
+    return beacon_lookupSymbolRecursively(context, environment->parent, (beacon_oop_t)symbolToSearch);
 }
 
 static beacon_oop_t beacon_LexicalCompilationEnvironment_lookupSymbolRecursively(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1265,7 +1763,7 @@ static beacon_oop_t beacon_LexicalCompilationEnvironment_lookupSymbolRecursively
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelySelector, (beacon_oop_t)symbolToSearch);
+    return beacon_lookupSymbolRecursively(context, environment->parent, (beacon_oop_t)symbolToSearch);
 }
 
 static beacon_oop_t beacon_MethodCompilationEnvironment_lookupSymbolRecursively(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1282,7 +1780,7 @@ static beacon_oop_t beacon_MethodCompilationEnvironment_lookupSymbolRecursively(
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelySelector, (beacon_oop_t)symbolToSearch);
+    return beacon_lookupSymbolRecursively(context, environment->parent, (beacon_oop_t)symbolToSearch);
 }
 
 static beacon_oop_t beacon_BlockClosureCompilationEnvironment_lookupSymbolRecursively(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
@@ -1299,7 +1797,156 @@ static beacon_oop_t beacon_BlockClosureCompilationEnvironment_lookupSymbolRecurs
     }
 
     BeaconAssert(context, environment->parent);
-    return beacon_performWith(context, (beacon_oop_t)environment->parent, context->roots.lookupSymbolRecursivelySelector, (beacon_oop_t)symbolToSearch);
+    return beacon_lookupSymbolRecursively(context, environment->parent, (beacon_oop_t)symbolToSearch);
+}
+
+size_t beacon_compileFileSyntaxMethods(beacon_context_t *context, beacon_ParseTreeNode_t *parseTree, beacon_SourceCode_t *sourceCode)
+{
+    beacon_FileCompilationEnvironment_t *fileEnvironment = beacon_SyntaxCompiler_makeFileEnvironment(context, sourceCode);
+
+    beacon_StackFrameRecord_t frameRecord = {
+        .kind = StackFramePrimitiveRoots,
+        .context = context,
+        .primitiveRoots = {
+            .receiver = (beacon_oop_t)parseTree,
+            .allocatedObjects = {
+                (beacon_oop_t)fileEnvironment
+            }
+        }
+    };
+    beacon_pushStackFrameRecord(&frameRecord);
+
+    beacon_ParseTreeNode_t *expression = parseTree;
+    if(beacon_getClass(context, (beacon_oop_t)expression) == context->classes.parseTreeWorkspaceScriptNode)
+        expression = ((beacon_ParseTreeWorkspaceScriptNode_t *)expression)->expression;
+
+    size_t statementCount = 1;
+    beacon_ParseTreeNode_t **statements = &expression;
+    if(beacon_getClass(context, (beacon_oop_t)expression) == context->classes.parseTreeSequenceNodeClass)
+    {
+        beacon_ParseTreeSequenceNode_t *sequenceNode = (beacon_ParseTreeSequenceNode_t *)expression;
+        statementCount = sequenceNode->elements->super.super.super.super.super.header.slotCount;
+        statements = (beacon_ParseTreeNode_t **)sequenceNode->elements->elements;
+    }
+
+    size_t compiledMethodCount = 0;
+    for(size_t i = 0; i < statementCount; ++i)
+    {
+        if(beacon_getClass(context, (beacon_oop_t)statements[i]) != context->classes.parseTreeAddMethodNodeClass)
+            continue;
+
+        beacon_ParseTreeAddMethod_t *addMethodNode = (beacon_ParseTreeAddMethod_t *)statements[i];
+        beacon_oop_t behaviorValue = beacon_evaluateNodeWithEnvironment(context, addMethodNode->behavior, &fileEnvironment->super);
+
+        beacon_BehaviorCompilationEnvironment_t *behaviorEnvironment = beacon_allocateObjectWithBehavior(context->heap, context->classes.behaviorCompilationEnvironmentClass, sizeof(beacon_BehaviorCompilationEnvironment_t), BeaconObjectKindPointers);
+        behaviorEnvironment->behavior = (beacon_Behavior_t*)behaviorValue;
+        behaviorEnvironment->parent = &fileEnvironment->super;
+        frameRecord.primitiveRoots.allocatedObjects[1] = (beacon_oop_t)behaviorEnvironment;
+
+        beacon_SyntaxCompiler_compileMethodNode(context, (beacon_ParseTreeMethodNode_t*)addMethodNode->method, &behaviorEnvironment->super, (beacon_oop_t)behaviorEnvironment->behavior->superclass);
+        ++compiledMethodCount;
+    }
+
+    beacon_popStackFrameRecord(&frameRecord);
+    return compiledMethodCount;
+}
+
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInCompileFunction(beacon_context_t *context, beacon_Behavior_t *nodeClass)
+{
+    if(nodeClass == context->classes.parseTreeMessageSendNodeClass)
+        return beacon_SyntaxCompiler_messageSend;
+    else if(nodeClass == context->classes.parseTreeIdentifierReferenceNodeClass)
+        return beacon_SyntaxCompiler_identifierReference;
+    else if(nodeClass == context->classes.parseTreeLiteralNodeClass)
+        return beacon_SyntaxCompiler_literal;
+    else if(nodeClass == context->classes.parseTreeSequenceNodeClass)
+        return beacon_SyntaxCompiler_sequenceNode;
+    else if(nodeClass == context->classes.parseTreeAssignmentNodeClass)
+        return beacon_SyntaxCompiler_temporaryAssignment;
+    else if(nodeClass == context->classes.parseTreeReturnNodeClass)
+        return beacon_SyntaxCompiler_returnNode;
+    else if(nodeClass == context->classes.parseTreeBlockClosureNodeClass)
+        return beacon_SyntaxCompiler_blockClosure;
+    else if(nodeClass == context->classes.parseTreeMessageCascadeNodeClass)
+        return beacon_SyntaxCompiler_messageCascade;
+    else if(nodeClass == context->classes.parseTreeArrayNodeClass)
+        return beacon_SyntaxCompiler_arrayNode;
+    else if(nodeClass == context->classes.parseTreeLiteralArrayNodeClass)
+        return beacon_SyntaxCompiler_literalArrayNode;
+    else if(nodeClass == context->classes.parseTreeByteArrayNodeClass)
+        return beacon_SyntaxCompiler_byteArrayNode;
+    else if(nodeClass == context->classes.parseTreeAddMethodNodeClass)
+        return beacon_SyntaxCompiler_addMethodNode;
+    else if(nodeClass == context->classes.parseTreeMethodNode)
+        return beacon_SyntaxCompiler_methodNode;
+    else if(nodeClass == context->classes.parseTreeWorkspaceScriptNode)
+        return beacon_SyntaxCompiler_workspaceScript;
+    else if(nodeClass == context->classes.parseTreeErrorNodeClass)
+        return beacon_SyntaxCompiler_error;
+    else if(nodeClass == context->classes.parseTreeNodeClass)
+        return beacon_SyntaxCompiler_node;
+    return NULL;
+}
+
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInEvaluateFunction(beacon_context_t *context, beacon_Behavior_t *nodeClass)
+{
+    if(nodeClass == context->classes.parseTreeMessageSendNodeClass)
+        return beacon_SyntaxCompiler_evaluateMessageSend;
+    else if(nodeClass == context->classes.parseTreeIdentifierReferenceNodeClass)
+        return beacon_SyntaxCompiler_evaluateIdentifierReference;
+    else if(nodeClass == context->classes.parseTreeLiteralNodeClass)
+        return beacon_SyntaxCompiler_evaluateLiteralNode;
+    else if(nodeClass == context->classes.parseTreeSequenceNodeClass)
+        return beacon_SyntaxCompiler_evaluateSequenceNode;
+    else if(nodeClass == context->classes.parseTreeAssignmentNodeClass)
+        return beacon_SyntaxCompiler_evaluateAssignment;
+    else if(nodeClass == context->classes.parseTreeMessageCascadeNodeClass)
+        return beacon_SyntaxCompiler_evaluateMessageCascade;
+    else if(nodeClass == context->classes.parseTreeLiteralArrayNodeClass)
+        return beacon_SyntaxCompiler_evaluateLiteralArray;
+    else if(nodeClass == context->classes.parseTreeAddMethodNodeClass)
+        return beacon_SyntaxCompiler_evaluateAddMethodNode;
+    else if(nodeClass == context->classes.parseTreeWorkspaceScriptNode)
+        return beacon_SyntaxCompiler_evaluateWorkspaceScript;
+    else if(nodeClass == context->classes.parseTreeNodeClass)
+        return beacon_SyntaxCompiler_evaluateNode;
+    return NULL;
+}
+
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInLookupSymbolWithBytecodeBuilderFunction(beacon_context_t *context, beacon_Behavior_t *environmentClass)
+{
+    if(environmentClass == context->classes.lexicalCompilationEnvironmentClass)
+        return beacon_LexicalCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    else if(environmentClass == context->classes.methodCompilationEnvironmentClass)
+        return beacon_MethodCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    else if(environmentClass == context->classes.blockClosureCompilationEnvironmentClass)
+        return beacon_BlockClosureCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    else if(environmentClass == context->classes.behaviorCompilationEnvironmentClass)
+        return beacon_BehaviorCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    else if(environmentClass == context->classes.fileCompilationEnvironmentClass)
+        return beacon_FileCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    else if(environmentClass == context->classes.systemCompilationEnvironmentClass)
+        return beacon_SystemCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    else if(environmentClass == context->classes.emptyCompilationEnvironmentClass)
+        return beacon_EmptyCompilationEnvironment_lookupSymbolRecursivelyWithCodeBuilder;
+    return NULL;
+}
+
+static beacon_NativeCodeFunction_t beacon_SyntaxCompiler_getBuiltInLookupSymbolFunction(beacon_context_t *context, beacon_Behavior_t *environmentClass)
+{
+    if(environmentClass == context->classes.lexicalCompilationEnvironmentClass)
+        return beacon_LexicalCompilationEnvironment_lookupSymbolRecursively;
+    else if(environmentClass == context->classes.methodCompilationEnvironmentClass)
+        return beacon_MethodCompilationEnvironment_lookupSymbolRecursively;
+    else if(environmentClass == context->classes.blockClosureCompilationEnvironmentClass)
+        return beacon_BlockClosureCompilationEnvironment_lookupSymbolRecursively;
+    else if(environmentClass == context->classes.fileCompilationEnvironmentClass)
+        return beacon_FileCompilationEnvironment_lookupSymbolRecursively;
+    else if(environmentClass == context->classes.systemCompilationEnvironmentClass)
+        return beacon_SystemCompilationEnvironment_lookupSymbolRecursively;
+    else if(environmentClass == context->classes.emptyCompilationEnvironmentClass)
+        return beacon_EmptyCompilationEnvironment_lookupSymbolRecursively;
+    return NULL;
 }
 
 void beacon_context_registerParseTreeCompilationPrimitives(beacon_context_t *context)
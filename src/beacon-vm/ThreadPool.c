@@ -0,0 +1,340 @@
+#include "beacon-lang/ThreadPool.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/Exceptions.h"
+#include "beacon-lang/Process.h"
+#include <stdlib.h>
+#include <time.h>
+#include <threads.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * The threads that run the tasks of every context. They are started on the first task, and they live until the process exits.
+ */
+typedef struct beacon_ThreadPool_s
+{
+    mtx_t mutex;
+    cnd_t taskAvailable;
+    beacon_AsyncTask_t *firstQueuedTask;
+    beacon_AsyncTask_t *lastQueuedTask;
+    size_t threadCount;
+} beacon_ThreadPool_t;
+
+/**
+ * The tasks of a context. The tasks that are not complete are in a list that only the thread of the context uses,
+ * and the pool threads queue the tasks that they have finished running under the mutex.
+ */
+struct beacon_AsyncTasks_s
+{
+    beacon_AsyncTask_t *firstTask;
+
+    mtx_t mutex;
+    cnd_t taskFinished;
+    size_t runningTaskCount;
+    beacon_AsyncTask_t *firstFinishedTask;
+    beacon_AsyncTask_t *lastFinishedTask;
+    beacon_AsyncTasksWakeUpFunction_t wakeUpFunction;
+};
+
+static beacon_ThreadPool_t beacon_threadPool;
+static once_flag beacon_threadPoolOnceFlag = ONCE_FLAG_INIT;
+
+size_t beacon_getProcessorCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors;
+#else
+    long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    return processorCount > 0 ? (size_t)processorCount : 1;
+#endif
+}
+
+static void beacon_AsyncTasks_addFinished(beacon_AsyncTasks_t *tasks, beacon_AsyncTask_t *task)
+{
+    beacon_context_t *context = task->context;
+    mtx_lock(&tasks->mutex);
+    task->nextInQueue = NULL;
+    if(tasks->lastFinishedTask)
+        tasks->lastFinishedTask->nextInQueue = task;
+    else
+        tasks->firstFinishedTask = task;
+    tasks->lastFinishedTask = task;
+    --tasks->runningTaskCount;
+    cnd_broadcast(&tasks->taskFinished);
+    beacon_AsyncTasksWakeUpFunction_t wakeUpFunction = tasks->wakeUpFunction;
+    mtx_unlock(&tasks->mutex);
+
+    if(wakeUpFunction)
+        wakeUpFunction(context);
+}
+
+static int beacon_ThreadPool_run(void *argument)
+{
+    beacon_ThreadPool_t *pool = (beacon_ThreadPool_t *)argument;
+    for(;;)
+    {
+        mtx_lock(&pool->mutex);
+        while(!pool->firstQueuedTask)
+            cnd_wait(&pool->taskAvailable, &pool->mutex);
+
+        beacon_AsyncTask_t *task = pool->firstQueuedTask;
+        pool->firstQueuedTask = task->nextInQueue;
+        if(!pool->firstQueuedTask)
+            pool->lastQueuedTask = NULL;
+        mtx_unlock(&pool->mutex);
+
+        task->run(task);
+        beacon_AsyncTasks_addFinished(task->context->asyncTasks, task);
+    }
+
+    return 0;
+}
+
+static void beacon_ThreadPool_start(void)
+{
+    beacon_ThreadPool_t *pool = &beacon_threadPool;
+    mtx_init(&pool->mutex, mtx_plain);
+    cnd_init(&pool->taskAvailable);
+
+    size_t threadCount = beacon_getProcessorCount();
+    for(size_t i = 0; i < threadCount; ++i)
+    {
+        thrd_t thread;
+        if(thrd_create(&thread, beacon_ThreadPool_run, pool) != thrd_success)
+            break;
+        thrd_detach(thread);
+        ++pool->threadCount;
+    }
+}
+
+static beacon_AsyncTasks_t *beacon_AsyncTasks_get(beacon_context_t *context)
+{
+    if(!context->asyncTasks)
+    {
+        context->asyncTasks = calloc(1, sizeof(beacon_AsyncTasks_t));
+        mtx_init(&context->asyncTasks->mutex, mtx_plain);
+        cnd_init(&context->asyncTasks->taskFinished);
+    }
+
+    return context->asyncTasks;
+}
+
+static void beacon_AsyncTask_free(beacon_AsyncTask_t *task)
+{
+    if(task->destroy)
+        task->destroy(task);
+    else
+        free(task);
+}
+
+static void beacon_AsyncTask_register(beacon_context_t *context, beacon_AsyncTask_t *task)
+{
+    beacon_Semaphore_t *semaphore = beacon_allocateObjectWithBehavior(context->heap, context->classes.semaphoreClass, sizeof(beacon_Semaphore_t), BeaconObjectKindPointers);
+    semaphore->excessSignals = beacon_encodeSmallInteger(0);
+    beacon_Future_t *future = beacon_allocateObjectWithBehavior(context->heap, context->classes.futureClass, sizeof(beacon_Future_t), BeaconObjectKindPointers);
+    future->isDone = context->roots.falseValue;
+    future->semaphore = (beacon_oop_t)semaphore;
+
+    beacon_AsyncTasks_t *tasks = beacon_AsyncTasks_get(context);
+    task->context = context;
+    task->future = (beacon_oop_t)future;
+    task->errorMessage = NULL;
+    task->previousInContext = NULL;
+    task->nextInContext = tasks->firstTask;
+    if(tasks->firstTask)
+        tasks->firstTask->previousInContext = task;
+    tasks->firstTask = task;
+
+    mtx_lock(&tasks->mutex);
+    ++tasks->runningTaskCount;
+    mtx_unlock(&tasks->mutex);
+}
+
+beacon_oop_t beacon_AsyncTask_start(beacon_context_t *context, beacon_AsyncTask_t *task)
+{
+    call_once(&beacon_threadPoolOnceFlag, beacon_ThreadPool_start);
+    beacon_ThreadPool_t *pool = &beacon_threadPool;
+    if(!pool->threadCount)
+    {
+        beacon_AsyncTask_free(task);
+        beacon_exception_error(context, "Failed to create the threads of the thread pool.");
+    }
+
+    beacon_AsyncTask_register(context, task);
+    mtx_lock(&pool->mutex);
+    task->nextInQueue = NULL;
+    if(pool->lastQueuedTask)
+        pool->lastQueuedTask->nextInQueue = task;
+    else
+        pool->firstQueuedTask = task;
+    pool->lastQueuedTask = task;
+    cnd_signal(&pool->taskAvailable);
+    mtx_unlock(&pool->mutex);
+
+    return task->future;
+}
+
+beacon_oop_t beacon_AsyncTask_startWaiting(beacon_context_t *context, beacon_AsyncTask_t *task)
+{
+    beacon_AsyncTask_register(context, task);
+    return task->future;
+}
+
+void beacon_AsyncTask_finish(beacon_AsyncTask_t *task)
+{
+    beacon_AsyncTasks_addFinished(task->context->asyncTasks, task);
+}
+
+static void beacon_AsyncTasks_removeTask(beacon_AsyncTasks_t *tasks, beacon_AsyncTask_t *task)
+{
+    if(task->previousInContext)
+        task->previousInContext->nextInContext = task->nextInContext;
+    else
+        tasks->firstTask = task->nextInContext;
+    if(task->nextInContext)
+        task->nextInContext->previousInContext = task->previousInContext;
+    task->previousInContext = task->nextInContext = NULL;
+}
+
+void beacon_AsyncTasks_completeFinished(beacon_context_t *context)
+{
+    beacon_AsyncTasks_t *tasks = context->asyncTasks;
+    if(!tasks)
+        return;
+
+    mtx_lock(&tasks->mutex);
+    beacon_AsyncTask_t *finishedTask = tasks->firstFinishedTask;
+    tasks->firstFinishedTask = tasks->lastFinishedTask = NULL;
+    mtx_unlock(&tasks->mutex);
+
+    while(finishedTask)
+    {
+        beacon_AsyncTask_t *task = finishedTask;
+        finishedTask = task->nextInQueue;
+        beacon_AsyncTasks_removeTask(tasks, task);
+
+        beacon_Future_t *future = (beacon_Future_t *)task->future;
+        if(!task->errorMessage && task->complete)
+            future->value = task->complete(context, task);
+        if(task->errorMessage)
+            future->error = (beacon_oop_t)beacon_importCString(context, task->errorMessage);
+        future->isDone = context->roots.trueValue;
+        beacon_AsyncTask_free(task);
+
+        beacon_Semaphore_signalWithoutPreemption(context, future->semaphore);
+    }
+}
+
+bool beacon_AsyncTasks_waitForFinished(beacon_context_t *context, int64_t timeoutMicroseconds)
+{
+    beacon_AsyncTasks_t *tasks = context->asyncTasks;
+    if(!tasks)
+        return false;
+
+    mtx_lock(&tasks->mutex);
+    if(!tasks->firstFinishedTask && !tasks->runningTaskCount)
+    {
+        mtx_unlock(&tasks->mutex);
+        return false;
+    }
+
+    if(timeoutMicroseconds < 0)
+    {
+        while(!tasks->firstFinishedTask)
+            cnd_wait(&tasks->taskFinished, &tasks->mutex);
+    }
+    else if(!tasks->firstFinishedTask && timeoutMicroseconds > 0)
+    {
+        struct timespec deadline;
+        timespec_get(&deadline, TIME_UTC);
+        deadline.tv_sec += timeoutMicroseconds / 1000000;
+        deadline.tv_nsec += (timeoutMicroseconds % 1000000) * 1000;
+        if(deadline.tv_nsec >= 1000000000)
+        {
+            ++deadline.tv_sec;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while(!tasks->firstFinishedTask)
+        {
+            if(cnd_timedwait(&tasks->taskFinished, &tasks->mutex, &deadline) != thrd_success)
+                break;
+        }
+    }
+
+    mtx_unlock(&tasks->mutex);
+    return true;
+}
+
+void beacon_AsyncTasks_setWakeUpFunction(beacon_context_t *context, beacon_AsyncTasksWakeUpFunction_t wakeUpFunction)
+{
+    if(!wakeUpFunction && !context->asyncTasks)
+        return;
+
+    beacon_AsyncTasks_t *tasks = beacon_AsyncTasks_get(context);
+    mtx_lock(&tasks->mutex);
+    tasks->wakeUpFunction = wakeUpFunction;
+    mtx_unlock(&tasks->mutex);
+}
+
+void beacon_AsyncTasks_markRoots(beacon_context_t *context)
+{
+    beacon_AsyncTasks_t *tasks = context->asyncTasks;
+    if(!tasks)
+        return;
+
+    for(beacon_AsyncTask_t *task = tasks->firstTask; task; task = task->nextInContext)
+    {
+        beacon_heap_pushReachableObject(context->heap, task->future);
+        for(size_t i = 0; i < sizeof(task->roots) / sizeof(task->roots[0]); ++i)
+            beacon_heap_pushReachableObject(context->heap, task->roots[i]);
+    }
+}
+
+void beacon_AsyncTasks_destroy(beacon_context_t *context)
+{
+    beacon_AsyncTasks_t *tasks = context->asyncTasks;
+    if(!tasks)
+        return;
+
+    // The running tasks may still be writing into the bytes of their roots.
+    mtx_lock(&tasks->mutex);
+    while(tasks->runningTaskCount)
+        cnd_wait(&tasks->taskFinished, &tasks->mutex);
+    mtx_unlock(&tasks->mutex);
+
+    while(tasks->firstTask)
+    {
+        beacon_AsyncTask_t *task = tasks->firstTask;
+        beacon_AsyncTasks_removeTask(tasks, task);
+        beacon_AsyncTask_free(task);
+    }
+
+    cnd_destroy(&tasks->taskFinished);
+    mtx_destroy(&tasks->mutex);
+    free(tasks);
+    context->asyncTasks = NULL;
+}
+
+static beacon_oop_t beacon_Future_isDone(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+
+    // The futures are completed by the scheduler, which does not run while a single process polls.
+    beacon_AsyncTasks_completeFinished(context);
+    return ((beacon_Future_t *)receiver)->isDone == context->roots.trueValue ? context->roots.trueValue : context->roots.falseValue;
+}
+
+void beacon_context_registerThreadPoolPrimitives(beacon_context_t *context)
+{
+    beacon_addPrimitiveToClass(context, context->classes.futureClass, "isDone", 0, beacon_Future_isDone);
+}
@@ -0,0 +1,389 @@
+#include "beacon-lang/TimerWheel.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/Exceptions.h"
+#include "beacon-lang/Process.h"
+#include <stdlib.h>
+#include <time.h>
+
+uint64_t beacon_getMonotonicClockNanoseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec*1000000000u + (uint64_t)now.tv_nsec;
+}
+
+uint64_t beacon_getMonotonicClockMicroseconds(void)
+{
+    return beacon_getMonotonicClockNanoseconds() / 1000u;
+}
+
+beacon_TimerWheel_t *beacon_TimerWheel_get(beacon_context_t *context)
+{
+    if(!context->timerWheel)
+    {
+        context->timerWheel = calloc(1, sizeof(beacon_TimerWheel_t));
+        context->timerWheel->currentTime = beacon_getMonotonicClockMicroseconds();
+    }
+
+    return context->timerWheel;
+}
+
+static void beacon_TimerWheelSlot_add(beacon_TimerWheelSlot_t *slot, beacon_TimerWheelEntry_t *entry)
+{
+    entry->slot = slot;
+    entry->previous = slot->last;
+    entry->next = NULL;
+    if(slot->last)
+        slot->last->next = entry;
+    else
+        slot->first = entry;
+    slot->last = entry;
+}
+
+static void beacon_TimerWheel_place(beacon_TimerWheel_t *wheel, beacon_TimerWheelEntry_t *entry)
+{
+    // The timers that are already due fire on the next advance.
+    if(entry->expirationTime <= wheel->currentTime)
+    {
+        beacon_TimerWheelSlot_add(&wheel->expired, entry);
+        return;
+    }
+
+    // The level is given by the highest digit where the expiration time differs from the current time, so the slot is always ahead of the current one.
+    uint64_t difference = entry->expirationTime ^ wheel->currentTime;
+    for(size_t level = 0; level < BEACON_TIMER_WHEEL_LEVEL_COUNT; ++level)
+    {
+        if(difference >> ((level + 1) * BEACON_TIMER_WHEEL_SLOT_BITS))
+            continue;
+
+        size_t slotIndex = (entry->expirationTime >> (level * BEACON_TIMER_WHEEL_SLOT_BITS)) & (BEACON_TIMER_WHEEL_SLOT_COUNT - 1);
+        beacon_TimerWheelSlot_add(&wheel->slots[level][slotIndex], entry);
+        wheel->occupiedSlots[level][slotIndex / 64] |= (uint64_t)1 << (slotIndex % 64);
+        return;
+    }
+
+    beacon_TimerWheelSlot_add(&wheel->overflow, entry);
+}
+
+static void beacon_TimerWheel_remove(beacon_TimerWheel_t *wheel, beacon_TimerWheelEntry_t *entry)
+{
+    beacon_TimerWheelSlot_t *slot = entry->slot;
+    if(entry->previous)
+        entry->previous->next = entry->next;
+    else
+        slot->first = entry->next;
+    if(entry->next)
+        entry->next->previous = entry->previous;
+    else
+        slot->last = entry->previous;
+    entry->previous = entry->next = NULL;
+    entry->slot = NULL;
+
+    ptrdiff_t slotIndex = slot - &wheel->slots[0][0];
+    if(!slot->first && slotIndex >= 0 && slotIndex < BEACON_TIMER_WHEEL_LEVEL_COUNT*BEACON_TIMER_WHEEL_SLOT_COUNT)
+    {
+        size_t level = slotIndex / BEACON_TIMER_WHEEL_SLOT_COUNT;
+        size_t levelSlotIndex = slotIndex % BEACON_TIMER_WHEEL_SLOT_COUNT;
+        wheel->occupiedSlots[level][levelSlotIndex / 64] &= ~((uint64_t)1 << (levelSlotIndex % 64));
+    }
+}
+
+void beacon_TimerWheel_schedule(beacon_TimerWheel_t *wheel, beacon_TimerWheelEntry_t *entry, uint64_t expirationTime)
+{
+    if(entry->slot)
+        beacon_TimerWheel_cancel(wheel, entry);
+
+    entry->expirationTime = expirationTime;
+    beacon_TimerWheel_place(wheel, entry);
+    ++wheel->timerCount;
+}
+
+void beacon_TimerWheel_cancel(beacon_TimerWheel_t *wheel, beacon_TimerWheelEntry_t *entry)
+{
+    if(!entry->slot)
+        return;
+
+    if(entry->slot != &wheel->firedBlocks)
+        --wheel->timerCount;
+    beacon_TimerWheel_remove(wheel, entry);
+}
+
+static inline size_t beacon_countTrailingZeros64(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    size_t count = 0;
+    while(!(word & 1))
+    {
+        word >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Returns the index of the first occupied slot of a level after a given one, or -1.
+ */
+static intptr_t beacon_TimerWheel_findOccupiedSlotAfter(beacon_TimerWheel_t *wheel, size_t level, size_t slotIndex)
+{
+    for(size_t index = slotIndex + 1; index < BEACON_TIMER_WHEEL_SLOT_COUNT; )
+    {
+        uint64_t word = wheel->occupiedSlots[level][index / 64] >> (index % 64);
+        if(word)
+            return index + beacon_countTrailingZeros64(word);
+        index = (index / 64 + 1) * 64;
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the next time where a slot that holds timers is reached. This either fires the timers of the first level, or moves the timers of a higher level down.
+ */
+static bool beacon_TimerWheel_nextEventTime(beacon_TimerWheel_t *wheel, uint64_t *outTime)
+{
+    bool found = false;
+    uint64_t eventTime = UINT64_MAX;
+    for(size_t level = 0; level < BEACON_TIMER_WHEEL_LEVEL_COUNT; ++level)
+    {
+        size_t shift = level * BEACON_TIMER_WHEEL_SLOT_BITS;
+        size_t currentSlotIndex = (wheel->currentTime >> shift) & (BEACON_TIMER_WHEEL_SLOT_COUNT - 1);
+        intptr_t slotIndex = beacon_TimerWheel_findOccupiedSlotAfter(wheel, level, currentSlotIndex);
+        if(slotIndex < 0)
+            continue;
+
+        size_t levelSpanShift = shift + BEACON_TIMER_WHEEL_SLOT_BITS;
+        uint64_t slotTime = ((wheel->currentTime >> levelSpanShift) << levelSpanShift) | ((uint64_t)slotIndex << shift);
+        if(slotTime < eventTime)
+            eventTime = slotTime;
+        found = true;
+    }
+
+    if(wheel->overflow.first)
+    {
+        size_t spanShift = BEACON_TIMER_WHEEL_LEVEL_COUNT * BEACON_TIMER_WHEEL_SLOT_BITS;
+        uint64_t wrapTime = ((wheel->currentTime >> spanShift) + 1) << spanShift;
+        if(wrapTime < eventTime)
+            eventTime = wrapTime;
+        found = true;
+    }
+
+    *outTime = eventTime;
+    return found;
+}
+
+bool beacon_TimerWheel_nextWakeUpTime(beacon_TimerWheel_t *wheel, uint64_t *outTime)
+{
+    if(wheel->expired.first)
+    {
+        *outTime = wheel->currentTime;
+        return true;
+    }
+
+    return beacon_TimerWheel_nextEventTime(wheel, outTime);
+}
+
+static void beacon_TimerWheel_placeAgain(beacon_TimerWheel_t *wheel, beacon_TimerWheelSlot_t *slot)
+{
+    beacon_TimerWheelEntry_t *entry;
+    while((entry = slot->first))
+    {
+        beacon_TimerWheel_remove(wheel, entry);
+        beacon_TimerWheel_place(wheel, entry);
+    }
+}
+
+static void beacon_TimerWheel_fire(beacon_context_t *context, beacon_TimerWheel_t *wheel, beacon_TimerWheelSlot_t *slot)
+{
+    // The callbacks may schedule and cancel other timers, so the entries are taken one at a time.
+    beacon_TimerWheelEntry_t *entry;
+    while((entry = slot->first))
+    {
+        beacon_TimerWheel_remove(wheel, entry);
+        --wheel->timerCount;
+        entry->callback(context, entry);
+    }
+}
+
+void beacon_TimerWheel_advance(beacon_context_t *context)
+{
+    beacon_TimerWheel_t *wheel = context->timerWheel;
+    if(!wheel)
+        return;
+
+    uint64_t now = beacon_getMonotonicClockMicroseconds();
+    beacon_TimerWheel_fire(context, wheel, &wheel->expired);
+
+    while(wheel->currentTime < now)
+    {
+        // Jump over the empty slots.
+        uint64_t eventTime;
+        if(!beacon_TimerWheel_nextEventTime(wheel, &eventTime) || eventTime > now)
+        {
+            wheel->currentTime = now;
+            break;
+        }
+
+        wheel->currentTime = eventTime;
+
+        // Move the timers of the higher levels down, from the top.
+        for(size_t level = BEACON_TIMER_WHEEL_LEVEL_COUNT; level >= 1; --level)
+        {
+            size_t shift = level * BEACON_TIMER_WHEEL_SLOT_BITS;
+            if(eventTime & (((uint64_t)1 << shift) - 1))
+                continue;
+
+            if(level == BEACON_TIMER_WHEEL_LEVEL_COUNT)
+                beacon_TimerWheel_placeAgain(wheel, &wheel->overflow);
+            else
+                beacon_TimerWheel_placeAgain(wheel, &wheel->slots[level][(eventTime >> shift) & (BEACON_TIMER_WHEEL_SLOT_COUNT - 1)]);
+        }
+
+        beacon_TimerWheel_fire(context, wheel, &wheel->slots[0][eventTime & (BEACON_TIMER_WHEEL_SLOT_COUNT - 1)]);
+        beacon_TimerWheel_fire(context, wheel, &wheel->expired);
+    }
+}
+
+static beacon_TimerWheelSlot_t *beacon_TimerWheel_slotForMarking(beacon_TimerWheel_t *wheel, size_t index)
+{
+    size_t wheelSlotCount = BEACON_TIMER_WHEEL_LEVEL_COUNT * BEACON_TIMER_WHEEL_SLOT_COUNT;
+    if(index < wheelSlotCount)
+        return &wheel->slots[0][0] + index;
+    else if(index == wheelSlotCount)
+        return &wheel->overflow;
+    else if(index == wheelSlotCount + 1)
+        return &wheel->expired;
+    else
+        return &wheel->firedBlocks;
+}
+
+void beacon_TimerWheel_markRoots(beacon_context_t *context)
+{
+    beacon_TimerWheel_t *wheel = context->timerWheel;
+    if(!wheel)
+        return;
+
+    for(size_t i = 0; i < BEACON_TIMER_WHEEL_LEVEL_COUNT * BEACON_TIMER_WHEEL_SLOT_COUNT + 3; ++i)
+    {
+        for(beacon_TimerWheelEntry_t *entry = beacon_TimerWheel_slotForMarking(wheel, i)->first; entry; entry = entry->next)
+            beacon_heap_pushReachableObject(context->heap, entry->owner);
+    }
+}
+
+static void beacon_Timer_fired(beacon_context_t *context, beacon_TimerWheelEntry_t *entry);
+
+void beacon_TimerWheel_destroy(beacon_context_t *context)
+{
+    beacon_TimerWheel_t *wheel = context->timerWheel;
+    if(!wheel)
+        return;
+
+    // The entries of the processes are embedded in them. The ones of the Timer objects are owned by the wheel.
+    for(size_t i = 0; i < BEACON_TIMER_WHEEL_LEVEL_COUNT * BEACON_TIMER_WHEEL_SLOT_COUNT + 3; ++i)
+    {
+        beacon_TimerWheelEntry_t *entry = beacon_TimerWheel_slotForMarking(wheel, i)->first;
+        while(entry)
+        {
+            beacon_TimerWheelEntry_t *nextEntry = entry->next;
+            if(entry->callback == beacon_Timer_fired)
+                free(entry);
+            entry = nextEntry;
+        }
+    }
+
+    free(wheel);
+    context->timerWheel = NULL;
+}
+
+static void beacon_Timer_release(beacon_context_t *context, beacon_Timer_t *timer)
+{
+    beacon_TimerWheelEntry_t *entry = beacon_unboxExternalAddress(context, timer->handle);
+    if(!entry)
+        return;
+
+    beacon_TimerWheel_cancel(context->timerWheel, entry);
+    ((beacon_ExternalAddress_t*)timer->handle)->address = NULL;
+    timer->handle = 0;
+    free(entry);
+}
+
+static void beacon_Timer_fired(beacon_context_t *context, beacon_TimerWheelEntry_t *entry)
+{
+    beacon_Timer_t *timer = (beacon_Timer_t*)entry->owner;
+    if(timer->block)
+    {
+        // Blocks may do anything, so they wait for the main loop.
+        beacon_TimerWheelSlot_add(&context->timerWheel->firedBlocks, entry);
+        return;
+    }
+
+    beacon_Timer_release(context, timer);
+    if(timer->semaphore)
+        beacon_Semaphore_signalWithoutPreemption(context, timer->semaphore);
+}
+
+void beacon_TimerWheel_runFiredTimers(beacon_context_t *context)
+{
+    beacon_TimerWheel_t *wheel = context->timerWheel;
+    if(!wheel)
+        return;
+
+    beacon_TimerWheel_advance(context);
+
+    beacon_TimerWheelEntry_t *entry;
+    while((entry = wheel->firedBlocks.first))
+    {
+        beacon_Timer_t *timer = (beacon_Timer_t*)entry->owner;
+        beacon_Timer_release(context, timer);
+        beacon_perform(context, timer->block, (beacon_oop_t)beacon_internCString(context, "value"));
+    }
+}
+
+static beacon_oop_t beacon_Timer_scheduleAt(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    BeaconAssert(context, beacon_isSmallInteger(arguments[0]));
+    beacon_Timer_t *timer = (beacon_Timer_t*)receiver;
+    if(!timer->semaphore && !timer->block)
+        beacon_exception_error(context, "The timer has neither a semaphore to signal nor a block to run.");
+
+    beacon_TimerWheel_t *wheel = beacon_TimerWheel_get(context);
+    beacon_TimerWheelEntry_t *entry = beacon_unboxExternalAddress(context, timer->handle);
+    if(!entry)
+    {
+        entry = calloc(1, sizeof(beacon_TimerWheelEntry_t));
+        entry->callback = beacon_Timer_fired;
+        entry->owner = receiver;
+        timer->handle = beacon_boxExternalAddress(context, entry);
+    }
+
+    intptr_t expirationTime = beacon_decodeSmallInteger(arguments[0]);
+    beacon_TimerWheel_schedule(wheel, entry, expirationTime > 0 ? (uint64_t)expirationTime : 0);
+    return receiver;
+}
+
+static beacon_oop_t beacon_Timer_cancel(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_Timer_release(context, (beacon_Timer_t*)receiver);
+    return receiver;
+}
+
+static beacon_oop_t beacon_TimerClass_runFiredTimers(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_TimerWheel_runFiredTimers(context);
+    return receiver;
+}
+
+void beacon_context_registerTimerWheelPrimitives(beacon_context_t *context)
+{
+    beacon_addPrimitiveToClass(context, context->classes.timerClass, "scheduleAt:", 1, beacon_Timer_scheduleAt);
+    beacon_addPrimitiveToClass(context, context->classes.timerClass, "cancel", 0, beacon_Timer_cancel);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.timerClass), "runFiredTimers", 0, beacon_TimerClass_runFiredTimers);
+}
@@ -1,3 +1,11 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // For pthread_getattr_np
+#endif
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600 // For the ucontext functions
+#define _DARWIN_C_SOURCE
+#endif
+
 #include "Context.c"
 #include "Exceptions.c"
 #include "Font.c"
@@ -10,7 +18,14 @@
 #include "Scanner.c"
 #include "Parser.c"
 #include "Bytecode.c"
+#include "Jit.c"
+#include "BytecodeCache.c"
 #include "SyntaxCompiler.c"
+#include "Profiler.c"
+#include "Process.c"
+#include "TimerWheel.c"
+#include "Worker.c"
+#include "ThreadPool.c"
 
 #include "NullWindow.c"
 #include "Main.c"
@@ -0,0 +1,890 @@
+#include "beacon-lang/Worker.h"
+#include "beacon-lang/Context.h"
+#include "beacon-lang/Memory.h"
+#include "beacon-lang/Exceptions.h"
+#include "beacon-lang/Dictionary.h"
+#include "beacon-lang/SourceCode.h"
+#include "beacon-lang/ThreadPool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+typedef struct beacon_ChannelMessage_s beacon_ChannelMessage_t;
+typedef struct beacon_NativeWorker_s beacon_NativeWorker_t;
+typedef struct beacon_ChannelReceiveTask_s beacon_ChannelReceiveTask_t;
+
+typedef enum beacon_ChannelMessageNodeKind_e
+{
+    BeaconChannelMessageNodeObject = 0,
+    BeaconChannelMessageNodeSymbol,
+    BeaconChannelMessageNodeClass,
+    BeaconChannelMessageNodeMetaclass,
+    BeaconChannelMessageNodeTrue,
+    BeaconChannelMessageNodeFalse,
+    BeaconChannelMessageNodeChannel,
+} beacon_ChannelMessageNodeKind_t;
+
+/**
+ * An object of a message. The references to the other nodes are encoded as (index + 1) << 3, whose tag bits are zero like the ones of a pointer,
+ * so the immediate objects and nil are kept as they are.
+ */
+typedef struct beacon_ChannelMessageNode_s
+{
+    beacon_ChannelMessageNodeKind_t kind;
+    beacon_ObjectKind_t objectKind;
+    uint32_t slotCount;
+    beacon_oop_t classReference;
+
+    // The slots or the bytes of an object, or the name of a symbol or of a class.
+    void *data;
+    size_t dataSize;
+
+    beacon_NativeChannel_t *channel;
+} beacon_ChannelMessageNode_t;
+
+struct beacon_ChannelMessage_s
+{
+    beacon_ChannelMessage_t *next;
+    beacon_oop_t root;
+    size_t nodeCount;
+    size_t nodeCapacity;
+    beacon_ChannelMessageNode_t *nodes;
+};
+
+/**
+ * A queue of messages that is shared by several contexts. Each context that references the channel holds one reference to it, and so does each message that contains it.
+ * The receives that wait for a message are queued too, and there are only waiting receives when there are no messages.
+ */
+struct beacon_NativeChannel_s
+{
+    mtx_t mutex;
+    size_t referenceCount;
+    beacon_ChannelMessage_t *firstMessage;
+    beacon_ChannelMessage_t *lastMessage;
+    beacon_ChannelReceiveTask_t *firstReceiveTask;
+    beacon_ChannelReceiveTask_t *lastReceiveTask;
+};
+
+/**
+ * A receive that waits for the next message of a channel. The sender gives the message to it, and finishes it for waking up the process that waits for its future.
+ */
+struct beacon_ChannelReceiveTask_s
+{
+    beacon_AsyncTask_t super;
+    beacon_ChannelReceiveTask_t *nextInChannel;
+    beacon_ChannelMessage_t *message;
+};
+
+/**
+ * A context that runs a list of files on its own thread.
+ */
+struct beacon_NativeWorker_s
+{
+    beacon_NativeWorker_t *next;
+    thrd_t thread;
+    bool isJoined;
+
+    size_t fileNameCount;
+    char **fileNames;
+    beacon_NativeChannel_t *channel;
+
+    // The options of the context that started the worker. The strings that they reference are never modified, so they are shared.
+    struct ContextOptions options;
+};
+
+/**
+ * The channels that are referenced by the objects of a context, and the workers that it has started.
+ */
+struct beacon_WorkerRegistry_s
+{
+    // The channel that was given by the context which started this one, if any.
+    beacon_NativeChannel_t *workerChannel;
+
+    size_t channelCount;
+    size_t channelCapacity;
+    beacon_NativeChannel_t **channels;
+
+    beacon_NativeWorker_t *firstWorker;
+};
+
+//==============================================================================
+// Native channels
+//==============================================================================
+
+static beacon_NativeChannel_t *beacon_NativeChannel_new(void)
+{
+    beacon_NativeChannel_t *channel = calloc(1, sizeof(beacon_NativeChannel_t));
+    mtx_init(&channel->mutex, mtx_plain);
+    channel->referenceCount = 1;
+    return channel;
+}
+
+static void beacon_ChannelMessage_free(beacon_ChannelMessage_t *message);
+
+static void beacon_NativeChannel_retain(beacon_NativeChannel_t *channel)
+{
+    mtx_lock(&channel->mutex);
+    ++channel->referenceCount;
+    mtx_unlock(&channel->mutex);
+}
+
+static void beacon_NativeChannel_release(beacon_NativeChannel_t *channel)
+{
+    mtx_lock(&channel->mutex);
+    size_t referenceCount = --channel->referenceCount;
+    mtx_unlock(&channel->mutex);
+    if(referenceCount > 0)
+        return;
+
+    beacon_ChannelMessage_t *message = channel->firstMessage;
+    while(message)
+    {
+        beacon_ChannelMessage_t *nextMessage = message->next;
+        beacon_ChannelMessage_free(message);
+        message = nextMessage;
+    }
+
+    mtx_destroy(&channel->mutex);
+    free(channel);
+}
+
+//==============================================================================
+// Worker registry
+//==============================================================================
+
+static beacon_WorkerRegistry_t *beacon_WorkerRegistry_get(beacon_context_t *context)
+{
+    if(!context->workerRegistry)
+        context->workerRegistry = calloc(1, sizeof(beacon_WorkerRegistry_t));
+    return context->workerRegistry;
+}
+
+/**
+ * Takes one reference to a channel for the context, unless it already has one.
+ */
+static void beacon_WorkerRegistry_addChannel(beacon_context_t *context, beacon_NativeChannel_t *channel, bool retain)
+{
+    beacon_WorkerRegistry_t *registry = beacon_WorkerRegistry_get(context);
+    for(size_t i = 0; i < registry->channelCount; ++i)
+    {
+        if(registry->channels[i] == channel)
+            return;
+    }
+
+    if(registry->channelCount >= registry->channelCapacity)
+    {
+        registry->channelCapacity = registry->channelCapacity ? registry->channelCapacity * 2 : 16;
+        registry->channels = realloc(registry->channels, registry->channelCapacity * sizeof(beacon_NativeChannel_t*));
+    }
+
+    if(retain)
+        beacon_NativeChannel_retain(channel);
+    registry->channels[registry->channelCount++] = channel;
+}
+
+static void beacon_NativeChannel_finishReceiveTasksOf(beacon_context_t *context, beacon_NativeChannel_t *channel);
+
+static void beacon_NativeWorker_join(beacon_NativeWorker_t *worker)
+{
+    if(worker->isJoined)
+        return;
+
+    thrd_join(worker->thread, NULL);
+    worker->isJoined = true;
+}
+
+void beacon_WorkerRegistry_destroy(beacon_context_t *context)
+{
+    beacon_WorkerRegistry_t *registry = context->workerRegistry;
+    if(!registry)
+        return;
+
+    // The receives that are still waiting are finished without a message, so that the tasks of the context can be destroyed.
+    for(size_t i = 0; i < registry->channelCount; ++i)
+        beacon_NativeChannel_finishReceiveTasksOf(context, registry->channels[i]);
+
+    beacon_NativeWorker_t *worker = registry->firstWorker;
+    while(worker)
+    {
+        beacon_NativeWorker_t *nextWorker = worker->next;
+        beacon_NativeWorker_join(worker);
+        for(size_t i = 0; i < worker->fileNameCount; ++i)
+            free(worker->fileNames[i]);
+        free(worker->fileNames);
+        beacon_NativeChannel_release(worker->channel);
+        free(worker);
+        worker = nextWorker;
+    }
+
+    for(size_t i = 0; i < registry->channelCount; ++i)
+        beacon_NativeChannel_release(registry->channels[i]);
+    free(registry->channels);
+    free(registry);
+    context->workerRegistry = NULL;
+}
+
+//==============================================================================
+// Channel objects
+//==============================================================================
+
+static beacon_NativeChannel_t *beacon_Channel_getNativeChannel(beacon_context_t *context, beacon_Channel_t *channel)
+{
+    beacon_NativeChannel_t *nativeChannel = beacon_unboxExternalAddress(context, channel->handle);
+    if(!nativeChannel)
+    {
+        // The reference of a new channel belongs to the context that created it.
+        nativeChannel = beacon_NativeChannel_new();
+        beacon_WorkerRegistry_addChannel(context, nativeChannel, false);
+        channel->handle = beacon_boxExternalAddress(context, nativeChannel);
+    }
+
+    return nativeChannel;
+}
+
+static beacon_oop_t beacon_Channel_forNativeChannel(beacon_context_t *context, beacon_NativeChannel_t *nativeChannel)
+{
+    beacon_WorkerRegistry_addChannel(context, nativeChannel, true);
+    beacon_Channel_t *channel = beacon_allocateObjectWithBehavior(context->heap, context->classes.channelClass, sizeof(beacon_Channel_t), BeaconObjectKindPointers);
+    channel->handle = beacon_boxExternalAddress(context, nativeChannel);
+    return (beacon_oop_t)channel;
+}
+
+//==============================================================================
+// Messages
+//==============================================================================
+
+static inline beacon_oop_t beacon_ChannelMessage_encodeReference(size_t index)
+{
+    return (beacon_oop_t)((index + 1) << ImmediateObjectTag_BitCount);
+}
+
+static inline size_t beacon_ChannelMessage_decodeReference(beacon_oop_t reference)
+{
+    return ((size_t)reference >> ImmediateObjectTag_BitCount) - 1;
+}
+
+static void beacon_ChannelMessage_free(beacon_ChannelMessage_t *message)
+{
+    for(size_t i = 0; i < message->nodeCount; ++i)
+    {
+        beacon_ChannelMessageNode_t *node = message->nodes + i;
+        free(node->data);
+        if(node->channel)
+            beacon_NativeChannel_release(node->channel);
+    }
+
+    free(message->nodes);
+    free(message);
+}
+
+typedef struct beacon_ChannelMessageWriter_s
+{
+    beacon_context_t *context;
+    beacon_ChannelMessage_t *message;
+
+    // The objects of the nodes, and an open addressing table from the objects to their nodes.
+    beacon_oop_t *objects;
+    size_t *objectTable;
+    size_t objectTableCapacity;
+
+    const char *errorMessage;
+} beacon_ChannelMessageWriter_t;
+
+static inline size_t beacon_ChannelMessageWriter_hash(beacon_oop_t object)
+{
+    // The low bits of the addresses are always zero, so they are mixed with a multiplicative hash.
+    return (size_t)(((uint64_t)object * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+static void beacon_ChannelMessageWriter_growObjectTable(beacon_ChannelMessageWriter_t *writer)
+{
+    size_t newCapacity = writer->objectTableCapacity ? writer->objectTableCapacity * 2 : 64;
+    free(writer->objectTable);
+    writer->objectTable = malloc(newCapacity * sizeof(size_t));
+    writer->objectTableCapacity = newCapacity;
+    for(size_t i = 0; i < newCapacity; ++i)
+        writer->objectTable[i] = SIZE_MAX;
+
+    for(size_t index = 0; index < writer->message->nodeCount; ++index)
+    {
+        size_t slot = beacon_ChannelMessageWriter_hash(writer->objects[index]) & (newCapacity - 1);
+        while(writer->objectTable[slot] != SIZE_MAX)
+            slot = (slot + 1) & (newCapacity - 1);
+        writer->objectTable[slot] = index;
+    }
+}
+
+/**
+ * Returns the reference to the node of an object, and adds the node when the object is seen for the first time. The nodes are described in order afterwards, so deep graphs do not recurse.
+ */
+static beacon_oop_t beacon_ChannelMessageWriter_reference(beacon_ChannelMessageWriter_t *writer, beacon_oop_t object)
+{
+    if(beacon_isImmediate(object))
+        return object;
+
+    beacon_ChannelMessage_t *message = writer->message;
+    size_t slot = 0;
+    if(writer->objectTableCapacity)
+    {
+        slot = beacon_ChannelMessageWriter_hash(object) & (writer->objectTableCapacity - 1);
+        while(writer->objectTable[slot] != SIZE_MAX)
+        {
+            size_t index = writer->objectTable[slot];
+            if(writer->objects[index] == object)
+                return beacon_ChannelMessage_encodeReference(index);
+            slot = (slot + 1) & (writer->objectTableCapacity - 1);
+        }
+    }
+
+    if(message->nodeCount >= message->nodeCapacity)
+    {
+        message->nodeCapacity = message->nodeCapacity ? message->nodeCapacity * 2 : 16;
+        message->nodes = realloc(message->nodes, message->nodeCapacity * sizeof(beacon_ChannelMessageNode_t));
+        writer->objects = realloc(writer->objects, message->nodeCapacity * sizeof(beacon_oop_t));
+    }
+
+    size_t index = message->nodeCount++;
+    memset(message->nodes + index, 0, sizeof(beacon_ChannelMessageNode_t));
+    writer->objects[index] = object;
+
+    // Keep the table at most half full.
+    if(message->nodeCount * 2 > writer->objectTableCapacity)
+    {
+        beacon_ChannelMessageWriter_growObjectTable(writer);
+    }
+    else
+    {
+        writer->objectTable[slot] = index;
+    }
+
+    return beacon_ChannelMessage_encodeReference(index);
+}
+
+static bool beacon_ChannelMessageWriter_isKindOf(beacon_Behavior_t *behavior, beacon_Behavior_t *expectedClass)
+{
+    for(; behavior; behavior = behavior->superclass)
+    {
+        if(behavior == expectedClass)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * The objects that reference native resources, or the code and the execution state of their context.
+ */
+static bool beacon_ChannelMessageWriter_canBeCopied(beacon_context_t *context, beacon_Behavior_t *behavior)
+{
+    beacon_Behavior_t *rejectedClasses[] = {
+        context->classes.externalAddressClass,
+        context->classes.compiledCodeClass,
+        context->classes.blockClosureClass,
+        context->classes.processClass,
+        context->classes.semaphoreClass,
+        context->classes.timerClass,
+        context->classes.workerClass,
+        context->classes.futureClass,
+        context->classes.windowClass,
+        context->classes.agpuClass,
+        context->classes.agpuSwapChainClass,
+        context->classes.agpuTextureHandleClass,
+        context->classes.agpuWindowRendererClass,
+    };
+
+    for(size_t i = 0; i < sizeof(rejectedClasses) / sizeof(rejectedClasses[0]); ++i)
+    {
+        if(beacon_ChannelMessageWriter_isKindOf(behavior, rejectedClasses[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static void beacon_ChannelMessageWriter_setName(beacon_ChannelMessageNode_t *node, beacon_Symbol_t *name)
+{
+    node->dataSize = name->super.super.super.super.super.header.slotCount;
+    node->data = malloc(node->dataSize ? node->dataSize : 1);
+    memcpy(node->data, name->data, node->dataSize);
+}
+
+static bool beacon_ChannelMessageWriter_describe(beacon_ChannelMessageWriter_t *writer, size_t index)
+{
+    beacon_context_t *context = writer->context;
+    beacon_oop_t object = writer->objects[index];
+    beacon_ChannelMessageNode_t *node = writer->message->nodes + index;
+    beacon_Behavior_t *behavior = beacon_getClass(context, object);
+
+    if(object == context->roots.trueValue)
+    {
+        node->kind = BeaconChannelMessageNodeTrue;
+        return true;
+    }
+    else if(object == context->roots.falseValue)
+    {
+        node->kind = BeaconChannelMessageNodeFalse;
+        return true;
+    }
+    else if(behavior == context->classes.symbolClass)
+    {
+        node->kind = BeaconChannelMessageNodeSymbol;
+        beacon_ChannelMessageWriter_setName(node, (beacon_Symbol_t*)object);
+        return true;
+    }
+    else if(behavior == context->classes.channelClass)
+    {
+        // The message holds its own reference, so the channel outlives the contexts that have sent it.
+        node->kind = BeaconChannelMessageNodeChannel;
+        node->channel = beacon_Channel_getNativeChannel(context, (beacon_Channel_t*)object);
+        beacon_NativeChannel_retain(node->channel);
+        return true;
+    }
+    else if(behavior == context->classes.metaclassClass || beacon_getClass(context, (beacon_oop_t)behavior) == context->classes.metaclassClass)
+    {
+        bool isMetaclass = behavior == context->classes.metaclassClass;
+        beacon_Class_t *class = isMetaclass ? ((beacon_Metaclass_t*)object)->thisClass : (beacon_Class_t*)object;
+        if(!class || !class->name)
+        {
+            writer->errorMessage = "An anonymous class cannot be sent through a channel.";
+            return false;
+        }
+
+        node->kind = isMetaclass ? BeaconChannelMessageNodeMetaclass : BeaconChannelMessageNodeClass;
+        beacon_ChannelMessageWriter_setName(node, class->name);
+        return true;
+    }
+
+    beacon_ObjectHeader_t *header = (beacon_ObjectHeader_t*)object;
+    if(header->objectKind == BeaconObjectKindWeakPointers || !beacon_ChannelMessageWriter_canBeCopied(context, behavior))
+    {
+        writer->errorMessage = "The message contains an object that cannot leave its context, such as a block, a process or an external resource.";
+        return false;
+    }
+
+    node->kind = BeaconChannelMessageNodeObject;
+    node->objectKind = header->objectKind;
+    node->slotCount = header->slotCount;
+    if(header->objectKind == BeaconObjectKindBytes)
+    {
+        node->dataSize = header->slotCount;
+        node->data = malloc(node->dataSize ? node->dataSize : 1);
+        memcpy(node->data, header + 1, node->dataSize);
+    }
+    else
+    {
+        node->dataSize = header->slotCount * sizeof(beacon_oop_t);
+        beacon_oop_t *slots = malloc(node->dataSize ? node->dataSize : 1);
+        beacon_oop_t *sourceSlots = (beacon_oop_t*)(header + 1);
+        for(size_t i = 0; i < header->slotCount; ++i)
+            slots[i] = beacon_ChannelMessageWriter_reference(writer, sourceSlots[i]);
+
+        // The references may have grown the nodes.
+        node = writer->message->nodes + index;
+        node->data = slots;
+    }
+
+    beacon_oop_t classReference = beacon_ChannelMessageWriter_reference(writer, (beacon_oop_t)behavior);
+    writer->message->nodes[index].classReference = classReference;
+    return true;
+}
+
+static beacon_ChannelMessage_t *beacon_ChannelMessage_write(beacon_context_t *context, beacon_oop_t object)
+{
+    beacon_ChannelMessageWriter_t writer = {
+        .context = context,
+        .message = calloc(1, sizeof(beacon_ChannelMessage_t)),
+    };
+
+    writer.message->root = beacon_ChannelMessageWriter_reference(&writer, object);
+    for(size_t i = 0; i < writer.message->nodeCount; ++i)
+    {
+        if(!beacon_ChannelMessageWriter_describe(&writer, i))
+            break;
+    }
+
+    free(writer.objects);
+    free(writer.objectTable);
+    if(writer.errorMessage)
+    {
+        beacon_ChannelMessage_free(writer.message);
+        beacon_exception_error(context, writer.errorMessage);
+    }
+
+    return writer.message;
+}
+
+/**
+ * The hashes of the method dictionaries depend on the addresses of their keys, so their copies are hashed again.
+ */
+static void beacon_ChannelMessage_rehashMethodDictionary(beacon_context_t *context, beacon_MethodDictionary_t *dictionary)
+{
+    beacon_Array_t *oldStorage = dictionary->super.super.array;
+    if(!oldStorage)
+        return;
+
+    size_t storageSize = oldStorage->super.super.super.super.super.header.slotCount;
+    dictionary->super.super.array = beacon_allocateObjectWithBehavior(context->heap, context->classes.arrayClass, sizeof(beacon_Array_t) + sizeof(beacon_oop_t)*storageSize, BeaconObjectKindPointers);
+    dictionary->super.super.tally = beacon_encodeSmallInteger(0);
+    for(size_t i = 0; i + 1 < storageSize; i += 2)
+    {
+        if(oldStorage->elements[i])
+            beacon_MethodDictionary_atPut(context, dictionary, (beacon_Symbol_t*)oldStorage->elements[i], oldStorage->elements[i + 1]);
+    }
+}
+
+/**
+ * Copies a message into the heap of the context, and frees it. Returns 0 with the error message when the message cannot be read.
+ */
+static beacon_oop_t beacon_ChannelMessage_readOrFail(beacon_context_t *context, beacon_ChannelMessage_t *message, const char **outErrorMessage)
+{
+    beacon_oop_t *objects = calloc(message->nodeCount ? message->nodeCount : 1, sizeof(beacon_oop_t));
+    const char *errorMessage = NULL;
+
+    // Resolve the names first, so that a missing class is reported before anything is copied.
+    for(size_t i = 0; i < message->nodeCount && !errorMessage; ++i)
+    {
+        beacon_ChannelMessageNode_t *node = message->nodes + i;
+        switch(node->kind)
+        {
+        case BeaconChannelMessageNodeSymbol:
+            objects[i] = (beacon_oop_t)beacon_internStringWithSize(context, node->dataSize, node->data);
+            break;
+        case BeaconChannelMessageNodeClass:
+        case BeaconChannelMessageNodeMetaclass:
+            {
+                beacon_Symbol_t *name = beacon_internStringWithSize(context, node->dataSize, node->data);
+                beacon_oop_t class = beacon_MethodDictionary_atOrNil(context, context->roots.systemDictionary, name);
+                if(beacon_isImmediate(class) || beacon_getClass(context, (beacon_oop_t)beacon_getClass(context, class)) != context->classes.metaclassClass)
+                    errorMessage = "The class of an object of the message does not exist in the receiving context.";
+                else
+                    objects[i] = node->kind == BeaconChannelMessageNodeMetaclass ? (beacon_oop_t)beacon_getClass(context, class) : class;
+            }
+            break;
+        case BeaconChannelMessageNodeTrue:
+            objects[i] = context->roots.trueValue;
+            break;
+        case BeaconChannelMessageNodeFalse:
+            objects[i] = context->roots.falseValue;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(errorMessage)
+    {
+        free(objects);
+        beacon_ChannelMessage_free(message);
+        *outErrorMessage = errorMessage;
+        return 0;
+    }
+
+    // Allocate the copies, and then fill them, because the nodes may reference each other in any order. There is no safepoint in between.
+    for(size_t i = 0; i < message->nodeCount; ++i)
+    {
+        beacon_ChannelMessageNode_t *node = message->nodes + i;
+        if(node->kind == BeaconChannelMessageNodeChannel)
+        {
+            objects[i] = beacon_Channel_forNativeChannel(context, node->channel);
+        }
+        else if(node->kind == BeaconChannelMessageNodeObject)
+        {
+            size_t slotsSize = node->objectKind == BeaconObjectKindBytes ? node->slotCount : node->slotCount * sizeof(beacon_oop_t);
+            beacon_Behavior_t *behavior = (beacon_Behavior_t*)objects[beacon_ChannelMessage_decodeReference(node->classReference)];
+            objects[i] = (beacon_oop_t)beacon_allocateObjectWithBehavior(context->heap, behavior, sizeof(beacon_ObjectHeader_t) + slotsSize, node->objectKind);
+        }
+    }
+
+    for(size_t i = 0; i < message->nodeCount; ++i)
+    {
+        beacon_ChannelMessageNode_t *node = message->nodes + i;
+        if(node->kind != BeaconChannelMessageNodeObject)
+            continue;
+
+        beacon_ObjectHeader_t *header = (beacon_ObjectHeader_t*)objects[i];
+        if(node->objectKind == BeaconObjectKindBytes)
+        {
+            memcpy(header + 1, node->data, node->dataSize);
+        }
+        else
+        {
+            beacon_oop_t *slots = (beacon_oop_t*)(header + 1);
+            beacon_oop_t *encodedSlots = node->data;
+            for(size_t slotIndex = 0; slotIndex < node->slotCount; ++slotIndex)
+            {
+                beacon_oop_t slot = encodedSlots[slotIndex];
+                slots[slotIndex] = beacon_isImmediate(slot) ? slot : objects[beacon_ChannelMessage_decodeReference(slot)];
+            }
+        }
+    }
+
+    for(size_t i = 0; i < message->nodeCount; ++i)
+    {
+        beacon_ChannelMessageNode_t *node = message->nodes + i;
+        if(node->kind == BeaconChannelMessageNodeObject && node->objectKind == BeaconObjectKindPointers &&
+            ((beacon_ObjectHeader_t*)objects[i])->behavior == context->classes.methodDictionaryClass)
+            beacon_ChannelMessage_rehashMethodDictionary(context, (beacon_MethodDictionary_t*)objects[i]);
+    }
+
+    beacon_oop_t root = beacon_isImmediate(message->root) ? message->root : objects[beacon_ChannelMessage_decodeReference(message->root)];
+    free(objects);
+    beacon_ChannelMessage_free(message);
+    return root;
+}
+
+static beacon_oop_t beacon_ChannelMessage_read(beacon_context_t *context, beacon_ChannelMessage_t *message)
+{
+    const char *errorMessage = NULL;
+    beacon_oop_t root = beacon_ChannelMessage_readOrFail(context, message, &errorMessage);
+    if(errorMessage)
+        beacon_exception_error(context, errorMessage);
+    return root;
+}
+
+void beacon_NativeChannel_send(beacon_context_t *context, beacon_NativeChannel_t *channel, beacon_oop_t object)
+{
+    beacon_ChannelMessage_t *message = beacon_ChannelMessage_write(context, object);
+
+    mtx_lock(&channel->mutex);
+    beacon_ChannelReceiveTask_t *receiveTask = channel->firstReceiveTask;
+    if(receiveTask)
+    {
+        channel->firstReceiveTask = receiveTask->nextInChannel;
+        if(!channel->firstReceiveTask)
+            channel->lastReceiveTask = NULL;
+        receiveTask->nextInChannel = NULL;
+        receiveTask->message = message;
+    }
+    else
+    {
+        if(channel->lastMessage)
+            channel->lastMessage->next = message;
+        else
+            channel->firstMessage = message;
+        channel->lastMessage = message;
+    }
+    mtx_unlock(&channel->mutex);
+
+    if(receiveTask)
+        beacon_AsyncTask_finish(&receiveTask->super);
+}
+
+static beacon_ChannelMessage_t *beacon_NativeChannel_takeMessage(beacon_NativeChannel_t *channel)
+{
+    beacon_ChannelMessage_t *message = channel->firstMessage;
+    if(message)
+    {
+        channel->firstMessage = message->next;
+        if(!channel->firstMessage)
+            channel->lastMessage = NULL;
+        message->next = NULL;
+    }
+
+    return message;
+}
+
+static beacon_oop_t beacon_ChannelReceiveTask_complete(beacon_context_t *context, beacon_AsyncTask_t *task)
+{
+    beacon_ChannelReceiveTask_t *receiveTask = (beacon_ChannelReceiveTask_t *)task;
+    beacon_ChannelMessage_t *message = receiveTask->message;
+    if(!message)
+        return 0;
+
+    // This runs in the scheduler, so the errors are given to the process that waits for the future.
+    receiveTask->message = NULL;
+    return beacon_ChannelMessage_readOrFail(context, message, &task->errorMessage);
+}
+
+static void beacon_ChannelReceiveTask_destroy(beacon_AsyncTask_t *task)
+{
+    beacon_ChannelReceiveTask_t *receiveTask = (beacon_ChannelReceiveTask_t *)task;
+    if(receiveTask->message)
+        beacon_ChannelMessage_free(receiveTask->message);
+    free(receiveTask);
+}
+
+beacon_oop_t beacon_NativeChannel_receiveAsync(beacon_context_t *context, beacon_NativeChannel_t *channel)
+{
+    beacon_ChannelReceiveTask_t *receiveTask = calloc(1, sizeof(beacon_ChannelReceiveTask_t));
+    receiveTask->super.complete = beacon_ChannelReceiveTask_complete;
+    receiveTask->super.destroy = beacon_ChannelReceiveTask_destroy;
+    beacon_oop_t future = beacon_AsyncTask_startWaiting(context, &receiveTask->super);
+
+    mtx_lock(&channel->mutex);
+    receiveTask->message = beacon_NativeChannel_takeMessage(channel);
+    if(!receiveTask->message)
+    {
+        if(channel->lastReceiveTask)
+            channel->lastReceiveTask->nextInChannel = receiveTask;
+        else
+            channel->firstReceiveTask = receiveTask;
+        channel->lastReceiveTask = receiveTask;
+    }
+    mtx_unlock(&channel->mutex);
+
+    // A message that is already there completes the future on the next check of the scheduler.
+    if(receiveTask->message)
+        beacon_AsyncTask_finish(&receiveTask->super);
+    return future;
+}
+
+static void beacon_NativeChannel_finishReceiveTasksOf(beacon_context_t *context, beacon_NativeChannel_t *channel)
+{
+    beacon_ChannelReceiveTask_t *finishedTasks = NULL;
+    mtx_lock(&channel->mutex);
+    beacon_ChannelReceiveTask_t **position = &channel->firstReceiveTask;
+    channel->lastReceiveTask = NULL;
+    while(*position)
+    {
+        beacon_ChannelReceiveTask_t *receiveTask = *position;
+        if(receiveTask->super.context == context)
+        {
+            *position = receiveTask->nextInChannel;
+            receiveTask->nextInChannel = finishedTasks;
+            finishedTasks = receiveTask;
+        }
+        else
+        {
+            channel->lastReceiveTask = receiveTask;
+            position = &receiveTask->nextInChannel;
+        }
+    }
+    mtx_unlock(&channel->mutex);
+
+    while(finishedTasks)
+    {
+        beacon_ChannelReceiveTask_t *receiveTask = finishedTasks;
+        finishedTasks = receiveTask->nextInChannel;
+        receiveTask->nextInChannel = NULL;
+        beacon_AsyncTask_finish(&receiveTask->super);
+    }
+}
+
+//==============================================================================
+// Workers
+//==============================================================================
+
+static int beacon_NativeWorker_run(void *argument)
+{
+    beacon_NativeWorker_t *worker = argument;
+    beacon_context_t *context = beacon_context_new();
+    if(!context)
+        return 1;
+
+    context->options = worker->options;
+    beacon_WorkerRegistry_get(context)->workerChannel = worker->channel;
+    beacon_WorkerRegistry_addChannel(context, worker->channel, true);
+
+    beacon_evaluateSourceCodeFiles(context, worker->fileNameCount, (const char **)worker->fileNames);
+    beacon_context_destroy(context);
+    return 0;
+}
+
+static beacon_oop_t beacon_WorkerClass_evaluateFilesChannel(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    BeaconAssert(context, argumentCount == 2);
+    BeaconAssert(context, beacon_getClass(context, arguments[0]) == context->classes.arrayClass);
+    BeaconAssert(context, beacon_getClass(context, arguments[1]) == context->classes.channelClass);
+
+    beacon_Array_t *fileNames = (beacon_Array_t*)arguments[0];
+    size_t fileNameCount = fileNames->super.super.super.super.super.header.slotCount;
+    for(size_t i = 0; i < fileNameCount; ++i)
+        BeaconAssert(context, beacon_getClass(context, fileNames->elements[i]) == context->classes.stringClass);
+
+    beacon_NativeWorker_t *worker = calloc(1, sizeof(beacon_NativeWorker_t));
+    worker->fileNameCount = fileNameCount;
+    worker->fileNames = calloc(fileNameCount ? fileNameCount : 1, sizeof(char*));
+    for(size_t i = 0; i < fileNameCount; ++i)
+    {
+        beacon_String_t *fileName = (beacon_String_t*)fileNames->elements[i];
+        size_t fileNameSize = fileName->super.super.super.super.super.header.slotCount;
+        worker->fileNames[i] = malloc(fileNameSize + 1);
+        memcpy(worker->fileNames[i], fileName->data, fileNameSize);
+        worker->fileNames[i][fileNameSize] = 0;
+    }
+
+    // The worker holds its own reference, for the context that it creates.
+    worker->channel = beacon_Channel_getNativeChannel(context, (beacon_Channel_t*)arguments[1]);
+    beacon_NativeChannel_retain(worker->channel);
+    worker->options = context->options;
+
+    // The perf map file belongs to the main context.
+    worker->options.writePerfMap = false;
+
+    beacon_WorkerRegistry_t *registry = beacon_WorkerRegistry_get(context);
+    worker->next = registry->firstWorker;
+    registry->firstWorker = worker;
+    if(thrd_create(&worker->thread, beacon_NativeWorker_run, worker) != thrd_success)
+    {
+        worker->isJoined = true;
+        beacon_exception_error(context, "Failed to create the thread of a worker.");
+    }
+
+    beacon_Worker_t *workerObject = beacon_allocateObjectWithBehavior(context->heap, context->classes.workerClass, sizeof(beacon_Worker_t), BeaconObjectKindPointers);
+    workerObject->handle = beacon_boxExternalAddress(context, worker);
+    workerObject->channel = arguments[1];
+    return (beacon_oop_t)workerObject;
+}
+
+static beacon_oop_t beacon_WorkerClass_channel(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)receiver;
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_WorkerRegistry_t *registry = context->workerRegistry;
+    if(!registry || !registry->workerChannel)
+        return 0;
+
+    return beacon_Channel_forNativeChannel(context, registry->workerChannel);
+}
+
+static beacon_oop_t beacon_Worker_wait(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    beacon_NativeWorker_t *worker = beacon_unboxExternalAddress(context, ((beacon_Worker_t*)receiver)->handle);
+    BeaconAssert(context, worker);
+    beacon_NativeWorker_join(worker);
+    return receiver;
+}
+
+static beacon_oop_t beacon_Channel_send(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    beacon_NativeChannel_send(context, beacon_Channel_getNativeChannel(context, (beacon_Channel_t*)receiver), arguments[0]);
+    return receiver;
+}
+
+static beacon_oop_t beacon_Channel_receiveAsync(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)arguments;
+    BeaconAssert(context, argumentCount == 0);
+    return beacon_NativeChannel_receiveAsync(context, beacon_Channel_getNativeChannel(context, (beacon_Channel_t*)receiver));
+}
+
+static beacon_oop_t beacon_Channel_receiveIfNone(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    BeaconAssert(context, argumentCount == 1);
+    beacon_NativeChannel_t *channel = beacon_Channel_getNativeChannel(context, (beacon_Channel_t*)receiver);
+    mtx_lock(&channel->mutex);
+    beacon_ChannelMessage_t *message = beacon_NativeChannel_takeMessage(channel);
+    mtx_unlock(&channel->mutex);
+
+    if(!message)
+        return beacon_perform(context, arguments[0], (beacon_oop_t)beacon_internCString(context, "value"));
+    return beacon_ChannelMessage_read(context, message);
+}
+
+void beacon_context_registerWorkerPrimitives(beacon_context_t *context)
+{
+    beacon_addPrimitiveToClass(context, context->classes.channelClass, "send:", 1, beacon_Channel_send);
+    beacon_addPrimitiveToClass(context, context->classes.channelClass, "receiveAsync", 0, beacon_Channel_receiveAsync);
+    beacon_addPrimitiveToClass(context, context->classes.channelClass, "receiveIfNone:", 1, beacon_Channel_receiveIfNone);
+
+    beacon_addPrimitiveToClass(context, context->classes.workerClass, "wait", 0, beacon_Worker_wait);
+
+    beacon_Behavior_t *workerClass = beacon_getClass(context, (beacon_oop_t)context->classes.workerClass);
+    beacon_addPrimitiveToClass(context, workerClass, "evaluateFiles:channel:", 2, beacon_WorkerClass_evaluateFilesChannel);
+    beacon_addPrimitiveToClass(context, workerClass, "channel", 0, beacon_WorkerClass_channel);
+}
@@ -1,10 +1,29 @@
 #include "Context.h"
 #include "Dictionary.h"
+#include "Exceptions.h"
+#include "Process.h"
+#include "ThreadPool.h"
+#include "TimerWheel.h"
 #include "Window.h"
 #include <xcb/xcb.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 
 static xcb_connection_t *xcb_connection = NULL;
+static bool isQuitting;
+static int wakeUpPipe[2] = {-1, -1};
+
+// The client part of the XIDs that the connection generates, which is small enough for indexing the window table.
+static uint32_t windowResourceIdMask;
+
+static beacon_Window_t *beacon_xcb_windowFromHandle(beacon_context_t *context, xcb_window_t windowHandle)
+{
+    return beacon_Window_fromHandle(context, windowHandle & windowResourceIdMask);
+}
 
 static beacon_oop_t beacon_Window_open(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
 {
@@ -21,7 +40,8 @@ static beacon_oop_t beacon_Window_open(beacon_context_t *context, beacon_oop_t r
     xcb_window_t windowHandle = xcb_generate_id(xcb_connection);
     beaconWindow->handle = beacon_encodeSmallInteger(windowHandle);
     
-    beacon_MethodDictionary_atPut(context, context->roots.windowHandleMap, (beacon_Symbol_t*)beaconWindow->handle, (beacon_oop_t)beaconWindow);
+    windowResourceIdMask = setup->resource_id_mask;
+    beacon_Window_registerHandle(context, beaconWindow, windowHandle & windowResourceIdMask);
     uint32_t mask = XCB_CW_EVENT_MASK;
     uint32_t valwin[] = {
         XCB_EVENT_MASK_EXPOSURE
@@ -44,77 +64,150 @@ static beacon_oop_t beacon_Window_open(beacon_context_t *context, beacon_oop_t r
     return receiver;
 }
 
-static beacon_oop_t beacon_WindowClass_enterMainLoop(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+static void beacon_xcb_dispatchEvent(beacon_context_t *context, xcb_generic_event_t *event)
 {
-    xcb_generic_event_t *event;
-    while((event = xcb_wait_for_event(xcb_connection)))
+    switch (event->response_type & ~0x80)
     {
-        switch (event->response_type & ~0x80)
+    case XCB_EXPOSE:
         {
-        case XCB_EXPOSE:
+            // The damaged region comes as a series of rectangles, and the window is drawn whole after the last one.
+            xcb_expose_event_t *expose = (xcb_expose_event_t *)event;
+            beacon_Window_t *beaconWindow = beacon_xcb_windowFromHandle(context, expose->window);
+            if(beaconWindow && expose->count == 0)
             {
-                xcb_expose_event_t *expose = (xcb_expose_event_t *)event;
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                        (beacon_Symbol_t*)beacon_encodeSmallInteger(expose->window));
-                if(beaconWindow)
-                {
-                    beacon_WindowExposeEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowExposeEventClass, sizeof(beacon_WindowExposeEvent_t), BeaconObjectKindPointers);
-                    beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onExpose:"), (beacon_oop_t)event);
-                }
-                
+                beacon_WindowExposeEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableExposeEvent, context->classes.windowExposeEventClass, sizeof(beacon_WindowExposeEvent_t));
+                beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onExposeSelector, (beacon_oop_t)event);
             }
-            break;
-        case XCB_BUTTON_PRESS:
+            
+        }
+        break;
+    case XCB_BUTTON_PRESS:
+        {
+            xcb_button_press_event_t *pressEvent = (xcb_button_press_event_t*)event;
+            beacon_Window_t *beaconWindow = beacon_xcb_windowFromHandle(context, pressEvent->event);
+            if(beaconWindow)
             {
-                xcb_button_press_event_t *pressEvent = (xcb_button_press_event_t*)event;
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(pressEvent->event));
-                if(beaconWindow)
-                {
-                    beacon_WindowMouseButtonEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t), BeaconObjectKindPointers);
-                    beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onMouseButtonDown:"), (beacon_oop_t)event);
-                }
+                beacon_WindowMouseButtonEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableMouseButtonEvent, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t));
+                beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onMouseButtonDownSelector, (beacon_oop_t)event);
             }
-            break;
-        case XCB_BUTTON_RELEASE:
+        }
+        break;
+    case XCB_BUTTON_RELEASE:
+        {
+            xcb_button_release_event_t *releaseEvent = (xcb_button_release_event_t*)event;
+            beacon_Window_t *beaconWindow = beacon_xcb_windowFromHandle(context, releaseEvent->event);
+            if(beaconWindow)
             {
-                xcb_button_release_event_t *releaseEvent = (xcb_button_release_event_t*)event;
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(releaseEvent->event));
-                if(beaconWindow)
-                {
-                    beacon_WindowMouseButtonEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t), BeaconObjectKindPointers);
-                    beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onMouseButtonUp:"), (beacon_oop_t)event);
-                }
+                beacon_WindowMouseButtonEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableMouseButtonEvent, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowMouseButtonEvent_t));
+                beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onMouseButtonUpSelector, (beacon_oop_t)event);
             }
-            break;
-            case XCB_KEY_PRESS:
+        }
+        break;
+        case XCB_KEY_PRESS:
+        {
+            xcb_key_press_event_t *pressEvent = (xcb_key_press_event_t*)event;
+            beacon_Window_t *beaconWindow = beacon_xcb_windowFromHandle(context, pressEvent->event);
+            if(beaconWindow)
             {
-                xcb_button_release_event_t *releaseEvent = (xcb_button_release_event_t*)event;
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(releaseEvent->event));
-                if(beaconWindow)
-                {
-                    beacon_WindowKeyboardEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowKeyboardEvent_t), BeaconObjectKindPointers);
-                    beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onKeyPressed:"), (beacon_oop_t)event);
-                }
+                beacon_WindowKeyboardEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableKeyboardEvent, context->classes.windowKeyboardEventClass, sizeof(beacon_WindowKeyboardEvent_t));
+                beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onKeyPressedSelector, (beacon_oop_t)event);
             }
-            break;
-            case XCB_KEY_RELEASE:
+        }
+        break;
+        case XCB_KEY_RELEASE:
+        {
+            xcb_key_release_event_t *releaseEvent = (xcb_key_release_event_t*)event;
+            beacon_Window_t *beaconWindow = beacon_xcb_windowFromHandle(context, releaseEvent->event);
+            if(beaconWindow)
             {
-                xcb_button_release_event_t *releaseEvent = (xcb_button_release_event_t*)event;
-                beacon_Window_t *beaconWindow = (beacon_Window_t*)beacon_MethodDictionary_atOrNil(context, context->roots.windowHandleMap,
-                    (beacon_Symbol_t*)beacon_encodeSmallInteger(releaseEvent->event));
-                if(beaconWindow)
-                {
-                    beacon_WindowKeyboardEvent_t *event = beacon_allocateObjectWithBehavior(context->heap, context->classes.windowMouseButtonEventClass, sizeof(beacon_WindowKeyboardEvent_t), BeaconObjectKindPointers);
-                    beacon_performWith(context, (beacon_oop_t)beaconWindow, (beacon_oop_t)beacon_internCString(context, "onKeyReleased:"), (beacon_oop_t)event);
-                }
+                beacon_WindowKeyboardEvent_t *event = beacon_Window_makeEvent(context, beaconWindow, &context->roots.reusableKeyboardEvent, context->classes.windowKeyboardEventClass, sizeof(beacon_WindowKeyboardEvent_t));
+                beacon_performWith(context, (beacon_oop_t)beaconWindow, context->roots.onKeyReleasedSelector, (beacon_oop_t)event);
             }
+        }
+        break;
+    }
+}
+
+static void beacon_xcb_wakeUpMainLoop(beacon_context_t *context)
+{
+    (void)context;
+    char wakeUpByte = 0;
+    ssize_t writtenSize = write(wakeUpPipe[1], &wakeUpByte, 1);
+    (void)writtenSize;
+}
+
+static beacon_oop_t beacon_WindowClass_enterMainLoop(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)argumentCount;
+    (void)arguments;
+    if(!xcb_connection)
+        return receiver;
+
+    // The threads of the pool write into this pipe for waking up the poll.
+    if(wakeUpPipe[0] < 0)
+    {
+        if(pipe(wakeUpPipe) != 0)
+            beacon_exception_error(context, "Failed to create the wake up pipe of the main loop.");
+        fcntl(wakeUpPipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeUpPipe[1], F_SETFL, O_NONBLOCK);
+    }
+
+    beacon_AsyncTasks_setWakeUpFunction(context, beacon_xcb_wakeUpMainLoop);
+    isQuitting = false;
+    while(!isQuitting && !xcb_connection_has_error(xcb_connection))
+    {
+        xcb_generic_event_t *event;
+        while((event = xcb_poll_for_event(xcb_connection)))
+        {
+            beacon_xcb_dispatchEvent(context, event);
+            free(event);
+        }
+
+        // Run the expired timers, and let the background processes run between the events.
+        beacon_TimerWheel_runFiredTimers(context);
+        beacon_ProcessScheduler_yield(context);
+        bool hasInvalidWindows = beacon_Window_renderInvalidWindows(context);
+        xcb_flush(xcb_connection);
+        if(isQuitting)
             break;
+
+        // The events that xcb read while rendering or flushing are already queued, so they would not wake up the poll.
+        bool hasQueuedEvents = false;
+        while((event = xcb_poll_for_queued_event(xcb_connection)))
+        {
+            beacon_xcb_dispatchEvent(context, event);
+            free(event);
+            hasQueuedEvents = true;
         }
+        if(hasQueuedEvents)
+            continue;
+
+        // Sleep until an event arrives, a timer expires, or a task of the thread pool finishes.
+        int64_t timeout = hasInvalidWindows ? 0 : beacon_ProcessScheduler_idleTimeout(context);
+        if(timeout != 0 && beacon_ProcessScheduler_runLowerPriorityProcesses(context, timeout))
+            continue;
 
+        struct pollfd pollDescriptors[2] = {
+            {.fd = xcb_get_file_descriptor(xcb_connection), .events = POLLIN},
+            {.fd = wakeUpPipe[0], .events = POLLIN},
+        };
+        poll(pollDescriptors, 2, timeout < 0 ? -1 : (int)(timeout < INT_MAX*INT64_C(1000) ? (timeout + 999) / 1000 : INT_MAX));
+
+        char wakeUpBytes[64];
+        while(read(wakeUpPipe[0], wakeUpBytes, sizeof(wakeUpBytes)) > 0)
+            ;
     }
+
+    beacon_AsyncTasks_setWakeUpFunction(context, NULL);
+    return receiver;
+}
+
+static beacon_oop_t beacon_WindowClass_exitMainLoop(beacon_context_t *context, beacon_oop_t receiver, size_t argumentCount, beacon_oop_t *arguments)
+{
+    (void)context;
+    (void)argumentCount;
+    (void)arguments;
+    isQuitting = true;
     return receiver;
 }
 
@@ -122,4 +215,5 @@ void beacon_context_registerWindowSystemPrimitives(beacon_context_t *context)
 {
     beacon_addPrimitiveToClass(context, context->classes.windowClass, "open", 0, beacon_Window_open);
     beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.windowClass), "enterMainLoop", 0, beacon_WindowClass_enterMainLoop);
+    beacon_addPrimitiveToClass(context, beacon_getClass(context, (beacon_oop_t)context->classes.windowClass), "exitMainLoop", 0, beacon_WindowClass_exitMainLoop);
 }
\ No newline at end of file